@@ -4,6 +4,8 @@
 #include <array>
 #include <cstring>
 #include <algorithm>
+#include <fstream>
+#include <sstream>
 
 #include <vulkan/vulkan.h>
 #include <GLFW/glfw3.h>
@@ -46,8 +48,11 @@ static constexpr VkPhysicalDeviceVulkan11Features REQUESTED_DEVICE_FEATURES_VK_1
 };
 
 static constexpr VkPhysicalDeviceFeatures REQUESTED_DEVICE_FEATURES_VK_1_0 {
+    .geometryShader = true, // gl_PrimitiveID in fragment shaders, only enabled if supported, see is_geometry_shader_supported()
     .multiDrawIndirect = true,
+    .drawIndirectFirstInstance = true,
     .samplerAnisotropy = true,
+    .textureCompressionBC = true,
     .occlusionQueryPrecise = true,
     .pipelineStatisticsQuery = true
 };
@@ -87,10 +92,14 @@ Instance::Instance(Proxy window_handle) {
     create_physical_device();
     create_logical_device();
     create_allocator();
+    create_pipeline_cache();
 }
 Instance::~Instance() {
     vkDeviceWaitIdle(m_device);
 
+    save_pipeline_cache();
+    vkDestroyPipelineCache(m_device, m_pipeline_cache, nullptr);
+
     vmaDestroyAllocator(m_allocator);
     vkDestroyDevice(m_device, nullptr);
     vkDestroySurfaceKHR(m_instance, m_surface, nullptr);
@@ -142,7 +151,9 @@ bool Instance::check_device_feature_support(VkPhysicalDevice device) {
     REQUIRE_FEATURE(supported_features_vk_1_0.features, occlusionQueryPrecise);
     REQUIRE_FEATURE(supported_features_vk_1_0.features, pipelineStatisticsQuery);
     REQUIRE_FEATURE(supported_features_vk_1_0.features, samplerAnisotropy);
+    REQUIRE_FEATURE(supported_features_vk_1_0.features, textureCompressionBC);
     REQUIRE_FEATURE(supported_features_vk_1_0.features, multiDrawIndirect);
+    REQUIRE_FEATURE(supported_features_vk_1_0.features, drawIndirectFirstInstance);
     REQUIRE_FEATURE(supported_features_vk_1_1, storageBuffer16BitAccess);
     REQUIRE_FEATURE(supported_features_vk_1_1, uniformAndStorageBuffer16BitAccess);
     REQUIRE_FEATURE(supported_features_vk_1_1, shaderDrawParameters);
@@ -160,6 +171,18 @@ bool Instance::check_device_feature_support(VkPhysicalDevice device) {
     REQUIRE_FEATURE(supported_features_vk_1_2, scalarBlockLayout);
     REQUIRE_FEATURE(supported_features_vk_1_2, hostQueryReset);
 
+    // Culling aggregates its atomics across subgroups
+    VkPhysicalDeviceVulkan11Properties properties_vk_1_1{ VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_1_PROPERTIES };
+    VkPhysicalDeviceProperties2 properties_vk_1_0{ VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2 };
+
+    properties_vk_1_0.pNext = reinterpret_cast<void *>(&properties_vk_1_1);
+    vkGetPhysicalDeviceProperties2(device, &properties_vk_1_0);
+
+    VkSubgroupFeatureFlags required_subgroup_operations = VK_SUBGROUP_FEATURE_BASIC_BIT | VK_SUBGROUP_FEATURE_BALLOT_BIT | VK_SUBGROUP_FEATURE_ARITHMETIC_BIT;
+    if (!(properties_vk_1_1.subgroupSupportedStages & VK_SHADER_STAGE_COMPUTE_BIT) || (properties_vk_1_1.subgroupSupportedOperations & required_subgroup_operations) != required_subgroup_operations) {
+        unsupported_features.emplace_back("subgroupSupportedOperations (basic, ballot, arithmetic in compute)");
+    }
+
     if (!unsupported_features.empty()) {
         DEBUG_WARNING("The physical device doesn't support the following required features: ")
         for (const auto &extension : unsupported_features) {
@@ -357,6 +380,14 @@ void Instance::create_physical_device() {
     bool async_transfer_possible = m_queue_indices.transfer.value() != m_queue_indices.graphics.value() && m_queue_indices.transfer.value() != m_queue_indices.compute.value();
     bool async_compute_possible = m_queue_indices.compute.value() != m_queue_indices.graphics.value() && m_queue_indices.compute.value() != m_queue_indices.transfer.value();
 
+    // The compute passes write GPU timestamps, so the family has to support them too
+    u32 queue_family_count{};
+    vkGetPhysicalDeviceQueueFamilyProperties(m_physical_device, &queue_family_count, nullptr);
+    std::vector<VkQueueFamilyProperties> queue_families(queue_family_count);
+    vkGetPhysicalDeviceQueueFamilyProperties(m_physical_device, &queue_family_count, queue_families.data());
+
+    m_async_compute_supported = async_compute_possible && queue_families[m_queue_indices.compute.value()].timestampValidBits > 0U;
+
     std::string str(properties.deviceName);
     if (str.find("RTX") != std::string::npos || str.find("GTX") != std::string::npos || str.find("NVIDIA") != std::string::npos || str.find("GeForce") != std::string::npos) {
         m_preferred_warp_size = 32u;
@@ -367,7 +398,7 @@ void Instance::create_physical_device() {
     DEBUG_LOG("\n" << properties.deviceName << " will be used as the physical device.")
     DEBUG_LOG("Graphics queue index: " << m_queue_indices.graphics.value())
     DEBUG_LOG("Transfer queue index: " << m_queue_indices.transfer.value() << ", async transfer will " << (async_transfer_possible ? "" : "not ") << "be possible.")
-    DEBUG_LOG("Compute queue index: " << m_queue_indices.compute.value() << ", async compute will " << (async_compute_possible ? "" : "not ") << "be possible.")
+    DEBUG_LOG("Compute queue index: " << m_queue_indices.compute.value() << ", async compute will " << (m_async_compute_supported ? "" : "not ") << "be possible.")
     DEBUG_LOG("Preferred warp size: " << m_preferred_warp_size)
 }
 void Instance::create_logical_device() {
@@ -389,6 +420,12 @@ void Instance::create_logical_device() {
         });
     }
 
+    // Optional, only the visibility buffer needs it
+    m_geometry_shader_supported = get_physical_device_features_vk_1_0().geometryShader;
+
+    VkPhysicalDeviceFeatures features_vk_1_0 = REQUESTED_DEVICE_FEATURES_VK_1_0;
+    features_vk_1_0.geometryShader = m_geometry_shader_supported;
+
     VkDeviceCreateInfo create_info {
         .sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO,
         .pNext = &REQUESTED_DEVICE_FEATURES_VK_1_1,
@@ -396,7 +433,7 @@ void Instance::create_logical_device() {
         .pQueueCreateInfos = queue_create_infos.data(),
         .enabledExtensionCount = static_cast<u32>(REQUESTED_DEVICE_EXTENSION_NAMES.size()),
         .ppEnabledExtensionNames = REQUESTED_DEVICE_EXTENSION_NAMES.data(),
-        .pEnabledFeatures = &REQUESTED_DEVICE_FEATURES_VK_1_0,
+        .pEnabledFeatures = &features_vk_1_0,
     };
 
 #ifdef ENABLE_VALIDATION_DEFINE
@@ -420,6 +457,81 @@ void Instance::create_allocator() {
 
     vmaCreateAllocator(&create_info, &m_allocator);
 }
+void Instance::create_pipeline_cache() {
+    DEBUG_TIMESTAMP(start);
+
+    std::string path = get_pipeline_cache_path();
+    std::vector<char> data{};
+
+    // Missing on the first launch on this device
+    std::ifstream file(path, std::ios::ate | std::ios::binary);
+    if (file.is_open()) {
+        data.resize(static_cast<usize>(file.tellg()));
+        file.seekg(0);
+        file.read(data.data(), static_cast<std::streamsize>(data.size()));
+    }
+
+    // The driver may reject a cache of another device or driver version or crash on a corrupted one, so the header is checked first
+    if (!data.empty()) {
+        VkPhysicalDeviceProperties properties = get_physical_device_properties_vk_1_0();
+        VkPipelineCacheHeaderVersionOne header{};
+
+        bool valid = data.size() >= sizeof(VkPipelineCacheHeaderVersionOne);
+        if (valid) {
+            std::memcpy(&header, data.data(), sizeof(VkPipelineCacheHeaderVersionOne));
+
+            valid = header.headerSize >= sizeof(VkPipelineCacheHeaderVersionOne) && header.headerSize <= data.size() &&
+                    header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+                    header.vendorID == properties.vendorID &&
+                    header.deviceID == properties.deviceID &&
+                    std::memcmp(header.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+        }
+
+        if (!valid) {
+            DEBUG_WARNING("Pipeline cache \"" << path << "\" was created by another device or driver, it will be rebuilt")
+            data.clear();
+        }
+    }
+
+    VkPipelineCacheCreateInfo create_info{
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,
+        .initialDataSize = data.size(),
+        .pInitialData = data.empty() ? nullptr : data.data()
+    };
+
+    DEBUG_ASSERT(vkCreatePipelineCache(m_device, &create_info, nullptr, &m_pipeline_cache) == VK_SUCCESS)
+
+    DEBUG_TIMESTAMP(stop);
+    DEBUG_LOG("Loaded " << data.size() / 1024U << "KB of pipeline cache in " << DEBUG_TIME_DIFF(start, stop) * 1000.0 << "ms")
+}
+
+void Instance::save_pipeline_cache() {
+    usize size{};
+    vkGetPipelineCacheData(m_device, m_pipeline_cache, &size, nullptr);
+
+    std::vector<char> data(size);
+    if (size == 0U || vkGetPipelineCacheData(m_device, m_pipeline_cache, &size, data.data()) != VK_SUCCESS) {
+        DEBUG_WARNING("Failed to get the pipeline cache data, it won't be saved")
+        return;
+    }
+
+    std::string path = get_pipeline_cache_path();
+    std::ofstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        DEBUG_WARNING("Failed to save the pipeline cache to \"" << path << "\" - cannot open the file")
+        return;
+    }
+
+    file.write(data.data(), static_cast<std::streamsize>(size));
+}
+std::string Instance::get_pipeline_cache_path() const {
+    VkPhysicalDeviceProperties properties = get_physical_device_properties_vk_1_0();
+
+    std::stringstream path{};
+    path << "./pipeline_cache_" << std::hex << properties.vendorID << "_" << properties.deviceID << ".bin";
+
+    return path.str();
+}
 
 u32 Instance::rate_device(VkPhysicalDevice device) {
     QueueFamilyIndices indices = get_device_queue_family_indices(device);
@@ -6,6 +6,7 @@
 #include <common/types.hpp>
 #include <common/debug.hpp>
 #include <optional>
+#include <string>
 
 #if DEBUG_MODE
 #define ENABLE_VALIDATION_DEFINE
@@ -57,14 +58,20 @@ public:
     VkQueue get_compute_queue() const { return m_queue_compute; }
 
     const QueueFamilyIndices &get_queue_family_indices() const { return m_queue_indices; }
+    bool is_async_compute_supported() const { return m_async_compute_supported; } // A separate compute family with timestamp support
+    bool is_geometry_shader_supported() const { return m_geometry_shader_supported; } // Enabled if supported, gl_PrimitiveID in fragment shaders depends on it
 
     VmaAllocator get_allocator() const { return m_allocator; }
 
+    // Shared by all pipeline creation, loaded from and saved to a file per physical device
+    VkPipelineCache get_pipeline_cache() const { return m_pipeline_cache; }
+
 private:
     VkInstance m_instance{};
     VkDevice m_device{};
 
     VmaAllocator m_allocator{};
+    VkPipelineCache m_pipeline_cache{};
 
     VkPhysicalDevice m_physical_device{};
     VkSurfaceKHR m_surface{};
@@ -74,6 +81,8 @@ private:
     VkQueue m_queue_compute{};
 
     QueueFamilyIndices m_queue_indices{};
+    bool m_async_compute_supported{};
+    bool m_geometry_shader_supported{};
 
     VkDebugUtilsMessengerEXT m_debug_messenger{};
 
@@ -85,6 +94,10 @@ private:
     void create_physical_device();
     void create_logical_device();
     void create_allocator();
+    void create_pipeline_cache();
+
+    void save_pipeline_cache();
+    std::string get_pipeline_cache_path() const;
 
     bool validation_layers_supported();
 
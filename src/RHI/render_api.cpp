@@ -17,6 +17,7 @@ RenderAPI::RenderAPI(const Window& window, const SwapchainConfig& config) : m_sw
     rm = MakeUnique<ResourceManager>(
         instance->get_device(),
         instance->get_allocator(),
+        instance->get_pipeline_cache(),
         family_indices.graphics.value(),
         family_indices.transfer.value(),
         family_indices.compute.value()
@@ -172,7 +173,8 @@ void RenderAPI::submit_commands(Handle<CommandList> handle, const SubmitInfo &in
             break;
     }
 
-    VkFence fence = rm->get_data(info.fence).fence;
+    // Submissions in the middle of a frame don't signal a fence
+    VkFence fence = info.fence != INVALID_HANDLE ? rm->get_data(info.fence).fence : VK_NULL_HANDLE;
 
     DEBUG_ASSERT(vkQueueSubmit(queue, 1U, &submit_info, fence) == VK_SUCCESS)
 }
@@ -413,11 +415,17 @@ void RenderAPI::read_queries(const std::vector<Handle<Query>> &query_handles, st
 }
 
 void RenderAPI::image_barrier(Handle<CommandList> command_list, VkPipelineStageFlags src_stage, VkPipelineStageFlags dst_stage, const std::vector<ImageBarrier> &barriers) const {
-    if(barriers.empty()) return;
+    pipeline_barrier(command_list, src_stage, dst_stage, barriers, {});
+}
+void RenderAPI::buffer_barrier(Handle<CommandList> command_list, VkPipelineStageFlags src_stage, VkPipelineStageFlags dst_stage, const std::vector<BufferBarrier> &barriers) const {
+    pipeline_barrier(command_list, src_stage, dst_stage, {}, barriers);
+}
+void RenderAPI::pipeline_barrier(Handle<CommandList> command_list, VkPipelineStageFlags src_stage, VkPipelineStageFlags dst_stage, const std::vector<ImageBarrier> &image_barriers, const std::vector<BufferBarrier> &buffer_barriers) const {
+    if(image_barriers.empty() && buffer_barriers.empty()) return;
 
-    std::vector<VkImageMemoryBarrier> image_barriers(barriers.size());
-    for(usize i{}; i < barriers.size(); ++i) {
-        const auto& barrier = barriers[i];
+    std::vector<VkImageMemoryBarrier> vk_image_barriers(image_barriers.size());
+    for(usize i{}; i < image_barriers.size(); ++i) {
+        const auto& barrier = image_barriers[i];
         const Image &image = rm->get_data(barrier.image_handle);
 
         u32 level_count;
@@ -442,14 +450,14 @@ void RenderAPI::image_barrier(Handle<CommandList> command_list, VkPipelineStageF
             DEBUG_PANIC("Invalid image barrier! - Image barrier[" << i << "] base_array_layer + array_layer_count is out of range, base_array_layer = " << barrier.base_array_layer_override << ", array_layer_count = " << layer_count << ", image.array_layer_count = " << image.array_layer_count)
         }
 
-        image_barriers[i] = VkImageMemoryBarrier{
+        vk_image_barriers[i] = VkImageMemoryBarrier{
             .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
             .srcAccessMask = barrier.src_access_mask,
             .dstAccessMask = barrier.dst_access_mask,
             .oldLayout = barrier.old_layout,
             .newLayout = barrier.new_layout,
-            .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-            .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .srcQueueFamilyIndex = barrier.src_queue_family.has_value() ? rm->get_queue_family_index(barrier.src_queue_family.value()) : VK_QUEUE_FAMILY_IGNORED,
+            .dstQueueFamilyIndex = barrier.dst_queue_family.has_value() ? rm->get_queue_family_index(barrier.dst_queue_family.value()) : VK_QUEUE_FAMILY_IGNORED,
             .image = image.image,
             .subresourceRange {
                 .aspectMask = image.aspect_flags,
@@ -461,14 +469,9 @@ void RenderAPI::image_barrier(Handle<CommandList> command_list, VkPipelineStageF
         };
     }
 
-    vkCmdPipelineBarrier(rm->get_data(command_list).command_buffer, src_stage, dst_stage, 0U, 0U, nullptr, 0U, nullptr, static_cast<u32>(image_barriers.size()), image_barriers.data());
-}
-void RenderAPI::buffer_barrier(Handle<CommandList> command_list, VkPipelineStageFlags src_stage, VkPipelineStageFlags dst_stage, const std::vector<BufferBarrier> &barriers) const {
-    if(barriers.empty()) return;
-
-    std::vector<VkBufferMemoryBarrier> buffer_barriers(barriers.size());
-    for(usize i{}; i < barriers.size(); ++i) {
-        const auto& barrier = barriers[i];
+    std::vector<VkBufferMemoryBarrier> vk_buffer_barriers(buffer_barriers.size());
+    for(usize i{}; i < buffer_barriers.size(); ++i) {
+        const auto& barrier = buffer_barriers[i];
         const auto& buffer = rm->get_data(barrier.buffer_handle);
 
         VkDeviceSize size;
@@ -482,18 +485,18 @@ void RenderAPI::buffer_barrier(Handle<CommandList> command_list, VkPipelineStage
             DEBUG_PANIC("Invalid buffer barrier! - Buffer barrier[" << i << "] offset + size is out of range, offset = " << barrier.offset_override << ", size = " << size << ", buffer.size = " << buffer.size)
         }
 
-        buffer_barriers[i] = VkBufferMemoryBarrier{
+        vk_buffer_barriers[i] = VkBufferMemoryBarrier{
             .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
             .srcAccessMask = barrier.src_access_mask,
             .dstAccessMask = barrier.dst_access_mask,
-            .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-            .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+            .srcQueueFamilyIndex = barrier.src_queue_family.has_value() ? rm->get_queue_family_index(barrier.src_queue_family.value()) : VK_QUEUE_FAMILY_IGNORED,
+            .dstQueueFamilyIndex = barrier.dst_queue_family.has_value() ? rm->get_queue_family_index(barrier.dst_queue_family.value()) : VK_QUEUE_FAMILY_IGNORED,
             .buffer = buffer.buffer,
             .offset = barrier.offset_override,
             .size = size,
         };
     }
-    vkCmdPipelineBarrier(rm->get_data(command_list).command_buffer, src_stage, dst_stage, 0U, 0U, nullptr, static_cast<u32>(buffer_barriers.size()), buffer_barriers.data(), 0U, nullptr);
+    vkCmdPipelineBarrier(rm->get_data(command_list).command_buffer, src_stage, dst_stage, 0U, 0U, nullptr, static_cast<u32>(vk_buffer_barriers.size()), vk_buffer_barriers.data(), static_cast<u32>(vk_image_barriers.size()), vk_image_barriers.data());
 }
 
 void RenderAPI::blit_image(Handle<CommandList> command_list, Handle<Image> src_image_handle, VkImageLayout src_image_layout, Handle<Image> dst_image_handle, VkImageLayout dst_image_layout, VkFilter filter, const std::vector<ImageBlit> &blits) const {
@@ -735,11 +738,23 @@ void RenderAPI::fill_buffer(Handle<CommandList> command_list, Handle<Buffer> han
     vkCmdFillBuffer(rm->get_data(command_list).command_buffer, rm->get_data(handle).buffer, offset, size, data);
 }
 
-void RenderAPI::begin_graphics_pipeline(Handle<CommandList> command_list, Handle<GraphicsPipeline> pipeline, Handle<RenderTarget> render_target, const std::vector<RenderTargetClear> &color_clears, const RenderTargetClear &depth_clear) const {
+void RenderAPI::begin_graphics_pipeline(Handle<CommandList> command_list, Handle<GraphicsPipeline> pipeline, Handle<RenderTarget> render_target, const std::vector<RenderTargetClear> &color_clears, const RenderTargetClear &depth_clear, VkExtent2D render_area) const {
     const GraphicsPipeline &pipe = rm->get_data(pipeline);
     const RenderTarget &rt = rm->get_data(render_target);
     const CommandList &cmd = rm->get_data(command_list);
 
+#if DEBUG_MODE
+    if(pipe.pipeline == VK_NULL_HANDLE) {
+        DEBUG_PANIC("Cannot begin graphics pipeline - Pipeline with a handle id: = " << pipeline << ", is still compiling! Call ResourceManager::wait_for_pipelines() first.")
+    }
+#endif
+
+    VkExtent2D extent = rt.extent;
+    if(render_area.width != 0U && render_area.height != 0U) {
+        DEBUG_ASSERT(render_area.width <= rt.extent.width && render_area.height <= rt.extent.height)
+        extent = render_area;
+    }
+
     u32 color_targets_count = static_cast<u32>(pipe.create_info.color_targets.size());
     u32 clears_depth_target = static_cast<u32>(pipe.create_info.depth_target.format != VK_FORMAT_UNDEFINED && pipe.create_info.depth_target.load_op == VK_ATTACHMENT_LOAD_OP_CLEAR);
 
@@ -761,20 +776,20 @@ void RenderAPI::begin_graphics_pipeline(Handle<CommandList> command_list, Handle
         .renderPass = pipe.render_pass,
         .framebuffer = rt.framebuffer,
         .renderArea {
-            .extent = rt.extent,
+            .extent = extent,
         },
         .clearValueCount = color_targets_count + clears_depth_target,
         .pClearValues = clear_values.data(),
     };
 
     VkViewport viewport{
-        .width = static_cast<f32>(rt.extent.width),
-        .height = static_cast<f32>(rt.extent.height),
+        .width = static_cast<f32>(extent.width),
+        .height = static_cast<f32>(extent.height),
         .maxDepth = 1.0f,
     };
 
     VkRect2D scissor{
-        .extent = rt.extent
+        .extent = extent
     };
 
     vkCmdBeginRenderPass(cmd.command_buffer, &info, VK_SUBPASS_CONTENTS_INLINE);
@@ -787,6 +802,12 @@ void RenderAPI::end_graphics_pipeline(Handle<CommandList> command_list, Handle<G
 }
 
 void RenderAPI::begin_compute_pipeline(Handle<CommandList> command_list, Handle<ComputePipeline> pipeline) const {
+#if DEBUG_MODE
+    if(rm->get_data(pipeline).pipeline == VK_NULL_HANDLE) {
+        DEBUG_PANIC("Cannot begin compute pipeline - Pipeline with a handle id: = " << pipeline << ", is still compiling! Call ResourceManager::wait_for_pipelines() first.")
+    }
+#endif
+
     vkCmdBindPipeline(
         rm->get_data(command_list).command_buffer,
         VK_PIPELINE_BIND_POINT_COMPUTE,
@@ -912,8 +933,8 @@ void RenderAPI::bind_descriptor(Handle<CommandList> command_list, Handle<Compute
 void RenderAPI::bind_vertex_buffer(Handle<CommandList> command_list, Handle<Buffer> buffer, u32 index, VkDeviceSize offset) const {
     vkCmdBindVertexBuffers(rm->get_data(command_list).command_buffer, index, 1U, &rm->get_data(buffer).buffer, &offset);
 }
-void RenderAPI::bind_index_buffer(Handle<CommandList> command_list, Handle<Buffer> buffer, VkDeviceSize offset) const {
-    vkCmdBindIndexBuffer(rm->get_data(command_list).command_buffer, rm->get_data(buffer).buffer, offset, VK_INDEX_TYPE_UINT32);
+void RenderAPI::bind_index_buffer(Handle<CommandList> command_list, Handle<Buffer> buffer, VkDeviceSize offset, VkIndexType index_type) const {
+    vkCmdBindIndexBuffer(rm->get_data(command_list).command_buffer, rm->get_data(buffer).buffer, offset, index_type);
 }
 
 void RenderAPI::clear_color_attachments(Handle<CommandList> command_list, Handle<GraphicsPipeline> pipeline, Handle<RenderTarget> rt, const std::vector<RenderTargetClear> &clear_colors) const {
@@ -1032,11 +1053,11 @@ void RenderAPI::draw_indexed(Handle<CommandList> command_list, u32 index_count,
 void RenderAPI::draw_indexed_indirect(Handle<CommandList> command_list, Handle<Buffer> indirect_buffer, u32 draw_count, u32 stride) const {
     vkCmdDrawIndexedIndirect(rm->get_data(command_list).command_buffer, rm->get_data(indirect_buffer).buffer, 0, draw_count, stride);
 }
-void RenderAPI::draw_indexed_indirect_count(Handle<CommandList> command_list, Handle<Buffer> indirect_buffer, Handle<Buffer> count_buffer, u32 max_draws, u32 stride) const {
+void RenderAPI::draw_indexed_indirect_count(Handle<CommandList> command_list, Handle<Buffer> indirect_buffer, Handle<Buffer> count_buffer, u32 max_draws, u32 stride, VkDeviceSize indirect_offset, VkDeviceSize count_offset) const {
     vkCmdDrawIndexedIndirectCount(
         rm->get_data(command_list).command_buffer,
-        rm->get_data(indirect_buffer).buffer, 0,
-        rm->get_data(count_buffer).buffer, 0,
+        rm->get_data(indirect_buffer).buffer, indirect_offset,
+        rm->get_data(count_buffer).buffer, count_offset,
         max_draws,
         stride
     );
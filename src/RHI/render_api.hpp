@@ -1,6 +1,8 @@
 #ifndef GEMINO_RENDER_API_HPP
 #define GEMINO_RENDER_API_HPP
 
+#include <optional>
+
 #include <window/window.hpp>
 
 #include <RHI/resource_manager.hpp>
@@ -23,7 +25,7 @@ struct SubmitInfo {
 
     std::vector<Handle<Semaphore>> wait_semaphores{};
     std::vector<Handle<Semaphore>> signal_semaphores{};
-    std::vector<VkPipelineStageFlags> signal_stages{};
+    std::vector<VkPipelineStageFlags> signal_stages{}; // Stages that wait for each of the wait_semaphores
 };
 
 struct ImageBarrier {
@@ -39,6 +41,10 @@ struct ImageBarrier {
     u32 mipmap_level_count_override{};
     u32 base_array_layer_override{};
     u32 array_layer_count_override{};
+
+    // Queue family ownership transfer, the same barrier has to be recorded on the releasing and then on the acquiring queue
+    std::optional<QueueFamily> src_queue_family{};
+    std::optional<QueueFamily> dst_queue_family{};
 };
 struct BufferBarrier {
     Handle<Buffer> buffer_handle{};
@@ -48,6 +54,10 @@ struct BufferBarrier {
 
     VkDeviceSize offset_override{};
     VkDeviceSize size_override{};
+
+    // Queue family ownership transfer, the same barrier has to be recorded on the releasing and then on the acquiring queue
+    std::optional<QueueFamily> src_queue_family{};
+    std::optional<QueueFamily> dst_queue_family{};
 };
 struct ImageBlit {
     VkExtent3D src_lower_bounds_override{};
@@ -113,6 +123,8 @@ public:
 
     void image_barrier(Handle<CommandList> command_list, VkPipelineStageFlags src_stage, VkPipelineStageFlags dst_stage, const std::vector<ImageBarrier> &barriers) const;
     void buffer_barrier(Handle<CommandList> command_list, VkPipelineStageFlags src_stage, VkPipelineStageFlags dst_stage, const std::vector<BufferBarrier> &barriers) const;
+    // Both kinds in a single vkCmdPipelineBarrier
+    void pipeline_barrier(Handle<CommandList> command_list, VkPipelineStageFlags src_stage, VkPipelineStageFlags dst_stage, const std::vector<ImageBarrier> &image_barriers, const std::vector<BufferBarrier> &buffer_barriers) const;
 
     void blit_image(Handle<CommandList> command_list, Handle<Image> src_image_handle, VkImageLayout src_image_layout, Handle<Image> dst_image_handle, VkImageLayout dst_image_layout, VkFilter filter, const std::vector<ImageBlit> &blits) const;
     void gen_mipmaps(Handle<CommandList> command_list, Handle<Image> target_image, VkFilter filter, VkImageLayout src_layout, VkPipelineStageFlags src_stage, VkAccessFlags src_access, VkImageLayout dst_layout, VkPipelineStageFlags dst_stage, VkAccessFlags dst_access) const;
@@ -122,7 +134,8 @@ public:
 
     void fill_buffer(Handle<CommandList> command_list, Handle<Buffer> handle, u32 data, VkDeviceSize size, VkDeviceSize offset = 0) const;
 
-    void begin_graphics_pipeline(Handle<CommandList> command_list, Handle<GraphicsPipeline> pipeline, Handle<RenderTarget> render_target, const std::vector<RenderTargetClear> &color_clears, const RenderTargetClear &depth_clear) const;
+    // A non-zero render_area limits the rendering, clears, viewport and scissor to the top left corner of the render target
+    void begin_graphics_pipeline(Handle<CommandList> command_list, Handle<GraphicsPipeline> pipeline, Handle<RenderTarget> render_target, const std::vector<RenderTargetClear> &color_clears, const RenderTargetClear &depth_clear, VkExtent2D render_area = {}) const;
     void end_graphics_pipeline(Handle<CommandList> command_list, Handle<GraphicsPipeline> pipeline) const;
 
     void begin_compute_pipeline(Handle<CommandList> command_list, Handle<ComputePipeline> pipeline) const;
@@ -136,7 +149,7 @@ public:
     void bind_descriptor(Handle<CommandList> command_list, Handle<ComputePipeline> pipeline, Handle<Descriptor> descriptor, u32 dst_index) const;
 
     void bind_vertex_buffer(Handle<CommandList> command_list, Handle<Buffer> buffer, u32 index = 0U, VkDeviceSize offset = 0) const;
-    void bind_index_buffer(Handle<CommandList> command_list, Handle<Buffer> buffer, VkDeviceSize offset = 0) const;
+    void bind_index_buffer(Handle<CommandList> command_list, Handle<Buffer> buffer, VkDeviceSize offset = 0, VkIndexType index_type = VK_INDEX_TYPE_UINT32) const;
 
     void clear_color_attachments(Handle<CommandList> command_list, Handle<GraphicsPipeline> pipeline, Handle<RenderTarget> rt, const std::vector<RenderTargetClear> &clear_colors) const;
     void clear_depth_attachment(Handle<CommandList> command_list, Handle<GraphicsPipeline> pipeline, Handle<RenderTarget> rt, const RenderTargetClear &clear) const;
@@ -146,7 +159,7 @@ public:
     void draw_count(Handle<CommandList> command_list, u32 vertex_count, u32 first_vertex = 0U, u32 instance_count = 1U) const;
     void draw_indexed(Handle<CommandList> command_list, u32 index_count, u32 first_index = 0U, i32 vertex_offset = 0U, u32 instance_count = 1U) const;
     void draw_indexed_indirect(Handle<CommandList> command_list, Handle<Buffer> indirect_buffer, u32 draw_count, u32 stride) const;
-    void draw_indexed_indirect_count(Handle<CommandList> command_list, Handle<Buffer> indirect_buffer, Handle<Buffer> count_buffer, u32 max_draws, u32 stride) const;
+    void draw_indexed_indirect_count(Handle<CommandList> command_list, Handle<Buffer> indirect_buffer, Handle<Buffer> count_buffer, u32 max_draws, u32 stride, VkDeviceSize indirect_offset = 0, VkDeviceSize count_offset = 0) const;
 
     const SwapchainConfig &get_swapchain_config() const { return m_swapchain_config; }
 
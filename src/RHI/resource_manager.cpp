@@ -1,8 +1,9 @@
 #include "resource_manager.hpp"
 #include <cstring>
+#include <array>
 
-ResourceManager::ResourceManager(VkDevice device, VmaAllocator allocator, u32 graphics_family_index, u32 transfer_family_index, u32 compute_family_index)
-    : VK_DEVICE(device), VK_ALLOCATOR(allocator) {
+ResourceManager::ResourceManager(VkDevice device, VmaAllocator allocator, VkPipelineCache pipeline_cache, u32 graphics_family_index, u32 transfer_family_index, u32 compute_family_index)
+    : VK_DEVICE(device), VK_ALLOCATOR(allocator), VK_PIPELINE_CACHE(pipeline_cache) {
     std::vector<VkDescriptorPoolSize> pool_sizes {
         VkDescriptorPoolSize { VK_DESCRIPTOR_TYPE_SAMPLER, 128U },
         VkDescriptorPoolSize { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 4096U },
@@ -39,6 +40,10 @@ ResourceManager::ResourceManager(VkDevice device, VmaAllocator allocator, u32 gr
     queue_families[transfer_family_index].emplace_back(QueueFamily::Transfer);
     queue_families[compute_family_index].emplace_back(QueueFamily::Compute);
 
+    m_queue_family_indices[QueueFamily::Graphics] = graphics_family_index;
+    m_queue_family_indices[QueueFamily::Transfer] = transfer_family_index;
+    m_queue_family_indices[QueueFamily::Compute] = compute_family_index;
+
     // Create VkCommandPools for each unique family
     for(const auto& [index, families] : queue_families) {
         VkCommandPool command_pool{};
@@ -204,36 +209,28 @@ Handle<Image> ResourceManager::create_image(const ImageCreateInfo &info) {
         .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
     };
 
-    VmaAllocationCreateInfo allocation_create_info {
-        .usage = VMA_MEMORY_USAGE_GPU_ONLY
-    };
-
-    DEBUG_ASSERT(vmaCreateImage(VK_ALLOCATOR, &image_create_info, &allocation_create_info, &image.image, &image.allocation, nullptr) == VK_SUCCESS)
+    if(info.create_per_mip_views) {
+        image.per_mip_views.resize(static_cast<usize>(info.mip_level_count));
+    }
 
-    VkImageViewCreateInfo view_create_info{
-        .sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
-        .image = image.image,
-        .viewType = image.view_type,
-        .format = image.format,
+    // The views are created once the memory is bound
+    if(info.alias_memory) {
+        image.is_aliased = true;
 
-        .subresourceRange {
-            .aspectMask = image.aspect_flags,
-            .levelCount = image.mip_level_count,
-            .layerCount = image.array_layer_count
-        }
-    };
+        DEBUG_ASSERT(vkCreateImage(VK_DEVICE, &image_create_info, nullptr, &image.image) == VK_SUCCESS)
 
-    DEBUG_ASSERT(vkCreateImageView(VK_DEVICE, &view_create_info, nullptr, &image.view) == VK_SUCCESS)
+        return m_image_allocator.alloc(image);
+    }
 
-    if(info.create_per_mip_views) {
-        image.per_mip_views.resize(static_cast<usize>(info.mip_level_count));
+    VmaAllocationCreateInfo allocation_create_info {
+        .usage = VMA_MEMORY_USAGE_GPU_ONLY
+    };
 
-        for(u32 i{}; i < info.mip_level_count; ++i) {
-            view_create_info.subresourceRange.levelCount = 1U;
-            view_create_info.subresourceRange.baseMipLevel = i;
+    DEBUG_ASSERT(vmaCreateImage(VK_ALLOCATOR, &image_create_info, &allocation_create_info, &image.image, &image.allocation, nullptr) == VK_SUCCESS)
 
-            DEBUG_ASSERT(vkCreateImageView(VK_DEVICE, &view_create_info, nullptr, &image.per_mip_views[i]) == VK_SUCCESS)
-        }
+    image.view = create_image_view(image, 0U, image.mip_level_count);
+    for(u32 i{}; i < image.per_mip_views.size(); ++i) {
+        image.per_mip_views[i] = create_image_view(image, i, 1U);
     }
 
     return m_image_allocator.alloc(image);
@@ -302,6 +299,14 @@ Handle<Buffer> ResourceManager::create_buffer(const BufferCreateInfo &info) {
         .sharingMode = VK_SHARING_MODE_EXCLUSIVE
     };
 
+    // Concurrent sharing is only valid between distinct families
+    std::array<u32, 2> concurrent_families{ m_queue_family_indices.at(QueueFamily::Graphics), m_queue_family_indices.at(QueueFamily::Compute) };
+    if(info.concurrent_sharing && concurrent_families[0] != concurrent_families[1]) {
+        buffer_create_info.sharingMode = VK_SHARING_MODE_CONCURRENT;
+        buffer_create_info.queueFamilyIndexCount = static_cast<u32>(concurrent_families.size());
+        buffer_create_info.pQueueFamilyIndices = concurrent_families.data();
+    }
+
     VmaAllocationCreateInfo allocation_create_info{
         .usage = info.memory_usage_flags
     };
@@ -545,100 +550,6 @@ Handle<GraphicsPipeline> ResourceManager::create_graphics_pipeline(const Graphic
 
     DEBUG_ASSERT(vkCreateRenderPass(VK_DEVICE, &render_pass_create_info, nullptr, &pipeline.render_pass) == VK_SUCCESS)
 
-    VkPipelineVertexInputStateCreateInfo vertex_input_state{
-        .sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO
-    };
-
-    VkPipelineInputAssemblyStateCreateInfo input_assembly{
-        .sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO,
-        .topology = info.primitive_topology,
-        .primitiveRestartEnable = VK_FALSE
-    };
-
-    VkViewport viewport{
-        .x = 0.0f,
-        .y = 0.0f,
-        .width = 1.0f,
-        .height = 1.0f,
-        .minDepth = 0.0f,
-        .maxDepth = 1.0f,
-    };
-
-    VkRect2D scissor{
-        .offset = { 0U, 0U },
-        .extent = { 1U, 1U}
-    };
-
-    VkPipelineViewportStateCreateInfo viewport_state{
-        .sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO,
-        .viewportCount = 1U,
-        .pViewports = &viewport,
-        .scissorCount = 1U,
-        .pScissors = &scissor
-    };
-
-    VkPipelineRasterizationStateCreateInfo rasterizer{
-        .sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO,
-        .depthClampEnable = VK_FALSE,
-        .rasterizerDiscardEnable = VK_FALSE,
-        .polygonMode = info.polygon_mode,
-        .cullMode = info.cull_mode,
-        .frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE,
-        .depthBiasEnable = VK_FALSE,
-        .lineWidth = 1.0f
-    };
-
-    VkPipelineMultisampleStateCreateInfo multisampling{
-        .sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO,
-        .rasterizationSamples = VK_SAMPLE_COUNT_1_BIT,
-        .sampleShadingEnable = VK_FALSE
-    };
-
-    std::vector<VkPipelineColorBlendAttachmentState> color_blend_attachments(info.color_targets.size());
-    for(u32 i{}; i < color_attachment_count; ++i) {
-        color_blend_attachments[i] = VkPipelineColorBlendAttachmentState{
-            .blendEnable = info.color_targets[i].enable_blending,
-            .srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA,
-            .dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA,
-            .colorBlendOp = VK_BLEND_OP_ADD,
-            .srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE,
-            .dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO,
-            .alphaBlendOp = VK_BLEND_OP_ADD,
-            .colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT
-        };
-    }
-
-    VkPipelineColorBlendStateCreateInfo color_blending{
-        .sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO,
-        .logicOpEnable = VK_FALSE,
-        .logicOp = VK_LOGIC_OP_COPY,
-        .attachmentCount = color_attachment_count,
-        .pAttachments = color_blend_attachments.data(),
-        .blendConstants = {0.0f, 0.0f, 0.0f, 0.0f}
-    };
-
-    VkPipelineDepthStencilStateCreateInfo depth_stencil{
-        .sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO,
-        .depthTestEnable = info.enable_depth_test,
-        .depthWriteEnable = info.enable_depth_write,
-        .depthCompareOp = info.depth_compare_op,
-        .depthBoundsTestEnable = VK_FALSE,
-        .stencilTestEnable = VK_FALSE,
-        .minDepthBounds = 0.0f,
-        .maxDepthBounds = 1.0f
-    };
-
-    std::vector<VkDynamicState> dynamic_states{
-        VK_DYNAMIC_STATE_VIEWPORT,
-        VK_DYNAMIC_STATE_SCISSOR
-    };
-
-    VkPipelineDynamicStateCreateInfo dynamic_state{
-        .sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO,
-        .dynamicStateCount = static_cast<u32>(dynamic_states.size()),
-        .pDynamicStates = dynamic_states.data()
-    };
-
     if(info.push_constants_size > 128U) {
         DEBUG_PANIC("Push constants size exceeded 128 bytes!")
     }
@@ -666,102 +577,14 @@ Handle<GraphicsPipeline> ResourceManager::create_graphics_pipeline(const Graphic
 
     DEBUG_ASSERT(vkCreatePipelineLayout(VK_DEVICE, &pipeline_layout_info, nullptr, &pipeline.layout) == VK_SUCCESS)
 
-    std::vector<VkPipelineShaderStageCreateInfo> shader_stages{};
-    std::vector<VkShaderModule> shader_modules{};
-    std::vector<VkSpecializationInfo> shader_spec_infos{};
-    std::vector<std::vector<VkSpecializationMapEntry>> shader_spec_maps{};
-
-    // I know it looks ugly but that's the quick way to take care of dangling pointer problems in the shader structures...
-    if(!info.vertex_shader_path.empty()) {
-        shader_modules.push_back(create_shader_module(info.vertex_shader_path));
-        shader_spec_maps.push_back(std::vector<VkSpecializationMapEntry>(info.vertex_constant_values.size()));
-
-        auto &shader_spec_map = shader_spec_maps.back();
-
-        for(u32 i{}; i < static_cast<u32>(shader_spec_map.size()); ++i) {
-            shader_spec_map[i] = VkSpecializationMapEntry{
-                .constantID = i,
-                .offset = i * static_cast<u32>(sizeof(u32)),
-                .size = sizeof(u32)
-            };
-        }
-
-        shader_spec_infos.push_back(VkSpecializationInfo{
-            .mapEntryCount = static_cast<u32>(shader_spec_map.size()),
-            .pMapEntries = shader_spec_map.data(),
-            .dataSize = static_cast<u32>(info.vertex_constant_values.size()) * sizeof(u32),
-            .pData = info.vertex_constant_values.data(),
-        });
-
-        shader_stages.push_back(VkPipelineShaderStageCreateInfo{
-            .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
-            .stage = VK_SHADER_STAGE_VERTEX_BIT,
-            .module = shader_modules.back(),
-            .pName = "main",
-            .pSpecializationInfo = info.vertex_constant_values.empty() ? nullptr : &shader_spec_infos.back(),
-        });
-    }
-
-    if(!info.fragment_shader_path.empty()) {
-        shader_modules.push_back(create_shader_module(info.fragment_shader_path));
-        shader_spec_maps.push_back(std::vector<VkSpecializationMapEntry>(info.fragment_constant_values.size()));
-
-        auto& shader_spec_map = shader_spec_maps.back();
-
-        for(u32 i{}; i < static_cast<u32>(shader_spec_map.size()); ++i) {
-            shader_spec_map[i] = VkSpecializationMapEntry{
-                .constantID = i,
-                .offset = i * static_cast<u32>(sizeof(u32)),
-                .size = sizeof(u32)
-            };
-        }
-
-        shader_spec_infos.push_back(VkSpecializationInfo{
-            .mapEntryCount = static_cast<u32>(shader_spec_map.size()),
-            .pMapEntries = shader_spec_map.data(),
-            .dataSize = static_cast<u32>(info.fragment_constant_values.size()) * sizeof(u32),
-            .pData = info.fragment_constant_values.data(),
-        });
-
-        shader_stages.push_back(VkPipelineShaderStageCreateInfo{
-            .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
-            .stage = VK_SHADER_STAGE_FRAGMENT_BIT,
-            .module = shader_modules.back(),
-            .pName = "main",
-            .pSpecializationInfo = info.fragment_constant_values.empty() ? nullptr : &shader_spec_infos.back(),
-        });
-    }
-
-    DEBUG_ASSERT(!shader_stages.empty())
-
-    VkGraphicsPipelineCreateInfo pipeline_create_info{
-        .sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
-
-        .stageCount = static_cast<u32>(shader_stages.size()),
-        .pStages = shader_stages.data(),
-
-        .pVertexInputState = &vertex_input_state,
-        .pInputAssemblyState = &input_assembly,
-        .pViewportState = &viewport_state,
-        .pRasterizationState = &rasterizer,
-        .pMultisampleState = &multisampling,
-        .pDepthStencilState = &depth_stencil,
-        .pColorBlendState = &color_blending,
-        .pDynamicState = &dynamic_state,
-
-        .layout = pipeline.layout,
-        .renderPass = pipeline.render_pass,
-
-        .basePipelineIndex = -1
-    };
+    Handle<GraphicsPipeline> handle = m_graphics_pipeline_allocator.alloc(pipeline);
 
-    DEBUG_ASSERT(vkCreateGraphicsPipelines(VK_DEVICE, nullptr, 1U, &pipeline_create_info, nullptr, &pipeline.pipeline) == VK_SUCCESS)
-
-    for (const auto &module : shader_modules) {
-        vkDestroyShaderModule(VK_DEVICE, module, nullptr);
-    }
+    // The render pass and the layout are ready right away, only the VkPipeline is compiled on a worker thread
+    m_pending_graphics_pipelines.emplace_back(handle, std::async(std::launch::async, [this, info, layout = pipeline.layout, render_pass = pipeline.render_pass] {
+        return compile_graphics_pipeline(info, layout, render_pass);
+    }));
 
-    return m_graphics_pipeline_allocator.alloc(pipeline);
+    return handle;
 }
 Handle<ComputePipeline> ResourceManager::create_compute_pipeline(const ComputePipelineCreateInfo &info) {
     ComputePipeline pipeline{
@@ -795,41 +618,24 @@ Handle<ComputePipeline> ResourceManager::create_compute_pipeline(const ComputePi
 
     DEBUG_ASSERT(vkCreatePipelineLayout(VK_DEVICE, &layout_create_info, nullptr, &pipeline.layout) == VK_SUCCESS)
 
-    VkShaderModule shader_module = create_shader_module(info.shader_path);
-
-    std::vector<VkSpecializationMapEntry> spec_map_entries(info.shader_constant_values.size());
-    for(u32 i{}; i < static_cast<u32>(spec_map_entries.size()); ++i) {
-        spec_map_entries[i] = VkSpecializationMapEntry{
-            .constantID = i,
-            .offset = i * static_cast<u32>(sizeof(u32)),
-            .size = sizeof(u32)
-        };
-    }
-
-    VkSpecializationInfo spec_info{
-        .mapEntryCount = static_cast<u32>(spec_map_entries.size()),
-        .pMapEntries = spec_map_entries.data(),
-        .dataSize = static_cast<u32>(info.shader_constant_values.size()) * sizeof(u32),
-        .pData = info.shader_constant_values.data(),
-    };
-
-    VkComputePipelineCreateInfo pipeline_create_info{
-        .sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
-        .stage {
-            .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
-            .stage = VK_SHADER_STAGE_COMPUTE_BIT,
-            .module = shader_module,
-            .pName = "main",
-            .pSpecializationInfo = &spec_info//((spec_info.mapEntryCount > 0U) ? &spec_info : nullptr),
-        },
-        .layout = pipeline.layout
-    };
+    Handle<ComputePipeline> handle = m_compute_pipeline_allocator.alloc(pipeline);
 
-    DEBUG_ASSERT(vkCreateComputePipelines(VK_DEVICE, nullptr, 1U, &pipeline_create_info, nullptr, &pipeline.pipeline) == VK_SUCCESS)
+    m_pending_compute_pipelines.emplace_back(handle, std::async(std::launch::async, [this, info, layout = pipeline.layout] {
+        return compile_compute_pipeline(info, layout);
+    }));
 
-    vkDestroyShaderModule(VK_DEVICE, shader_module, nullptr);
+    return handle;
+}
+void ResourceManager::wait_for_pipelines() {
+    for (auto &[handle, pipeline] : m_pending_graphics_pipelines) {
+        m_graphics_pipeline_allocator.get_element_mutable(handle).pipeline = pipeline.get();
+    }
+    for (auto &[handle, pipeline] : m_pending_compute_pipelines) {
+        m_compute_pipeline_allocator.get_element_mutable(handle).pipeline = pipeline.get();
+    }
 
-    return m_compute_pipeline_allocator.alloc(pipeline);
+    m_pending_graphics_pipelines.clear();
+    m_pending_compute_pipelines.clear();
 }
 Handle<RenderTarget> ResourceManager::create_render_target(Handle<GraphicsPipeline> src_pipeline, const RenderTargetCreateInfo &info) {
     std::vector<Handle<Image>> color_handles{};
@@ -967,12 +773,34 @@ void ResourceManager::flush_mapped_buffer(Handle<Buffer> buffer_handle, VkDevice
 
     vmaFlushAllocation(VK_ALLOCATOR, buffer.allocation, offset, size);
 }
+void ResourceManager::invalidate_mapped_buffer(Handle<Buffer> buffer_handle, VkDeviceSize size, VkDeviceSize offset) {
+#if DEBUG_MODE // Remove hot-path checks in release mode
+    if (!m_buffer_allocator.is_handle_valid(buffer_handle)) {
+        DEBUG_PANIC("Cannot invalidate mapped buffer! - Buffer with a handle id: = " << buffer_handle << ", does not exist!")
+    }
+#endif
 
-void ResourceManager::memcpy_to_buffer_once(Handle<Buffer> buffer_handle, const void *src_data, usize size, usize dst_offset, usize src_offset) {
-    void *mapped = reinterpret_cast<void*>(reinterpret_cast<usize>(map_buffer(buffer_handle)) + dst_offset);
-    void *src = reinterpret_cast<void*>(reinterpret_cast<usize>(src_data) + src_offset);
-
-    std::memcpy(mapped, src, size);
+    const Buffer &buffer = m_buffer_allocator.get_element(buffer_handle);
+
+    VkDeviceSize invalidate_size;
+    if(size != 0) {
+        invalidate_size = size;
+    } else {
+        invalidate_size = buffer.size;
+    }
+
+    if(invalidate_size + offset > buffer.size) {
+        DEBUG_PANIC("Cannot invalidate mapped buffer! - Invalidate range out of bounds: invalidate_size = " << invalidate_size << ", offset = " << offset)
+    }
+
+    vmaInvalidateAllocation(VK_ALLOCATOR, buffer.allocation, offset, invalidate_size);
+}
+
+void ResourceManager::memcpy_to_buffer_once(Handle<Buffer> buffer_handle, const void *src_data, usize size, usize dst_offset, usize src_offset) {
+    void *mapped = reinterpret_cast<void*>(reinterpret_cast<usize>(map_buffer(buffer_handle)) + dst_offset);
+    void *src = reinterpret_cast<void*>(reinterpret_cast<usize>(src_data) + src_offset);
+
+    std::memcpy(mapped, src, size);
 
     unmap_buffer(buffer_handle);
 }
@@ -1061,8 +889,9 @@ void ResourceManager::update_descriptor(Handle<Descriptor> descriptor_handle, co
                 DEBUG_PANIC("Binding write failed! - descriptor_type is invalid, descriptor_type = " << descriptor_type << ", binding_index = " << binding.binding_index)
             }
 
+            // Storage images are bound without a sampler
             descriptor_images.push_back(VkDescriptorImageInfo {
-                .sampler = get_data(binding.image_info.image_sampler).sampler,
+                .sampler = (binding.image_info.image_sampler != INVALID_HANDLE) ? get_data(binding.image_info.image_sampler).sampler : VK_NULL_HANDLE,
                 .imageView = image_view,
                 .imageLayout = image_layout
             });
@@ -1087,6 +916,55 @@ void ResourceManager::update_descriptor(Handle<Descriptor> descriptor_handle, co
 
     vkUpdateDescriptorSets(VK_DEVICE, static_cast<u32>(descriptor_writes.size()), descriptor_writes.data(), 0U, nullptr);
 }
+void ResourceManager::bind_aliased_image_memory(const std::vector<Handle<Image>> &image_handles) {
+    if(image_handles.empty()) return;
+
+    VkMemoryRequirements requirements{
+        .memoryTypeBits = UINT32_MAX
+    };
+    for(const auto &image_handle : image_handles) {
+        const Image &image = m_image_allocator.get_element(image_handle);
+        if(!image.is_aliased || image.allocation != nullptr) {
+            DEBUG_PANIC("Cannot bind aliased memory - Image with a handle id: = " << image_handle << ", wasn't created with alias_memory or is already bound!")
+        }
+
+        VkMemoryRequirements image_requirements = get_image_memory_requirements(image_handle);
+        requirements.size = std::max(requirements.size, image_requirements.size);
+        requirements.alignment = std::max(requirements.alignment, image_requirements.alignment);
+        requirements.memoryTypeBits &= image_requirements.memoryTypeBits;
+    }
+
+    if(requirements.memoryTypeBits == 0U) {
+        DEBUG_PANIC("Cannot bind aliased memory - The images have no memory type in common!")
+    }
+
+    VmaAllocationCreateInfo allocation_create_info {
+        .usage = VMA_MEMORY_USAGE_GPU_ONLY
+    };
+
+    VmaAllocation allocation{};
+    DEBUG_ASSERT(vmaAllocateMemory(VK_ALLOCATOR, &requirements, &allocation_create_info, &allocation, nullptr) == VK_SUCCESS)
+
+    for(const auto &image_handle : image_handles) {
+        Image &image = m_image_allocator.get_element_mutable(image_handle);
+        image.allocation = allocation;
+
+        DEBUG_ASSERT(vmaBindImageMemory(VK_ALLOCATOR, allocation, image.image) == VK_SUCCESS)
+
+        image.view = create_image_view(image, 0U, image.mip_level_count);
+        for(u32 i{}; i < image.per_mip_views.size(); ++i) {
+            image.per_mip_views[i] = create_image_view(image, i, 1U);
+        }
+    }
+
+    m_aliased_allocation_users[allocation] = static_cast<u32>(image_handles.size());
+}
+VkMemoryRequirements ResourceManager::get_image_memory_requirements(Handle<Image> image_handle) const {
+    VkMemoryRequirements requirements{};
+    vkGetImageMemoryRequirements(VK_DEVICE, get_data(image_handle).image, &requirements);
+
+    return requirements;
+}
 
 void ResourceManager::destroy(Handle<Image> image_handle) {
     if (!m_image_allocator.is_handle_valid(image_handle)) {
@@ -1095,6 +973,24 @@ void ResourceManager::destroy(Handle<Image> image_handle) {
 
     const Image &image = m_image_allocator.get_element(image_handle);
 
+    // The shared allocation is freed together with its last image
+    if(image.is_aliased) {
+        for(const auto& view : image.per_mip_views) {
+            vkDestroyImageView(VK_DEVICE, view, nullptr);
+        }
+
+        vkDestroyImageView(VK_DEVICE, image.view, nullptr);
+        vkDestroyImage(VK_DEVICE, image.image, nullptr);
+
+        if(image.allocation != nullptr && --m_aliased_allocation_users.at(image.allocation) == 0U) {
+            m_aliased_allocation_users.erase(image.allocation);
+            vmaFreeMemory(VK_ALLOCATOR, image.allocation);
+        }
+
+        m_image_allocator.free(image_handle);
+        return;
+    }
+
     // If it is a borrowed image
     if(image.allocation == nullptr) {
         return;
@@ -1191,6 +1087,9 @@ void ResourceManager::destroy(Handle<GraphicsPipeline> pipeline_handle) {
         DEBUG_PANIC("Cannot delete graphics pipeline - Pipeline with a handle id: = " << pipeline_handle << ", does not exist!")
     }
 
+    // The worker thread may still be compiling it
+    wait_for_pipelines();
+
     const GraphicsPipeline &pipeline = m_graphics_pipeline_allocator.get_element(pipeline_handle);
     vkDestroyPipelineLayout(VK_DEVICE, pipeline.layout, nullptr);
     vkDestroyRenderPass(VK_DEVICE, pipeline.render_pass, nullptr);
@@ -1203,6 +1102,9 @@ void ResourceManager::destroy(Handle<ComputePipeline> pipeline_handle) {
         DEBUG_PANIC("Cannot delete compute pipeline - Pipeline with a handle id: = " << pipeline_handle << ", does not exist!")
     }
 
+    // The worker thread may still be compiling it
+    wait_for_pipelines();
+
     const ComputePipeline &pipeline = m_compute_pipeline_allocator.get_element(pipeline_handle);
     vkDestroyPipelineLayout(VK_DEVICE, pipeline.layout, nullptr);
     vkDestroyPipeline(VK_DEVICE, pipeline.pipeline, nullptr);
@@ -1324,7 +1226,240 @@ const RenderTarget &ResourceManager::get_data(Handle<RenderTarget> rt_handle) co
 const VkQueryPool &ResourceManager::get_query_pool(QueryType query_type) const {
     return m_query_pools.at(query_type);
 }
-VkShaderModule ResourceManager::create_shader_module(const std::string &path) {
+VkPipeline ResourceManager::compile_graphics_pipeline(const GraphicsPipelineCreateInfo &info, VkPipelineLayout layout, VkRenderPass render_pass) const {
+    u32 color_attachment_count = static_cast<u32>(info.color_targets.size());
+
+    VkPipelineVertexInputStateCreateInfo vertex_input_state{
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO
+    };
+
+    VkPipelineInputAssemblyStateCreateInfo input_assembly{
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO,
+        .topology = info.primitive_topology,
+        .primitiveRestartEnable = VK_FALSE
+    };
+
+    VkViewport viewport{
+        .x = 0.0f,
+        .y = 0.0f,
+        .width = 1.0f,
+        .height = 1.0f,
+        .minDepth = 0.0f,
+        .maxDepth = 1.0f,
+    };
+
+    VkRect2D scissor{
+        .offset = { 0U, 0U },
+        .extent = { 1U, 1U}
+    };
+
+    VkPipelineViewportStateCreateInfo viewport_state{
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO,
+        .viewportCount = 1U,
+        .pViewports = &viewport,
+        .scissorCount = 1U,
+        .pScissors = &scissor
+    };
+
+    VkPipelineRasterizationStateCreateInfo rasterizer{
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO,
+        .depthClampEnable = VK_FALSE,
+        .rasterizerDiscardEnable = VK_FALSE,
+        .polygonMode = info.polygon_mode,
+        .cullMode = info.cull_mode,
+        .frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE,
+        .depthBiasEnable = VK_FALSE,
+        .lineWidth = 1.0f
+    };
+
+    VkPipelineMultisampleStateCreateInfo multisampling{
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO,
+        .rasterizationSamples = VK_SAMPLE_COUNT_1_BIT,
+        .sampleShadingEnable = VK_FALSE
+    };
+
+    std::vector<VkPipelineColorBlendAttachmentState> color_blend_attachments(info.color_targets.size());
+    for(u32 i{}; i < color_attachment_count; ++i) {
+        color_blend_attachments[i] = VkPipelineColorBlendAttachmentState{
+            .blendEnable = info.color_targets[i].enable_blending,
+            .srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA,
+            .dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA,
+            .colorBlendOp = VK_BLEND_OP_ADD,
+            .srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE,
+            .dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO,
+            .alphaBlendOp = VK_BLEND_OP_ADD,
+            .colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT
+        };
+    }
+
+    VkPipelineColorBlendStateCreateInfo color_blending{
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO,
+        .logicOpEnable = VK_FALSE,
+        .logicOp = VK_LOGIC_OP_COPY,
+        .attachmentCount = color_attachment_count,
+        .pAttachments = color_blend_attachments.data(),
+        .blendConstants = {0.0f, 0.0f, 0.0f, 0.0f}
+    };
+
+    VkPipelineDepthStencilStateCreateInfo depth_stencil{
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO,
+        .depthTestEnable = info.enable_depth_test,
+        .depthWriteEnable = info.enable_depth_write,
+        .depthCompareOp = info.depth_compare_op,
+        .depthBoundsTestEnable = VK_FALSE,
+        .stencilTestEnable = VK_FALSE,
+        .minDepthBounds = 0.0f,
+        .maxDepthBounds = 1.0f
+    };
+
+    std::vector<VkDynamicState> dynamic_states{
+        VK_DYNAMIC_STATE_VIEWPORT,
+        VK_DYNAMIC_STATE_SCISSOR
+    };
+
+    VkPipelineDynamicStateCreateInfo dynamic_state{
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO,
+        .dynamicStateCount = static_cast<u32>(dynamic_states.size()),
+        .pDynamicStates = dynamic_states.data()
+    };
+
+    std::vector<VkPipelineShaderStageCreateInfo> shader_stages{};
+    std::vector<VkShaderModule> shader_modules{};
+    std::vector<VkSpecializationInfo> shader_spec_infos{};
+    std::vector<std::vector<VkSpecializationMapEntry>> shader_spec_maps{};
+
+    // I know it looks ugly but that's the quick way to take care of dangling pointer problems in the shader structures...
+    if(!info.vertex_shader_path.empty()) {
+        shader_modules.push_back(create_shader_module(info.vertex_shader_path));
+        shader_spec_maps.push_back(std::vector<VkSpecializationMapEntry>(info.vertex_constant_values.size()));
+
+        auto &shader_spec_map = shader_spec_maps.back();
+
+        for(u32 i{}; i < static_cast<u32>(shader_spec_map.size()); ++i) {
+            shader_spec_map[i] = VkSpecializationMapEntry{
+                .constantID = i,
+                .offset = i * static_cast<u32>(sizeof(u32)),
+                .size = sizeof(u32)
+            };
+        }
+
+        shader_spec_infos.push_back(VkSpecializationInfo{
+            .mapEntryCount = static_cast<u32>(shader_spec_map.size()),
+            .pMapEntries = shader_spec_map.data(),
+            .dataSize = static_cast<u32>(info.vertex_constant_values.size()) * sizeof(u32),
+            .pData = info.vertex_constant_values.data(),
+        });
+
+        shader_stages.push_back(VkPipelineShaderStageCreateInfo{
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+            .stage = VK_SHADER_STAGE_VERTEX_BIT,
+            .module = shader_modules.back(),
+            .pName = "main",
+            .pSpecializationInfo = info.vertex_constant_values.empty() ? nullptr : &shader_spec_infos.back(),
+        });
+    }
+
+    if(!info.fragment_shader_path.empty()) {
+        shader_modules.push_back(create_shader_module(info.fragment_shader_path));
+        shader_spec_maps.push_back(std::vector<VkSpecializationMapEntry>(info.fragment_constant_values.size()));
+
+        auto& shader_spec_map = shader_spec_maps.back();
+
+        for(u32 i{}; i < static_cast<u32>(shader_spec_map.size()); ++i) {
+            shader_spec_map[i] = VkSpecializationMapEntry{
+                .constantID = i,
+                .offset = i * static_cast<u32>(sizeof(u32)),
+                .size = sizeof(u32)
+            };
+        }
+
+        shader_spec_infos.push_back(VkSpecializationInfo{
+            .mapEntryCount = static_cast<u32>(shader_spec_map.size()),
+            .pMapEntries = shader_spec_map.data(),
+            .dataSize = static_cast<u32>(info.fragment_constant_values.size()) * sizeof(u32),
+            .pData = info.fragment_constant_values.data(),
+        });
+
+        shader_stages.push_back(VkPipelineShaderStageCreateInfo{
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+            .stage = VK_SHADER_STAGE_FRAGMENT_BIT,
+            .module = shader_modules.back(),
+            .pName = "main",
+            .pSpecializationInfo = info.fragment_constant_values.empty() ? nullptr : &shader_spec_infos.back(),
+        });
+    }
+
+    DEBUG_ASSERT(!shader_stages.empty())
+
+    VkGraphicsPipelineCreateInfo pipeline_create_info{
+        .sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
+
+        .stageCount = static_cast<u32>(shader_stages.size()),
+        .pStages = shader_stages.data(),
+
+        .pVertexInputState = &vertex_input_state,
+        .pInputAssemblyState = &input_assembly,
+        .pViewportState = &viewport_state,
+        .pRasterizationState = &rasterizer,
+        .pMultisampleState = &multisampling,
+        .pDepthStencilState = &depth_stencil,
+        .pColorBlendState = &color_blending,
+        .pDynamicState = &dynamic_state,
+
+        .layout = layout,
+        .renderPass = render_pass,
+
+        .basePipelineIndex = -1
+    };
+
+    VkPipeline pipeline{};
+    DEBUG_ASSERT(vkCreateGraphicsPipelines(VK_DEVICE, VK_PIPELINE_CACHE, 1U, &pipeline_create_info, nullptr, &pipeline) == VK_SUCCESS)
+
+    for (const auto &module : shader_modules) {
+        vkDestroyShaderModule(VK_DEVICE, module, nullptr);
+    }
+
+    return pipeline;
+}
+VkPipeline ResourceManager::compile_compute_pipeline(const ComputePipelineCreateInfo &info, VkPipelineLayout layout) const {
+    VkShaderModule shader_module = create_shader_module(info.shader_path);
+
+    std::vector<VkSpecializationMapEntry> spec_map_entries(info.shader_constant_values.size());
+    for(u32 i{}; i < static_cast<u32>(spec_map_entries.size()); ++i) {
+        spec_map_entries[i] = VkSpecializationMapEntry{
+            .constantID = i,
+            .offset = i * static_cast<u32>(sizeof(u32)),
+            .size = sizeof(u32)
+        };
+    }
+
+    VkSpecializationInfo spec_info{
+        .mapEntryCount = static_cast<u32>(spec_map_entries.size()),
+        .pMapEntries = spec_map_entries.data(),
+        .dataSize = static_cast<u32>(info.shader_constant_values.size()) * sizeof(u32),
+        .pData = info.shader_constant_values.data(),
+    };
+
+    VkComputePipelineCreateInfo pipeline_create_info{
+        .sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
+        .stage {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+            .stage = VK_SHADER_STAGE_COMPUTE_BIT,
+            .module = shader_module,
+            .pName = "main",
+            .pSpecializationInfo = &spec_info//((spec_info.mapEntryCount > 0U) ? &spec_info : nullptr),
+        },
+        .layout = layout
+    };
+
+    VkPipeline pipeline{};
+    DEBUG_ASSERT(vkCreateComputePipelines(VK_DEVICE, VK_PIPELINE_CACHE, 1U, &pipeline_create_info, nullptr, &pipeline) == VK_SUCCESS)
+
+    vkDestroyShaderModule(VK_DEVICE, shader_module, nullptr);
+
+    return pipeline;
+}
+VkShaderModule ResourceManager::create_shader_module(const std::string &path) const {
     VkShaderModule shader_module{};
 
     std::vector<u8> spirv_code = Utils::read_file_bytes(path);
@@ -1365,4 +1500,24 @@ VkShaderModule ResourceManager::create_shader_module(const std::string &path) {
     //};
 
     return shader_module;
+}
+VkImageView ResourceManager::create_image_view(const Image &image, u32 base_mip_level, u32 mip_level_count) {
+    VkImageViewCreateInfo view_create_info{
+        .sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+        .image = image.image,
+        .viewType = image.view_type,
+        .format = image.format,
+
+        .subresourceRange {
+            .aspectMask = image.aspect_flags,
+            .baseMipLevel = base_mip_level,
+            .levelCount = mip_level_count,
+            .layerCount = image.array_layer_count
+        }
+    };
+
+    VkImageView view{};
+    DEBUG_ASSERT(vkCreateImageView(VK_DEVICE, &view_create_info, nullptr, &view) == VK_SUCCESS)
+
+    return view;
 }
\ No newline at end of file
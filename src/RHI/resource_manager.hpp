@@ -4,6 +4,7 @@
 #define VMA_VULKAN_VERSION 1002000 // Vulkan 1.2
 #include <vk_mem_alloc.h>
 #include <unordered_map>
+#include <future>
 
 #include <common/utils.hpp>
 #include <common/types.hpp>
@@ -22,6 +23,7 @@ struct BufferCreateInfo {
     VkDeviceSize size{};
     VkBufferUsageFlags buffer_usage_flags{};
     VmaMemoryUsage memory_usage_flags{};
+    bool concurrent_sharing = false; // Read by the graphics and compute queues at the same time, no ownership transfers needed
 };
 
 struct Image {
@@ -44,6 +46,7 @@ struct Image {
     std::vector<VkImageView> per_mip_views{};
 
     VmaAllocation allocation{};
+    bool is_aliased{}; // The allocation is shared with other images, see ImageCreateInfo::alias_memory
 };
 struct ImageCreateInfo {
     VkFormat format{};
@@ -57,6 +60,9 @@ struct ImageCreateInfo {
     u32 array_layer_count = 1U;
 
     bool create_per_mip_views = false;
+
+    // Created without memory and views, bind_aliased_image_memory() has to be called before the image is used
+    bool alias_memory = false;
 };
 
 struct SamplerCreateInfo {
@@ -221,7 +227,7 @@ struct QueryPipelineStatisticsResults {
 
 class ResourceManager {
 public:
-    ResourceManager(VkDevice device, VmaAllocator allocator, u32 graphics_family_index, u32 transfer_family_index, u32 compute_family_index);
+    ResourceManager(VkDevice device, VmaAllocator allocator, VkPipelineCache pipeline_cache, u32 graphics_family_index, u32 transfer_family_index, u32 compute_family_index);
     ~ResourceManager();
 
     ResourceManager &operator=(const ResourceManager &other) = delete;
@@ -232,17 +238,22 @@ public:
     Handle<Buffer> create_buffer(const BufferCreateInfo &info);
     Handle<Descriptor> create_descriptor(const DescriptorCreateInfo &info);
     Handle<Sampler> create_sampler(const SamplerCreateInfo &info);
+    // The SPIR-V is read and the VkPipeline is compiled on a worker thread, the handle can be used for render targets and descriptors right away
+    // but only for recording commands after wait_for_pipelines()
     Handle<GraphicsPipeline> create_graphics_pipeline(const GraphicsPipelineCreateInfo &info);
     Handle<ComputePipeline> create_compute_pipeline(const ComputePipelineCreateInfo &info);
     Handle<RenderTarget> create_render_target(Handle<GraphicsPipeline> src_pipeline, const RenderTargetCreateInfo &info);
     Handle<Query> create_query(QueryType q_type);
     Handle<CommandList> create_command_list(QueueFamily family);
     Handle<Fence> create_fence(bool signaled = true);
+
+    void wait_for_pipelines(); // Joins the pipelines still being compiled
     Handle<Semaphore> create_semaphore();
 
     void *map_buffer(Handle<Buffer> buffer_handle);
     void unmap_buffer(Handle<Buffer> buffer_handle);
     void flush_mapped_buffer(Handle<Buffer> buffer_handle, VkDeviceSize size = 0, VkDeviceSize offset = 0);
+    void invalidate_mapped_buffer(Handle<Buffer> buffer_handle, VkDeviceSize size = 0, VkDeviceSize offset = 0);
 
     void memcpy_to_buffer_once(Handle<Buffer> buffer_handle, const void *src_data, usize size, usize dst_offset = 0, usize src_offset = 0);
 
@@ -251,6 +262,10 @@ public:
 
     void update_descriptor(Handle<Descriptor> descriptor_handle, const DescriptorUpdateInfo &info);
 
+    // All images share one allocation, so only those that are never in use at the same time can be bound together
+    void bind_aliased_image_memory(const std::vector<Handle<Image>> &image_handles);
+    [[nodiscard]] VkMemoryRequirements get_image_memory_requirements(Handle<Image> image_handle) const;
+
     void destroy(Handle<Image> image_handle);
     void destroy(Handle<Buffer> buffer_handle);
     void destroy(Handle<Descriptor> descriptor_handle);
@@ -277,12 +292,18 @@ public:
 
     [[nodiscard]] const VkQueryPool &get_query_pool(QueryType query_type) const;
     [[nodiscard]] VkDescriptorPool get_descriptor_pool() const { return m_descriptor_pool; }
+    [[nodiscard]] u32 get_queue_family_index(QueueFamily family) const { return m_queue_family_indices.at(family); }
 
 private:
     const VkDevice VK_DEVICE;
     const VmaAllocator VK_ALLOCATOR;
+    const VkPipelineCache VK_PIPELINE_CACHE;
 
-    VkShaderModule create_shader_module(const std::string& path);
+    // Called on the worker threads, so they can't touch the allocators
+    VkPipeline compile_graphics_pipeline(const GraphicsPipelineCreateInfo &info, VkPipelineLayout layout, VkRenderPass render_pass) const;
+    VkPipeline compile_compute_pipeline(const ComputePipelineCreateInfo &info, VkPipelineLayout layout) const;
+    VkShaderModule create_shader_module(const std::string& path) const;
+    VkImageView create_image_view(const Image &image, u32 base_mip_level, u32 mip_level_count);
     VkDescriptorPool m_descriptor_pool{};
 
     HandleAllocator<Buffer> m_buffer_allocator{};
@@ -291,6 +312,8 @@ private:
     HandleAllocator<Sampler> m_sampler_allocator{};
 
     std::unordered_map<QueueFamily, VkCommandPool> m_command_pools{};
+    std::unordered_map<QueueFamily, u32> m_queue_family_indices{};
+    std::unordered_map<VmaAllocation, u32> m_aliased_allocation_users{};
     std::unordered_map<QueryType, VkQueryPool> m_query_pools{};
     std::unordered_map<QueryType, HandleAllocator<u32>> m_query_id_allocators{};
 
@@ -302,6 +325,8 @@ private:
 
     HandleAllocator<GraphicsPipeline> m_graphics_pipeline_allocator{};
     HandleAllocator<ComputePipeline> m_compute_pipeline_allocator{};
+    std::vector<std::pair<Handle<GraphicsPipeline>, std::future<VkPipeline>>> m_pending_graphics_pipelines{};
+    std::vector<std::pair<Handle<ComputePipeline>, std::future<VkPipeline>>> m_pending_compute_pipelines{};
     HandleAllocator<RenderTarget> m_render_target_allocator{};
 };
 
@@ -0,0 +1,420 @@
+#include "bc_encoder.hpp"
+
+#include <common/utils.hpp>
+
+#include <algorithm>
+#include <array>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#define BC_ENCODER_SSE2 1
+#include <emmintrin.h>
+#else
+#define BC_ENCODER_SSE2 0
+#endif
+
+static constexpr std::array<u32, 16> BC7_WEIGHTS_4 { 0u, 4u, 9u, 13u, 17u, 21u, 26u, 30u, 34u, 38u, 43u, 47u, 51u, 55u, 60u, 64u };
+
+struct BitWriter {
+    u64 bits[2]{};
+    u32 position{};
+
+    void write(u64 value, u32 count) {
+        for (u32 i{}; i < count; ++i, ++position) {
+            bits[position / 64u] |= ((value >> i) & 1u) << (position % 64u);
+        }
+    }
+};
+
+static void load_block(const u8 *rgba, u32 width, u32 height, u32 block_x, u32 block_y, u8 *block) {
+    // Pixels outside of the image are clamped to the edge so that partial blocks don't pull in garbage
+    for (u32 y{}; y < 4u; ++y) {
+        u32 src_y = std::min(block_y * 4u + y, height - 1u);
+
+        for (u32 x{}; x < 4u; ++x) {
+            u32 src_x = std::min(block_x * 4u + x, width - 1u);
+
+            std::memcpy(block + (y * 4u + x) * 4u, rgba + (static_cast<usize>(src_y) * width + src_x) * 4u, 4u);
+        }
+    }
+}
+
+static void compute_block_min_max(const u8 *block, u8 *min, u8 *max) {
+#if BC_ENCODER_SSE2
+    __m128i p0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(block) + 0);
+    __m128i p1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(block) + 1);
+    __m128i p2 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(block) + 2);
+    __m128i p3 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(block) + 3);
+
+    __m128i mn = _mm_min_epu8(_mm_min_epu8(p0, p1), _mm_min_epu8(p2, p3));
+    __m128i mx = _mm_max_epu8(_mm_max_epu8(p0, p1), _mm_max_epu8(p2, p3));
+
+    mn = _mm_min_epu8(mn, _mm_srli_si128(mn, 8));
+    mn = _mm_min_epu8(mn, _mm_srli_si128(mn, 4));
+    mx = _mm_max_epu8(mx, _mm_srli_si128(mx, 8));
+    mx = _mm_max_epu8(mx, _mm_srli_si128(mx, 4));
+
+    i32 packed_min = _mm_cvtsi128_si32(mn);
+    i32 packed_max = _mm_cvtsi128_si32(mx);
+    std::memcpy(min, &packed_min, 4u);
+    std::memcpy(max, &packed_max, 4u);
+#else
+    for (u32 c{}; c < 4u; ++c) {
+        min[c] = 255u;
+        max[c] = 0u;
+    }
+
+    for (u32 i{}; i < 16u; ++i) {
+        for (u32 c{}; c < 4u; ++c) {
+            min[c] = std::min(min[c], block[i * 4u + c]);
+            max[c] = std::max(max[c], block[i * 4u + c]);
+        }
+    }
+#endif
+}
+
+// dots[i] = dot(block[i] - base, dir) for all 16 pixels
+static void compute_block_dots(const u8 *block, const i32 *base, const i32 *dir, i32 *dots) {
+#if BC_ENCODER_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i base16 = _mm_setr_epi16(
+        static_cast<i16>(base[0]), static_cast<i16>(base[1]), static_cast<i16>(base[2]), static_cast<i16>(base[3]),
+        static_cast<i16>(base[0]), static_cast<i16>(base[1]), static_cast<i16>(base[2]), static_cast<i16>(base[3])
+    );
+    const __m128i dir16 = _mm_setr_epi16(
+        static_cast<i16>(dir[0]), static_cast<i16>(dir[1]), static_cast<i16>(dir[2]), static_cast<i16>(dir[3]),
+        static_cast<i16>(dir[0]), static_cast<i16>(dir[1]), static_cast<i16>(dir[2]), static_cast<i16>(dir[3])
+    );
+
+    for (u32 i{}; i < 4u; ++i) {
+        __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i *>(block) + i);
+
+        __m128i lo = _mm_madd_epi16(_mm_sub_epi16(_mm_unpacklo_epi8(pixels, zero), base16), dir16);
+        __m128i hi = _mm_madd_epi16(_mm_sub_epi16(_mm_unpackhi_epi8(pixels, zero), base16), dir16);
+
+        // lo = [p0.rg, p0.ba, p1.rg, p1.ba], hi = [p2.rg, p2.ba, p3.rg, p3.ba]
+        __m128 rg = _mm_shuffle_ps(_mm_castsi128_ps(lo), _mm_castsi128_ps(hi), _MM_SHUFFLE(2, 0, 2, 0));
+        __m128 ba = _mm_shuffle_ps(_mm_castsi128_ps(lo), _mm_castsi128_ps(hi), _MM_SHUFFLE(3, 1, 3, 1));
+
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dots) + i, _mm_add_epi32(_mm_castps_si128(rg), _mm_castps_si128(ba)));
+    }
+#else
+    for (u32 i{}; i < 16u; ++i) {
+        dots[i] = 0;
+        for (u32 c{}; c < 4u; ++c) {
+            dots[i] += (static_cast<i32>(block[i * 4u + c]) - base[c]) * dir[c];
+        }
+    }
+#endif
+}
+
+static u16 pack_565(const i32 *color) {
+    u32 r = (static_cast<u32>(color[0]) * 31u + 127u) / 255u;
+    u32 g = (static_cast<u32>(color[1]) * 63u + 127u) / 255u;
+    u32 b = (static_cast<u32>(color[2]) * 31u + 127u) / 255u;
+
+    return static_cast<u16>((r << 11u) | (g << 5u) | b);
+}
+static void unpack_565(u16 packed, i32 *color) {
+    u32 r = (packed >> 11u) & 31u;
+    u32 g = (packed >> 5u) & 63u;
+    u32 b = packed & 31u;
+
+    color[0] = static_cast<i32>((r << 3u) | (r >> 2u));
+    color[1] = static_cast<i32>((g << 2u) | (g >> 4u));
+    color[2] = static_cast<i32>((b << 3u) | (b >> 2u));
+    color[3] = 0;
+}
+
+void BCEncoder::encode_block_bc1(const u8 *block_rgba, u8 *dst) {
+    u8 min[4], max[4];
+    compute_block_min_max(block_rgba, min, max);
+
+    // Bounding box diagonal with the sign of the RG and BG covariance picking one of the four diagonals
+    i32 center[4] = { (min[0] + max[0]) / 2, (min[1] + max[1]) / 2, (min[2] + max[2]) / 2, 0 };
+    i32 cov_rg{}, cov_bg{};
+    for (u32 i{}; i < 16u; ++i) {
+        i32 r = block_rgba[i * 4u + 0u] - center[0];
+        i32 g = block_rgba[i * 4u + 1u] - center[1];
+        i32 b = block_rgba[i * 4u + 2u] - center[2];
+
+        cov_rg += r * g;
+        cov_bg += b * g;
+    }
+
+    i32 c0[4], c1[4];
+    for (u32 c{}; c < 3u; ++c) {
+        // Inset the box by 1/16 of its size, the extremes are rarely hit after interpolation
+        i32 inset = (max[c] - min[c]) >> 4;
+        c0[c] = max[c] - inset;
+        c1[c] = min[c] + inset;
+    }
+    c0[3] = c1[3] = 0;
+
+    if (cov_rg < 0) std::swap(c0[0], c1[0]);
+    if (cov_bg < 0) std::swap(c0[2], c1[2]);
+
+    u16 packed0 = pack_565(c0);
+    u16 packed1 = pack_565(c1);
+
+    // c0 > c1 selects the 4 color mode
+    if (packed0 < packed1) {
+        std::swap(packed0, packed1);
+    }
+
+    u32 indices{};
+    if (packed0 != packed1) {
+        unpack_565(packed0, c0);
+        unpack_565(packed1, c1);
+
+        i32 dir[4] = { c1[0] - c0[0], c1[1] - c0[1], c1[2] - c0[2], 0 };
+        i32 dir_len_sq = dir[0] * dir[0] + dir[1] * dir[1] + dir[2] * dir[2];
+
+        i32 dots[16];
+        compute_block_dots(block_rgba, c0, dir, dots);
+
+        // Position along c0 -> c1 to the BC1 index (0 = c0, 1 = c1, 2 = 2/3 c0 + 1/3 c1, 3 = 1/3 c0 + 2/3 c1)
+        static constexpr u32 INDEX_MAP[4] { 0u, 2u, 3u, 1u };
+        for (u32 i{}; i < 16u; ++i) {
+            i32 position = std::clamp((dots[i] * 3 + dir_len_sq / 2) / dir_len_sq, 0, 3);
+            indices |= INDEX_MAP[position] << (i * 2u);
+        }
+    }
+
+    std::memcpy(dst + 0u, &packed0, sizeof(u16));
+    std::memcpy(dst + 2u, &packed1, sizeof(u16));
+    std::memcpy(dst + 4u, &indices, sizeof(u32));
+}
+
+void BCEncoder::encode_block_bc4(const u8 *block_rgba, u32 channel, u8 *dst) {
+    u8 min[4], max[4];
+    compute_block_min_max(block_rgba, min, max);
+
+    u8 a0 = max[channel];
+    u8 a1 = min[channel];
+
+    u64 indices{};
+    if (a0 != a1) {
+        i32 range = a0 - a1;
+
+        // a0 > a1 selects the 8 value mode, position 7 is a0 and position 0 is a1
+        for (u32 i{}; i < 16u; ++i) {
+            i32 position = ((block_rgba[i * 4u + channel] - a1) * 7 + range / 2) / range;
+            u64 index = (position == 7) ? 0u : (position == 0) ? 1u : static_cast<u64>(8 - position);
+
+            indices |= index << (i * 3u);
+        }
+    }
+
+    dst[0] = a0;
+    dst[1] = a1;
+    for (u32 i{}; i < 6u; ++i) {
+        dst[2u + i] = static_cast<u8>(indices >> (i * 8u));
+    }
+}
+
+void BCEncoder::encode_block_bc3(const u8 *block_rgba, u8 *dst) {
+    encode_block_bc4(block_rgba, 3u, dst);
+    encode_block_bc1(block_rgba, dst + 8u);
+}
+
+void BCEncoder::encode_block_bc5(const u8 *block_rgba, u8 *dst) {
+    encode_block_bc4(block_rgba, 0u, dst);
+    encode_block_bc4(block_rgba, 1u, dst + 8u);
+}
+
+void BCEncoder::encode_block_bc7(const u8 *block_rgba, u8 *dst) {
+    // Mode 6: one subset, RGBA 7.7.7.7 endpoints with a unique p-bit and 4 bit indices
+    f32 mean[4]{};
+    for (u32 i{}; i < 16u; ++i) {
+        for (u32 c{}; c < 4u; ++c) {
+            mean[c] += static_cast<f32>(block_rgba[i * 4u + c]);
+        }
+    }
+    for (f32 &m : mean) {
+        m /= 16.0f;
+    }
+
+    f32 cov[4][4]{};
+    for (u32 i{}; i < 16u; ++i) {
+        f32 d[4];
+        for (u32 c{}; c < 4u; ++c) {
+            d[c] = static_cast<f32>(block_rgba[i * 4u + c]) - mean[c];
+        }
+        for (u32 a{}; a < 4u; ++a) {
+            for (u32 b{}; b < 4u; ++b) {
+                cov[a][b] += d[a] * d[b];
+            }
+        }
+    }
+
+    // Principal axis by power iteration
+    f32 axis[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+    for (u32 iteration{}; iteration < 8u; ++iteration) {
+        f32 next[4]{};
+        for (u32 a{}; a < 4u; ++a) {
+            for (u32 b{}; b < 4u; ++b) {
+                next[a] += cov[a][b] * axis[b];
+            }
+        }
+
+        f32 length = std::max({ std::abs(next[0]), std::abs(next[1]), std::abs(next[2]), std::abs(next[3]) });
+        if (length < 1e-6f) break;
+
+        for (u32 c{}; c < 4u; ++c) {
+            axis[c] = next[c] / length;
+        }
+    }
+
+    f32 axis_len_sq = axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2] + axis[3] * axis[3];
+    f32 t_min = 0.0f, t_max = 0.0f;
+    if (axis_len_sq > 1e-6f) {
+        t_min = 1e30f, t_max = -1e30f;
+        for (u32 i{}; i < 16u; ++i) {
+            f32 t{};
+            for (u32 c{}; c < 4u; ++c) {
+                t += (static_cast<f32>(block_rgba[i * 4u + c]) - mean[c]) * axis[c];
+            }
+            t_min = std::min(t_min, t / axis_len_sq);
+            t_max = std::max(t_max, t / axis_len_sq);
+        }
+    }
+
+    // Quantize both endpoints to 7 bits per channel, the p-bit is picked per endpoint to minimize the error
+    u32 quantized[2][4]{}, p_bits[2]{};
+    i32 endpoints[2][4]{};
+    for (u32 e{}; e < 2u; ++e) {
+        f32 t = (e == 0u) ? t_min : t_max;
+
+        i32 target[4];
+        for (u32 c{}; c < 4u; ++c) {
+            target[c] = std::clamp(static_cast<i32>(std::lround(mean[c] + axis[c] * t)), 0, 255);
+        }
+
+        i32 best_error = INT32_MAX;
+        for (u32 p{}; p < 2u; ++p) {
+            i32 error{};
+            u32 q[4];
+            for (u32 c{}; c < 4u; ++c) {
+                q[c] = static_cast<u32>(std::clamp((target[c] - static_cast<i32>(p) + 1) >> 1, 0, 127));
+
+                i32 diff = static_cast<i32>((q[c] << 1u) | p) - target[c];
+                error += diff * diff;
+            }
+
+            if (error < best_error) {
+                best_error = error;
+                p_bits[e] = p;
+                for (u32 c{}; c < 4u; ++c) {
+                    quantized[e][c] = q[c];
+                    endpoints[e][c] = static_cast<i32>((q[c] << 1u) | p);
+                }
+            }
+        }
+    }
+
+    i32 dir[4] = { endpoints[1][0] - endpoints[0][0], endpoints[1][1] - endpoints[0][1], endpoints[1][2] - endpoints[0][2], endpoints[1][3] - endpoints[0][3] };
+    i32 dir_len_sq = dir[0] * dir[0] + dir[1] * dir[1] + dir[2] * dir[2] + dir[3] * dir[3];
+
+    u32 indices[16]{};
+    if (dir_len_sq > 0) {
+        i32 dots[16];
+        compute_block_dots(block_rgba, endpoints[0], dir, dots);
+
+        for (u32 i{}; i < 16u; ++i) {
+            i32 weight = std::clamp((dots[i] * 64 + dir_len_sq / 2) / dir_len_sq, 0, 64);
+
+            // The weight table is almost uniform, so the rounded guess is off by at most one
+            u32 index = static_cast<u32>(std::clamp((weight * 15 + 32) / 64, 0, 15));
+            if (index > 0u && std::abs(static_cast<i32>(BC7_WEIGHTS_4[index - 1u]) - weight) < std::abs(static_cast<i32>(BC7_WEIGHTS_4[index]) - weight)) {
+                index--;
+            } else if (index < 15u && std::abs(static_cast<i32>(BC7_WEIGHTS_4[index + 1u]) - weight) < std::abs(static_cast<i32>(BC7_WEIGHTS_4[index]) - weight)) {
+                index++;
+            }
+
+            indices[i] = index;
+        }
+    }
+
+    // The anchor index has an implicit 0 MSB, flip the endpoints (the weight table is symmetric) if it's set
+    if (indices[0] & 8u) {
+        std::swap(quantized[0], quantized[1]);
+        std::swap(p_bits[0], p_bits[1]);
+        for (u32 &index : indices) {
+            index = 15u - index;
+        }
+    }
+
+    BitWriter writer{};
+    writer.write(1u << 6u, 7u);
+    for (u32 c{}; c < 4u; ++c) {
+        writer.write(quantized[0][c], 7u);
+        writer.write(quantized[1][c], 7u);
+    }
+    writer.write(p_bits[0], 1u);
+    writer.write(p_bits[1], 1u);
+
+    writer.write(indices[0], 3u);
+    for (u32 i = 1u; i < 16u; ++i) {
+        writer.write(indices[i], 4u);
+    }
+
+    std::memcpy(dst, writer.bits, 16u);
+}
+
+u32 BCEncoder::get_block_size(BCFormat format) {
+    switch (format) {
+        case BCFormat::BC1:
+        case BCFormat::BC4:
+            return 8u;
+        case BCFormat::BC3:
+        case BCFormat::BC5:
+        case BCFormat::BC7:
+            return 16u;
+    }
+
+    return 0u;
+}
+
+usize BCEncoder::calculate_encoded_size(BCFormat format, u32 width, u32 height) {
+    return Utils::div_ceil(width, 4u) * Utils::div_ceil(height, 4u) * get_block_size(format);
+}
+
+void BCEncoder::encode(BCFormat format, const std::vector<BCEncodeLevel> &levels) {
+    // One job per block row of every level
+    struct Job {
+        u32 level{};
+        u32 block_row{};
+    };
+
+    std::vector<Job> jobs{};
+    for (u32 level{}; level < static_cast<u32>(levels.size()); ++level) {
+        DEBUG_ASSERT(levels[level].rgba != nullptr && levels[level].dst != nullptr && levels[level].width > 0u && levels[level].height > 0u)
+
+        for (u32 row{}; row < static_cast<u32>(Utils::div_ceil(levels[level].height, 4u)); ++row) {
+            jobs.push_back(Job{ level, row });
+        }
+    }
+
+    u32 block_size = get_block_size(format);
+
+    Utils::parallel_for(static_cast<u32>(jobs.size()), [&jobs, &levels, format, block_size](u32 job_id) {
+        const auto &[level_id, block_row] = jobs[job_id];
+        const BCEncodeLevel &level = levels[level_id];
+
+        u32 blocks_x = static_cast<u32>(Utils::div_ceil(level.width, 4u));
+        u8 *dst = level.dst + static_cast<usize>(block_row) * blocks_x * block_size;
+
+        alignas(16) u8 block[64];
+        for (u32 block_x{}; block_x < blocks_x; ++block_x, dst += block_size) {
+            load_block(level.rgba, level.width, level.height, block_x, block_row, block);
+
+            switch (format) {
+                case BCFormat::BC1: encode_block_bc1(block, dst); break;
+                case BCFormat::BC3: encode_block_bc3(block, dst); break;
+                case BCFormat::BC4: encode_block_bc4(block, 0u, dst); break;
+                case BCFormat::BC5: encode_block_bc5(block, dst); break;
+                case BCFormat::BC7: encode_block_bc7(block, dst); break;
+            }
+        }
+    });
+}
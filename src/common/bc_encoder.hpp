@@ -0,0 +1,39 @@
+#ifndef GEMINO_BC_ENCODER_HPP
+#define GEMINO_BC_ENCODER_HPP
+
+#include <common/types.hpp>
+#include <common/debug.hpp>
+
+#include <vector>
+
+enum struct BCFormat : u32 {
+    BC1, // RGB, 4 bpp
+    BC3, // RGBA, 8 bpp
+    BC4, // R, 4 bpp
+    BC5, // RG, 8 bpp
+    BC7, // RGBA, 8 bpp (mode 6 only)
+};
+
+struct BCEncodeLevel {
+    const u8 *rgba{}; // Tightly packed RGBA8 pixels
+    u32 width{};
+    u32 height{};
+    u8 *dst{}; // Must be at least BCEncoder::calculate_encoded_size(format, width, height) bytes
+};
+
+// CPU block compression encoder, BC4 reads the R channel and BC5 reads the RG channels of the RGBA8 input
+namespace BCEncoder {
+    u32 get_block_size(BCFormat format);
+    usize calculate_encoded_size(BCFormat format, u32 width, u32 height);
+
+    // Blocks of all levels are encoded in parallel on all hardware threads
+    void encode(BCFormat format, const std::vector<BCEncodeLevel> &levels);
+
+    void encode_block_bc1(const u8 *block_rgba, u8 *dst);
+    void encode_block_bc3(const u8 *block_rgba, u8 *dst);
+    void encode_block_bc4(const u8 *block_rgba, u32 channel, u8 *dst);
+    void encode_block_bc5(const u8 *block_rgba, u8 *dst);
+    void encode_block_bc7(const u8 *block_rgba, u8 *dst);
+}
+
+#endif
@@ -0,0 +1,366 @@
+#include "mip_generator.hpp"
+
+#include <common/utils.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+#define MIP_GENERATOR_SSE2 1
+#include <emmintrin.h>
+#else
+#define MIP_GENERATOR_SSE2 0
+#endif
+
+static constexpr u32 ROWS_PER_TASK = 16u;
+static constexpr f32 KAISER_WIDTH = 3.0f;
+static constexpr f32 KAISER_ALPHA = 4.0f;
+static constexpr u32 ALPHA_HISTOGRAM_SIZE = 4096u;
+
+struct FilterTaps {
+    std::vector<u32> first_tap{}; // Per destination pixel, count is first_tap[i + 1] - first_tap[i]
+    std::vector<u32> indices{};
+    std::vector<f32> weights{};
+};
+
+static const std::array<f32, 256> &get_srgb_to_linear_table() {
+    static const std::array<f32, 256> table = []() {
+        std::array<f32, 256> result{};
+        for (u32 i{}; i < 256u; ++i) {
+            f32 c = static_cast<f32>(i) / 255.0f;
+            result[i] = (c <= 0.04045f) ? (c / 12.92f) : std::pow((c + 0.055f) / 1.055f, 2.4f);
+        }
+
+        return result;
+    }();
+
+    return table;
+}
+static const std::vector<u8> &get_linear_to_srgb_table() {
+    // 16 bit input precision, the sRGB curve is steep near 0 so fewer bits would band dark gradients
+    static const std::vector<u8> table = []() {
+        std::vector<u8> result(65536u);
+        for (u32 i{}; i < 65536u; ++i) {
+            f32 l = static_cast<f32>(i) / 65535.0f;
+            f32 c = (l <= 0.0031308f) ? (l * 12.92f) : (1.055f * std::pow(l, 1.0f / 2.4f) - 0.055f);
+            result[i] = static_cast<u8>(std::clamp(c * 255.0f + 0.5f, 0.0f, 255.0f));
+        }
+
+        return result;
+    }();
+
+    return table;
+}
+
+static void for_each_row_block(u32 row_count, bool multithreaded, const std::function<void(u32, u32)> &fn) {
+    u32 task_count = static_cast<u32>(Utils::div_ceil(row_count, ROWS_PER_TASK));
+
+    auto task = [&fn, row_count](u32 task_index) {
+        u32 begin = task_index * ROWS_PER_TASK;
+        fn(begin, std::min(begin + ROWS_PER_TASK, row_count));
+    };
+
+    if (multithreaded && task_count > 1u) {
+        Utils::parallel_for(task_count, task);
+    } else {
+        for (u32 i{}; i < task_count; ++i) {
+            task(i);
+        }
+    }
+}
+
+static f32 bessel_i0(f32 x) {
+    // Power series, converges quickly for the small arguments used by the Kaiser window
+    f32 sum = 1.0f, term = 1.0f, half_x_sq = x * x * 0.25f;
+    for (u32 k = 1u; k < 32u && term > sum * 1e-7f; ++k) {
+        term *= half_x_sq / static_cast<f32>(k * k);
+        sum += term;
+    }
+
+    return sum;
+}
+static f32 sinc(f32 x) {
+    if (std::abs(x) < 1e-5f) {
+        return 1.0f;
+    }
+
+    f32 px = x * 3.14159265358979f;
+    return std::sin(px) / px;
+}
+static f32 kaiser(f32 x) {
+    f32 t = x / KAISER_WIDTH;
+    if (t * t >= 1.0f) {
+        return 0.0f;
+    }
+
+    return sinc(x) * bessel_i0(KAISER_ALPHA * std::sqrt(1.0f - t * t)) / bessel_i0(KAISER_ALPHA);
+}
+
+static FilterTaps build_taps(MipFilter filter, u32 src_size, u32 dst_size) {
+    FilterTaps taps{};
+    taps.first_tap.reserve(dst_size + 1u);
+
+    f32 scale = static_cast<f32>(src_size) / static_cast<f32>(dst_size);
+
+    for (u32 i{}; i < dst_size; ++i) {
+        taps.first_tap.push_back(static_cast<u32>(taps.indices.size()));
+
+        f32 weight_sum{};
+        if (filter == MipFilter::Box) {
+            f32 span_begin = static_cast<f32>(i) * scale, span_end = static_cast<f32>(i + 1u) * scale;
+
+            for (u32 s = static_cast<u32>(span_begin); s < std::min(static_cast<u32>(std::ceil(span_end)), src_size); ++s) {
+                f32 weight = std::min(span_end, static_cast<f32>(s + 1u)) - std::max(span_begin, static_cast<f32>(s));
+                if (weight <= 0.0f) {
+                    continue;
+                }
+
+                taps.indices.push_back(s);
+                taps.weights.push_back(weight);
+                weight_sum += weight;
+            }
+        } else {
+            // Distances are measured in destination pixels so the kernel widens with the downscale factor
+            f32 center = (static_cast<f32>(i) + 0.5f) * scale;
+            i32 begin = static_cast<i32>(std::floor(center - KAISER_WIDTH * scale));
+            i32 end = static_cast<i32>(std::ceil(center + KAISER_WIDTH * scale));
+
+            for (i32 s = begin; s <= end; ++s) {
+                f32 weight = kaiser((static_cast<f32>(s) + 0.5f - center) / scale);
+                if (weight == 0.0f) {
+                    continue;
+                }
+
+                // Clamp to edge
+                taps.indices.push_back(static_cast<u32>(std::clamp(s, 0, static_cast<i32>(src_size) - 1)));
+                taps.weights.push_back(weight);
+                weight_sum += weight;
+            }
+        }
+
+        for (u32 t = taps.first_tap.back(); t < static_cast<u32>(taps.weights.size()); ++t) {
+            taps.weights[t] /= weight_sum;
+        }
+    }
+
+    taps.first_tap.push_back(static_cast<u32>(taps.indices.size()));
+
+    return taps;
+}
+
+// Both passes work on RGBA f32 pixels
+static void filter_rows(const f32 *src, u32 src_width, f32 *dst, u32 dst_width, const FilterTaps &taps, u32 row_begin, u32 row_end) {
+    for (u32 y = row_begin; y < row_end; ++y) {
+        const f32 *src_row = src + static_cast<usize>(y) * src_width * 4u;
+        f32 *dst_row = dst + static_cast<usize>(y) * dst_width * 4u;
+
+        for (u32 x{}; x < dst_width; ++x) {
+#if MIP_GENERATOR_SSE2
+            __m128 acc = _mm_setzero_ps();
+            for (u32 t = taps.first_tap[x]; t < taps.first_tap[x + 1u]; ++t) {
+                acc = _mm_add_ps(acc, _mm_mul_ps(_mm_set1_ps(taps.weights[t]), _mm_loadu_ps(src_row + taps.indices[t] * 4u)));
+            }
+            _mm_storeu_ps(dst_row + x * 4u, acc);
+#else
+            f32 acc[4]{};
+            for (u32 t = taps.first_tap[x]; t < taps.first_tap[x + 1u]; ++t) {
+                for (u32 c{}; c < 4u; ++c) {
+                    acc[c] += taps.weights[t] * src_row[taps.indices[t] * 4u + c];
+                }
+            }
+            std::memcpy(dst_row + x * 4u, acc, sizeof(acc));
+#endif
+        }
+    }
+}
+static void filter_columns(const f32 *src, f32 *dst, u32 width, const FilterTaps &taps, u32 row_begin, u32 row_end) {
+    usize row_floats = static_cast<usize>(width) * 4u;
+
+    for (u32 y = row_begin; y < row_end; ++y) {
+        f32 *dst_row = dst + y * row_floats;
+        std::fill(dst_row, dst_row + row_floats, 0.0f);
+
+        // Whole source rows are accumulated at once, which keeps the access pattern linear
+        for (u32 t = taps.first_tap[y]; t < taps.first_tap[y + 1u]; ++t) {
+            const f32 *src_row = src + taps.indices[t] * row_floats;
+            f32 weight = taps.weights[t];
+
+#if MIP_GENERATOR_SSE2
+            __m128 w = _mm_set1_ps(weight);
+            for (usize i{}; i < row_floats; i += 4u) {
+                _mm_storeu_ps(dst_row + i, _mm_add_ps(_mm_loadu_ps(dst_row + i), _mm_mul_ps(w, _mm_loadu_ps(src_row + i))));
+            }
+#else
+            for (usize i{}; i < row_floats; ++i) {
+                dst_row[i] += weight * src_row[i];
+            }
+#endif
+        }
+    }
+}
+
+static f32 calculate_alpha_coverage(const std::vector<u32> &histogram, usize pixel_count, f32 alpha_cutoff, f32 scale) {
+    // Pixels with alpha * scale >= cutoff
+    f32 threshold = alpha_cutoff / scale;
+    u32 first_bin = static_cast<u32>(std::clamp(std::ceil(threshold * static_cast<f32>(ALPHA_HISTOGRAM_SIZE - 1u)), 0.0f, static_cast<f32>(ALPHA_HISTOGRAM_SIZE)));
+
+    usize covered{};
+    for (u32 i = first_bin; i < ALPHA_HISTOGRAM_SIZE; ++i) {
+        covered += histogram[i];
+    }
+
+    return static_cast<f32>(covered) / static_cast<f32>(pixel_count);
+}
+static std::vector<u32> build_alpha_histogram(const std::vector<f32> &pixels) {
+    std::vector<u32> histogram(ALPHA_HISTOGRAM_SIZE);
+    for (usize i = 3u; i < pixels.size(); i += 4u) {
+        histogram[static_cast<u32>(std::clamp(pixels[i], 0.0f, 1.0f) * static_cast<f32>(ALPHA_HISTOGRAM_SIZE - 1u) + 0.5f)]++;
+    }
+
+    return histogram;
+}
+static f32 find_alpha_scale(const std::vector<f32> &pixels, f32 alpha_cutoff, f32 target_coverage) {
+    std::vector<u32> histogram = build_alpha_histogram(pixels);
+    usize pixel_count = pixels.size() / 4u;
+
+    // Coverage grows with the scale, so a bisection converges to the closest match
+    f32 low = 0.0f, high = 4.0f;
+    for (u32 i{}; i < 16u; ++i) {
+        f32 mid = (low + high) * 0.5f;
+
+        if (calculate_alpha_coverage(histogram, pixel_count, alpha_cutoff, mid) < target_coverage) {
+            low = mid;
+        } else {
+            high = mid;
+        }
+    }
+
+    return (low + high) * 0.5f;
+}
+
+static void convert_to_linear(const MipGenerateInfo &info, std::vector<f32> &dst) {
+    const auto &srgb_table = get_srgb_to_linear_table();
+    u32 color_channels = (info.channels == 4u) ? 3u : info.channels;
+
+    dst.resize(static_cast<usize>(info.width) * info.height * 4u);
+
+    for_each_row_block(info.height, info.multithreaded, [&](u32 row_begin, u32 row_end) {
+        for (usize i = static_cast<usize>(row_begin) * info.width; i < static_cast<usize>(row_end) * info.width; ++i) {
+            const u8 *src = info.pixels + i * info.channels;
+            f32 *pixel = dst.data() + i * 4u;
+
+            pixel[0] = 0.0f;
+            pixel[1] = 0.0f;
+            pixel[2] = 0.0f;
+            pixel[3] = 1.0f;
+
+            for (u32 c{}; c < info.channels; ++c) {
+                pixel[c] = (info.is_srgb && c < color_channels) ? srgb_table[src[c]] : static_cast<f32>(src[c]) / 255.0f;
+            }
+        }
+    });
+}
+static void convert_to_u8(const MipGenerateInfo &info, const std::vector<f32> &src, u32 width, u32 height, f32 alpha_scale, u8 *dst) {
+    const auto &srgb_table = get_linear_to_srgb_table();
+    u32 color_channels = (info.channels == 4u) ? 3u : info.channels;
+
+    for_each_row_block(height, info.multithreaded, [&](u32 row_begin, u32 row_end) {
+        for (usize i = static_cast<usize>(row_begin) * width; i < static_cast<usize>(row_end) * width; ++i) {
+            const f32 *pixel = src.data() + i * 4u;
+            u8 *out = dst + i * info.channels;
+
+            for (u32 c{}; c < info.channels; ++c) {
+                f32 value = std::clamp((c == 3u) ? pixel[c] * alpha_scale : pixel[c], 0.0f, 1.0f);
+
+                if (info.is_srgb && c < color_channels) {
+                    out[c] = srgb_table[static_cast<u32>(value * 65535.0f + 0.5f)];
+                } else {
+                    out[c] = static_cast<u8>(value * 255.0f + 0.5f);
+                }
+            }
+        }
+    });
+}
+
+std::vector<MipLevel> MipGenerator::calculate_levels(u32 width, u32 height, u32 channels) {
+    std::vector<MipLevel> levels{};
+
+    usize offset{};
+    u32 level_count = Utils::calculate_mipmap_levels_xy(width, height);
+    for (u32 i{}; i < level_count; ++i) {
+        usize size = static_cast<usize>(width) * height * channels;
+        levels.push_back(MipLevel{ .offset = offset, .size = size, .width = width, .height = height });
+
+        offset += size;
+        width = std::max(1u, width / 2u);
+        height = std::max(1u, height / 2u);
+    }
+
+    return levels;
+}
+usize MipGenerator::calculate_chain_size(u32 width, u32 height, u32 channels) {
+    const auto levels = calculate_levels(width, height, channels);
+    return levels.back().offset + levels.back().size;
+}
+usize MipGenerator::calculate_working_set_size(u32 width, u32 height) {
+    // The full size level, the horizontally filtered half and the quarter size result, the buffers never shrink when swapped
+    usize level_size = static_cast<usize>(width) * height * 4u * sizeof(f32);
+    return level_size + level_size / 2u + level_size / 4u;
+}
+
+MipChain MipGenerator::generate(const MipGenerateInfo &info) {
+    MipChain chain{
+        .levels = calculate_levels(info.width, info.height, info.channels)
+    };
+
+    chain.bytes.resize(chain.levels.back().offset + chain.levels.back().size);
+    generate_into(info, chain.bytes.data());
+
+    return chain;
+}
+void MipGenerator::generate_into(const MipGenerateInfo &info, u8 *dst) {
+    DEBUG_ASSERT(info.pixels != nullptr && info.width > 0u && info.height > 0u)
+    DEBUG_ASSERT(info.channels >= 1u && info.channels <= 4u)
+
+    const auto levels = calculate_levels(info.width, info.height, info.channels);
+
+    std::memcpy(dst, info.pixels, levels[0].size);
+    if (levels.size() == 1u) {
+        return;
+    }
+
+    bool preserve_alpha_coverage = info.preserve_alpha_coverage && info.channels == 4u;
+
+    std::vector<f32> current{}, horizontal{}, next{};
+    convert_to_linear(info, current);
+
+    f32 target_coverage{};
+    if (preserve_alpha_coverage) {
+        target_coverage = calculate_alpha_coverage(build_alpha_histogram(current), current.size() / 4u, info.alpha_cutoff, 1.0f);
+    }
+
+    for (u32 level = 1u; level < static_cast<u32>(levels.size()); ++level) {
+        u32 src_w = levels[level - 1u].width, src_h = levels[level - 1u].height;
+        u32 dst_w = levels[level].width, dst_h = levels[level].height;
+
+        FilterTaps horizontal_taps = build_taps(info.filter, src_w, dst_w);
+        FilterTaps vertical_taps = build_taps(info.filter, src_h, dst_h);
+
+        horizontal.resize(static_cast<usize>(dst_w) * src_h * 4u);
+        next.resize(static_cast<usize>(dst_w) * dst_h * 4u);
+
+        for_each_row_block(src_h, info.multithreaded, [&](u32 row_begin, u32 row_end) {
+            filter_rows(current.data(), src_w, horizontal.data(), dst_w, horizontal_taps, row_begin, row_end);
+        });
+        for_each_row_block(dst_h, info.multithreaded, [&](u32 row_begin, u32 row_end) {
+            filter_columns(horizontal.data(), next.data(), dst_w, vertical_taps, row_begin, row_end);
+        });
+
+        // The unscaled level is kept as the source of the next one, otherwise the alpha scale would compound
+        f32 alpha_scale = preserve_alpha_coverage ? find_alpha_scale(next, info.alpha_cutoff, target_coverage) : 1.0f;
+        convert_to_u8(info, next, dst_w, dst_h, alpha_scale, dst + levels[level].offset);
+
+        std::swap(current, next);
+    }
+}
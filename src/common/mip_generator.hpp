@@ -0,0 +1,54 @@
+#ifndef GEMINO_MIP_GENERATOR_HPP
+#define GEMINO_MIP_GENERATOR_HPP
+
+#include <common/types.hpp>
+#include <common/debug.hpp>
+
+#include <vector>
+
+enum struct MipFilter : u32 {
+    Box, // Area average, also correct for odd sizes
+    Kaiser, // Kaiser windowed sinc (width 3, alpha 4), sharper than Box
+};
+
+struct MipGenerateInfo {
+    const u8 *pixels{}; // Tightly packed, 'channels' bytes per pixel
+    u32 width{};
+    u32 height{};
+    u32 channels = 4u; // 1 to 4
+
+    bool is_srgb = false; // Color channels are filtered in linear space, alpha is always linear
+    MipFilter filter = MipFilter::Kaiser;
+
+    bool preserve_alpha_coverage = false; // Only with 4 channels, keeps the fraction of pixels with alpha >= 'alpha_cutoff' constant across mips
+    f32 alpha_cutoff = 0.5f;
+
+    bool multithreaded = true; // Disable when generating many chains in parallel already
+};
+
+struct MipLevel {
+    usize offset{}; // Relative to the start of the chain
+    usize size{};
+    u32 width{};
+    u32 height{};
+};
+
+struct MipChain {
+    std::vector<MipLevel> levels{};
+    std::vector<u8> bytes{};
+};
+
+// CPU mip chain generator, the whole chain is tightly packed so that it can be uploaded with a single copy
+namespace MipGenerator {
+    std::vector<MipLevel> calculate_levels(u32 width, u32 height, u32 channels);
+    usize calculate_chain_size(u32 width, u32 height, u32 channels);
+    // Peak host memory of the f32 RGBA buffers generate_into() allocates, excluding 'pixels' and 'dst'
+    usize calculate_working_set_size(u32 width, u32 height);
+
+    MipChain generate(const MipGenerateInfo &info);
+
+    // Writes the chain laid out as in calculate_levels() to 'dst', which is never read from (can be mapped write-combined memory)
+    void generate_into(const MipGenerateInfo &info, u8 *dst);
+}
+
+#endif
@@ -6,6 +6,7 @@
 #include <vector>
 #include <unordered_set>
 #include <set>
+#include <algorithm>
 
 template<typename T>
 struct Range {
@@ -71,6 +72,7 @@ public:
         range.count = count;
 
         m_valid_ranges.insert(range);
+        m_high_water_mark = std::max(m_high_water_mark, range.start + count);
 
         if (alloc_type == RangeAllocatorType::InPlace) {
             if (data != nullptr) {
@@ -181,6 +183,10 @@ public:
     const std::set<Range<T>> &get_free_ranges() const {
         return m_free_ranges;
     }
+    // One past the highest element ever allocated, doesn't decrease when ranges are freed
+    u32 get_high_water_mark() const {
+        return m_high_water_mark;
+    }
 
 private:
     Range<T> find_free_range(u32 count) {
@@ -197,6 +203,7 @@ private:
     std::set<Range<T>> m_free_ranges{};
     std::unordered_set<Range<T>> m_valid_ranges{};
     std::vector<T> m_elements{};
+    u32 m_high_water_mark{};
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,100 @@
+#ifndef GEMINO_RESOURCE_REGISTRY_HPP
+#define GEMINO_RESOURCE_REGISTRY_HPP
+
+#include <common/handle_allocator.hpp>
+#include <common/types.hpp>
+
+#include <unordered_map>
+#include <cstring>
+#include <type_traits>
+
+// Maps content hashes to handles and counts how many users share every registered handle
+// Key holds a few cheap properties of the content (sizes, counts), a hash hit with a different key is a collision and counts as a miss
+template <typename T, typename Key>
+class ResourceRegistry {
+    static_assert(std::is_trivially_copyable_v<Key>, "ResourceRegistry - Keys are compared bytewise!");
+
+public:
+    // Adds a reference to the handle registered with 'hash' and 'key', returns INVALID_HANDLE if there is none
+    Handle<T> acquire(u64 hash, const Key &key) {
+        auto it = m_handles.find(hash);
+        if (it == m_handles.end()) {
+            return INVALID_HANDLE;
+        }
+
+        Entry &entry = m_entries.at(it->second);
+        if (std::memcmp(&entry.key, &key, sizeof(Key)) != 0) {
+            DEBUG_WARNING("ResourceRegistry - Hash " << hash << " collision, the resource won't be shared!")
+            return INVALID_HANDLE;
+        }
+
+        ++entry.ref_count;
+        ++m_reference_count;
+
+        return it->second;
+    }
+
+    // Registers a newly created handle with a single reference
+    // After a collision in acquire() the handle isn't registered, the hash stays with the first resource and release() always frees the new one
+    void add(u64 hash, const Key &key, Handle<T> handle) {
+        if (auto it = m_handles.find(hash); it != m_handles.end()) {
+            if (std::memcmp(&m_entries.at(it->second).key, &key, sizeof(Key)) == 0) {
+                DEBUG_PANIC("ResourceRegistry - Hash " << hash << " is already registered!")
+            }
+
+            return;
+        }
+        if (m_entries.contains(handle)) {
+            DEBUG_PANIC("ResourceRegistry - Handle " << handle << " is already registered!")
+        }
+
+        m_handles[hash] = handle;
+        m_entries[handle] = Entry{ .hash = hash, .key = key, .ref_count = 1u };
+        ++m_reference_count;
+    }
+
+    // Removes a reference, returns true if it was the last one and the resource should be freed
+    // Handles that were never registered are always freed
+    bool release(Handle<T> handle) {
+        auto it = m_entries.find(handle);
+        if (it == m_entries.end()) {
+            return true;
+        }
+
+        --m_reference_count;
+        if (--it->second.ref_count > 0u) {
+            return false;
+        }
+
+        m_handles.erase(it->second.hash);
+        m_entries.erase(it);
+
+        return true;
+    }
+
+    [[nodiscard]] u32 get_ref_count(Handle<T> handle) const {
+        auto it = m_entries.find(handle);
+        return (it == m_entries.end()) ? 0u : it->second.ref_count;
+    }
+
+    [[nodiscard]] u32 get_handle_count() const {
+        return static_cast<u32>(m_entries.size());
+    }
+    [[nodiscard]] u32 get_reference_count() const {
+        return m_reference_count;
+    }
+
+private:
+    struct Entry {
+        u64 hash{};
+        Key key{};
+        u32 ref_count{};
+    };
+
+    std::unordered_map<u64, Handle<T>> m_handles{};
+    std::unordered_map<Handle<T>, Entry> m_entries{};
+
+    u32 m_reference_count{};
+};
+
+#endif
@@ -0,0 +1,74 @@
+#ifndef GEMINO_SPARSE_SET_HPP
+#define GEMINO_SPARSE_SET_HPP
+
+#include <common/types.hpp>
+
+#include <vector>
+#include <unordered_set>
+
+// Unordered set of ids packed into a dense array, removal swaps the last id into the freed slot
+// Remembers which dense slots changed so that a GPU copy of the array can be kept up to date incrementally
+class SparseSet {
+public:
+    // Returns false if the id was already present
+    bool insert(u32 id) {
+        if (contains(id)) {
+            return false;
+        }
+
+        if (id >= m_slots.size()) {
+            m_slots.resize(id + 1u, INVALID_SLOT);
+        }
+
+        m_slots[id] = static_cast<u32>(m_ids.size());
+        m_changed_slots.insert(m_slots[id]);
+        m_ids.push_back(id);
+
+        return true;
+    }
+
+    // Returns false if the id wasn't present
+    bool erase(u32 id) {
+        if (!contains(id)) {
+            return false;
+        }
+
+        u32 slot = m_slots[id];
+        u32 last_id = m_ids.back();
+
+        m_ids[slot] = last_id;
+        m_slots[last_id] = slot;
+        m_ids.pop_back();
+
+        m_slots[id] = INVALID_SLOT;
+
+        // Slots past the end are reported too, they can be ignored
+        m_changed_slots.insert(slot);
+        m_changed_slots.insert(static_cast<u32>(m_ids.size()));
+
+        return true;
+    }
+
+    [[nodiscard]] bool contains(u32 id) const {
+        return id < m_slots.size() && m_slots[id] != INVALID_SLOT;
+    }
+
+    void clear_changed_slots(const std::vector<u32> &slots) {
+        for (const auto &slot : slots) {
+            m_changed_slots.erase(slot);
+        }
+    }
+
+    [[nodiscard]] const std::vector<u32> &get_ids() const { return m_ids; }
+    [[nodiscard]] const std::unordered_set<u32> &get_changed_slots() const { return m_changed_slots; }
+    [[nodiscard]] u32 size() const { return static_cast<u32>(m_ids.size()); }
+
+private:
+    static constexpr u32 INVALID_SLOT = 0xFFFFFFFFu;
+
+    std::vector<u32> m_ids{};
+    std::vector<u32> m_slots{}; // Indexed with the id
+    std::unordered_set<u32> m_changed_slots{};
+};
+
+#endif
@@ -1,5 +1,8 @@
 #include "utils.hpp"
 
+#include <atomic>
+#include <thread>
+
 u32 Utils::nearest_pot_floor(u32 x) {
     return (1U << static_cast<u32>(std::floor(std::log2(x))));
 }
@@ -75,3 +78,104 @@ std::string Utils::get_directory(const std::string &path) {
         return "/";
     }
 }
+
+void Utils::parallel_for(u32 count, const std::function<void(u32)> &fn) {
+    if (count == 0u) return;
+
+    u32 thread_count = std::min(std::max(std::thread::hardware_concurrency(), 1u), count);
+    if (thread_count == 1u) {
+        for (u32 i{}; i < count; ++i) {
+            fn(i);
+        }
+
+        return;
+    }
+
+    // Work items are pulled from a shared counter so that uneven items don't stall a whole thread
+    std::atomic<u32> next_item{};
+    auto worker = [&next_item, &fn, count]() {
+        for (u32 i = next_item.fetch_add(1u, std::memory_order_relaxed); i < count; i = next_item.fetch_add(1u, std::memory_order_relaxed)) {
+            fn(i);
+        }
+    };
+
+    std::vector<std::thread> threads{};
+    threads.reserve(thread_count - 1u);
+    for (u32 i{}; i < thread_count - 1u; ++i) {
+        threads.emplace_back(worker);
+    }
+
+    worker();
+
+    for (auto &thread : threads) {
+        thread.join();
+    }
+}
+
+static constexpr u64 HASH_PRIME_1 = 0x9E3779B185EBCA87ull;
+static constexpr u64 HASH_PRIME_2 = 0xC2B2AE3D27D4EB4Full;
+static constexpr u64 HASH_PRIME_3 = 0x165667B19E3779F9ull;
+static constexpr u64 HASH_PRIME_4 = 0x85EBCA77C2B2AE63ull;
+static constexpr u64 HASH_PRIME_5 = 0x27D4EB2F165667C5ull;
+
+static u64 hash_rotl(u64 x, u32 r) {
+    return (x << r) | (x >> (64u - r));
+}
+static u64 hash_read_u64(const u8 *bytes) {
+    u64 value;
+    std::memcpy(&value, bytes, sizeof(u64));
+    return value;
+}
+static u64 hash_round(u64 acc, u64 value) {
+    return hash_rotl(acc + value * HASH_PRIME_2, 31u) * HASH_PRIME_1;
+}
+static u64 hash_merge_round(u64 acc, u64 value) {
+    return (acc ^ hash_round(0ull, value)) * HASH_PRIME_1 + HASH_PRIME_4;
+}
+
+u64 Utils::hash_bytes(const void *data, usize size, u64 seed) {
+    const u8 *bytes = static_cast<const u8 *>(data);
+    const u8 *end = bytes + size;
+
+    u64 hash;
+
+    // Four independent lanes so that the multiplies of consecutive words don't depend on each other
+    if (size >= 32u) {
+        u64 v1 = seed + HASH_PRIME_1 + HASH_PRIME_2;
+        u64 v2 = seed + HASH_PRIME_2;
+        u64 v3 = seed;
+        u64 v4 = seed - HASH_PRIME_1;
+
+        for (; bytes + 32u <= end; bytes += 32u) {
+            v1 = hash_round(v1, hash_read_u64(bytes));
+            v2 = hash_round(v2, hash_read_u64(bytes + 8u));
+            v3 = hash_round(v3, hash_read_u64(bytes + 16u));
+            v4 = hash_round(v4, hash_read_u64(bytes + 24u));
+        }
+
+        hash = hash_rotl(v1, 1u) + hash_rotl(v2, 7u) + hash_rotl(v3, 12u) + hash_rotl(v4, 18u);
+        hash = hash_merge_round(hash, v1);
+        hash = hash_merge_round(hash, v2);
+        hash = hash_merge_round(hash, v3);
+        hash = hash_merge_round(hash, v4);
+    } else {
+        hash = seed + HASH_PRIME_5;
+    }
+
+    hash += static_cast<u64>(size);
+
+    for (; bytes + 8u <= end; bytes += 8u) {
+        hash = hash_rotl(hash ^ hash_round(0ull, hash_read_u64(bytes)), 27u) * HASH_PRIME_1 + HASH_PRIME_4;
+    }
+    for (; bytes < end; ++bytes) {
+        hash = hash_rotl(hash ^ (static_cast<u64>(*bytes) * HASH_PRIME_5), 11u) * HASH_PRIME_1;
+    }
+
+    hash ^= hash >> 33u;
+    hash *= HASH_PRIME_2;
+    hash ^= hash >> 29u;
+    hash *= HASH_PRIME_3;
+    hash ^= hash >> 32u;
+
+    return hash;
+}
@@ -9,6 +9,7 @@
 #include <cstring>
 #include <fstream>
 #include <unordered_map>
+#include <functional>
 
 namespace Utils {
     u32 nearest_pot_floor(u32 x);
@@ -23,6 +24,19 @@ namespace Utils {
     std::string get_file_name(const std::string &path, bool with_extension = true);
     std::string get_directory(const std::string &path);
 
+    // Calls fn(i) for every i in [0, count) on all hardware threads and blocks until all calls have returned
+    void parallel_for(u32 count, const std::function<void(u32)> &fn);
+
+    // 64-bit content hash (xxHash64 style), not suitable for cryptographic use
+    u64 hash_bytes(const void *data, usize size, u64 seed = 0ull);
+
+    constexpr u64 hash_combine(u64 seed, u64 value) {
+        u64 x = seed ^ (value + 0x9E3779B97F4A7C15ull + (seed << 6) + (seed >> 2));
+        x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+        x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+        return x ^ (x >> 31);
+    }
+
     constexpr usize align(usize alignment, usize size) {
         return ((size - 1) / alignment + 1) * alignment;
     }
@@ -1,6 +1,7 @@
 #include "editor.hpp"
 
 #include <algorithm>
+#include <map>
 #include <imgui.h>
 #include <implot.h>
 #include <ImGuiProfilerRenderer.h>
@@ -11,6 +12,12 @@ static bool g_config_window_open = true;
 static bool g_frametime_window_open = true;
 static Renderer *g_renderer_ptr = nullptr;
 
+static constexpr std::array GBUFFER_LAYOUT_NAMES {
+    "Full (RGBA32F normals)",
+    "Octahedral (RG16 SNORM normals)",
+    "Octahedral (RGB10A2 normals)"
+};
+
 struct GPUMemoryElement {
     std::string format{};
     usize bytes{};
@@ -59,15 +66,28 @@ void Editor::draw_gpu_memory_usage_window(Renderer &renderer, World &world) {
     std::vector<GPUMemoryElement> pre_allocated_gpu_memory_elements{
         {"Bindless Texture Descriptor       : %.02f mb", renderer.MAX_SCENE_TEXTURES * 96},     // https://gist.github.com/nanokatze/bb03a486571e13a7b6a8709368bd87cf#file-04-descriptors-md
         {"Scene Material Buffer             : %.02f mb", renderer.MAX_SCENE_MATERIALS * sizeof(Material)},
-        {"Scene Vertex Buffer               : %.02f mb", renderer.MAX_SCENE_VERTICES * sizeof(Vertex)},
+        {"Scene Vertex Buffer               : %.02f mb", renderer.MAX_SCENE_VERTEX_BLOCKS * sizeof(VertexBlock)},
         {"Scene Index Buffer                : %.02f mb", renderer.MAX_SCENE_INDICES * sizeof(u32)},
+        {"Scene 16-bit Index Buffer         : %.02f mb", renderer.MAX_SCENE_INDICES16 * sizeof(u16)},
         {"Scene Mesh Buffer                 : %.02f mb", renderer.MAX_SCENE_MESHES * sizeof(Mesh)},
         {"Scene MeshInstance Buffer         : %.02f mb", renderer.MAX_SCENE_MESH_INSTANCES * sizeof(MeshInstance)},
         {"Scene MeshInstance Material Buffer: %.02f mb", renderer.MAX_SCENE_MESH_INSTANCE_MATERIALS * sizeof(Handle<Material>)},
         {"Scene Primitive Buffer            : %.02f mb", renderer.MAX_SCENE_PRIMITIVES * sizeof(Primitive)},
         {"Scene Object Buffer               : %.02f mb", renderer.MAX_SCENE_OBJECTS * sizeof(Object)},
+        {"Scene Renderable Object Buffer    : %.02f mb", renderer.MAX_SCENE_OBJECTS * sizeof(u32)},
         {"Scene Global Transform Buffer     : %.02f mb", renderer.MAX_SCENE_OBJECTS * sizeof(Transform)},
         {"Scene Draw Buffer                 : %.02f mb", renderer.MAX_SCENE_DRAWS * sizeof(DrawCommand)},
+        {"Scene Late Draw Buffer            : %.02f mb", renderer.MAX_SCENE_DRAWS * sizeof(DrawCommand)},
+        {"Scene Draw Instance Buffers       : %.02f mb", renderer.MAX_SCENE_DRAW_INSTANCES * sizeof(DrawInstance) * 2ull},
+        {"Scene Visible Instance Buffer     : %.02f mb", renderer.MAX_SCENE_VISIBLE_INSTANCES * sizeof(VisibleInstance)},
+        {"Scene Draw Bucket Buffers         : %.02f mb", renderer.MAX_SCENE_DRAW_BUCKETS * GPU_MAX_VIEW_COUNT * sizeof(u32) * 2ull},
+        {"Scene View Buffer                 : %.02f mb", GPU_MAX_VIEW_COUNT * sizeof(Camera)},
+        {"Scene Visibility Buffer           : %.02f mb", Utils::div_ceil(renderer.MAX_SCENE_OBJECTS, 32ull) * sizeof(u32)},
+        {"Scene Meshlet Buffer              : %.02f mb", renderer.MAX_SCENE_MESHLETS * sizeof(Meshlet)},
+        {"Scene Cluster Cull Job Buffer     : %.02f mb", renderer.MAX_SCENE_CLUSTER_JOBS * sizeof(ClusterCullJob)},
+        {"Scene Cluster Index Buffer        : %.02f mb", renderer.MAX_SCENE_CLUSTER_INDICES * sizeof(u32)},
+        {"Scene Light Buffer                : %.02f mb", renderer.MAX_SCENE_LIGHTS * sizeof(Light)},
+        {"Scene Light Cluster Buffers       : %.02f mb", GPU_LIGHT_CLUSTER_COUNT * (GPU_LIGHT_CLUSTER_MAX_LIGHTS + 1ull) * sizeof(u32)},
     };
 
     usize pre_allocated_total_size{};
@@ -86,22 +106,32 @@ void Editor::draw_gpu_memory_usage_window(Renderer &renderer, World &world) {
     std::vector<GPUMemoryElement> used_gpu_memory_elements{
         {"Allocated Textures              : %.04f / %.04f mb", 0, 0},
         {"Allocated Materials             : %.04f / %.04f mb", renderer.get_material_allocator().get_valid_handles().size() * sizeof(Material), renderer.MAX_SCENE_MATERIALS * sizeof(Material)},
-        {"Allocated Vertices              : %.04f / %.04f mb", 0, renderer.MAX_SCENE_VERTICES * sizeof(Vertex)},
+        {"Allocated Vertices              : %.04f / %.04f mb", 0, renderer.MAX_SCENE_VERTEX_BLOCKS * sizeof(VertexBlock)},
         {"Allocated Indices               : %.04f / %.04f mb", 0, renderer.MAX_SCENE_INDICES * sizeof(u32) },
         {"Allocated Meshes                : %.04f / %.04f mb", renderer.get_mesh_allocator().get_valid_handles().size() * sizeof(Mesh), renderer.MAX_SCENE_MESHES * sizeof(Mesh) },
         {"Allocated MeshInstances         : %.04f / %.04f mb", renderer.get_mesh_instance_allocator().get_valid_handles().size() * sizeof(MeshInstance), renderer.MAX_SCENE_MESH_INSTANCES * sizeof(MeshInstance) },
         {"Allocated MeshInstance Materials: %.04f / %.04f mb", 0, renderer.MAX_SCENE_MESH_INSTANCE_MATERIALS * sizeof(Handle<Material>) },
         {"Allocated Primitives            : %.04f / %.04f mb", 0, renderer.MAX_SCENE_PRIMITIVES * sizeof(Primitive) },
         {"Allocated Objects               : %.04f / %.04f mb", world.get_valid_object_handles().size() * sizeof(Object), renderer.MAX_SCENE_OBJECTS * sizeof(Object) },
+        {"Renderable Objects              : %.04f / %.04f mb", renderer.get_renderable_object_count() * sizeof(u32), renderer.MAX_SCENE_OBJECTS * sizeof(u32) },
         {"Allocated Global Transforms     : %.04f / %.04f mb", world.get_valid_object_handles().size() * sizeof(Transform), renderer.MAX_SCENE_DRAWS * sizeof(DrawCommand) },
+        {"Allocated Lights                : %.04f / %.04f mb", world.get_valid_light_handles().size() * sizeof(Light), renderer.MAX_SCENE_LIGHTS * sizeof(Light) },
+        {"Allocated Meshlets              : %.04f / %.04f mb", 0, renderer.MAX_SCENE_MESHLETS * sizeof(Meshlet) },
+        {"Allocated 16-bit Indices        : %.04f / %.04f mb", 0, renderer.MAX_SCENE_INDICES16 * sizeof(u16) },
     };
 
+    std::map<VkFormat, std::pair<usize, u32>> texture_memory_by_format{};
     for(const auto &elem : renderer.get_texture_allocator().get_valid_handles()) {
         const Texture &texture = renderer.get_texture_allocator().get_element(elem);
 
+        auto &[format_bytes, format_count] = texture_memory_by_format[texture.format];
+        format_count++;
+
         u32 w = texture.width, h = texture.height;
         for(u32 i{}; i < texture.mip_level_count; ++i) {
-            used_gpu_memory_elements[0].bytes += w * h * texture.bytes_per_pixel;
+            usize mip_size = (i >= texture.resident_mip) ? TextureFile::calculate_level_size(texture.format, w, h) : 0U;
+            used_gpu_memory_elements[0].bytes += mip_size;
+            format_bytes += mip_size;
 
             w = std::max(1u, w / 2u);
             h = std::max(1u, h / 2u);
@@ -109,7 +139,7 @@ void Editor::draw_gpu_memory_usage_window(Renderer &renderer, World &world) {
     }
 
     for(const auto &[start, count] : renderer.get_vertex_allocator().get_valid_ranges()) {
-        used_gpu_memory_elements[2].bytes += count * sizeof(Vertex);
+        used_gpu_memory_elements[2].bytes += count * sizeof(VertexBlock);
     }
     for(const auto &[start, count] : renderer.get_index_allocator().get_valid_ranges()) {
         used_gpu_memory_elements[3].bytes += count * sizeof(u32);
@@ -120,6 +150,12 @@ void Editor::draw_gpu_memory_usage_window(Renderer &renderer, World &world) {
     for(const auto &[start, count] : renderer.get_primitive_allocator().get_valid_ranges()) {
         used_gpu_memory_elements[7].bytes += count * sizeof(Primitive);
     }
+    for(const auto &[start, count] : renderer.get_meshlet_allocator().get_valid_ranges()) {
+        used_gpu_memory_elements[10].bytes += count * sizeof(Meshlet);
+    }
+    for(const auto &[start, count] : renderer.get_index16_allocator().get_valid_ranges()) {
+        used_gpu_memory_elements[11].bytes += count * sizeof(u16);
+    }
 
     usize used_total_size{};
     for (const auto &[format, bytes, capacity] : used_gpu_memory_elements) {
@@ -132,6 +168,31 @@ void Editor::draw_gpu_memory_usage_window(Renderer &renderer, World &world) {
     ImGui::Spacing();
     ImGui::Text("Total: %.02f mb", static_cast<f32>(used_total_size) / 1024.0f / 1024.0f);
 
+    ImGui::SeparatorText("Texture memory by format");
+
+    for(const auto &[format, data] : texture_memory_by_format) {
+        const auto &[bytes, count] = data;
+
+        sprintf(buf, "%-16s: %.04f mb (%u textures)", TextureFile::get_format_name(format), static_cast<f32>(bytes) / 1024.0f / 1024.0f, count);
+        ImGui::Text(buf);
+    }
+
+    ImGui::SeparatorText("Texture streaming");
+
+    sprintf(buf, "Streamed textures: %zu", renderer.get_streamed_texture_count());
+    ImGui::Text(buf);
+    sprintf(buf, "Resident          : %.04f / %u mb", static_cast<f32>(renderer.get_streamed_texture_resident_bytes()) / 1024.0f / 1024.0f, renderer.get_shared_objects().config_texture_streaming_budget_mb);
+    ImGui::Text(buf);
+
+    ImGui::SeparatorText("Shared resources");
+
+    sprintf(buf, "Meshes   : %u unique, %u references", renderer.get_mesh_registry().get_handle_count(), renderer.get_mesh_registry().get_reference_count());
+    ImGui::Text(buf);
+    sprintf(buf, "Textures : %u unique, %u references", renderer.get_texture_registry().get_handle_count(), renderer.get_texture_registry().get_reference_count());
+    ImGui::Text(buf);
+    sprintf(buf, "Materials: %u unique, %u references", renderer.get_material_registry().get_handle_count(), renderer.get_material_registry().get_reference_count());
+    ImGui::Text(buf);
+
     ImGui::End();
 }
 
@@ -164,6 +225,61 @@ void Editor::draw_frametime_window(Renderer &renderer) {
 
     }
 
+    if(ImGui::CollapsingHeader("Occlusion Culling")) {
+        if(renderer.get_shared_objects().config_enable_occlusion_cull) {
+            const OcclusionCullStats &stats = renderer.get_occlusion_cull_stats();
+
+            sprintf(buf, "Visible objects    : %u", stats.visible_object_count); ImGui::Text(buf);
+            sprintf(buf, "Occluded objects   : %u", stats.occluded_object_count); ImGui::Text(buf);
+            sprintf(buf, "Disoccluded objects: %u", stats.disoccluded_object_count); ImGui::Text(buf);
+        } else {
+            ImGui::Text("Occlusion culling is disabled");
+        }
+    }
+
+    if(ImGui::CollapsingHeader("Render Graph")) {
+        const RenderGraph &render_graph = renderer.get_render_graph();
+
+        f64 transient_mb = static_cast<f64>(render_graph.get_transient_memory_size()) / 1024.0 / 1024.0;
+        f64 transient_unaliased_mb = static_cast<f64>(render_graph.get_transient_memory_size_unaliased()) / 1024.0 / 1024.0;
+
+        sprintf(buf, "Transient image memory: %.02f mb (%.02f mb without aliasing)", transient_mb, transient_unaliased_mb); ImGui::Text(buf);
+        sprintf(buf, "Barriers per frame    : %u", render_graph.get_barrier_count()); ImGui::Text(buf);
+    }
+
+    // Passes that read or write the G-Buffer, averaged per layout so that they can be compared after switching
+    static constexpr std::array GBUFFER_PASS_NAMES { "Geometry Pass", "Late Geometry Pass", "Material Pass", "SSAO Pass", "Composite Pass" };
+    static std::array<f64, GBUFFER_LAYOUT_NAMES.size()> avg_gbuffer_pass_times{};
+
+    f64 gbuffer_pass_time{};
+    for(const auto &name : GBUFFER_PASS_NAMES) {
+        const auto &[start, end] = renderer.get_gpu_timing().at(name).second;
+        gbuffer_pass_time += end - start;
+    }
+
+    auto gbuffer_layout_id = static_cast<u32>(renderer.get_shared_objects().config_gbuffer_layout);
+    f64 &avg_gbuffer_pass_time = avg_gbuffer_pass_times[gbuffer_layout_id];
+    avg_gbuffer_pass_time = (avg_gbuffer_pass_time == 0.0) ? gbuffer_pass_time : (avg_gbuffer_pass_time * 20.0 + gbuffer_pass_time) / 21.0;
+
+    if(ImGui::CollapsingHeader("G-Buffer")) {
+        ImVec2 display_size = ImGui::GetIO().DisplaySize;
+        f64 gbuffer_mb = static_cast<f64>(renderer.get_gbuffer_bytes_per_pixel()) * display_size.x * display_size.y / 1024.0 / 1024.0;
+
+        sprintf(buf, "Bytes per pixel: %u (%.02f mb per full write)", renderer.get_gbuffer_bytes_per_pixel(), gbuffer_mb); ImGui::Text(buf);
+        ImGui::Text("Average time of the passes touching the G-Buffer (delta to Full):");
+
+        for(u32 i{}; i < static_cast<u32>(GBUFFER_LAYOUT_NAMES.size()); ++i) {
+            if(avg_gbuffer_pass_times[i] == 0.0) {
+                sprintf(buf, "\t%s: not measured", GBUFFER_LAYOUT_NAMES[i]);
+            } else if(avg_gbuffer_pass_times[0] == 0.0) {
+                sprintf(buf, "\t%s: %.03fms", GBUFFER_LAYOUT_NAMES[i], static_cast<f32>(avg_gbuffer_pass_times[i]));
+            } else {
+                sprintf(buf, "\t%s: %.03fms (%+.03fms)", GBUFFER_LAYOUT_NAMES[i], static_cast<f32>(avg_gbuffer_pass_times[i]), static_cast<f32>(avg_gbuffer_pass_times[i] - avg_gbuffer_pass_times[0]));
+            }
+            ImGui::Text(buf);
+        }
+    }
+
     if(ImGui::CollapsingHeader("GPU Timing")) {
         static bool pause_gpu_profiler{};
         static u32 gpu_profile_frame_count = 100u;
@@ -187,6 +303,8 @@ void Editor::draw_frametime_window(Renderer &renderer) {
 
         sprintf(buf, "%s: %fms", "Total GPU Time", static_cast<f32>(full_frame)); ImGui::Text(buf);
 
+        const auto &async_compute_passes = renderer.get_async_compute_passes();
+
         u32 color_id{};
         for(const auto &[name, data] : renderer.get_gpu_timing()) {
             const auto &[queries, time_pair] = data;
@@ -195,12 +313,36 @@ void Editor::draw_frametime_window(Renderer &renderer) {
                 tasks.push_back(legit::ProfilerTask{
                     .startTime = time_pair.first - full_frame_start,
                     .endTime = time_pair.second - full_frame_start,
-                    .name = name,
+                    .name = async_compute_passes.contains(name) ? name + " (Async Compute)" : name,
                     .color = TASK_COLORS[(color_id++ * 3) % TASK_COLORS.size()],
                 });
             }
         }
 
+        // The compute queue timestamps run in parallel with the graphics passes, the overlap is the time saved by async compute
+        f64 async_compute_time{};
+        f64 async_compute_overlap{};
+        for(const auto &async_name : async_compute_passes) {
+            if(!renderer.get_gpu_timing().contains(async_name)) {
+                continue;
+            }
+
+            const auto &[async_start, async_end] = renderer.get_gpu_timing().at(async_name).second;
+            async_compute_time += async_end - async_start;
+
+            for(const auto &[name, data] : renderer.get_gpu_timing()) {
+                const auto &[queries, time_pair] = data;
+
+                if(name != "Total GPU Time" && !async_compute_passes.contains(name)) {
+                    async_compute_overlap += std::max(std::min(async_end, time_pair.second) - std::max(async_start, time_pair.first), 0.0);
+                }
+            }
+        }
+
+        if(!async_compute_passes.empty()) {
+            sprintf(buf, "Async Compute: %fms, overlapped with graphics: %fms", static_cast<f32>(async_compute_time), static_cast<f32>(async_compute_overlap)); ImGui::Text(buf);
+        }
+
         static f32 avg_full_frame = full_frame;
 
         if(!pause_gpu_profiler) {
@@ -250,8 +392,30 @@ void Editor::draw_config_window(Renderer &renderer) {
     f32 ssao_bias = shared.config_ssao_bias;
     f32 ssao_multiplier = shared.config_ssao_multiplier;
     i32 ssao_noise_scale_divider = static_cast<i32>(shared.config_ssao_noise_scale_divider);
-
-    if(ImGui::SliderInt("SSAO Samples", &ssao_samples, 2, 64)) {
+    bool enable_half_res_ssao = shared.config_enable_half_res_ssao;
+    i32 ssao_half_res_samples = static_cast<i32>(shared.config_ssao_half_res_samples);
+    f32 lod_error_threshold = shared.config_lod_error_threshold;
+    bool enable_cluster_cull = shared.config_enable_cluster_cull;
+    f32 cluster_cull_min_pixel_size = shared.config_cluster_cull_min_pixel_size;
+    bool enable_vertex_quantization = shared.config_enable_vertex_quantization;
+    bool enable_occlusion_cull = shared.config_enable_occlusion_cull;
+    bool enable_visibility_buffer = shared.config_enable_visibility_buffer;
+    i32 gbuffer_layout = static_cast<i32>(shared.config_gbuffer_layout);
+    bool enable_dynamic_resolution = shared.config_enable_dynamic_resolution;
+    f32 dynamic_resolution_target_ms = shared.config_dynamic_resolution_target_ms;
+    f32 dynamic_resolution_min_scale = shared.config_dynamic_resolution_min_scale;
+    bool enable_async_compute = shared.config_enable_async_compute;
+    bool enable_texture_streaming = shared.config_enable_texture_streaming;
+    i32 texture_streaming_budget_mb = static_cast<i32>(shared.config_texture_streaming_budget_mb);
+
+    if(ImGui::Checkbox("Half Resolution SSAO", &enable_half_res_ssao)) {
+        renderer.set_config_enable_half_res_ssao(enable_half_res_ssao);
+    }
+    if(enable_half_res_ssao) {
+        if(ImGui::SliderInt("SSAO Samples Per Frame", &ssao_half_res_samples, 4, 32)) {
+            renderer.set_config_ssao_half_res_samples(ssao_half_res_samples);
+        }
+    } else if(ImGui::SliderInt("SSAO Samples", &ssao_samples, 2, 64)) {
         renderer.set_config_ssao_samples(ssao_samples);
     }
     if(ImGui::SliderFloat("SSAO Radius", &ssao_radius, 0.0f, 8.0f)) {
@@ -266,6 +430,49 @@ void Editor::draw_config_window(Renderer &renderer) {
     if(ImGui::SliderInt("SSAO Noise Scale Divider", &ssao_noise_scale_divider, 1, 4)) {
         renderer.set_config_ssao_noise_scale_divider(ssao_noise_scale_divider);
     }
+    if(ImGui::SliderFloat("LOD Error Threshold (px)", &lod_error_threshold, 0.0f, 16.0f)) {
+        renderer.set_config_lod_error_threshold(lod_error_threshold);
+    }
+    if(ImGui::Checkbox("Cluster Culling", &enable_cluster_cull)) {
+        renderer.set_config_enable_cluster_cull(enable_cluster_cull);
+    }
+    if(ImGui::SliderFloat("Cluster Min Pixel Size", &cluster_cull_min_pixel_size, 0.0f, 8.0f)) {
+        renderer.set_config_cluster_cull_min_pixel_size(cluster_cull_min_pixel_size);
+    }
+    if(ImGui::Checkbox("Occlusion Culling", &enable_occlusion_cull)) {
+        renderer.set_config_enable_occlusion_cull(enable_occlusion_cull);
+    }
+    if(ImGui::Checkbox("Visibility Buffer", &enable_visibility_buffer)) {
+        renderer.set_config_enable_visibility_buffer(enable_visibility_buffer);
+    }
+    if(ImGui::Combo("G-Buffer Layout", &gbuffer_layout, GBUFFER_LAYOUT_NAMES.data(), static_cast<i32>(GBUFFER_LAYOUT_NAMES.size()))) {
+        renderer.set_config_gbuffer_layout(static_cast<GBufferLayout>(gbuffer_layout));
+    }
+    if(ImGui::Checkbox("Dynamic Resolution", &enable_dynamic_resolution)) {
+        renderer.set_config_enable_dynamic_resolution(enable_dynamic_resolution);
+    }
+    if(enable_dynamic_resolution) {
+        if(ImGui::SliderFloat("Target GPU Time (ms)", &dynamic_resolution_target_ms, 1.0f, 50.0f)) {
+            renderer.set_config_dynamic_resolution_target_ms(dynamic_resolution_target_ms);
+        }
+        if(ImGui::SliderFloat("Min Resolution Scale", &dynamic_resolution_min_scale, 0.25f, 1.0f)) {
+            renderer.set_config_dynamic_resolution_min_scale(dynamic_resolution_min_scale);
+        }
+
+        ImGui::Text("Resolution Scale: %.2f (%ux%u)", shared.render_scale, shared.render_extent.width, shared.render_extent.height);
+    }
+    if(ImGui::Checkbox("Async Compute", &enable_async_compute)) {
+        renderer.set_config_enable_async_compute(enable_async_compute);
+    }
+    if(ImGui::Checkbox("Vertex Quantization (new meshes)", &enable_vertex_quantization)) {
+        renderer.set_config_enable_vertex_quantization(enable_vertex_quantization);
+    }
+    if(ImGui::Checkbox("Texture Streaming", &enable_texture_streaming)) {
+        renderer.set_config_enable_texture_streaming(enable_texture_streaming);
+    }
+    if(ImGui::SliderInt("Texture Streaming Budget (mb)", &texture_streaming_budget_mb, 16, 4096)) {
+        renderer.set_config_texture_streaming_budget_mb(static_cast<u32>(texture_streaming_budget_mb));
+    }
 
     ImGui::End();
 }
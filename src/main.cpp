@@ -15,6 +15,9 @@
 //constexpr const char *SPONZA_PATH = "C:/Dev/Resources/Meshes/main1_sponza/NewSponza_Main_glTF_003.gltf";
 constexpr const char *BISTRO_PATH = "C:/Dev/Resources/Meshes/Bistro_v5_2/GLTF/BistroExterior.gltf";
 
+constexpr bool SPAWN_DEMO_LIGHTS = false; // Stress test for the light culling
+constexpr u32 DEMO_LIGHT_COUNT = 2048u;
+
 int main(){
     Window window(WindowConfig {
         .title = "Gemino Engine Example",
@@ -60,6 +63,35 @@ int main(){
 
     std::srand(0xDEADBEEF);
 
+    // Night lighting over the Bistro, warm spot lights pointing down with coloured point lights between them
+    for (u32 i{}; i < (SPAWN_DEMO_LIGHTS ? DEMO_LIGHT_COUNT : 0u); ++i) {
+        glm::vec3 position(
+            static_cast<f32>(std::rand() % 2000) * 0.1f - 100.0f,
+            static_cast<f32>(std::rand() % 80) * 0.1f + 0.5f,
+            static_cast<f32>(std::rand() % 2000) * 0.1f - 100.0f
+        );
+
+        if (i % 2u == 0u) {
+            world.create_light(LightCreateInfo{
+                .type = GPU_LIGHT_TYPE_SPOT,
+                .position = position,
+                .direction = glm::vec3(0.0f, -1.0f, 0.0f),
+                .color = glm::vec3(1.0f, 0.8f, 0.6f),
+                .intensity = 8.0f,
+                .range = 8.0f,
+                .inner_cone_angle = 25.0f,
+                .outer_cone_angle = 40.0f
+            });
+        } else {
+            world.create_light(LightCreateInfo{
+                .position = position,
+                .color = glm::vec3(static_cast<f32>(std::rand() % 100) * 0.01f, static_cast<f32>(std::rand() % 100) * 0.01f, 1.0f),
+                .intensity = 2.0f,
+                .range = 4.0f
+            });
+        }
+    }
+
     auto main_camera = world.create_camera(CameraCreateInfo{
         .viewport_size = glm::vec2(window.get_size()),
         .position = glm::vec3(-9.98111f, 1.07925f, 2.21961f),
@@ -5,6 +5,7 @@
 #include <RHI/resource_manager.hpp>
 #include <world/world.hpp>
 #include <renderer/renderer_shared_objects.hpp>
+#include <renderer/render_graph.hpp>
 
 class BasePass {
 public:
@@ -15,6 +16,10 @@ public:
     virtual void destroy(const RenderAPI &api) = 0;
 
     virtual void process(Handle<CommandList> cmd, const RenderAPI &api, const RendererSharedObjects &shared, const World &world) = 0;
+
+    // Called before init() and after a resize, so only the config and the shared handles can be used
+    // The render graph places the barriers between the passes from these, the written buffers of PassQueue::AsyncCompute passes are transferred back to the graphics queue family
+    virtual void declare_resources(PassResources &resources, const RendererSharedObjects &shared) const {}
 };
 
 #endif
@@ -3,6 +3,52 @@
 
 #define GPU_MAX_LOD_COUNT 8
 
+#define GPU_MESHLET_MAX_VERTICES 64
+#define GPU_MESHLET_MAX_TRIANGLES 124
+#define GPU_CLUSTER_CULL_GROUP_SIZE 64 // Meshlets culled by a single ClusterCullJob
+
+#define GPU_INDEX_TYPE_U32 0
+#define GPU_INDEX_TYPE_U16 1
+#define GPU_INDEX_TYPE_COUNT 2
+#define GPU_INDEX16_MAX_VERTICES 65536 // LODs referencing at most this many vertices are stored in the 16-bit index pool
+#define GPU_LOD_INDEX_TYPE(vertex_count) (((vertex_count) <= GPU_INDEX16_MAX_VERTICES) ? GPU_INDEX_TYPE_U16 : GPU_INDEX_TYPE_U32)
+
+#define GPU_VERTEX_FORMAT_FULL 0
+#define GPU_VERTEX_FORMAT_COMPACT 1
+#define GPU_VERTEX_BLOCK_SIZE 60 // Holds a whole number of vertices of every format
+
+#define GPU_OCCLUSION_CULL_PHASE_DISABLED 0 // Single pass, everything in the frustum is drawn
+#define GPU_OCCLUSION_CULL_PHASE_EARLY 1 // Draws the objects that were visible last frame
+#define GPU_OCCLUSION_CULL_PHASE_LATE 2 // Tests against the depth pyramid and draws the newly visible objects
+#define GPU_DEPTH_PYRAMID_GROUP_SIZE 8
+
+#define GPU_MAX_VIEW_COUNT 4 // The main camera and the secondary views culled in the same dispatch
+
+#define GPU_NORMAL_ENCODING_FLOAT 0 // RGBA32F, xyz
+#define GPU_NORMAL_ENCODING_OCTAHEDRAL_SNORM 1 // R16G16_SNORM, octahedral in [-1, 1]
+#define GPU_NORMAL_ENCODING_OCTAHEDRAL_UNORM 2 // A2B10G10R10_UNORM, octahedral remapped to [0, 1]
+
+#define GPU_SSAO_GROUP_SIZE 8 // Half resolution SSAO downsample and occlusion dispatches
+#define GPU_SSAO_MAX_HISTORY_LENGTH 16 // Frames accumulated before the history turns into an exponential moving average
+
+#define GPU_LIGHT_TYPE_POINT 0
+#define GPU_LIGHT_TYPE_SPOT 1
+
+#define GPU_LIGHT_CLUSTER_X 16 // Screen space tiles
+#define GPU_LIGHT_CLUSTER_Y 9
+#define GPU_LIGHT_CLUSTER_Z 24 // Exponential view depth slices between the near and far plane of the camera
+#define GPU_LIGHT_CLUSTER_COUNT (GPU_LIGHT_CLUSTER_X * GPU_LIGHT_CLUSTER_Y * GPU_LIGHT_CLUSTER_Z)
+#define GPU_LIGHT_CLUSTER_MAX_LIGHTS 128 // Length of the index list of every cluster, further lights are dropped
+#define GPU_LIGHT_CULL_GROUP_SIZE 64 // One workgroup per cluster
+
+// Visibility buffer texel: x - draw instance index + 1 (0 means no geometry), y - first index of the triangle in its index pool
+#define GPU_VISIBILITY_LATE_PHASE_BIT 0x80000000u // Set in x if the instance is in the late phase draw instance buffer
+#define GPU_VISIBILITY_INDEX16_BIT 0x80000000u // Set in y if the triangle is in the 16-bit index pool
+
+#define GPU_DRAW_BUCKET_SCAN_GROUP_SIZE 256
+#define GPU_DRAW_BUCKET_SCAN_ITEMS 4 // Buckets scanned by a single invocation
+#define GPU_DRAW_BUCKET_SCAN_BLOCK_SIZE (GPU_DRAW_BUCKET_SCAN_GROUP_SIZE * GPU_DRAW_BUCKET_SCAN_ITEMS)
+
 #ifdef __cplusplus
 #include <vulkan/vulkan.h>
 #include <meshoptimizer.h>
@@ -61,6 +107,21 @@ struct Vertex {
     glm::u16vec2 texcoord{};
 };
 
+// Quantized Vertex, decoded with Primitive::quantization_offset and quantization_scale
+struct CompactVertex {
+    glm::u16vec3 pos{}; // unorm16 within the bounds of the primitive
+    u16 normal{}; // Octahedral, two snorm8
+    glm::u16vec2 texcoord{}; // half2
+};
+
+// Unit of the vertex buffer allocator, so that primitives of both formats can share the same buffer
+struct VertexBlock {
+    std::array<u8, GPU_VERTEX_BLOCK_SIZE> bytes{};
+};
+
+static_assert(sizeof(Vertex) == 20 && sizeof(CompactVertex) == 12);
+static_assert(sizeof(VertexBlock) % sizeof(Vertex) == 0 && sizeof(VertexBlock) % sizeof(CompactVertex) == 0);
+
 namespace std {
     template<>
     struct hash<Vertex> {
@@ -75,13 +136,31 @@ namespace std {
 }
 
 struct PrimitiveLOD {
-    u32 index_start{};
+    u32 index_start{}; // In the index pool of GPU_LOD_INDEX_TYPE(vertex_count)
     u32 index_count{};
+    u32 vertex_count{}; // Every LOD references only the first vertex_count vertices of its primitive, coarser LODs use shorter prefixes
+    f32 error{}; // Object space geometric deviation from LOD0
 };
 struct Primitive {
-    i32 vertex_start{};
+    i32 vertex_start{}; // In vertices of 'vertex_format'
     u32 vertex_count{};
     std::array<PrimitiveLOD, 8> lods{};
+    u32 meshlet_start{}; // Meshlets cover the LOD0 indices, each meshlet is a contiguous index range
+    u32 meshlet_count{};
+    u32 vertex_format{}; // GPU_VERTEX_FORMAT_*
+    glm::vec3 quantization_offset{}; // position = quantization_offset + CompactVertex::pos * quantization_scale
+    glm::vec3 quantization_scale{};
+    glm::vec3 center_offset{}; // Bounding sphere in mesh space
+    f32 radius{};
+    glm::vec3 aabb_min{};
+    glm::vec3 aabb_max{};
+};
+struct alignas(16) Meshlet {
+    glm::vec3 center{};
+    f32 radius{};
+    glm::i8vec4 cone{}; // xyz - snorm8 cone axis, w - snorm8 cone cutoff
+    u32 index_offset{}; // Relative to lods[0].index_start of the primitive
+    u32 index_count{};
 };
 struct alignas(16) Mesh {
     glm::vec3 center_offset{};
@@ -100,10 +179,12 @@ struct MeshInstance {
 struct Texture {
     Handle<struct Image> image{};
     Handle<struct Sampler> sampler{};
+    VkFormat format = VK_FORMAT_UNDEFINED;
     u16 width{};
     u16 height{};
     u16 bytes_per_pixel{};
     u16 mip_level_count{};
+    u16 resident_mip{}; // First mip level present in the image, higher resolution mips are streamed in on demand
     u16 is_srgb{};
     u16 use_linear_filter{};
 };
@@ -128,11 +209,57 @@ struct Object {
 };
 
 struct DrawCommand {
-    VkDrawIndexedIndirectCommand vk_cmd{};
+    VkDrawIndexedIndirectCommand vk_cmd{}; // Instances are read from the DrawInstance buffer starting at first_instance
+    u32 primitive_index{}; // Global index in the primitive buffer
+};
+struct DrawInstance {
+    u32 object_id{};
+    u32 primitive_id{}; // Relative to the mesh
+};
+
+// Culling output before it's bucketed by (primitive, LOD)
+struct VisibleInstance {
+    u32 object_id{};
+    u32 primitive_id{}; // Relative to the mesh
+    u32 bucket{}; // primitive_index * GPU_MAX_LOD_COUNT + lod
+    u32 bucket_slot{}; // Position of the instance within its bucket
+};
+struct DrawInstanceDispatch {
+    VkDispatchIndirectCommand vk_cmd{}; // Scatters the visible instances into their buckets
+    u32 visible_instance_count{};
+    u32 draw_instance_count{}; // Bucketed instances first, instances of the cluster cull draws are appended after them
+};
+
+struct ClusterCullJob {
     u32 object_id{};
-    u32 primitive_id{};
+    u32 primitive_id{}; // Relative to the mesh
+    u32 primitive_index{}; // Global index in the primitive buffer
+    u32 meshlet_offset{}; // Relative to meshlet_start of the primitive
+};
+struct ClusterCullDispatch {
+    VkDispatchIndirectCommand vk_cmd{}; // One workgroup per ClusterCullJob
+    u32 compacted_index_count{};
+};
+struct OcclusionCullStats {
+    u32 visible_object_count{}; // In the frustum and not occluded
+    u32 occluded_object_count{};
+    u32 disoccluded_object_count{}; // Drawn by the late phase
 };
 
+// Point lights ignore the direction and the cone
+struct alignas(16) Light {
+    alignas(16) glm::vec3 position{};
+    alignas(4) f32 range = 10.0f; // No influence past this distance
+    alignas(16) glm::vec3 color = glm::vec3(1.0f); // Premultiplied by the intensity
+    alignas(4) u32 type = GPU_LIGHT_TYPE_POINT;
+    alignas(16) glm::vec3 direction = glm::vec3(0.0f, -1.0f, 0.0f);
+    alignas(4) f32 inner_cone_cos = 1.0f; // Full intensity inside
+    alignas(4) f32 outer_cone_cos = 0.0f; // Zero intensity outside
+    alignas(4) u32 enabled = 1U; // Destroyed lights stay in the buffer disabled until the handle is reused
+};
+
+static_assert(sizeof(Light) == 64);
+
 #else
 
 #extension GL_EXT_shader_16bit_storage : require
@@ -174,14 +301,37 @@ struct Vertex {
     i8vec4 normal;
     f16vec2 texcoord;
 };
+struct CompactVertex {
+    u16vec3 position;
+    uint16_t normal; // Two snorm8, read with unpackSnorm4x8
+    f16vec2 texcoord;
+};
 struct PrimitiveLOD {
     uint index_start;
     uint index_count;
+    uint vertex_count;
+    float error;
 };
 struct Primitive {
     int vertex_start;
     uint vertex_count;
     PrimitiveLOD lods[GPU_MAX_LOD_COUNT];
+    uint meshlet_start;
+    uint meshlet_count;
+    uint vertex_format;
+    float quantization_offset[3];
+    float quantization_scale[3];
+    float center_offset[3]; // vec3 would change the alignment of the struct
+    float radius;
+    float aabb_min[3];
+    float aabb_max[3];
+};
+struct Meshlet {
+    vec3 center;
+    float radius;
+    uint cone; // i8vec4 packed as snorm8x4, read with unpackSnorm4x8
+    uint index_offset;
+    uint index_count;
 };
 struct Mesh {
     vec3 center_offset;
@@ -224,9 +374,55 @@ struct DrawCommand {
     uint first_index;
     int vertex_offset;
     uint first_instance;
+    uint primitive_index;
+};
+struct DrawInstance {
     uint object_id;
     uint primitive_id;
 };
+
+struct VisibleInstance {
+    uint object_id;
+    uint primitive_id;
+    uint bucket;
+    uint bucket_slot;
+};
+struct DrawInstanceDispatch {
+    uint group_count_x;
+    uint group_count_y;
+    uint group_count_z;
+    uint visible_instance_count;
+    uint draw_instance_count;
+};
+
+struct ClusterCullJob {
+    uint object_id;
+    uint primitive_id;
+    uint primitive_index;
+    uint meshlet_offset;
+};
+struct ClusterCullDispatch {
+    uint group_count_x;
+    uint group_count_y;
+    uint group_count_z;
+    uint compacted_index_count;
+};
+struct OcclusionCullStats {
+    uint visible_object_count;
+    uint occluded_object_count;
+    uint disoccluded_object_count;
+};
+
+struct Light {
+    vec3 position;
+    float range;
+    vec3 color;
+    uint type;
+    vec3 direction;
+    float inner_cone_cos;
+    float outer_cone_cos;
+    uint enabled;
+};
 #endif
 
 #endif
\ No newline at end of file
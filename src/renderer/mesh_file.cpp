@@ -0,0 +1,157 @@
+#include "mesh_file.hpp"
+
+#include <common/utils.hpp>
+
+#include <fstream>
+#include <cstring>
+
+static constexpr u32 GMESH_MAGIC = 0x48534D47u; // "GMSH"
+static constexpr u32 GMESH_VERSION = 1u;
+
+struct GMeshHeader {
+    u32 magic{};
+    u32 version{};
+    u32 primitive_count{};
+    f32 simplify_target_error{};
+};
+struct GMeshPrimitiveHeader {
+    u32 vertex_count{};
+    u32 index_count{};
+    u32 encoded_vertices_size{};
+    u32 encoded_indices_size{};
+};
+
+bool MeshFile::save(const std::string &path, const MeshData &data) {
+    std::vector<u8> file(sizeof(GMeshHeader));
+
+    GMeshHeader header{
+        .magic = GMESH_MAGIC,
+        .version = GMESH_VERSION,
+        .primitive_count = static_cast<u32>(data.primitives.size()),
+        .simplify_target_error = data.simplify_target_error
+    };
+    std::memcpy(file.data(), &header, sizeof(GMeshHeader));
+
+    for (const auto &primitive : data.primitives) {
+        if (primitive.indices.size() % 3u != 0u) {
+            DEBUG_ERROR("Failed to save mesh to \"" << path << "\" - index count must be a multiple of 3")
+            return false;
+        }
+
+        std::vector<u8> encoded_vertices(meshopt_encodeVertexBufferBound(primitive.vertices.size(), sizeof(Vertex)));
+        encoded_vertices.resize(meshopt_encodeVertexBuffer(encoded_vertices.data(), encoded_vertices.size(), primitive.vertices.data(), primitive.vertices.size(), sizeof(Vertex)));
+
+        std::vector<u8> encoded_indices(meshopt_encodeIndexBufferBound(primitive.indices.size(), primitive.vertices.size()));
+        encoded_indices.resize(meshopt_encodeIndexBuffer(encoded_indices.data(), encoded_indices.size(), primitive.indices.data(), primitive.indices.size()));
+
+        if (encoded_vertices.empty() || encoded_indices.empty()) {
+            DEBUG_ERROR("Failed to save mesh to \"" << path << "\" - encoding failed")
+            return false;
+        }
+
+        GMeshPrimitiveHeader primitive_header{
+            .vertex_count = static_cast<u32>(primitive.vertices.size()),
+            .index_count = static_cast<u32>(primitive.indices.size()),
+            .encoded_vertices_size = static_cast<u32>(encoded_vertices.size()),
+            .encoded_indices_size = static_cast<u32>(encoded_indices.size())
+        };
+
+        usize offset = file.size();
+        file.resize(offset + sizeof(GMeshPrimitiveHeader) + encoded_vertices.size() + encoded_indices.size());
+
+        std::memcpy(file.data() + offset, &primitive_header, sizeof(GMeshPrimitiveHeader));
+        offset += sizeof(GMeshPrimitiveHeader);
+        std::memcpy(file.data() + offset, encoded_vertices.data(), encoded_vertices.size());
+        offset += encoded_vertices.size();
+        std::memcpy(file.data() + offset, encoded_indices.data(), encoded_indices.size());
+    }
+
+    std::ofstream stream(path, std::ios::binary);
+    if (!stream.is_open()) {
+        DEBUG_ERROR("Failed to save mesh to \"" << path << "\" - cannot open the file")
+        return false;
+    }
+
+    stream.write(reinterpret_cast<const char*>(file.data()), static_cast<std::streamsize>(file.size()));
+
+    return stream.good();
+}
+
+bool MeshFile::load(const std::string &path, MeshData &data) {
+    std::vector<u8> file = Utils::read_file_bytes(path);
+
+    if (file.size() < sizeof(GMeshHeader)) {
+        DEBUG_ERROR("Failed to load mesh from \"" << path << "\" - file is too small")
+        return false;
+    }
+
+    GMeshHeader header{};
+    std::memcpy(&header, file.data(), sizeof(GMeshHeader));
+
+    if (header.magic != GMESH_MAGIC) {
+        DEBUG_ERROR("Failed to load mesh from \"" << path << "\" - invalid magic number")
+        return false;
+    }
+    if (header.version != GMESH_VERSION) {
+        DEBUG_ERROR("Failed to load mesh from \"" << path << "\" - unsupported version " << header.version)
+        return false;
+    }
+
+    if (header.primitive_count > (file.size() - sizeof(GMeshHeader)) / sizeof(GMeshPrimitiveHeader)) {
+        DEBUG_ERROR("Failed to load mesh from \"" << path << "\" - invalid primitive count " << header.primitive_count)
+        return false;
+    }
+
+    data.simplify_target_error = header.simplify_target_error;
+    data.primitives.resize(header.primitive_count);
+
+    usize offset = sizeof(GMeshHeader);
+    for (auto &primitive : data.primitives) {
+        if (file.size() < offset + sizeof(GMeshPrimitiveHeader)) {
+            DEBUG_ERROR("Failed to load mesh from \"" << path << "\" - file is truncated")
+            return false;
+        }
+
+        GMeshPrimitiveHeader primitive_header{};
+        std::memcpy(&primitive_header, file.data() + offset, sizeof(GMeshPrimitiveHeader));
+        offset += sizeof(GMeshPrimitiveHeader);
+
+        if (file.size() < offset + primitive_header.encoded_vertices_size + primitive_header.encoded_indices_size) {
+            DEBUG_ERROR("Failed to load mesh from \"" << path << "\" - file is truncated")
+            return false;
+        }
+
+        // Neither codec compresses below 2 header bits per 16 vertex bytes and 1 byte per triangle, larger counts can only come from a corrupted header
+        if (primitive_header.vertex_count == 0u || primitive_header.vertex_count > static_cast<usize>(primitive_header.encoded_vertices_size) * 64u / sizeof(Vertex)) {
+            DEBUG_ERROR("Failed to load mesh from \"" << path << "\" - invalid vertex count " << primitive_header.vertex_count)
+            return false;
+        }
+        if (primitive_header.index_count == 0u || primitive_header.index_count % 3u != 0u || primitive_header.index_count / 3u > primitive_header.encoded_indices_size) {
+            DEBUG_ERROR("Failed to load mesh from \"" << path << "\" - invalid index count " << primitive_header.index_count)
+            return false;
+        }
+
+        primitive.vertices.resize(primitive_header.vertex_count);
+        primitive.indices.resize(primitive_header.index_count);
+
+        const u8 *encoded_vertices = file.data() + offset;
+        const u8 *encoded_indices = encoded_vertices + primitive_header.encoded_vertices_size;
+
+        if (meshopt_decodeVertexBuffer(primitive.vertices.data(), primitive.vertices.size(), sizeof(Vertex), encoded_vertices, primitive_header.encoded_vertices_size) != 0 ||
+            meshopt_decodeIndexBuffer(primitive.indices.data(), primitive.indices.size(), sizeof(u32), encoded_indices, primitive_header.encoded_indices_size) != 0) {
+            DEBUG_ERROR("Failed to load mesh from \"" << path << "\" - corrupted primitive data")
+            return false;
+        }
+
+        for (u32 index : primitive.indices) {
+            if (index >= primitive_header.vertex_count) {
+                DEBUG_ERROR("Failed to load mesh from \"" << path << "\" - index " << index << " is out of range")
+                return false;
+            }
+        }
+
+        offset += primitive_header.encoded_vertices_size + primitive_header.encoded_indices_size;
+    }
+
+    return true;
+}
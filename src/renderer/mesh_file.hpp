@@ -0,0 +1,28 @@
+#ifndef GEMINO_MESH_FILE_HPP
+#define GEMINO_MESH_FILE_HPP
+
+#include <common/types.hpp>
+#include <common/debug.hpp>
+#include <common/handle_allocator.hpp>
+#include <renderer/gpu_types.inl>
+
+#include <vector>
+#include <string>
+
+struct MeshDataPrimitive {
+    std::vector<Vertex> vertices{};
+    std::vector<u32> indices{}; // Triangle list
+};
+
+struct MeshData {
+    std::vector<MeshDataPrimitive> primitives{};
+    f32 simplify_target_error = 0.05f;
+};
+
+// Meshes stored with meshoptimizer's vertex and index buffer codecs (.gmesh), decoded on load
+namespace MeshFile {
+    bool save(const std::string &path, const MeshData &data);
+    bool load(const std::string &path, MeshData &data);
+}
+
+#endif
@@ -0,0 +1,140 @@
+#include "cluster_cull_pass.hpp"
+
+void ClusterCullPass::init(const RenderAPI &api, const RendererSharedObjects &shared, const Window &window) {
+    m_descriptor = api.rm->create_descriptor(DescriptorCreateInfo{
+        .bindings {
+            DescriptorBindingCreateInfo{VK_DESCRIPTOR_TYPE_STORAGE_BUFFER}, // Cluster Cull Job Buffer
+            DescriptorBindingCreateInfo{VK_DESCRIPTOR_TYPE_STORAGE_BUFFER}, // Cluster Cull Dispatch Buffer
+            DescriptorBindingCreateInfo{VK_DESCRIPTOR_TYPE_STORAGE_BUFFER}, // Primitive Buffer
+            DescriptorBindingCreateInfo{VK_DESCRIPTOR_TYPE_STORAGE_BUFFER}, // Meshlet Buffer
+            DescriptorBindingCreateInfo{VK_DESCRIPTOR_TYPE_STORAGE_BUFFER}, // Global Transform Buffer
+            DescriptorBindingCreateInfo{VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER}, // Camera Buffer
+            DescriptorBindingCreateInfo{VK_DESCRIPTOR_TYPE_STORAGE_BUFFER}, // Index Buffer
+            DescriptorBindingCreateInfo{VK_DESCRIPTOR_TYPE_STORAGE_BUFFER}, // Draw Commands
+            DescriptorBindingCreateInfo{VK_DESCRIPTOR_TYPE_STORAGE_BUFFER}, // Draw Commands Count
+            DescriptorBindingCreateInfo{VK_DESCRIPTOR_TYPE_STORAGE_BUFFER}, // 16-bit Index Buffer
+            DescriptorBindingCreateInfo{VK_DESCRIPTOR_TYPE_STORAGE_BUFFER}, // Draw Instance Dispatch Buffer
+            DescriptorBindingCreateInfo{VK_DESCRIPTOR_TYPE_STORAGE_BUFFER}, // Draw Instance Buffer
+        }
+    });
+
+    api.rm->update_descriptor(m_descriptor, DescriptorUpdateInfo{
+        .bindings{
+            DescriptorBindingUpdateInfo{
+                .binding_index = 0U,
+                .buffer_info {
+                    .buffer_handle = shared.scene_cluster_job_buffer
+                }
+            },
+            DescriptorBindingUpdateInfo{
+                .binding_index = 1U,
+                .buffer_info {
+                    .buffer_handle = shared.scene_cluster_dispatch_buffer
+                }
+            },
+            DescriptorBindingUpdateInfo{
+                .binding_index = 2U,
+                .buffer_info {
+                    .buffer_handle = shared.scene_primitive_buffer
+                }
+            },
+            DescriptorBindingUpdateInfo{
+                .binding_index = 3U,
+                .buffer_info {
+                    .buffer_handle = shared.scene_meshlet_buffer
+                }
+            },
+            DescriptorBindingUpdateInfo{
+                .binding_index = 4U,
+                .buffer_info {
+                    .buffer_handle = shared.scene_global_transform_buffer
+                }
+            },
+            DescriptorBindingUpdateInfo{
+                .binding_index = 5U,
+                .buffer_info {
+                    .buffer_handle = shared.scene_camera_buffer
+                }
+            },
+            DescriptorBindingUpdateInfo{
+                .binding_index = 6U,
+                .buffer_info {
+                    .buffer_handle = shared.scene_index_buffer
+                }
+            },
+            DescriptorBindingUpdateInfo{
+                .binding_index = 7U,
+                .buffer_info {
+                    .buffer_handle = shared.scene_draw_buffer
+                }
+            },
+            DescriptorBindingUpdateInfo{
+                .binding_index = 8U,
+                .buffer_info {
+                    .buffer_handle = shared.scene_draw_count_buffer
+                }
+            },
+            DescriptorBindingUpdateInfo{
+                .binding_index = 9U,
+                .buffer_info {
+                    .buffer_handle = shared.scene_index16_buffer
+                }
+            },
+            DescriptorBindingUpdateInfo{
+                .binding_index = 10U,
+                .buffer_info {
+                    .buffer_handle = shared.scene_draw_instance_dispatch_buffer
+                }
+            },
+            DescriptorBindingUpdateInfo{
+                .binding_index = 11U,
+                .buffer_info {
+                    .buffer_handle = shared.scene_draw_instance_buffer
+                }
+            }
+        }
+    });
+
+    m_pipeline = api.rm->create_compute_pipeline(ComputePipelineCreateInfo{
+        .shader_path = "./shaders/cluster_cull.comp.spv",
+        .shader_constant_values {
+            static_cast<uint32_t>(shared.config_enable_frustum_cull),
+        },
+        .push_constants_size = sizeof(ClusterCullPushConstant),
+        .descriptors { m_descriptor }
+    });
+}
+void ClusterCullPass::resize(const RenderAPI &api, const RendererSharedObjects &shared, const Window &window) {
+
+}
+void ClusterCullPass::destroy(const RenderAPI &api) {
+    api.rm->destroy(m_pipeline);
+    api.rm->destroy(m_descriptor);
+}
+
+void ClusterCullPass::process(Handle<CommandList> cmd, const RenderAPI &api, const RendererSharedObjects &shared, const World &world) {
+    ClusterCullPushConstant push_constant{
+        .cluster_index_start = shared.scene_cluster_index_start,
+        .cluster_index_capacity = shared.scene_cluster_index_capacity,
+        .draw_capacity = shared.scene_draw_capacity,
+        .draw_instance_capacity = shared.scene_draw_instance_capacity,
+        .min_pixel_size = shared.config_cluster_cull_min_pixel_size
+    };
+
+    // The workgroup count is the number of jobs written by the Draw Call Generation Pass
+    api.begin_compute_pipeline(cmd, m_pipeline);
+    api.bind_descriptor(cmd, m_pipeline, m_descriptor, 0U);
+    api.push_constants(cmd, m_pipeline, &push_constant);
+    api.dispatch_indirect_compute_pipeline(cmd, shared.scene_cluster_dispatch_buffer);
+}
+void ClusterCullPass::declare_resources(PassResources &resources, const RendererSharedObjects &shared) const {
+    resources.read_buffer(shared.scene_cluster_dispatch_buffer, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_SHADER_READ_BIT);
+    resources.read_buffer(shared.scene_cluster_job_buffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+
+    // Appended to the early phase draws
+    resources.write_buffer(shared.scene_draw_buffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+    resources.write_buffer(shared.scene_draw_count_buffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+    resources.write_buffer(shared.scene_draw_instance_buffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+    resources.write_buffer(shared.scene_draw_instance_dispatch_buffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+    resources.write_buffer(shared.scene_index_buffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT);
+}
\ No newline at end of file
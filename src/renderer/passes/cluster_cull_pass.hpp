@@ -0,0 +1,28 @@
+#ifndef CLUSTER_CULL_PASS_HPP
+#define CLUSTER_CULL_PASS_HPP
+
+#include <renderer/base_pass.hpp>
+
+struct ClusterCullPushConstant {
+    u32 cluster_index_start{};
+    u32 cluster_index_capacity{};
+    u32 draw_capacity{};
+    u32 draw_instance_capacity{};
+    f32 min_pixel_size{};
+};
+
+// Culls meshlets of the jobs emitted by the Draw Call Generation Pass and compacts the indices of the surviving ones
+class ClusterCullPass : public BasePass {
+public:
+    void init(const RenderAPI &api, const RendererSharedObjects &shared, const Window &window) override;
+    void resize(const RenderAPI &api, const RendererSharedObjects &shared, const Window &window) override;
+    void destroy(const RenderAPI &api) override;
+    void process(Handle<CommandList> cmd, const RenderAPI &api, const RendererSharedObjects &shared, const World &world) override;
+    void declare_resources(PassResources &resources, const RendererSharedObjects &shared) const override;
+
+private:
+    Handle<Descriptor> m_descriptor{};
+    Handle<ComputePipeline> m_pipeline{};
+};
+
+#endif
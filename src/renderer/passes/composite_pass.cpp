@@ -5,39 +5,21 @@ void CompositePass::init(const RenderAPI &api, const RendererSharedObjects &shar
         .bindings {
             DescriptorBindingCreateInfo{VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER}, // Albedo
             DescriptorBindingCreateInfo{VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER}, // Normal
-            DescriptorBindingCreateInfo{VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER}  // SSAO
+            DescriptorBindingCreateInfo{VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER}, // SSAO
+            DescriptorBindingCreateInfo{VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER}, // Depth
+            DescriptorBindingCreateInfo{VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER}, // Camera
+            DescriptorBindingCreateInfo{VK_DESCRIPTOR_TYPE_STORAGE_BUFFER}, // Light Buffer
+            DescriptorBindingCreateInfo{VK_DESCRIPTOR_TYPE_STORAGE_BUFFER}, // Light Cluster Count Buffer
+            DescriptorBindingCreateInfo{VK_DESCRIPTOR_TYPE_STORAGE_BUFFER}, // Light Cluster Index Buffer
         }
     });
 
-    api.rm->update_descriptor(m_descriptor, DescriptorUpdateInfo{
-        .bindings {
-            DescriptorBindingUpdateInfo {
-                .binding_index = 0u,
-                .image_info {
-                    .image_handle = shared.albedo_image,
-                    .image_sampler = shared.offscreen_sampler
-                }
-            },
-            DescriptorBindingUpdateInfo {
-                .binding_index = 1u,
-                .image_info {
-                    .image_handle = shared.normal_image,
-                    .image_sampler = shared.offscreen_sampler
-                }
-            },
-            DescriptorBindingUpdateInfo {
-                .binding_index = 2u,
-                .image_info {
-                    .image_handle = shared.ssao_output_image,
-                    .image_sampler = shared.offscreen_sampler
-                }
-            }
-        }
-    });
+    update_descriptor(api, shared);
 
     m_pipeline = api.rm->create_graphics_pipeline(GraphicsPipelineCreateInfo{
         .vertex_shader_path = "./shaders/fullscreen_tri.vert.spv",
         .fragment_shader_path = "./shaders/composite.frag.spv",
+        .fragment_constant_values { static_cast<u32>(shared.config_gbuffer_layout) },
         .descriptors = { m_descriptor } ,
         .color_targets = {
             RenderTargetCommonInfo {
@@ -57,6 +39,24 @@ void CompositePass::init(const RenderAPI &api, const RendererSharedObjects &shar
     });
 }
 void CompositePass::resize(const RenderAPI &api, const RendererSharedObjects &shared, const Window &window) {
+    update_descriptor(api, shared);
+
+    api.rm->destroy(m_render_target);
+    m_render_target = api.rm->create_render_target(m_pipeline, RenderTargetCreateInfo{
+        .color_attachments = {
+            RenderTargetAttachmentCreateInfo {
+                .target_handle = shared.offscreen_image
+            }
+        }
+    });
+}
+void CompositePass::destroy(const RenderAPI &api) {
+    api.rm->destroy(m_render_target);
+    api.rm->destroy(m_pipeline);
+    api.rm->destroy(m_descriptor);
+}
+
+void CompositePass::update_descriptor(const RenderAPI &api, const RendererSharedObjects &shared) {
     api.rm->update_descriptor(m_descriptor, DescriptorUpdateInfo{
         .bindings {
             DescriptorBindingUpdateInfo {
@@ -79,55 +79,57 @@ void CompositePass::resize(const RenderAPI &api, const RendererSharedObjects &sh
                     .image_handle = shared.ssao_output_image,
                     .image_sampler = shared.offscreen_sampler
                 }
+            },
+            DescriptorBindingUpdateInfo {
+                .binding_index = 3u,
+                .image_info {
+                    .image_handle = shared.depth_image,
+                    .image_sampler = shared.offscreen_sampler
+                }
+            },
+            DescriptorBindingUpdateInfo {
+                .binding_index = 4u,
+                .buffer_info = {
+                    .buffer_handle = shared.scene_camera_buffer
+                }
+            },
+            DescriptorBindingUpdateInfo {
+                .binding_index = 5u,
+                .buffer_info = {
+                    .buffer_handle = shared.scene_light_buffer
+                }
+            },
+            DescriptorBindingUpdateInfo {
+                .binding_index = 6u,
+                .buffer_info = {
+                    .buffer_handle = shared.scene_light_cluster_count_buffer
+                }
+            },
+            DescriptorBindingUpdateInfo {
+                .binding_index = 7u,
+                .buffer_info = {
+                    .buffer_handle = shared.scene_light_cluster_index_buffer
+                }
             }
         }
     });
-
-    api.rm->destroy(m_render_target);
-    m_render_target = api.rm->create_render_target(m_pipeline, RenderTargetCreateInfo{
-        .color_attachments = {
-            RenderTargetAttachmentCreateInfo {
-                .target_handle = shared.offscreen_image
-            }
-        }
-    });
-}
-void CompositePass::destroy(const RenderAPI &api) {
-    api.rm->destroy(m_render_target);
-    api.rm->destroy(m_pipeline);
-    api.rm->destroy(m_descriptor);
 }
 
 void CompositePass::process(Handle<CommandList> cmd, const RenderAPI &api, const RendererSharedObjects &shared, const World &world) {
-    api.image_barrier(cmd, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, {
-        ImageBarrier{
-            .image_handle = shared.albedo_image,
-            .src_access_mask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
-            .dst_access_mask = VK_ACCESS_SHADER_READ_BIT,
-            .old_layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
-            .new_layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
-        },
-        ImageBarrier{
-            .image_handle = shared.ssao_output_image,
-            .src_access_mask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
-            .dst_access_mask = VK_ACCESS_SHADER_READ_BIT,
-            .old_layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
-            .new_layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
-        }
-    });
-
-    api.image_barrier(cmd, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, {
-        ImageBarrier{
-            .image_handle = shared.offscreen_image,
-            .src_access_mask = VK_ACCESS_SHADER_READ_BIT,
-            .dst_access_mask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
-            .old_layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-            .new_layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL
-        },
-    });
-
-    api.begin_graphics_pipeline(cmd, m_pipeline, m_render_target, {RenderTargetClear{}}, RenderTargetClear{});
+    api.begin_graphics_pipeline(cmd, m_pipeline, m_render_target, {RenderTargetClear{}}, RenderTargetClear{}, shared.render_extent);
     api.bind_descriptor(cmd, m_pipeline, m_descriptor, 0U);
     api.draw_count(cmd, 3U),
     api.end_graphics_pipeline(cmd, m_pipeline);
 }
+void CompositePass::declare_resources(PassResources &resources, const RendererSharedObjects &shared) const {
+    resources.read_image(shared.albedo_image, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+    resources.read_image(shared.normal_image, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+    resources.read_image(shared.ssao_output_image, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+
+    // Positions of the lit pixels are reconstructed from the depth
+    resources.read_image(shared.depth_image, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+    resources.read_buffer(shared.scene_light_cluster_count_buffer, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+    resources.read_buffer(shared.scene_light_cluster_index_buffer, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+
+    resources.write_image(shared.offscreen_image, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT);
+}
@@ -9,8 +9,11 @@ public:
     void resize(const RenderAPI &api, const RendererSharedObjects &shared, const Window &window) override;
     void destroy(const RenderAPI &api) override;
     void process(Handle<CommandList> cmd, const RenderAPI &api, const RendererSharedObjects &shared, const World &world) override;
+    void declare_resources(PassResources &resources, const RendererSharedObjects &shared) const override;
 
 private:
+    void update_descriptor(const RenderAPI &api, const RendererSharedObjects &shared);
+
     Handle<RenderTarget> m_render_target{};
     Handle<GraphicsPipeline> m_pipeline{};
     Handle<Descriptor> m_descriptor{};
@@ -64,13 +64,13 @@ void DebugPass::init(const RenderAPI &api, const RendererSharedObjects &shared,
     m_graphics_descriptor = api.rm->create_descriptor(DescriptorCreateInfo{
         .bindings {
             DescriptorBindingCreateInfo { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER }, // Vertex Buffer
-            DescriptorBindingCreateInfo { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER }, // DrawCommands Buffer
-            DescriptorBindingCreateInfo { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER }, // Object Buffer
+            DescriptorBindingCreateInfo { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER }, // Draw Instance Buffer
             DescriptorBindingCreateInfo { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER }, // Global Transform Buffer
-            DescriptorBindingCreateInfo { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER }, // Mesh Buffer
-            DescriptorBindingCreateInfo { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER }, // MeshInstance Buffer
+            DescriptorBindingCreateInfo { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER }, // Primitive Buffer
             DescriptorBindingCreateInfo { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER }, // Camera Buffer
-            DescriptorBindingCreateInfo { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER }, // Draw Count Buffer
+            DescriptorBindingCreateInfo { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER }, // Object Buffer
+            DescriptorBindingCreateInfo { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER }, // Mesh Instance Buffer
+            DescriptorBindingCreateInfo { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER }, // Mesh Buffer
         }
     });
 
@@ -85,43 +85,43 @@ void DebugPass::init(const RenderAPI &api, const RendererSharedObjects &shared,
             DescriptorBindingUpdateInfo {
                 .binding_index = 1u,
                 .buffer_info {
-                    .buffer_handle = shared.scene_draw_buffer
+                    .buffer_handle = shared.scene_draw_instance_buffer
                 }
             },
             DescriptorBindingUpdateInfo {
                 .binding_index = 2u,
                 .buffer_info {
-                    .buffer_handle = shared.scene_object_buffer
+                    .buffer_handle = shared.scene_global_transform_buffer
                 }
             },
             DescriptorBindingUpdateInfo {
                 .binding_index = 3u,
                 .buffer_info {
-                    .buffer_handle = shared.scene_global_transform_buffer
+                    .buffer_handle = shared.scene_primitive_buffer
                 }
             },
             DescriptorBindingUpdateInfo {
                 .binding_index = 4u,
                 .buffer_info {
-                    .buffer_handle = shared.scene_mesh_buffer
+                    .buffer_handle = shared.scene_camera_buffer
                 }
             },
             DescriptorBindingUpdateInfo {
                 .binding_index = 5u,
                 .buffer_info {
-                    .buffer_handle = shared.scene_mesh_instance_buffer
+                    .buffer_handle = shared.scene_object_buffer
                 }
             },
             DescriptorBindingUpdateInfo {
                 .binding_index = 6u,
                 .buffer_info {
-                    .buffer_handle = shared.scene_camera_buffer
+                    .buffer_handle = shared.scene_mesh_instance_buffer
                 }
             },
             DescriptorBindingUpdateInfo {
                 .binding_index = 7u,
                 .buffer_info {
-                    .buffer_handle = shared.scene_draw_count_buffer
+                    .buffer_handle = shared.scene_mesh_buffer
                 }
             }
         }
@@ -131,6 +131,7 @@ void DebugPass::init(const RenderAPI &api, const RendererSharedObjects &shared,
         .vertex_shader_path = "./shaders/debug_shape.vert.spv",
         .fragment_shader_path = "./shaders/debug_shape.frag.spv",
 
+
         .push_constants_size = sizeof(f32),
 
         .descriptors { m_graphics_descriptor },
@@ -178,7 +179,7 @@ void DebugPass::init(const RenderAPI &api, const RendererSharedObjects &shared,
     m_compute_descriptor = api.rm->create_descriptor(DescriptorCreateInfo{
         .bindings{
             DescriptorBindingCreateInfo { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER }, // Output VkDrawIndexedIndirectCommand
-            DescriptorBindingCreateInfo { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER }, // Draw Command Count
+            DescriptorBindingCreateInfo { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER }, // Draw Instance Dispatch
         }
     });
 
@@ -193,7 +194,7 @@ void DebugPass::init(const RenderAPI &api, const RendererSharedObjects &shared,
             DescriptorBindingUpdateInfo {
                 .binding_index = 1u,
                 .buffer_info {
-                    .buffer_handle = shared.scene_draw_count_buffer
+                    .buffer_handle = shared.scene_draw_instance_dispatch_buffer
                 }
             },
         }
@@ -201,7 +202,7 @@ void DebugPass::init(const RenderAPI &api, const RendererSharedObjects &shared,
 
     m_compute_pipeline = api.rm->create_compute_pipeline(ComputePipelineCreateInfo{
         .shader_path = "./shaders/debug_shape.comp.spv",
-        .shader_constant_values{ static_cast<u32>(sphere_mesh_indices.size()) },
+        .shader_constant_values{ static_cast<u32>(sphere_mesh_indices.size()), shared.scene_draw_instance_capacity },
         .descriptors { m_compute_descriptor }
     });
 }
@@ -233,16 +234,6 @@ void DebugPass::destroy(const RenderAPI &api) {
 }
 
 void DebugPass::process(Handle<CommandList> cmd, const RenderAPI &api, const RendererSharedObjects &shared, const World &world) {
-    api.image_barrier(cmd, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, {
-        ImageBarrier {
-            .image_handle = shared.offscreen_image,
-            .src_access_mask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
-            .dst_access_mask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
-            .old_layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
-            .new_layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
-        }
-    });
-
     api.begin_compute_pipeline(cmd, m_compute_pipeline);
         api.bind_descriptor(cmd, m_compute_pipeline, m_compute_descriptor, 0u);
         api.dispatch_compute_pipeline(cmd);
@@ -251,10 +242,15 @@ void DebugPass::process(Handle<CommandList> cmd, const RenderAPI &api, const Ren
             BufferBarrier { m_sphere_indirect_draw_buffer, VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_INDIRECT_COMMAND_READ_BIT }
         });
 
-    api.begin_graphics_pipeline(cmd, m_graphics_pipeline, m_render_target, {RenderTargetClear{}}, RenderTargetClear{});
+    api.begin_graphics_pipeline(cmd, m_graphics_pipeline, m_render_target, {RenderTargetClear{}}, RenderTargetClear{}, shared.render_extent);
         api.push_constants(cmd, m_graphics_pipeline, &shared.config_debug_shape_opacity);
         api.bind_descriptor(cmd, m_graphics_pipeline, m_graphics_descriptor, 0u);
         api.bind_index_buffer(cmd, m_sphere_mesh_index_buffer);
         api.draw_indexed_indirect(cmd, m_sphere_indirect_draw_buffer, 1u, sizeof(VkDrawIndexedIndirectCommand));
     api.end_graphics_pipeline(cmd, m_graphics_pipeline);
 }
+void DebugPass::declare_resources(PassResources &resources, const RendererSharedObjects &shared) const {
+    // Drawn over the composited image, tested against the scene depth
+    resources.write_image(shared.offscreen_image, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT);
+    resources.write_image(shared.depth_image, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT, VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT);
+}
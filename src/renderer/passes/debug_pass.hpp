@@ -9,6 +9,7 @@ public:
     void resize(const RenderAPI &api, const RendererSharedObjects &shared, const Window &window) override;
     void destroy(const RenderAPI &api) override;
     void process(Handle<CommandList> cmd, const RenderAPI &api, const RendererSharedObjects &shared, const World &world) override;
+    void declare_resources(PassResources &resources, const RendererSharedObjects &shared) const override;
 
 private:
     Handle<Descriptor> m_graphics_descriptor{};
@@ -0,0 +1,102 @@
+#include "depth_pyramid_pass.hpp"
+
+#include "common/utils.hpp"
+
+void DepthPyramidPass::init(const RenderAPI &api, const RendererSharedObjects &shared, const Window &window) {
+    u32 level_count = api.rm->get_data(shared.depth_pyramid_image).mip_level_count;
+
+    for (u32 level{}; level < level_count; ++level) {
+        Handle<Descriptor> descriptor = api.rm->create_descriptor(DescriptorCreateInfo{
+            .bindings {
+                DescriptorBindingCreateInfo{VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER}, // Depth Image
+                DescriptorBindingCreateInfo{VK_DESCRIPTOR_TYPE_STORAGE_IMAGE}, // Source Level
+                DescriptorBindingCreateInfo{VK_DESCRIPTOR_TYPE_STORAGE_IMAGE}, // Destination Level
+            }
+        });
+
+        // Level 0 doesn't read the source level, it is bound only to keep the descriptor complete
+        api.rm->update_descriptor(descriptor, DescriptorUpdateInfo{
+            .bindings{
+                DescriptorBindingUpdateInfo{
+                    .binding_index = 0U,
+                    .image_info {
+                        .image_handle = shared.depth_image,
+                        .image_sampler = shared.depth_pyramid_sampler
+                    }
+                },
+                DescriptorBindingUpdateInfo{
+                    .binding_index = 1U,
+                    .image_info {
+                        .image_handle = shared.depth_pyramid_image,
+                        .image_mip = (level > 0U) ? level - 1U : 0U
+                    }
+                },
+                DescriptorBindingUpdateInfo{
+                    .binding_index = 2U,
+                    .image_info {
+                        .image_handle = shared.depth_pyramid_image,
+                        .image_mip = level
+                    }
+                }
+            }
+        });
+
+        m_descriptors.push_back(descriptor);
+    }
+
+    m_pipeline = api.rm->create_compute_pipeline(ComputePipelineCreateInfo{
+        .shader_path = "./shaders/depth_pyramid.comp.spv",
+        .push_constants_size = sizeof(DepthPyramidPushConstant),
+        .descriptors { m_descriptors.front() }
+    });
+}
+void DepthPyramidPass::resize(const RenderAPI &api, const RendererSharedObjects &shared, const Window &window) {
+    // The level count depends on the screen size
+    destroy(api);
+    init(api, shared, window);
+}
+void DepthPyramidPass::destroy(const RenderAPI &api) {
+    api.rm->destroy(m_pipeline);
+
+    for (const auto &descriptor : m_descriptors) {
+        api.rm->destroy(descriptor);
+    }
+
+    m_descriptors.clear();
+}
+
+void DepthPyramidPass::process(Handle<CommandList> cmd, const RenderAPI &api, const RendererSharedObjects &shared, const World &world) {
+    const Image &pyramid = api.rm->get_data(shared.depth_pyramid_image);
+
+    api.begin_compute_pipeline(cmd, m_pipeline);
+
+    for (u32 level{}; level < pyramid.mip_level_count; ++level) {
+        u32 width = std::max(pyramid.extent.width >> level, 1u);
+        u32 height = std::max(pyramid.extent.height >> level, 1u);
+
+        DepthPyramidPushConstant push_constant{
+            .level = level
+        };
+
+        api.bind_descriptor(cmd, m_pipeline, m_descriptors[level], 0U);
+        api.push_constants(cmd, m_pipeline, &push_constant);
+        api.dispatch_compute_pipeline(cmd, Utils::div_ceil(width, GPU_DEPTH_PYRAMID_GROUP_SIZE), Utils::div_ceil(height, GPU_DEPTH_PYRAMID_GROUP_SIZE));
+
+        // The next level reads this one
+        api.image_barrier(cmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, {
+            ImageBarrier{
+                .image_handle = shared.depth_pyramid_image,
+                .src_access_mask = VK_ACCESS_SHADER_WRITE_BIT,
+                .dst_access_mask = VK_ACCESS_SHADER_READ_BIT,
+                .old_layout = VK_IMAGE_LAYOUT_GENERAL,
+                .new_layout = VK_IMAGE_LAYOUT_GENERAL,
+                .base_mipmap_level_override = level,
+                .mipmap_level_count_override = 1u
+            },
+        });
+    }
+}
+void DepthPyramidPass::declare_resources(PassResources &resources, const RendererSharedObjects &shared) const {
+    resources.read_image(shared.depth_image, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+    resources.write_image(shared.depth_pyramid_image, VK_IMAGE_LAYOUT_GENERAL, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+}
\ No newline at end of file
@@ -0,0 +1,24 @@
+#ifndef DEPTH_PYRAMID_PASS_HPP
+#define DEPTH_PYRAMID_PASS_HPP
+
+#include <renderer/base_pass.hpp>
+
+struct DepthPyramidPushConstant {
+    u32 level{}; // Level 0 is reduced from the depth image, the others from the previous level
+};
+
+// Builds a min depth (farthest with reverse Z) pyramid out of the early Geometry Pass depth for the late occlusion cull phase
+class DepthPyramidPass : public BasePass {
+public:
+    void init(const RenderAPI &api, const RendererSharedObjects &shared, const Window &window) override;
+    void resize(const RenderAPI &api, const RendererSharedObjects &shared, const Window &window) override;
+    void destroy(const RenderAPI &api) override;
+    void process(Handle<CommandList> cmd, const RenderAPI &api, const RendererSharedObjects &shared, const World &world) override;
+    void declare_resources(PassResources &resources, const RendererSharedObjects &shared) const override;
+
+private:
+    std::vector<Handle<Descriptor>> m_descriptors{}; // One per pyramid level
+    Handle<ComputePipeline> m_pipeline{};
+};
+
+#endif
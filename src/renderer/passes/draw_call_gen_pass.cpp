@@ -13,6 +13,19 @@ void DrawCallGenPass::init(const RenderAPI &api, const RendererSharedObjects &sh
             DescriptorBindingCreateInfo{VK_DESCRIPTOR_TYPE_STORAGE_BUFFER}, // Draw Commands
             DescriptorBindingCreateInfo{VK_DESCRIPTOR_TYPE_STORAGE_BUFFER}, // Draw Commands Count
             DescriptorBindingCreateInfo{VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER}, // Camera Buffer
+            DescriptorBindingCreateInfo{VK_DESCRIPTOR_TYPE_STORAGE_BUFFER}, // Cluster Cull Job Buffer
+            DescriptorBindingCreateInfo{VK_DESCRIPTOR_TYPE_STORAGE_BUFFER}, // Cluster Cull Dispatch Buffer
+            DescriptorBindingCreateInfo{VK_DESCRIPTOR_TYPE_STORAGE_BUFFER}, // Visibility Buffer
+            DescriptorBindingCreateInfo{VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER}, // Depth Pyramid
+            DescriptorBindingCreateInfo{VK_DESCRIPTOR_TYPE_STORAGE_BUFFER}, // Occlusion Cull Stats Buffer
+            DescriptorBindingCreateInfo{VK_DESCRIPTOR_TYPE_STORAGE_BUFFER}, // Draw Bucket Count Buffer
+            DescriptorBindingCreateInfo{VK_DESCRIPTOR_TYPE_STORAGE_BUFFER}, // Draw Bucket Offset Buffer
+            DescriptorBindingCreateInfo{VK_DESCRIPTOR_TYPE_STORAGE_BUFFER}, // Draw Bucket Block Buffer
+            DescriptorBindingCreateInfo{VK_DESCRIPTOR_TYPE_STORAGE_BUFFER}, // Visible Instance Buffer
+            DescriptorBindingCreateInfo{VK_DESCRIPTOR_TYPE_STORAGE_BUFFER}, // Draw Instance Dispatch Buffer
+            DescriptorBindingCreateInfo{VK_DESCRIPTOR_TYPE_STORAGE_BUFFER}, // Draw Instance Buffer
+            DescriptorBindingCreateInfo{VK_DESCRIPTOR_TYPE_STORAGE_BUFFER}, // Renderable Object Buffer
+            DescriptorBindingCreateInfo{VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER}, // View Buffer
         }
     });
 
@@ -51,13 +64,13 @@ void DrawCallGenPass::init(const RenderAPI &api, const RendererSharedObjects &sh
             DescriptorBindingUpdateInfo{
                 .binding_index = 5U,
                 .buffer_info {
-                    .buffer_handle = shared.scene_draw_buffer
+                    .buffer_handle = m_is_late_phase ? shared.scene_late_draw_buffer : shared.scene_draw_buffer
                 }
             },
             DescriptorBindingUpdateInfo{
                 .binding_index = 6U,
                 .buffer_info {
-                    .buffer_handle = shared.scene_draw_count_buffer
+                    .buffer_handle = m_is_late_phase ? shared.scene_late_draw_count_buffer : shared.scene_draw_count_buffer
                 }
             },
             DescriptorBindingUpdateInfo{
@@ -65,65 +78,338 @@ void DrawCallGenPass::init(const RenderAPI &api, const RendererSharedObjects &sh
                 .buffer_info {
                     .buffer_handle = shared.scene_camera_buffer
                 },
+            },
+            DescriptorBindingUpdateInfo{
+                .binding_index = 8U,
+                .buffer_info {
+                    .buffer_handle = shared.scene_cluster_job_buffer
+                }
+            },
+            DescriptorBindingUpdateInfo{
+                .binding_index = 9U,
+                .buffer_info {
+                    .buffer_handle = shared.scene_cluster_dispatch_buffer
+                }
+            },
+            DescriptorBindingUpdateInfo{
+                .binding_index = 10U,
+                .buffer_info {
+                    .buffer_handle = shared.scene_visibility_buffer
+                }
+            },
+            DescriptorBindingUpdateInfo{
+                .binding_index = 11U,
+                .image_info {
+                    .image_handle = shared.depth_pyramid_image,
+                    .image_sampler = shared.depth_pyramid_sampler
+                }
+            },
+            DescriptorBindingUpdateInfo{
+                .binding_index = 12U,
+                .buffer_info {
+                    .buffer_handle = shared.scene_occlusion_stats_buffer
+                }
+            },
+            DescriptorBindingUpdateInfo{
+                .binding_index = 13U,
+                .buffer_info {
+                    .buffer_handle = shared.scene_draw_bucket_count_buffer
+                }
+            },
+            DescriptorBindingUpdateInfo{
+                .binding_index = 14U,
+                .buffer_info {
+                    .buffer_handle = shared.scene_draw_bucket_offset_buffer
+                }
+            },
+            DescriptorBindingUpdateInfo{
+                .binding_index = 15U,
+                .buffer_info {
+                    .buffer_handle = shared.scene_draw_bucket_block_buffer
+                }
+            },
+            DescriptorBindingUpdateInfo{
+                .binding_index = 16U,
+                .buffer_info {
+                    .buffer_handle = shared.scene_visible_instance_buffer
+                }
+            },
+            DescriptorBindingUpdateInfo{
+                .binding_index = 17U,
+                .buffer_info {
+                    .buffer_handle = m_is_late_phase ? shared.scene_late_draw_instance_dispatch_buffer : shared.scene_draw_instance_dispatch_buffer
+                }
+            },
+            DescriptorBindingUpdateInfo{
+                .binding_index = 18U,
+                .buffer_info {
+                    .buffer_handle = m_is_late_phase ? shared.scene_late_draw_instance_buffer : shared.scene_draw_instance_buffer
+                }
+            },
+            DescriptorBindingUpdateInfo{
+                .binding_index = 19U,
+                .buffer_info {
+                    .buffer_handle = shared.scene_renderable_object_buffer
+                }
+            },
+            DescriptorBindingUpdateInfo{
+                .binding_index = 20U,
+                .buffer_info {
+                    .buffer_handle = shared.scene_view_buffer
+                }
             }
         }
     });
 
+    u32 occlusion_cull_phase = GPU_OCCLUSION_CULL_PHASE_DISABLED;
+    if (m_is_late_phase) {
+        occlusion_cull_phase = GPU_OCCLUSION_CULL_PHASE_LATE;
+    } else if (shared.config_enable_occlusion_cull) {
+        occlusion_cull_phase = GPU_OCCLUSION_CULL_PHASE_EARLY;
+    }
+
     m_pipeline = api.rm->create_compute_pipeline(ComputePipelineCreateInfo{
         .shader_path = "./shaders/draw_call_gen.comp.spv",
         .shader_constant_values {
             static_cast<uint32_t>(shared.config_enable_dynamic_lod),
             static_cast<uint32_t>(shared.config_enable_frustum_cull),
             api.instance->get_physical_device_preferred_warp_size(),
+            // Newly visible objects are rare, so the late phase skips cluster culling and draws them whole
+            static_cast<uint32_t>(shared.config_enable_cluster_cull && !m_is_late_phase),
+            occlusion_cull_phase,
         },
         .push_constants_size = sizeof(DrawCallGenPushConstant),
         .descriptors { m_descriptor }
     });
+    m_bucket_scan_pipeline = api.rm->create_compute_pipeline(ComputePipelineCreateInfo{
+        .shader_path = "./shaders/draw_bucket_scan.comp.spv",
+        .push_constants_size = sizeof(DrawBucketPushConstant),
+        .descriptors { m_descriptor }
+    });
+    m_bucket_emit_pipeline = api.rm->create_compute_pipeline(ComputePipelineCreateInfo{
+        .shader_path = "./shaders/draw_bucket_emit.comp.spv",
+        .push_constants_size = sizeof(DrawBucketPushConstant),
+        .descriptors { m_descriptor }
+    });
+    m_instance_scatter_pipeline = api.rm->create_compute_pipeline(ComputePipelineCreateInfo{
+        .shader_path = "./shaders/draw_instance_scatter.comp.spv",
+        .push_constants_size = sizeof(DrawBucketPushConstant),
+        .descriptors { m_descriptor }
+    });
 }
 void DrawCallGenPass::resize(const RenderAPI &api, const RendererSharedObjects &shared, const Window &window) {
-
+    api.rm->update_descriptor(m_descriptor, DescriptorUpdateInfo{
+        .bindings{
+            DescriptorBindingUpdateInfo{
+                .binding_index = 11U,
+                .image_info {
+                    .image_handle = shared.depth_pyramid_image,
+                    .image_sampler = shared.depth_pyramid_sampler
+                }
+            }
+        }
+    });
 }
 void DrawCallGenPass::destroy(const RenderAPI &api) {
     api.rm->destroy(m_pipeline);
+    api.rm->destroy(m_bucket_scan_pipeline);
+    api.rm->destroy(m_bucket_emit_pipeline);
+    api.rm->destroy(m_instance_scatter_pipeline);
     api.rm->destroy(m_descriptor);
 }
 
 
 void DrawCallGenPass::process(Handle<CommandList> cmd, const RenderAPI &api, const RendererSharedObjects &shared, const World &world) {
-    api.fill_buffer(cmd, shared.scene_draw_count_buffer, 0U, sizeof(u32));
+    Handle<Buffer> draw_count_buffer = m_is_late_phase ? shared.scene_late_draw_count_buffer : shared.scene_draw_count_buffer;
+    Handle<Buffer> draw_instance_dispatch_buffer = m_is_late_phase ? shared.scene_late_draw_instance_dispatch_buffer : shared.scene_draw_instance_dispatch_buffer;
+
+    if (m_is_late_phase) {
+        // The stats of the previous frame might still be copied out
+        api.buffer_barrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, {
+            BufferBarrier{
+                .buffer_handle = shared.scene_occlusion_stats_buffer,
+                .src_access_mask = VK_ACCESS_TRANSFER_READ_BIT,
+                .dst_access_mask = VK_ACCESS_TRANSFER_WRITE_BIT
+            }
+        });
+
+        api.fill_buffer(cmd, shared.scene_occlusion_stats_buffer, 0U, sizeof(OcclusionCullStats));
+    } else {
+        // Zero jobs and compacted indices, the y and z workgroup counts are always 1
+        api.fill_buffer(cmd, shared.scene_cluster_dispatch_buffer, 0U, sizeof(ClusterCullDispatch));
+        api.fill_buffer(cmd, shared.scene_cluster_dispatch_buffer, 1U, sizeof(u32) * 2U, offsetof(VkDispatchIndirectCommand, y));
+    }
+
+    // The depth pyramid only matches the main camera, so the late phase culls just that one
+    u32 view_count = m_is_late_phase ? 1U : shared.scene_view_count;
+
+    api.fill_buffer(cmd, draw_count_buffer, 0U, sizeof(u32) * GPU_INDEX_TYPE_COUNT * view_count);
+
+    // Zero the scatter workgroups and the instance counts, the y and z workgroup counts are always 1
+    api.fill_buffer(cmd, draw_instance_dispatch_buffer, 0U, sizeof(DrawInstanceDispatch));
+    api.fill_buffer(cmd, draw_instance_dispatch_buffer, 1U, sizeof(u32) * 2U, offsetof(VkDispatchIndirectCommand, y));
 
     api.buffer_barrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, {
         BufferBarrier{
-            .buffer_handle = shared.scene_draw_count_buffer,
+            .buffer_handle = draw_count_buffer,
+            .src_access_mask = VK_ACCESS_TRANSFER_WRITE_BIT,
+            .dst_access_mask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT
+        },
+        BufferBarrier{
+            .buffer_handle = draw_instance_dispatch_buffer,
+            .src_access_mask = VK_ACCESS_TRANSFER_WRITE_BIT,
+            .dst_access_mask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT
+        },
+        BufferBarrier{
+            .buffer_handle = m_is_late_phase ? shared.scene_occlusion_stats_buffer : shared.scene_cluster_dispatch_buffer,
             .src_access_mask = VK_ACCESS_TRANSFER_WRITE_BIT,
             .dst_access_mask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT
         }
     });
 
-    u32 scene_objects_count = static_cast<u32>(world.get_objects().size());
+    const VkExtent3D &depth_extent = api.rm->get_data(shared.depth_image).extent;
 
     DrawCallGenPushConstant push_constant{
-        .object_count_pre_cull = scene_objects_count,
+        .object_count_pre_cull = shared.scene_renderable_object_count,
         .global_lod_bias = shared.config_global_lod_bias,
         .global_cull_dist_multiplier = shared.config_global_cull_dist_multiplier,
-        .lod_sphere_visible_angle = shared.config_lod_sphere_visible_angle
+        .lod_sphere_visible_angle = shared.config_lod_sphere_visible_angle,
+        .cluster_job_capacity = shared.scene_cluster_job_capacity,
+        .lod_error_threshold = shared.config_lod_error_threshold,
+        .visible_instance_capacity = shared.scene_visible_instance_capacity,
+        .view_count = view_count,
+        .view_bucket_count = shared.scene_draw_bucket_count,
+        .depth_pyramid_uv_scale = glm::vec2(
+            static_cast<f32>(shared.render_extent.width) / static_cast<f32>(depth_extent.width),
+            static_cast<f32>(shared.render_extent.height) / static_cast<f32>(depth_extent.height)
+        )
     };
 
     api.begin_compute_pipeline(cmd, m_pipeline);
     api.bind_descriptor(cmd, m_pipeline, m_descriptor, 0U);
     api.push_constants(cmd, m_pipeline, &push_constant);
-    api.dispatch_compute_pipeline(cmd, Utils::div_ceil(scene_objects_count, api.instance->get_physical_device_preferred_warp_size()));
 
-    api.buffer_barrier(cmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT, {
+    // Only live objects are culled, the groups are spread over Y so that every object count fits in the guaranteed maxComputeWorkGroupCount
+    u32 group_count = Utils::div_ceil(shared.scene_renderable_object_count, api.instance->get_physical_device_preferred_warp_size());
+    u32 group_count_x = std::min(group_count, MAX_DISPATCH_GROUP_COUNT);
+    u32 group_count_y = (group_count_x > 0U) ? Utils::div_ceil(group_count, group_count_x) : 0U;
+
+    api.dispatch_compute_pipeline(cmd, group_count_x, group_count_y);
+
+    build_instanced_draws(cmd, api, shared, view_count);
+}
+
+void DrawCallGenPass::build_instanced_draws(Handle<CommandList> cmd, const RenderAPI &api, const RendererSharedObjects &shared, u32 view_count) {
+    Handle<Buffer> draw_instance_dispatch_buffer = m_is_late_phase ? shared.scene_late_draw_instance_dispatch_buffer : shared.scene_draw_instance_dispatch_buffer;
+
+    DrawBucketPushConstant push_constant{
+        .bucket_count = shared.scene_draw_bucket_count * view_count,
+        .scan_level = 0U,
+        .draw_capacity = shared.scene_draw_capacity,
+        .visible_instance_capacity = shared.scene_visible_instance_capacity,
+        .view_bucket_count = shared.scene_draw_bucket_count
+    };
+
+    api.buffer_barrier(cmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, {
+        BufferBarrier{
+            .buffer_handle = shared.scene_draw_bucket_count_buffer,
+            .src_access_mask = VK_ACCESS_SHADER_WRITE_BIT,
+            .dst_access_mask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT
+        },
+        BufferBarrier{
+            .buffer_handle = shared.scene_visible_instance_buffer,
+            .src_access_mask = VK_ACCESS_SHADER_WRITE_BIT,
+            .dst_access_mask = VK_ACCESS_SHADER_READ_BIT
+        },
+        BufferBarrier{
+            .buffer_handle = draw_instance_dispatch_buffer,
+            .src_access_mask = VK_ACCESS_SHADER_WRITE_BIT,
+            .dst_access_mask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT
+        }
+    });
+
+    // Exclusive prefix sum of the bucket counts, first within blocks and then across the block sums
+    api.begin_compute_pipeline(cmd, m_bucket_scan_pipeline);
+    api.bind_descriptor(cmd, m_bucket_scan_pipeline, m_descriptor, 0U);
+    api.push_constants(cmd, m_bucket_scan_pipeline, &push_constant);
+    api.dispatch_compute_pipeline(cmd, Utils::div_ceil(push_constant.bucket_count, GPU_DRAW_BUCKET_SCAN_BLOCK_SIZE));
+
+    api.buffer_barrier(cmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, {
         BufferBarrier{
-            .buffer_handle = shared.scene_draw_buffer,
+            .buffer_handle = shared.scene_draw_bucket_block_buffer,
             .src_access_mask = VK_ACCESS_SHADER_WRITE_BIT,
-            .dst_access_mask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_SHADER_READ_BIT,
+            .dst_access_mask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT
+        }
+    });
+
+    push_constant.scan_level = 1U;
+    api.push_constants(cmd, m_bucket_scan_pipeline, &push_constant);
+    api.dispatch_compute_pipeline(cmd);
+
+    api.buffer_barrier(cmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, {
+        BufferBarrier{
+            .buffer_handle = shared.scene_draw_bucket_offset_buffer,
+            .src_access_mask = VK_ACCESS_SHADER_WRITE_BIT,
+            .dst_access_mask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT
         },
         BufferBarrier{
-            .buffer_handle = shared.scene_draw_count_buffer,
+            .buffer_handle = shared.scene_draw_bucket_block_buffer,
             .src_access_mask = VK_ACCESS_SHADER_WRITE_BIT,
-            .dst_access_mask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT,
+            .dst_access_mask = VK_ACCESS_SHADER_READ_BIT
+        }
+    });
+
+    // One instanced draw per non-empty bucket
+    api.begin_compute_pipeline(cmd, m_bucket_emit_pipeline);
+    api.bind_descriptor(cmd, m_bucket_emit_pipeline, m_descriptor, 0U);
+    api.push_constants(cmd, m_bucket_emit_pipeline, &push_constant);
+    api.dispatch_compute_pipeline(cmd, Utils::div_ceil(push_constant.bucket_count, GPU_DRAW_BUCKET_SCAN_GROUP_SIZE));
+
+    api.buffer_barrier(cmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, {
+        BufferBarrier{
+            .buffer_handle = shared.scene_draw_bucket_offset_buffer,
+            .src_access_mask = VK_ACCESS_SHADER_WRITE_BIT,
+            .dst_access_mask = VK_ACCESS_SHADER_READ_BIT
         },
+        BufferBarrier{
+            .buffer_handle = draw_instance_dispatch_buffer,
+            .src_access_mask = VK_ACCESS_SHADER_WRITE_BIT,
+            .dst_access_mask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_SHADER_READ_BIT
+        }
     });
+
+    api.begin_compute_pipeline(cmd, m_instance_scatter_pipeline);
+    api.bind_descriptor(cmd, m_instance_scatter_pipeline, m_descriptor, 0U);
+    api.push_constants(cmd, m_instance_scatter_pipeline, &push_constant);
+    api.dispatch_indirect_compute_pipeline(cmd, draw_instance_dispatch_buffer);
 }
+void DrawCallGenPass::declare_resources(PassResources &resources, const RendererSharedObjects &shared) const {
+    Handle<Buffer> draw_buffer = m_is_late_phase ? shared.scene_late_draw_buffer : shared.scene_draw_buffer;
+    Handle<Buffer> draw_count_buffer = m_is_late_phase ? shared.scene_late_draw_count_buffer : shared.scene_draw_count_buffer;
+    Handle<Buffer> draw_instance_buffer = m_is_late_phase ? shared.scene_late_draw_instance_buffer : shared.scene_draw_instance_buffer;
+    Handle<Buffer> draw_instance_dispatch_buffer = m_is_late_phase ? shared.scene_late_draw_instance_dispatch_buffer : shared.scene_draw_instance_dispatch_buffer;
+
+    // Cleared with transfers before the culling
+    VkPipelineStageFlags cleared_stages = VK_PIPELINE_STAGE_TRANSFER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+    VkAccessFlags cleared_access = VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+
+    resources.write_buffer(draw_count_buffer, cleared_stages, cleared_access);
+    resources.write_buffer(draw_instance_dispatch_buffer, cleared_stages | VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, cleared_access | VK_ACCESS_INDIRECT_COMMAND_READ_BIT);
+    resources.write_buffer(draw_buffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+    resources.write_buffer(draw_instance_buffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+    resources.write_buffer(shared.scene_visibility_buffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+
+    // Scratch of both phases
+    resources.write_buffer(shared.scene_visible_instance_buffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+    resources.write_buffer(shared.scene_draw_bucket_count_buffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+    resources.write_buffer(shared.scene_draw_bucket_offset_buffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+    resources.write_buffer(shared.scene_draw_bucket_block_buffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+
+    // Bound by both phases, only the late one samples it
+    resources.read_image(shared.depth_pyramid_image, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+
+    if (!m_is_late_phase) {
+        resources.write_buffer(shared.scene_cluster_dispatch_buffer, cleared_stages, cleared_access);
+        resources.write_buffer(shared.scene_cluster_job_buffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT);
+    }
+}
\ No newline at end of file
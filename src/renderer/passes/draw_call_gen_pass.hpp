@@ -8,18 +8,46 @@ struct DrawCallGenPushConstant {
     f32 global_lod_bias{};
     f32 global_cull_dist_multiplier{};
     f32 lod_sphere_visible_angle{};
+    u32 cluster_job_capacity{};
+    f32 lod_error_threshold{};
+    u32 visible_instance_capacity{};
+    u32 view_count{};
+    u32 view_bucket_count{};
+    alignas(8) glm::vec2 depth_pyramid_uv_scale{}; // render_extent / depth image extent, the pyramid covers the whole depth image
+};
+struct DrawBucketPushConstant {
+    u32 bucket_count{}; // Of all views
+    u32 scan_level{};
+    u32 draw_capacity{};
+    u32 visible_instance_capacity{};
+    u32 view_bucket_count{};
 };
 
+// Culled instances are bucketed by (view, primitive, LOD) with a prefix sum and every bucket is drawn as a single instanced draw
+// Every object is loaded once and tested against all views, only the main camera uses occlusion and cluster culling
+// The late phase tests the objects against the depth pyramid and writes to the late draw buffers
 class DrawCallGenPass : public BasePass {
 public:
+    explicit DrawCallGenPass(bool is_late_phase = false) : m_is_late_phase(is_late_phase) {}
+
     void init(const RenderAPI &api, const RendererSharedObjects &shared, const Window &window) override;
     void resize(const RenderAPI &api, const RendererSharedObjects &shared, const Window &window) override;
     void destroy(const RenderAPI &api) override;
     void process(Handle<CommandList> cmd, const RenderAPI &api, const RendererSharedObjects &shared, const World &world) override;
+    void declare_resources(PassResources &resources, const RendererSharedObjects &shared) const override;
 
 private:
+    void build_instanced_draws(Handle<CommandList> cmd, const RenderAPI &api, const RendererSharedObjects &shared, u32 view_count);
+
+    static constexpr u32 MAX_DISPATCH_GROUP_COUNT = 65535U; // Guaranteed minimum of maxComputeWorkGroupCount
+
+    bool m_is_late_phase{};
+
     Handle<Descriptor> m_descriptor{};
     Handle<ComputePipeline> m_pipeline{};
+    Handle<ComputePipeline> m_bucket_scan_pipeline{};
+    Handle<ComputePipeline> m_bucket_emit_pipeline{};
+    Handle<ComputePipeline> m_instance_scatter_pipeline{};
 };
 
 #endif
\ No newline at end of file
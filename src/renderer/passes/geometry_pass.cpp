@@ -13,6 +13,10 @@ void GeometryPass::init(const RenderAPI &api, const RendererSharedObjects &share
             DescriptorBindingCreateInfo{VK_DESCRIPTOR_TYPE_STORAGE_BUFFER}, // Mesh Instance Materials Buffer
             DescriptorBindingCreateInfo{VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER}, // Camera Buffer
             DescriptorBindingCreateInfo{VK_DESCRIPTOR_TYPE_STORAGE_BUFFER}, // Vertex Buffer
+            DescriptorBindingCreateInfo{VK_DESCRIPTOR_TYPE_STORAGE_BUFFER}, // Texture Feedback Buffer
+            DescriptorBindingCreateInfo{VK_DESCRIPTOR_TYPE_STORAGE_BUFFER}, // Compact Vertex Buffer
+            DescriptorBindingCreateInfo{VK_DESCRIPTOR_TYPE_STORAGE_BUFFER}, // Primitive Buffer
+            DescriptorBindingCreateInfo{VK_DESCRIPTOR_TYPE_STORAGE_BUFFER}, // Draw Instance Buffer
         }
     });
     
@@ -21,7 +25,7 @@ void GeometryPass::init(const RenderAPI &api, const RendererSharedObjects &share
             DescriptorBindingUpdateInfo{
                 .binding_index = 0U,
                 .buffer_info {
-                    .buffer_handle = shared.scene_draw_buffer
+                    .buffer_handle = m_is_late_phase ? shared.scene_late_draw_buffer : shared.scene_draw_buffer
                 }
             },
             DescriptorBindingUpdateInfo{
@@ -65,30 +69,66 @@ void GeometryPass::init(const RenderAPI &api, const RendererSharedObjects &share
                 .buffer_info {
                     .buffer_handle = shared.scene_vertex_buffer
                 }
+            },
+            DescriptorBindingUpdateInfo{
+                .binding_index = 8U,
+                .buffer_info {
+                    .buffer_handle = shared.scene_texture_feedback_buffer
+                }
+            },
+            DescriptorBindingUpdateInfo{
+                .binding_index = 9U,
+                .buffer_info {
+                    .buffer_handle = shared.scene_vertex_buffer
+                }
+            },
+            DescriptorBindingUpdateInfo{
+                .binding_index = 10U,
+                .buffer_info {
+                    .buffer_handle = shared.scene_primitive_buffer
+                }
+            },
+            DescriptorBindingUpdateInfo{
+                .binding_index = 11U,
+                .buffer_info {
+                    .buffer_handle = m_is_late_phase ? shared.scene_late_draw_instance_buffer : shared.scene_draw_instance_buffer
+                }
             }
         }
     });
 
+    m_use_visibility_buffer = shared.config_enable_visibility_buffer;
+
+    VkAttachmentLoadOp load_op = m_is_late_phase ? VK_ATTACHMENT_LOAD_OP_LOAD : VK_ATTACHMENT_LOAD_OP_CLEAR;
+
+    std::vector<RenderTargetCommonInfo> color_targets{};
+    for (const auto &image : get_color_images(shared)) {
+        color_targets.push_back(RenderTargetCommonInfo {
+            .format = api.rm->get_data(image).format,
+            .layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+            .load_op = load_op
+        });
+    }
+
+    // Textures are sampled later by the Material Pass if the visibility buffer is used
+    std::vector<Handle<Descriptor>> descriptors{ m_descriptor };
+    if (!m_use_visibility_buffer) {
+        descriptors.push_back(shared.scene_texture_descriptor);
+    }
+
     m_pipeline = api.rm->create_graphics_pipeline(GraphicsPipelineCreateInfo{
-        .vertex_shader_path = "./shaders/forward.vert.spv",
-        .fragment_shader_path = "./shaders/forward.frag.spv",
+        .vertex_shader_path = m_use_visibility_buffer ? "./shaders/visibility.vert.spv" : "./shaders/forward.vert.spv",
+        .fragment_shader_path = m_use_visibility_buffer ? "./shaders/visibility.frag.spv" : "./shaders/forward.frag.spv",
+        .fragment_constant_values { static_cast<u32>(shared.config_gbuffer_layout) },
 
-        //.push_constants_size = sizeof(PushConstants),
-        .descriptors { m_descriptor, shared.scene_texture_descriptor },
+        .push_constants_size = sizeof(GeometryPushConstant),
+        .descriptors = descriptors,
 
-        .color_targets {
-            RenderTargetCommonInfo {
-                .format = api.rm->get_data(shared.albedo_image).format,
-                .layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
-            },
-            RenderTargetCommonInfo {
-                .format = api.rm->get_data(shared.normal_image).format,
-                .layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL
-            }
-        },
+        .color_targets = color_targets,
         .depth_target {
             .format = api.rm->get_data(shared.depth_image).format,
-            .layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL
+            .layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+            .load_op = load_op
         },
 
         .enable_depth_test = true,
@@ -97,36 +137,12 @@ void GeometryPass::init(const RenderAPI &api, const RendererSharedObjects &share
         .depth_compare_op = VK_COMPARE_OP_GREATER,
     });
 
-    m_render_target = api.rm->create_render_target(m_pipeline, RenderTargetCreateInfo{
-        .color_attachments = {
-            RenderTargetAttachmentCreateInfo {
-                .target_handle = shared.albedo_image,
-            },
-            RenderTargetAttachmentCreateInfo {
-                .target_handle = shared.normal_image,
-            }
-        },
-        .depth_attachment = {
-            .target_handle = shared.depth_image
-        }
-    });
+    create_render_target(api, shared);
 }
 void GeometryPass::resize(const RenderAPI &api, const RendererSharedObjects &shared, const Window &window) {
     api.rm->destroy(m_render_target);
 
-    m_render_target = api.rm->create_render_target(m_pipeline, RenderTargetCreateInfo{
-        .color_attachments = {
-            RenderTargetAttachmentCreateInfo {
-                .target_handle = shared.albedo_image,
-            },
-            RenderTargetAttachmentCreateInfo {
-                .target_handle = shared.normal_image,
-            }
-        },
-        .depth_attachment = {
-            .target_handle = shared.depth_image
-        }
-    });
+    create_render_target(api, shared);
 }
 void GeometryPass::destroy(const RenderAPI &api) {
     api.rm->destroy(m_render_target);
@@ -135,39 +151,95 @@ void GeometryPass::destroy(const RenderAPI &api) {
 }
 
 void GeometryPass::process(Handle<CommandList> cmd, const RenderAPI &api, const RendererSharedObjects &shared, const World &world) {
-    api.image_barrier(cmd, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, {
-        ImageBarrier{
-            .image_handle = shared.albedo_image,
-            .src_access_mask = VK_ACCESS_SHADER_READ_BIT,
-            .dst_access_mask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
-            .old_layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-            .new_layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL
-        },
-        ImageBarrier{
-            .image_handle = shared.normal_image,
-            .src_access_mask = VK_ACCESS_SHADER_READ_BIT,
-            .dst_access_mask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
-            .old_layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-            .new_layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL
-        }
+    // Zero is also the empty visibility texel
+    std::vector<RenderTargetClear> color_clears(get_color_images(shared).size(), RenderTargetClear{
+        .color = {0.0f, 0.0f, 0.0f, 0.0f},
     });
 
-    api.begin_graphics_pipeline(cmd, m_pipeline, m_render_target, {
-        RenderTargetClear{
-            .color = {0.0f, 0.0f, 0.0f, 0.0f},
-        },
-        RenderTargetClear{
-            .color = {0.0f, 0.0f, 0.0f, 0.0f},
-        }
-    }, RenderTargetClear{
+    api.begin_graphics_pipeline(cmd, m_pipeline, m_render_target, color_clears, RenderTargetClear{
         .depth = 0.0f
-    });
+    }, shared.render_extent);
 
     // No vertex buffer bound because of programmable vertex fetching
     api.bind_descriptor(cmd, m_pipeline, m_descriptor, 0U);
-    api.bind_descriptor(cmd, m_pipeline, shared.scene_texture_descriptor, 1U);
-    api.bind_index_buffer(cmd, shared.scene_index_buffer);
-    api.draw_indexed_indirect_count(cmd,shared.scene_draw_buffer, shared.scene_draw_count_buffer, world.get_objects().size(), sizeof(DrawCommand));
+    if (!m_use_visibility_buffer) {
+        api.bind_descriptor(cmd, m_pipeline, shared.scene_texture_descriptor, 1U);
+    }
+
+    Handle<Buffer> draw_buffer = m_is_late_phase ? shared.scene_late_draw_buffer : shared.scene_draw_buffer;
+    Handle<Buffer> draw_count_buffer = m_is_late_phase ? shared.scene_late_draw_count_buffer : shared.scene_draw_count_buffer;
+
+    // One indirect draw per index type bucket
+    for (u32 index_type{}; index_type < GPU_INDEX_TYPE_COUNT; ++index_type) {
+        GeometryPushConstant push_constant{
+            .draw_command_offset = index_type * shared.scene_draw_capacity,
+            .index_type = index_type,
+            .instance_flags = m_is_late_phase ? GPU_VISIBILITY_LATE_PHASE_BIT : 0U
+        };
+
+        api.push_constants(cmd, m_pipeline, &push_constant);
+
+        if (index_type == GPU_INDEX_TYPE_U16) {
+            api.bind_index_buffer(cmd, shared.scene_index16_buffer, 0, VK_INDEX_TYPE_UINT16);
+        } else {
+            api.bind_index_buffer(cmd, shared.scene_index_buffer, 0, VK_INDEX_TYPE_UINT32);
+        }
+
+        api.draw_indexed_indirect_count(
+            cmd,
+            draw_buffer,
+            draw_count_buffer,
+            shared.scene_draw_capacity,
+            sizeof(DrawCommand),
+            static_cast<VkDeviceSize>(push_constant.draw_command_offset) * sizeof(DrawCommand),
+            index_type * sizeof(u32)
+        );
+    }
 
     api.end_graphics_pipeline(cmd, m_pipeline);
 }
+
+void GeometryPass::declare_resources(PassResources &resources, const RendererSharedObjects &shared) const {
+    Handle<Buffer> draw_buffer = m_is_late_phase ? shared.scene_late_draw_buffer : shared.scene_draw_buffer;
+    Handle<Buffer> draw_count_buffer = m_is_late_phase ? shared.scene_late_draw_count_buffer : shared.scene_draw_count_buffer;
+    Handle<Buffer> draw_instance_buffer = m_is_late_phase ? shared.scene_late_draw_instance_buffer : shared.scene_draw_instance_buffer;
+
+    resources.read_buffer(draw_buffer, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT, VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_SHADER_READ_BIT);
+    resources.read_buffer(draw_count_buffer, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, VK_ACCESS_INDIRECT_COMMAND_READ_BIT);
+    resources.read_buffer(draw_instance_buffer, VK_PIPELINE_STAGE_VERTEX_SHADER_BIT);
+    resources.read_buffer(shared.scene_index_buffer, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_ACCESS_INDEX_READ_BIT);
+
+    // The late phase loads the results of the early phase
+    VkAccessFlags color_access = m_is_late_phase ? VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT : VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+
+    std::vector<Handle<Image>> color_images = shared.config_enable_visibility_buffer ? std::vector{ shared.visibility_image } : std::vector{ shared.albedo_image, shared.normal_image };
+    for (const auto &image : color_images) {
+        resources.write_image(image, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, color_access);
+    }
+
+    resources.write_image(shared.depth_image, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+        VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT);
+}
+
+void GeometryPass::create_render_target(const RenderAPI &api, const RendererSharedObjects &shared) {
+    std::vector<RenderTargetAttachmentCreateInfo> color_attachments{};
+    for (const auto &image : get_color_images(shared)) {
+        color_attachments.push_back(RenderTargetAttachmentCreateInfo {
+            .target_handle = image,
+        });
+    }
+
+    m_render_target = api.rm->create_render_target(m_pipeline, RenderTargetCreateInfo{
+        .color_attachments = color_attachments,
+        .depth_attachment = {
+            .target_handle = shared.depth_image
+        }
+    });
+}
+std::vector<Handle<Image>> GeometryPass::get_color_images(const RendererSharedObjects &shared) const {
+    if (m_use_visibility_buffer) {
+        return { shared.visibility_image };
+    }
+
+    return { shared.albedo_image, shared.normal_image };
+}
@@ -3,14 +3,31 @@
 
 #include <renderer/base_pass.hpp>
 
+struct GeometryPushConstant {
+    u32 draw_command_offset{}; // Start of the index type bucket in the draw buffer
+    u32 index_type{}; // GPU_INDEX_TYPE_* of the bucket
+    u32 instance_flags{}; // GPU_VISIBILITY_LATE_PHASE_BIT in the late phase, used only by the visibility buffer
+};
+
+// The late phase draws over the results of the early phase using the late draw buffers
+// With config_enable_visibility_buffer only triangle ids are written and the Material Pass fills the G-Buffer
 class GeometryPass : public BasePass {
 public:
+    explicit GeometryPass(bool is_late_phase = false) : m_is_late_phase(is_late_phase) {}
+
     void init(const RenderAPI &api, const RendererSharedObjects &shared, const Window &window) override;
     void resize(const RenderAPI &api, const RendererSharedObjects &shared, const Window &window) override;
     void destroy(const RenderAPI &api) override;
     void process(Handle<CommandList> cmd, const RenderAPI &api, const RendererSharedObjects &shared, const World &world) override;
+    void declare_resources(PassResources &resources, const RendererSharedObjects &shared) const override;
 
 private:
+    void create_render_target(const RenderAPI &api, const RendererSharedObjects &shared);
+    std::vector<Handle<Image>> get_color_images(const RendererSharedObjects &shared) const;
+
+    bool m_is_late_phase{};
+    bool m_use_visibility_buffer{};
+
     Handle<RenderTarget> m_render_target{};
     Handle<Descriptor> m_descriptor{};
     Handle<GraphicsPipeline> m_pipeline{};
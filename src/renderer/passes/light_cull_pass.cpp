@@ -0,0 +1,69 @@
+#include "light_cull_pass.hpp"
+
+void LightCullPass::init(const RenderAPI &api, const RendererSharedObjects &shared, const Window &window) {
+    m_descriptor = api.rm->create_descriptor(DescriptorCreateInfo{
+        .bindings {
+            DescriptorBindingCreateInfo{VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER}, // Camera Buffer
+            DescriptorBindingCreateInfo{VK_DESCRIPTOR_TYPE_STORAGE_BUFFER}, // Light Buffer
+            DescriptorBindingCreateInfo{VK_DESCRIPTOR_TYPE_STORAGE_BUFFER}, // Light Cluster Count Buffer
+            DescriptorBindingCreateInfo{VK_DESCRIPTOR_TYPE_STORAGE_BUFFER}, // Light Cluster Index Buffer
+        }
+    });
+
+    api.rm->update_descriptor(m_descriptor, DescriptorUpdateInfo{
+        .bindings{
+            DescriptorBindingUpdateInfo{
+                .binding_index = 0U,
+                .buffer_info {
+                    .buffer_handle = shared.scene_camera_buffer
+                }
+            },
+            DescriptorBindingUpdateInfo{
+                .binding_index = 1U,
+                .buffer_info {
+                    .buffer_handle = shared.scene_light_buffer
+                }
+            },
+            DescriptorBindingUpdateInfo{
+                .binding_index = 2U,
+                .buffer_info {
+                    .buffer_handle = shared.scene_light_cluster_count_buffer
+                }
+            },
+            DescriptorBindingUpdateInfo{
+                .binding_index = 3U,
+                .buffer_info {
+                    .buffer_handle = shared.scene_light_cluster_index_buffer
+                }
+            },
+        }
+    });
+
+    m_pipeline = api.rm->create_compute_pipeline(ComputePipelineCreateInfo{
+        .shader_path = "./shaders/light_cull.comp.spv",
+        .push_constants_size = sizeof(LightCullPushConstant),
+        .descriptors { m_descriptor }
+    });
+}
+void LightCullPass::resize(const RenderAPI &api, const RendererSharedObjects &shared, const Window &window) {
+
+}
+void LightCullPass::destroy(const RenderAPI &api) {
+    api.rm->destroy(m_pipeline);
+    api.rm->destroy(m_descriptor);
+}
+
+void LightCullPass::process(Handle<CommandList> cmd, const RenderAPI &api, const RendererSharedObjects &shared, const World &world) {
+    LightCullPushConstant push_constant{
+        .light_count = shared.scene_light_count
+    };
+
+    api.begin_compute_pipeline(cmd, m_pipeline);
+    api.bind_descriptor(cmd, m_pipeline, m_descriptor, 0U);
+    api.push_constants(cmd, m_pipeline, &push_constant);
+    api.dispatch_compute_pipeline(cmd, GPU_LIGHT_CLUSTER_COUNT);
+}
+void LightCullPass::declare_resources(PassResources &resources, const RendererSharedObjects &shared) const {
+    resources.write_buffer(shared.scene_light_cluster_count_buffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT);
+    resources.write_buffer(shared.scene_light_cluster_index_buffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT);
+}
\ No newline at end of file
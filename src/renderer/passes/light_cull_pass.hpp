@@ -0,0 +1,24 @@
+#ifndef LIGHT_CULL_PASS_HPP
+#define LIGHT_CULL_PASS_HPP
+
+#include <renderer/base_pass.hpp>
+
+struct LightCullPushConstant {
+    u32 light_count{};
+};
+
+// Bins the scene lights into a GPU_LIGHT_CLUSTER_X * Y * Z view space grid of the main camera, the Composite Pass shades only the lights of a pixel's cluster
+class LightCullPass : public BasePass {
+public:
+    void init(const RenderAPI &api, const RendererSharedObjects &shared, const Window &window) override;
+    void resize(const RenderAPI &api, const RendererSharedObjects &shared, const Window &window) override;
+    void destroy(const RenderAPI &api) override;
+    void process(Handle<CommandList> cmd, const RenderAPI &api, const RendererSharedObjects &shared, const World &world) override;
+    void declare_resources(PassResources &resources, const RendererSharedObjects &shared) const override;
+
+private:
+    Handle<Descriptor> m_descriptor{};
+    Handle<ComputePipeline> m_pipeline{};
+};
+
+#endif
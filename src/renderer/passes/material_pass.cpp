@@ -0,0 +1,208 @@
+#include "material_pass.hpp"
+
+#include "renderer/renderer.hpp"
+
+void MaterialPass::init(const RenderAPI &api, const RendererSharedObjects &shared, const Window &window) {
+    m_descriptor = api.rm->create_descriptor(DescriptorCreateInfo{
+        .bindings {
+            DescriptorBindingCreateInfo{VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER}, // Visibility Image
+            DescriptorBindingCreateInfo{VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER}, // Camera Buffer
+            DescriptorBindingCreateInfo{VK_DESCRIPTOR_TYPE_STORAGE_BUFFER}, // Draw Instance Buffer
+            DescriptorBindingCreateInfo{VK_DESCRIPTOR_TYPE_STORAGE_BUFFER}, // Late Draw Instance Buffer
+            DescriptorBindingCreateInfo{VK_DESCRIPTOR_TYPE_STORAGE_BUFFER}, // Scene Object Buffer
+            DescriptorBindingCreateInfo{VK_DESCRIPTOR_TYPE_STORAGE_BUFFER}, // Mesh Instance Buffer
+            DescriptorBindingCreateInfo{VK_DESCRIPTOR_TYPE_STORAGE_BUFFER}, // Mesh Buffer
+            DescriptorBindingCreateInfo{VK_DESCRIPTOR_TYPE_STORAGE_BUFFER}, // Primitive Buffer
+            DescriptorBindingCreateInfo{VK_DESCRIPTOR_TYPE_STORAGE_BUFFER}, // Global Transform Buffer
+            DescriptorBindingCreateInfo{VK_DESCRIPTOR_TYPE_STORAGE_BUFFER}, // Vertex Buffer
+            DescriptorBindingCreateInfo{VK_DESCRIPTOR_TYPE_STORAGE_BUFFER}, // Compact Vertex Buffer
+            DescriptorBindingCreateInfo{VK_DESCRIPTOR_TYPE_STORAGE_BUFFER}, // Index Buffer
+            DescriptorBindingCreateInfo{VK_DESCRIPTOR_TYPE_STORAGE_BUFFER}, // Index16 Buffer
+            DescriptorBindingCreateInfo{VK_DESCRIPTOR_TYPE_STORAGE_BUFFER}, // Material Buffer
+            DescriptorBindingCreateInfo{VK_DESCRIPTOR_TYPE_STORAGE_BUFFER}, // Mesh Instance Materials Buffer
+            DescriptorBindingCreateInfo{VK_DESCRIPTOR_TYPE_STORAGE_BUFFER}, // Texture Feedback Buffer
+        }
+    });
+
+    api.rm->update_descriptor(m_descriptor, DescriptorUpdateInfo{
+        .bindings {
+            DescriptorBindingUpdateInfo {
+                .binding_index = 0u,
+                .image_info {
+                    .image_handle = shared.visibility_image,
+                    .image_sampler = shared.offscreen_sampler
+                }
+            },
+            DescriptorBindingUpdateInfo {
+                .binding_index = 1u,
+                .buffer_info {
+                    .buffer_handle = shared.scene_camera_buffer
+                }
+            },
+            DescriptorBindingUpdateInfo {
+                .binding_index = 2u,
+                .buffer_info {
+                    .buffer_handle = shared.scene_draw_instance_buffer
+                }
+            },
+            DescriptorBindingUpdateInfo {
+                .binding_index = 3u,
+                .buffer_info {
+                    .buffer_handle = shared.scene_late_draw_instance_buffer
+                }
+            },
+            DescriptorBindingUpdateInfo {
+                .binding_index = 4u,
+                .buffer_info {
+                    .buffer_handle = shared.scene_object_buffer
+                }
+            },
+            DescriptorBindingUpdateInfo {
+                .binding_index = 5u,
+                .buffer_info {
+                    .buffer_handle = shared.scene_mesh_instance_buffer
+                }
+            },
+            DescriptorBindingUpdateInfo {
+                .binding_index = 6u,
+                .buffer_info {
+                    .buffer_handle = shared.scene_mesh_buffer
+                }
+            },
+            DescriptorBindingUpdateInfo {
+                .binding_index = 7u,
+                .buffer_info {
+                    .buffer_handle = shared.scene_primitive_buffer
+                }
+            },
+            DescriptorBindingUpdateInfo {
+                .binding_index = 8u,
+                .buffer_info {
+                    .buffer_handle = shared.scene_global_transform_buffer
+                }
+            },
+            DescriptorBindingUpdateInfo {
+                .binding_index = 9u,
+                .buffer_info {
+                    .buffer_handle = shared.scene_vertex_buffer
+                }
+            },
+            DescriptorBindingUpdateInfo {
+                .binding_index = 10u,
+                .buffer_info {
+                    .buffer_handle = shared.scene_vertex_buffer
+                }
+            },
+            DescriptorBindingUpdateInfo {
+                .binding_index = 11u,
+                .buffer_info {
+                    .buffer_handle = shared.scene_index_buffer
+                }
+            },
+            DescriptorBindingUpdateInfo {
+                .binding_index = 12u,
+                .buffer_info {
+                    .buffer_handle = shared.scene_index16_buffer
+                }
+            },
+            DescriptorBindingUpdateInfo {
+                .binding_index = 13u,
+                .buffer_info {
+                    .buffer_handle = shared.scene_material_buffer
+                }
+            },
+            DescriptorBindingUpdateInfo {
+                .binding_index = 14u,
+                .buffer_info {
+                    .buffer_handle = shared.scene_mesh_instance_materials_buffer
+                }
+            },
+            DescriptorBindingUpdateInfo {
+                .binding_index = 15u,
+                .buffer_info {
+                    .buffer_handle = shared.scene_texture_feedback_buffer
+                }
+            }
+        }
+    });
+
+    m_pipeline = api.rm->create_graphics_pipeline(GraphicsPipelineCreateInfo{
+        .vertex_shader_path = "./shaders/fullscreen_tri.vert.spv",
+        .fragment_shader_path = "./shaders/material.frag.spv",
+        .fragment_constant_values { static_cast<u32>(shared.config_gbuffer_layout) },
+        .descriptors = { m_descriptor, shared.scene_texture_descriptor },
+        .color_targets = {
+            RenderTargetCommonInfo {
+                .format = api.rm->get_data(shared.albedo_image).format,
+                .layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+                .load_op = VK_ATTACHMENT_LOAD_OP_DONT_CARE // Every texel is written
+            },
+            RenderTargetCommonInfo {
+                .format = api.rm->get_data(shared.normal_image).format,
+                .layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+                .load_op = VK_ATTACHMENT_LOAD_OP_DONT_CARE // Every texel is written
+            }
+        },
+        .cull_mode = VK_CULL_MODE_NONE,
+    });
+
+    m_render_target = api.rm->create_render_target(m_pipeline, RenderTargetCreateInfo{
+        .color_attachments = {
+            RenderTargetAttachmentCreateInfo {
+                .target_handle = shared.albedo_image
+            },
+            RenderTargetAttachmentCreateInfo {
+                .target_handle = shared.normal_image
+            }
+        }
+    });
+}
+void MaterialPass::resize(const RenderAPI &api, const RendererSharedObjects &shared, const Window &window) {
+    api.rm->update_descriptor(m_descriptor, DescriptorUpdateInfo{
+        .bindings {
+            DescriptorBindingUpdateInfo {
+                .binding_index = 0u,
+                .image_info {
+                    .image_handle = shared.visibility_image,
+                    .image_sampler = shared.offscreen_sampler
+                }
+            }
+        }
+    });
+
+    api.rm->destroy(m_render_target);
+    m_render_target = api.rm->create_render_target(m_pipeline, RenderTargetCreateInfo{
+        .color_attachments = {
+            RenderTargetAttachmentCreateInfo {
+                .target_handle = shared.albedo_image
+            },
+            RenderTargetAttachmentCreateInfo {
+                .target_handle = shared.normal_image
+            }
+        }
+    });
+}
+void MaterialPass::destroy(const RenderAPI &api) {
+    api.rm->destroy(m_render_target);
+    api.rm->destroy(m_pipeline);
+    api.rm->destroy(m_descriptor);
+}
+
+void MaterialPass::process(Handle<CommandList> cmd, const RenderAPI &api, const RendererSharedObjects &shared, const World &world) {
+    // Empty texels are written with the clear value of the forward Geometry Pass
+    api.begin_graphics_pipeline(cmd, m_pipeline, m_render_target, {RenderTargetClear{}, RenderTargetClear{}}, RenderTargetClear{}, shared.render_extent);
+    api.bind_descriptor(cmd, m_pipeline, m_descriptor, 0U);
+    api.bind_descriptor(cmd, m_pipeline, shared.scene_texture_descriptor, 1U);
+    api.draw_count(cmd, 3U);
+    api.end_graphics_pipeline(cmd, m_pipeline);
+}
+void MaterialPass::declare_resources(PassResources &resources, const RendererSharedObjects &shared) const {
+    resources.read_image(shared.visibility_image, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+    resources.read_buffer(shared.scene_draw_instance_buffer, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+    resources.read_buffer(shared.scene_late_draw_instance_buffer, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+    resources.read_buffer(shared.scene_index_buffer, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+
+    // The same G-Buffer as the forward Geometry Pass
+    resources.write_image(shared.albedo_image, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT);
+    resources.write_image(shared.normal_image, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT);
+}
\ No newline at end of file
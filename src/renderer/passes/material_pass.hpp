@@ -0,0 +1,22 @@
+#ifndef MATERIAL_PASS_HPP
+#define MATERIAL_PASS_HPP
+
+#include <renderer/base_pass.hpp>
+
+// Shades every pixel of the visibility buffer exactly once and writes the same G-Buffer as the forward Geometry Pass
+// Vertex attributes are fetched again for the visible triangle and interpolated with analytic barycentrics
+class MaterialPass : public BasePass {
+public:
+    void init(const RenderAPI &api, const RendererSharedObjects &shared, const Window &window) override;
+    void resize(const RenderAPI &api, const RendererSharedObjects &shared, const Window &window) override;
+    void destroy(const RenderAPI &api) override;
+    void process(Handle<CommandList> cmd, const RenderAPI &api, const RendererSharedObjects &shared, const World &world) override;
+    void declare_resources(PassResources &resources, const RendererSharedObjects &shared) const override;
+
+private:
+    Handle<RenderTarget> m_render_target{};
+    Handle<GraphicsPipeline> m_pipeline{};
+    Handle<Descriptor> m_descriptor{};
+};
+
+#endif
@@ -20,7 +20,8 @@ void OffscreenToSwapchainPass::init(const RenderAPI &api, const RendererSharedOb
 
     m_pipeline = api.rm->create_graphics_pipeline(GraphicsPipelineCreateInfo{
         .vertex_shader_path = "./shaders/fullscreen_tri.vert.spv",
-        .fragment_shader_path = "./shaders/fullscreen_tri.frag.spv",
+        .fragment_shader_path = "./shaders/upscale.frag.spv",
+        .push_constants_size = sizeof(UpscalePushConstant),
         .descriptors = { m_descriptor } ,
         .color_targets {
             RenderTargetCommonInfo{
@@ -81,16 +82,19 @@ void OffscreenToSwapchainPass::destroy(const RenderAPI &api) {
 }
 
 void OffscreenToSwapchainPass::process(Handle<CommandList> cmd, const RenderAPI &api, const RendererSharedObjects &shared, const World &world) {
-    api.image_barrier(cmd, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, { ImageBarrier{
-        .image_handle = shared.offscreen_image,
-        .src_access_mask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
-        .dst_access_mask = VK_ACCESS_SHADER_READ_BIT,
-        .old_layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
-        .new_layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
-    }});
+    const RenderTarget &target = api.rm->get_data(m_render_targets[shared.swapchain_target_index]);
+
+    UpscalePushConstant pc{
+        .render_size = glm::vec2(shared.render_extent.width, shared.render_extent.height),
+        .output_size = glm::vec2(target.extent.width, target.extent.height)
+    };
 
     api.begin_graphics_pipeline(cmd, m_pipeline, m_render_targets[shared.swapchain_target_index], {RenderTargetClear{}}, RenderTargetClear{});
     api.bind_descriptor(cmd, m_pipeline, m_descriptor, 0U);
+    api.push_constants(cmd, m_pipeline, &pc);
     api.draw_count(cmd, 3U),
     api.end_graphics_pipeline(cmd, m_pipeline);
 }
+void OffscreenToSwapchainPass::declare_resources(PassResources &resources, const RendererSharedObjects &shared) const {
+    resources.read_image(shared.offscreen_image, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+}
@@ -3,12 +3,19 @@
 
 #include <renderer/base_pass.hpp>
 
+struct UpscalePushConstant {
+    glm::vec2 render_size{}; // Rendered part of the offscreen image
+    glm::vec2 output_size{};
+};
+
+// Upscales the rendered part of the offscreen image to the swapchain with an edge directed filter, a plain copy when the sizes match
 class OffscreenToSwapchainPass : public BasePass {
 public:
     void init(const RenderAPI &api, const RendererSharedObjects &shared, const Window &window) override;
     void resize(const RenderAPI &api, const RendererSharedObjects &shared, const Window &window) override;
     void destroy(const RenderAPI &api) override;
     void process(Handle<CommandList> cmd, const RenderAPI &api, const RendererSharedObjects &shared, const World &world) override;
+    void declare_resources(PassResources &resources, const RendererSharedObjects &shared) const override;
 
 private:
     Handle<GraphicsPipeline> m_pipeline{};
@@ -1,54 +1,96 @@
 #include "ssao_pass.hpp"
 
+#include "common/utils.hpp"
+
 void SSAOPass::init(const RenderAPI &api, const RendererSharedObjects &shared, const Window &window) {
-    m_descriptor = api.rm->create_descriptor(DescriptorCreateInfo{
-        .bindings {
-            DescriptorBindingCreateInfo{VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER}, // Depth Image
-            DescriptorBindingCreateInfo{VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER}, // Normal Image
-            DescriptorBindingCreateInfo{VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER}, // Camera
-        }
-    });
+    m_use_half_res = shared.config_enable_half_res_ssao;
 
-    api.rm->update_descriptor(m_descriptor, DescriptorUpdateInfo{
-        .bindings {
-            DescriptorBindingUpdateInfo {
-                .binding_index = 0u,
-                .image_info {
-                    .image_handle = shared.depth_image,
-                    .image_sampler = shared.offscreen_sampler
+    if (m_use_half_res) {
+        // Only for the history, the 32 bit float depth images aren't guaranteed to be filterable and use the nearest shared.offscreen_sampler
+        m_history_sampler = api.rm->create_sampler(SamplerCreateInfo{
+            .filter = VK_FILTER_LINEAR,
+            .mipmap_mode = VK_SAMPLER_MIPMAP_MODE_NEAREST,
+            .address_mode = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE
+        });
+
+        m_previous_camera_buffer = api.rm->create_buffer(BufferCreateInfo{
+            .size = sizeof(Camera),
+            .buffer_usage_flags = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            .memory_usage_flags = VMA_MEMORY_USAGE_GPU_ONLY
+        });
+
+        init_half_res_targets(api, shared);
+
+        m_downsample_pipeline = api.rm->create_compute_pipeline(ComputePipelineCreateInfo{
+            .shader_path = "./shaders/SSAO_downsample.comp.spv",
+            .shader_constant_values { static_cast<u32>(shared.config_gbuffer_layout) },
+            .descriptors { m_downsample_descriptors[0] }
+        });
+
+        m_half_res_pipeline = api.rm->create_compute_pipeline(ComputePipelineCreateInfo{
+            .shader_path = "./shaders/SSAO_half_res.comp.spv",
+            .shader_constant_values { shared.config_ssao_half_res_samples },
+            .push_constants_size = sizeof(SSAOHalfResPushConstant),
+            .descriptors { m_half_res_descriptors[0] }
+        });
+
+        m_pipeline = api.rm->create_graphics_pipeline(GraphicsPipelineCreateInfo{
+            .vertex_shader_path = "./shaders/fullscreen_tri.vert.spv",
+            .fragment_shader_path = "./shaders/SSAO_upsample.frag.spv",
+            .descriptors = { m_upsample_descriptors[0] },
+            .color_targets = {
+                RenderTargetCommonInfo {
+                    .format = api.rm->get_data(shared.ssao_output_image).format,
+                    .layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
                 }
             },
-            DescriptorBindingUpdateInfo {
-                .binding_index = 1u,
-                .image_info {
-                    .image_handle = shared.normal_image,
-                    .image_sampler = shared.offscreen_sampler
+            .cull_mode = VK_CULL_MODE_NONE,
+        });
+    } else {
+        m_descriptor = api.rm->create_descriptor(DescriptorCreateInfo{
+            .bindings {
+                DescriptorBindingCreateInfo{VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER}, // Depth Image
+                DescriptorBindingCreateInfo{VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER}, // Normal Image
+                DescriptorBindingCreateInfo{VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER}, // Camera
+            }
+        });
+
+        update_descriptor(api, shared);
+
+        m_pipeline = api.rm->create_graphics_pipeline(GraphicsPipelineCreateInfo{
+            .vertex_shader_path = "./shaders/fullscreen_tri.vert.spv",
+            .fragment_shader_path = "./shaders/SSAO.frag.spv",
+            .fragment_constant_values { shared.config_ssao_samples, static_cast<u32>(shared.config_gbuffer_layout) },
+            .push_constants_size = sizeof(SSAOPushConstant),
+            .descriptors = { m_descriptor } ,
+            .color_targets = {
+                RenderTargetCommonInfo {
+                    .format = api.rm->get_data(shared.ssao_output_image).format,
+                    .layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
                 }
             },
-            DescriptorBindingUpdateInfo {
-                .binding_index = 2u,
-                .buffer_info = {
-                    .buffer_handle = shared.scene_camera_buffer
-                }
-            }
-        }
-    });
+            .cull_mode = VK_CULL_MODE_NONE,
+        });
+    }
 
-    m_pipeline = api.rm->create_graphics_pipeline(GraphicsPipelineCreateInfo{
-        .vertex_shader_path = "./shaders/fullscreen_tri.vert.spv",
-        .fragment_shader_path = "./shaders/SSAO.frag.spv",
-        .fragment_constant_values { shared.config_ssao_samples },
-        .push_constants_size = sizeof(SSAOPushConstant),
-        .descriptors = { m_descriptor } ,
-        .color_targets = {
-            RenderTargetCommonInfo {
-                .format = api.rm->get_data(shared.ssao_output_image).format,
-                .layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+    m_render_target = api.rm->create_render_target(m_pipeline, RenderTargetCreateInfo{
+        .color_attachments = {
+            RenderTargetAttachmentCreateInfo {
+                .target_handle = shared.ssao_output_image
             }
-        },
-        .cull_mode = VK_CULL_MODE_NONE,
+        }
     });
+}
+void SSAOPass::resize(const RenderAPI &api, const RendererSharedObjects &shared, const Window &window) {
+    if (m_use_half_res) {
+        // The layouts of the recreated descriptors match, so the pipelines are kept
+        destroy_half_res_targets(api);
+        init_half_res_targets(api, shared);
+    } else {
+        update_descriptor(api, shared);
+    }
 
+    api.rm->destroy(m_render_target);
     m_render_target = api.rm->create_render_target(m_pipeline, RenderTargetCreateInfo{
         .color_attachments = {
             RenderTargetAttachmentCreateInfo {
@@ -57,7 +99,226 @@ void SSAOPass::init(const RenderAPI &api, const RendererSharedObjects &shared, c
         }
     });
 }
-void SSAOPass::resize(const RenderAPI &api, const RendererSharedObjects &shared, const Window &window) {
+void SSAOPass::destroy(const RenderAPI &api) {
+    api.rm->destroy(m_render_target);
+    api.rm->destroy(m_pipeline);
+
+    if (m_use_half_res) {
+        destroy_half_res_targets(api);
+
+        api.rm->destroy(m_downsample_pipeline);
+        api.rm->destroy(m_half_res_pipeline);
+        api.rm->destroy(m_history_sampler);
+        api.rm->destroy(m_previous_camera_buffer);
+    } else {
+        api.rm->destroy(m_descriptor);
+    }
+}
+
+void SSAOPass::init_half_res_targets(const RenderAPI &api, const RendererSharedObjects &shared) {
+    VkExtent3D screen_size = api.rm->get_data(shared.ssao_output_image).extent;
+    VkExtent3D half_size{
+        .width = std::max(screen_size.width / 2U, 1U),
+        .height = std::max(screen_size.height / 2U, 1U),
+        .depth = 1U
+    };
+
+    for (u32 i{}; i < 2U; ++i) {
+        m_half_depth_images[i] = api.rm->create_image(ImageCreateInfo{
+            .format = VK_FORMAT_R32_SFLOAT,
+            .extent = half_size,
+            .usage_flags = VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+            .aspect_flags = VK_IMAGE_ASPECT_COLOR_BIT
+        });
+
+        // R16G16_SFLOAT would do, but RGBA16F is guaranteed to support both storage without shaderStorageImageExtendedFormats and linear filtering of m_history_sampler
+        m_history_images[i] = api.rm->create_image(ImageCreateInfo{
+            .format = VK_FORMAT_R16G16B16A16_SFLOAT,
+            .extent = half_size,
+            .usage_flags = VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+            .aspect_flags = VK_IMAGE_ASPECT_COLOR_BIT
+        });
+    }
+
+    // View space normals of the texels picked by the depth downsample
+    m_half_normal_image = api.rm->create_image(ImageCreateInfo{
+        .format = VK_FORMAT_R16G16B16A16_SFLOAT,
+        .extent = half_size,
+        .usage_flags = VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+        .aspect_flags = VK_IMAGE_ASPECT_COLOR_BIT
+    });
+
+    for (u32 i{}; i < 2U; ++i) {
+        u32 previous = 1U - i;
+
+        m_downsample_descriptors[i] = api.rm->create_descriptor(DescriptorCreateInfo{
+            .bindings {
+                DescriptorBindingCreateInfo{VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER}, // Depth Image
+                DescriptorBindingCreateInfo{VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER}, // Normal Image
+                DescriptorBindingCreateInfo{VK_DESCRIPTOR_TYPE_STORAGE_IMAGE}, // Half Depth
+                DescriptorBindingCreateInfo{VK_DESCRIPTOR_TYPE_STORAGE_IMAGE}, // Half Normal
+                DescriptorBindingCreateInfo{VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER}, // Camera
+            }
+        });
+        api.rm->update_descriptor(m_downsample_descriptors[i], DescriptorUpdateInfo{
+            .bindings {
+                DescriptorBindingUpdateInfo {
+                    .binding_index = 0u,
+                    .image_info {
+                        .image_handle = shared.depth_image,
+                        .image_sampler = shared.offscreen_sampler
+                    }
+                },
+                DescriptorBindingUpdateInfo {
+                    .binding_index = 1u,
+                    .image_info {
+                        .image_handle = shared.normal_image,
+                        .image_sampler = shared.offscreen_sampler
+                    }
+                },
+                DescriptorBindingUpdateInfo {
+                    .binding_index = 2u,
+                    .image_info {
+                        .image_handle = m_half_depth_images[i],
+                        .image_mip = 0u
+                    }
+                },
+                DescriptorBindingUpdateInfo {
+                    .binding_index = 3u,
+                    .image_info {
+                        .image_handle = m_half_normal_image,
+                        .image_mip = 0u
+                    }
+                },
+                DescriptorBindingUpdateInfo {
+                    .binding_index = 4u,
+                    .buffer_info = {
+                        .buffer_handle = shared.scene_camera_buffer
+                    }
+                }
+            }
+        });
+
+        m_half_res_descriptors[i] = api.rm->create_descriptor(DescriptorCreateInfo{
+            .bindings {
+                DescriptorBindingCreateInfo{VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER}, // Half Depth
+                DescriptorBindingCreateInfo{VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER}, // Half Normal
+                DescriptorBindingCreateInfo{VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER}, // Previous Half Depth
+                DescriptorBindingCreateInfo{VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER}, // Previous History
+                DescriptorBindingCreateInfo{VK_DESCRIPTOR_TYPE_STORAGE_IMAGE}, // History
+                DescriptorBindingCreateInfo{VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER}, // Camera
+                DescriptorBindingCreateInfo{VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER}, // Previous Camera
+            }
+        });
+        api.rm->update_descriptor(m_half_res_descriptors[i], DescriptorUpdateInfo{
+            .bindings {
+                DescriptorBindingUpdateInfo {
+                    .binding_index = 0u,
+                    .image_info {
+                        .image_handle = m_half_depth_images[i],
+                        .image_sampler = shared.offscreen_sampler
+                    }
+                },
+                DescriptorBindingUpdateInfo {
+                    .binding_index = 1u,
+                    .image_info {
+                        .image_handle = m_half_normal_image,
+                        .image_sampler = shared.offscreen_sampler
+                    }
+                },
+                DescriptorBindingUpdateInfo {
+                    .binding_index = 2u,
+                    .image_info {
+                        .image_handle = m_half_depth_images[previous],
+                        .image_sampler = shared.offscreen_sampler
+                    }
+                },
+                DescriptorBindingUpdateInfo {
+                    .binding_index = 3u,
+                    .image_info {
+                        .image_handle = m_history_images[previous],
+                        .image_sampler = m_history_sampler
+                    }
+                },
+                DescriptorBindingUpdateInfo {
+                    .binding_index = 4u,
+                    .image_info {
+                        .image_handle = m_history_images[i],
+                        .image_mip = 0u
+                    }
+                },
+                DescriptorBindingUpdateInfo {
+                    .binding_index = 5u,
+                    .buffer_info = {
+                        .buffer_handle = shared.scene_camera_buffer
+                    }
+                },
+                DescriptorBindingUpdateInfo {
+                    .binding_index = 6u,
+                    .buffer_info = {
+                        .buffer_handle = m_previous_camera_buffer
+                    }
+                }
+            }
+        });
+
+        m_upsample_descriptors[i] = api.rm->create_descriptor(DescriptorCreateInfo{
+            .bindings {
+                DescriptorBindingCreateInfo{VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER}, // Depth Image
+                DescriptorBindingCreateInfo{VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER}, // Half Depth
+                DescriptorBindingCreateInfo{VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER}, // History
+                DescriptorBindingCreateInfo{VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER}, // Camera
+            }
+        });
+        api.rm->update_descriptor(m_upsample_descriptors[i], DescriptorUpdateInfo{
+            .bindings {
+                DescriptorBindingUpdateInfo {
+                    .binding_index = 0u,
+                    .image_info {
+                        .image_handle = shared.depth_image,
+                        .image_sampler = shared.offscreen_sampler
+                    }
+                },
+                DescriptorBindingUpdateInfo {
+                    .binding_index = 1u,
+                    .image_info {
+                        .image_handle = m_half_depth_images[i],
+                        .image_sampler = shared.offscreen_sampler
+                    }
+                },
+                DescriptorBindingUpdateInfo {
+                    .binding_index = 2u,
+                    .image_info {
+                        .image_handle = m_history_images[i],
+                        .image_sampler = shared.offscreen_sampler
+                    }
+                },
+                DescriptorBindingUpdateInfo {
+                    .binding_index = 3u,
+                    .buffer_info = {
+                        .buffer_handle = shared.scene_camera_buffer
+                    }
+                }
+            }
+        });
+    }
+
+    // The new images have undefined contents
+    m_history_valid = false;
+}
+void SSAOPass::destroy_half_res_targets(const RenderAPI &api) {
+    for (u32 i{}; i < 2U; ++i) {
+        api.rm->destroy(m_downsample_descriptors[i]);
+        api.rm->destroy(m_half_res_descriptors[i]);
+        api.rm->destroy(m_upsample_descriptors[i]);
+
+        api.rm->destroy(m_half_depth_images[i]);
+        api.rm->destroy(m_history_images[i]);
+    }
+
+    api.rm->destroy(m_half_normal_image);
+}
+void SSAOPass::update_descriptor(const RenderAPI &api, const RendererSharedObjects &shared) {
     api.rm->update_descriptor(m_descriptor, DescriptorUpdateInfo{
         .bindings {
             DescriptorBindingUpdateInfo {
@@ -82,75 +343,180 @@ void SSAOPass::resize(const RenderAPI &api, const RendererSharedObjects &shared,
             }
         }
     });
+}
 
-    api.rm->destroy(m_render_target);
-    m_render_target = api.rm->create_render_target(m_pipeline, RenderTargetCreateInfo{
-        .color_attachments = {
-            RenderTargetAttachmentCreateInfo {
-                .target_handle = shared.ssao_output_image
-            }
+void SSAOPass::process(Handle<CommandList> cmd, const RenderAPI &api, const RendererSharedObjects &shared, const World &world) {
+    if (m_use_half_res) {
+        process_half_res(cmd, api, shared);
+        return;
+    }
+
+    SSAOPushConstant pc {
+        .screen_wh_combined = static_cast<i32>(shared.render_extent.width | (shared.render_extent.height << 16)),
+        .radius = shared.config_ssao_radius,
+        .bias = shared.config_ssao_bias,
+        .multiplier = shared.config_ssao_multiplier,
+        .noise_scale = shared.config_ssao_noise_scale_divider
+    };
+
+    api.begin_graphics_pipeline(cmd, m_pipeline, m_render_target, {RenderTargetClear{}}, RenderTargetClear{}, shared.render_extent);
+    api.bind_descriptor(cmd, m_pipeline, m_descriptor, 0U);
+    api.push_constants(cmd, m_pipeline, &pc);
+    api.draw_count(cmd, 3U),
+    api.end_graphics_pipeline(cmd, m_pipeline);
+}
+
+void SSAOPass::process_half_res(Handle<CommandList> cmd, const RenderAPI &api, const RendererSharedObjects &shared) {
+    u32 current = m_history_index;
+    u32 previous = 1U - current;
+
+    // Only the part covering render_extent is computed, the shaders get its size from the camera
+    VkExtent2D half_size{
+        static_cast<u32>(Utils::div_ceil(shared.render_extent.width, 2U)),
+        static_cast<u32>(Utils::div_ceil(shared.render_extent.height, 2U))
+    };
+
+    // Every half resolution image rests in SHADER_READ_ONLY_OPTIMAL between the dispatches, the previous ones are bound even if they are not read
+    if (!m_history_valid) {
+        std::vector<ImageBarrier> barriers{};
+        for (u32 i{}; i < 2U; ++i) {
+            barriers.push_back(ImageBarrier{
+                .image_handle = m_half_depth_images[i],
+                .dst_access_mask = VK_ACCESS_SHADER_READ_BIT,
+                .old_layout = VK_IMAGE_LAYOUT_UNDEFINED,
+                .new_layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+            });
+            barriers.push_back(ImageBarrier{
+                .image_handle = m_history_images[i],
+                .dst_access_mask = VK_ACCESS_SHADER_READ_BIT,
+                .old_layout = VK_IMAGE_LAYOUT_UNDEFINED,
+                .new_layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+            });
         }
+        barriers.push_back(ImageBarrier{
+            .image_handle = m_half_normal_image,
+            .dst_access_mask = VK_ACCESS_SHADER_READ_BIT,
+            .old_layout = VK_IMAGE_LAYOUT_UNDEFINED,
+            .new_layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+        });
+
+        api.image_barrier(cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, barriers);
+    }
+
+    // Last read by the previous frame's occlusion dispatch and upsample
+    api.image_barrier(cmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, {
+        ImageBarrier{
+            .image_handle = m_half_depth_images[current],
+            .src_access_mask = VK_ACCESS_SHADER_READ_BIT,
+            .dst_access_mask = VK_ACCESS_SHADER_WRITE_BIT,
+            .old_layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+            .new_layout = VK_IMAGE_LAYOUT_GENERAL
+        },
+        ImageBarrier{
+            .image_handle = m_half_normal_image,
+            .src_access_mask = VK_ACCESS_SHADER_READ_BIT,
+            .dst_access_mask = VK_ACCESS_SHADER_WRITE_BIT,
+            .old_layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+            .new_layout = VK_IMAGE_LAYOUT_GENERAL
+        },
     });
-}
-void SSAOPass::destroy(const RenderAPI &api) {
-    api.rm->destroy(m_render_target);
-    api.rm->destroy(m_pipeline);
-    api.rm->destroy(m_descriptor);
-}
 
-void SSAOPass::process(Handle<CommandList> cmd, const RenderAPI &api, const RendererSharedObjects &shared, const World &world) {
-    api.image_barrier(cmd, VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, {
+    api.begin_compute_pipeline(cmd, m_downsample_pipeline);
+    api.bind_descriptor(cmd, m_downsample_pipeline, m_downsample_descriptors[current], 0U);
+    api.dispatch_compute_pipeline(cmd, Utils::div_ceil(half_size.width, GPU_SSAO_GROUP_SIZE), Utils::div_ceil(half_size.height, GPU_SSAO_GROUP_SIZE));
+
+    api.image_barrier(cmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, {
         ImageBarrier{
-            .image_handle = shared.depth_image,
-            .src_access_mask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+            .image_handle = m_half_depth_images[current],
+            .src_access_mask = VK_ACCESS_SHADER_WRITE_BIT,
             .dst_access_mask = VK_ACCESS_SHADER_READ_BIT,
-            .old_layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+            .old_layout = VK_IMAGE_LAYOUT_GENERAL,
             .new_layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
         },
-    });
-    api.image_barrier(cmd, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, {
         ImageBarrier{
-            .image_handle = shared.normal_image,
-            .src_access_mask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+            .image_handle = m_half_normal_image,
+            .src_access_mask = VK_ACCESS_SHADER_WRITE_BIT,
             .dst_access_mask = VK_ACCESS_SHADER_READ_BIT,
-            .old_layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+            .old_layout = VK_IMAGE_LAYOUT_GENERAL,
             .new_layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
-        }
+        },
     });
-
-    api.image_barrier(cmd, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, {
+    api.image_barrier(cmd, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, {
         ImageBarrier{
-            .image_handle = shared.ssao_output_image,
+            .image_handle = m_history_images[current],
             .src_access_mask = VK_ACCESS_SHADER_READ_BIT,
-            .dst_access_mask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+            .dst_access_mask = VK_ACCESS_SHADER_WRITE_BIT,
             .old_layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-            .new_layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL
+            .new_layout = VK_IMAGE_LAYOUT_GENERAL
         },
     });
 
-    VkExtent3D image_size = api.rm->get_data(shared.ssao_output_image).extent;
-
-    SSAOPushConstant pc {
-        .screen_wh_combined = static_cast<i32>(image_size.width | (image_size.height << 16)),
+    SSAOHalfResPushConstant half_res_pc {
         .radius = shared.config_ssao_radius,
         .bias = shared.config_ssao_bias,
         .multiplier = shared.config_ssao_multiplier,
-        .noise_scale = shared.config_ssao_noise_scale_divider
+        .frame_index = shared.frames_since_init,
+        .history_valid = static_cast<u32>(m_history_valid)
     };
 
-    api.begin_graphics_pipeline(cmd, m_pipeline, m_render_target, {RenderTargetClear{}}, RenderTargetClear{});
-    api.bind_descriptor(cmd, m_pipeline, m_descriptor, 0U);
-    api.push_constants(cmd, m_pipeline, &pc);
-    api.draw_count(cmd, 3U),
-    api.end_graphics_pipeline(cmd, m_pipeline);
+    api.begin_compute_pipeline(cmd, m_half_res_pipeline);
+    api.bind_descriptor(cmd, m_half_res_pipeline, m_half_res_descriptors[current], 0U);
+    api.push_constants(cmd, m_half_res_pipeline, &half_res_pc);
+    api.dispatch_compute_pipeline(cmd, Utils::div_ceil(half_size.width, GPU_SSAO_GROUP_SIZE), Utils::div_ceil(half_size.height, GPU_SSAO_GROUP_SIZE));
 
-    api.image_barrier(cmd, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT, {
+    api.image_barrier(cmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, {
         ImageBarrier{
-            .image_handle = shared.depth_image,
-            .src_access_mask = VK_ACCESS_SHADER_READ_BIT,
-            .dst_access_mask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
-            .old_layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-            .new_layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL
+            .image_handle = m_history_images[current],
+            .src_access_mask = VK_ACCESS_SHADER_WRITE_BIT,
+            .dst_access_mask = VK_ACCESS_SHADER_READ_BIT,
+            .old_layout = VK_IMAGE_LAYOUT_GENERAL,
+            .new_layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+        },
+    });
+
+    // The next frame reprojects with this frame's camera
+    api.buffer_barrier(cmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, {
+        BufferBarrier{
+            .buffer_handle = shared.scene_camera_buffer,
+            .src_access_mask = VK_ACCESS_UNIFORM_READ_BIT,
+            .dst_access_mask = VK_ACCESS_TRANSFER_READ_BIT
+        },
+        BufferBarrier{
+            .buffer_handle = m_previous_camera_buffer,
+            .src_access_mask = VK_ACCESS_UNIFORM_READ_BIT,
+            .dst_access_mask = VK_ACCESS_TRANSFER_WRITE_BIT
+        },
+    });
+    api.copy_buffer_to_buffer(cmd, shared.scene_camera_buffer, m_previous_camera_buffer, {
+        VkBufferCopy{
+            .size = sizeof(Camera)
         }
     });
+    api.buffer_barrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, {
+        BufferBarrier{
+            .buffer_handle = m_previous_camera_buffer,
+            .src_access_mask = VK_ACCESS_TRANSFER_WRITE_BIT,
+            .dst_access_mask = VK_ACCESS_UNIFORM_READ_BIT
+        },
+    });
+
+    api.begin_graphics_pipeline(cmd, m_pipeline, m_render_target, {RenderTargetClear{}}, RenderTargetClear{}, shared.render_extent);
+    api.bind_descriptor(cmd, m_pipeline, m_upsample_descriptors[current], 0U);
+    api.draw_count(cmd, 3U);
+    api.end_graphics_pipeline(cmd, m_pipeline);
+
+    m_history_index = previous;
+    m_history_valid = true;
 }
+void SSAOPass::declare_resources(PassResources &resources, const RendererSharedObjects &shared) const {
+    // The half resolution path downsamples them with a compute shader, the depth is read again by the upsample
+    if (shared.config_enable_half_res_ssao) {
+        resources.read_image(shared.depth_image, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+        resources.read_image(shared.normal_image, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+    } else {
+        resources.read_image(shared.depth_image, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+        resources.read_image(shared.normal_image, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+    }
+
+    resources.write_image(shared.ssao_output_image, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT);
+}
\ No newline at end of file
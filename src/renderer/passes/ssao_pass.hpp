@@ -3,6 +3,8 @@
 
 #include <renderer/base_pass.hpp>
 
+#include <array>
+
 struct SSAOPushConstant {
     i32 screen_wh_combined{};
     f32 radius{};
@@ -11,17 +13,52 @@ struct SSAOPushConstant {
     f32 noise_scale{};
 };
 
+struct SSAOHalfResPushConstant {
+    f32 radius{};
+    f32 bias{};
+    f32 multiplier{};
+    u32 frame_index{}; // Rotates the sample kernel every frame so that the accumulated history sees new directions
+    u32 history_valid{}; // 0 right after init or resize, the history images hold garbage then
+};
+
+// Full resolution fragment SSAO or, if config_enable_half_res_ssao is set, a compute chain:
+// Depth and normal downsample -> half resolution SSAO with temporal accumulation -> depth aware upsample into ssao_output_image
 class SSAOPass : public BasePass {
 public:
     void init(const RenderAPI &api, const RendererSharedObjects &shared, const Window &window) override;
     void resize(const RenderAPI &api, const RendererSharedObjects &shared, const Window &window) override;
     void destroy(const RenderAPI &api) override;
     void process(Handle<CommandList> cmd, const RenderAPI &api, const RendererSharedObjects &shared, const World &world) override;
+    void declare_resources(PassResources &resources, const RendererSharedObjects &shared) const override;
 
 private:
+    void init_half_res_targets(const RenderAPI &api, const RendererSharedObjects &shared);
+    void destroy_half_res_targets(const RenderAPI &api);
+    void update_descriptor(const RenderAPI &api, const RendererSharedObjects &shared);
+
+    void process_half_res(Handle<CommandList> cmd, const RenderAPI &api, const RendererSharedObjects &shared);
+
+    bool m_use_half_res{};
+
     Handle<RenderTarget> m_render_target{};
     Handle<GraphicsPipeline> m_pipeline{};
     Handle<Descriptor> m_descriptor{};
+
+    // Half resolution path, the images and descriptors are indexed by m_history_index which flips every frame
+    Handle<ComputePipeline> m_downsample_pipeline{};
+    Handle<ComputePipeline> m_half_res_pipeline{};
+    std::array<Handle<Descriptor>, 2> m_downsample_descriptors{};
+    std::array<Handle<Descriptor>, 2> m_half_res_descriptors{};
+    std::array<Handle<Descriptor>, 2> m_upsample_descriptors{};
+
+    std::array<Handle<Image>, 2> m_half_depth_images{};
+    std::array<Handle<Image>, 2> m_history_images{}; // R = accumulated AO, G = accumulated frame count
+    Handle<Image> m_half_normal_image{};
+    Handle<Sampler> m_history_sampler{};
+    Handle<Buffer> m_previous_camera_buffer{}; // Copy of the scene camera from the last frame for the reprojection
+
+    u32 m_history_index{};
+    bool m_history_valid{};
 };
 
 #endif
@@ -93,6 +93,7 @@ void UIPass::init(const RenderAPI &api, const RendererSharedObjects &shared, con
         .MinImageCount = api.get_swapchain_image_count(),
         .ImageCount = api.get_swapchain_image_count(),
         .MSAASamples = VK_SAMPLE_COUNT_1_BIT,
+        .PipelineCache = api.instance->get_pipeline_cache(),
         .CheckVkResultFn = [](VkResult result) {
             if (result != VK_SUCCESS) {
                 DEBUG_PANIC("ImGui Vulkan Error!");
@@ -0,0 +1,433 @@
+#include "render_graph.hpp"
+
+#include <algorithm>
+#include <optional>
+
+static constexpr VkAccessFlags READ_ACCESS_MASK =
+    VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_INDEX_READ_BIT | VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_UNIFORM_READ_BIT |
+    VK_ACCESS_INPUT_ATTACHMENT_READ_BIT | VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT |
+    VK_ACCESS_TRANSFER_READ_BIT | VK_ACCESS_HOST_READ_BIT | VK_ACCESS_MEMORY_READ_BIT;
+static constexpr VkAccessFlags WRITE_ACCESS_MASK =
+    VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT |
+    VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_HOST_WRITE_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+
+// The last write to a resource and the reads that followed it
+struct SyncState {
+    VkPipelineStageFlags write_stages{};
+    VkAccessFlags write_access{};
+    VkPipelineStageFlags read_stages{};
+
+    // The last write is already visible to these
+    VkPipelineStageFlags visible_stages{};
+    VkAccessFlags visible_access{};
+};
+struct Dependency {
+    VkPipelineStageFlags src_stages{};
+    VkAccessFlags src_access{};
+};
+
+// Returns what the access has to wait for, reads of the same write only wait once for every stage and access type
+static std::optional<Dependency> track_access(SyncState &state, VkPipelineStageFlags stages, VkAccessFlags access, bool write, bool layout_transition) {
+    if (write || layout_transition) {
+        Dependency dependency{
+            .src_stages = state.write_stages | state.read_stages,
+            .src_access = state.write_access
+        };
+
+        // A layout transition is a write too, later reads in other stages have to wait for the first reader that made it
+        state = SyncState{
+            .write_stages = stages,
+            .write_access = write ? (access & WRITE_ACCESS_MASK) : 0U,
+            .visible_stages = write ? 0U : stages,
+            .visible_access = write ? 0U : access
+        };
+
+        if (!layout_transition && dependency.src_stages == 0U) {
+            return std::nullopt;
+        }
+
+        return dependency;
+    }
+
+    state.read_stages |= stages;
+
+    if (state.write_stages == 0U || ((stages & ~state.visible_stages) == 0U && (access & ~state.visible_access) == 0U)) {
+        return std::nullopt;
+    }
+
+    state.visible_stages |= stages;
+    state.visible_access |= access;
+
+    return Dependency{
+        .src_stages = state.write_stages,
+        .src_access = state.write_access
+    };
+}
+
+static bool is_read(VkAccessFlags access, bool write) {
+    return !write || (access & READ_ACCESS_MASK) != 0U;
+}
+
+void PassResources::read_image(Handle<Image> image, VkImageLayout layout, VkPipelineStageFlags stages, VkAccessFlags access) {
+    for (auto &declared : images) {
+        if (declared.image == image) {
+            if (declared.layout != layout) {
+                DEBUG_PANIC("Image with a handle id: " << image << " is declared in two different layouts by the same pass!")
+            }
+
+            declared.stages |= stages;
+            declared.access |= access;
+            return;
+        }
+    }
+
+    images.push_back(ImageAccess{
+        .image = image,
+        .layout = layout,
+        .stages = stages,
+        .access = access
+    });
+}
+void PassResources::write_image(Handle<Image> image, VkImageLayout layout, VkPipelineStageFlags stages, VkAccessFlags access) {
+    read_image(image, layout, stages, access);
+
+    for (auto &declared : images) {
+        if (declared.image == image) {
+            declared.write = true;
+        }
+    }
+}
+void PassResources::read_buffer(Handle<Buffer> buffer, VkPipelineStageFlags stages, VkAccessFlags access) {
+    for (auto &declared : buffers) {
+        if (declared.buffer == buffer) {
+            declared.stages |= stages;
+            declared.access |= access;
+            return;
+        }
+    }
+
+    buffers.push_back(BufferAccess{
+        .buffer = buffer,
+        .stages = stages,
+        .access = access
+    });
+}
+void PassResources::write_buffer(Handle<Buffer> buffer, VkPipelineStageFlags stages, VkAccessFlags access) {
+    read_buffer(buffer, stages, access);
+
+    for (auto &declared : buffers) {
+        if (declared.buffer == buffer) {
+            declared.write = true;
+        }
+    }
+}
+
+void RenderGraph::build(const RenderAPI &api, std::vector<RenderGraphPass> passes, const std::vector<Handle<Image>> &transient_images) {
+    m_passes = std::move(passes);
+
+    struct TransientImage {
+        Handle<Image> image{};
+        VkMemoryRequirements requirements{};
+
+        // Over all passes, enabled or not, so the aliasing doesn't depend on the runtime state
+        u32 first_pass = UINT32_MAX;
+        u32 last_pass{};
+    };
+
+    std::vector<TransientImage> images{};
+    for (const auto &image : transient_images) {
+        TransientImage transient{
+            .image = image,
+            .requirements = api.rm->get_image_memory_requirements(image)
+        };
+
+        for (u32 i{}; i < static_cast<u32>(m_passes.size()); ++i) {
+            for (const auto &access : m_passes[i].resources.images) {
+                if (access.image == image) {
+                    transient.first_pass = std::min(transient.first_pass, i);
+                    transient.last_pass = std::max(transient.last_pass, i);
+                }
+            }
+        }
+
+        images.push_back(transient);
+    }
+
+    // The largest images open the allocations, the smaller ones fill the gaps in their lifetimes
+    std::sort(images.begin(), images.end(), [](const TransientImage &left, const TransientImage &right) {
+        return left.requirements.size > right.requirements.size;
+    });
+
+    struct MemoryGroup {
+        std::vector<u32> images{};
+        u32 memory_type_bits = UINT32_MAX;
+        VkDeviceSize size{};
+    };
+
+    std::vector<MemoryGroup> groups{};
+
+    m_transient_memory_ids.clear();
+    m_transient_memory_size_unaliased = 0U;
+
+    for (u32 i{}; i < static_cast<u32>(images.size()); ++i) {
+        const TransientImage &image = images[i];
+
+        // Images that no pass uses overlap nothing
+        auto overlaps = [&image, &images](u32 other_index) {
+            const TransientImage &other = images[other_index];
+            return image.first_pass <= other.last_pass && other.first_pass <= image.last_pass;
+        };
+
+        u32 group_id{};
+        while (group_id < static_cast<u32>(groups.size())) {
+            const MemoryGroup &group = groups[group_id];
+            if ((group.memory_type_bits & image.requirements.memoryTypeBits) != 0U && std::none_of(group.images.begin(), group.images.end(), overlaps)) {
+                break;
+            }
+
+            ++group_id;
+        }
+
+        if (group_id == static_cast<u32>(groups.size())) {
+            groups.emplace_back();
+        }
+
+        MemoryGroup &group = groups[group_id];
+        group.images.push_back(i);
+        group.memory_type_bits &= image.requirements.memoryTypeBits;
+        group.size = std::max(group.size, image.requirements.size);
+
+        m_transient_memory_ids[image.image] = group_id;
+        m_transient_memory_size_unaliased += image.requirements.size;
+    }
+
+    m_transient_memory_size = 0U;
+    for (const auto &group : groups) {
+        std::vector<Handle<Image>> group_images{};
+        for (const auto &image_index : group.images) {
+            group_images.push_back(images[image_index].image);
+        }
+
+        api.rm->bind_aliased_image_memory(group_images);
+        m_transient_memory_size += group.size;
+    }
+
+    DEBUG_LOG("Render graph: " << images.size() << " transient images in " << groups.size() << " allocations, "
+        << m_transient_memory_size / 1024U / 1024U << "MB instead of " << m_transient_memory_size_unaliased / 1024U / 1024U << "MB")
+
+    // The images are new, everything is compiled again on the next frame
+    m_compiled_states.clear();
+    m_compiled_passes.clear();
+    m_frame_start_layouts.clear();
+    m_current_layouts.clear();
+}
+
+void RenderGraph::compile(const std::vector<RenderGraphPassState> &states) {
+    if (!m_compiled_passes.empty() && states == m_compiled_states) {
+        return;
+    }
+
+    if (states.size() != m_passes.size()) {
+        DEBUG_PANIC("Cannot compile the render graph! - Got " << states.size() << " pass states for " << m_passes.size() << " passes")
+    }
+
+    m_compiled_states = states;
+    m_compiled_passes.assign(m_passes.size(), CompiledPass{});
+
+    std::vector<bool> culled = cull_passes(states);
+    for (usize i{}; i < m_passes.size(); ++i) {
+        m_compiled_passes[i].culled = culled[i];
+    }
+
+    // Images sharing memory are synchronized as one resource, the rest by their own handles
+    auto get_sync_key = [this](Handle<Image> image) -> u64 {
+        if (m_transient_memory_ids.contains(image)) {
+            return (2ull << 32) | m_transient_memory_ids.at(image);
+        }
+
+        return (1ull << 32) | image.as_u32();
+    };
+
+    // Persistent images start the frame in the layout the last pass left them in
+    m_frame_start_layouts.clear();
+    for (usize i{}; i < m_passes.size(); ++i) {
+        if (culled[i]) {
+            continue;
+        }
+
+        for (const auto &access : m_passes[i].resources.images) {
+            if (!m_transient_memory_ids.contains(access.image)) {
+                m_frame_start_layouts[access.image] = access.layout;
+            }
+        }
+    }
+
+    // The first frame only carries the state of the previous frame over, the barriers are taken from the second one
+    std::unordered_map<u64, SyncState> sync_states{};
+    for (u32 frame{}; frame < 2U; ++frame) {
+        bool record = frame == 1U;
+
+        // Transient images aren't in the map, their contents are discarded at the first use of every frame
+        std::unordered_map<Handle<Image>, VkImageLayout> layouts = m_frame_start_layouts;
+
+        for (usize i{}; i < m_passes.size(); ++i) {
+            if (culled[i]) {
+                continue;
+            }
+
+            const PassResources &resources = m_passes[i].resources;
+
+            // Ordered by the semaphores and the queue ownership transfers, the state starts anew after the join
+            if (states[i].async_compute) {
+                for (const auto &access : resources.images) {
+                    sync_states[get_sync_key(access.image)] = SyncState{};
+                    layouts[access.image] = access.layout;
+                }
+                for (const auto &access : resources.buffers) {
+                    sync_states[access.buffer.as_u32()] = SyncState{};
+                }
+
+                continue;
+            }
+
+            CompiledPass &compiled = m_compiled_passes[i];
+
+            for (const auto &access : resources.images) {
+                VkImageLayout old_layout = layouts.contains(access.image) ? layouts.at(access.image) : VK_IMAGE_LAYOUT_UNDEFINED;
+                layouts[access.image] = access.layout;
+
+                auto dependency = track_access(sync_states[get_sync_key(access.image)], access.stages, access.access, access.write, old_layout != access.layout);
+                if (record && dependency.has_value()) {
+                    compiled.src_stages |= dependency->src_stages;
+                    compiled.dst_stages |= access.stages;
+                    compiled.image_barriers.push_back(ImageBarrier{
+                        .image_handle = access.image,
+                        .src_access_mask = dependency->src_access,
+                        .dst_access_mask = access.access,
+                        .old_layout = old_layout,
+                        .new_layout = access.layout
+                    });
+                }
+            }
+            for (const auto &access : resources.buffers) {
+                auto dependency = track_access(sync_states[access.buffer.as_u32()], access.stages, access.access, access.write, false);
+                if (record && dependency.has_value()) {
+                    compiled.src_stages |= dependency->src_stages;
+                    compiled.dst_stages |= access.stages;
+                    compiled.buffer_barriers.push_back(BufferBarrier{
+                        .buffer_handle = access.buffer,
+                        .src_access_mask = dependency->src_access,
+                        .dst_access_mask = access.access
+                    });
+                }
+            }
+        }
+    }
+
+    m_barrier_count = 0U;
+    for (const auto &pass : m_compiled_passes) {
+        m_barrier_count += static_cast<u32>(pass.image_barriers.size() + pass.buffer_barriers.size());
+    }
+}
+
+void RenderGraph::record_prologue(Handle<CommandList> cmd, const RenderAPI &api) {
+    std::vector<ImageBarrier> barriers{};
+    for (const auto &[image, layout] : m_frame_start_layouts) {
+        VkImageLayout current_layout = m_current_layouts.contains(image) ? m_current_layouts.at(image) : VK_IMAGE_LAYOUT_UNDEFINED;
+        if (current_layout == layout) {
+            continue;
+        }
+
+        barriers.push_back(ImageBarrier{
+            .image_handle = image,
+            .src_access_mask = VK_ACCESS_MEMORY_WRITE_BIT,
+            .dst_access_mask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT,
+            .old_layout = current_layout,
+            .new_layout = layout
+        });
+
+        m_current_layouts[image] = layout;
+    }
+
+    // Only after init, a resize or when a pass toggled at runtime changes how the frame ends
+    api.image_barrier(cmd, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, barriers);
+}
+void RenderGraph::record_barriers(Handle<CommandList> cmd, const RenderAPI &api, usize pass_index) const {
+    const CompiledPass &pass = m_compiled_passes[pass_index];
+
+    VkPipelineStageFlags src_stages = pass.src_stages != 0U ? pass.src_stages : VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+    api.pipeline_barrier(cmd, src_stages, pass.dst_stages, pass.image_barriers, pass.buffer_barriers);
+}
+
+std::vector<Handle<Buffer>> RenderGraph::get_written_buffers(usize pass_index) const {
+    std::vector<Handle<Buffer>> buffers{};
+    for (const auto &access : m_passes[pass_index].resources.buffers) {
+        if (access.write) {
+            buffers.push_back(access.buffer);
+        }
+    }
+
+    return buffers;
+}
+
+std::vector<bool> RenderGraph::cull_passes(const std::vector<RenderGraphPassState> &states) const {
+    std::vector<bool> culled(m_passes.size(), true);
+
+    // Passes without declared outputs, like the ones that draw to the swapchain, are always kept
+    for (usize i{}; i < m_passes.size(); ++i) {
+        const PassResources &resources = m_passes[i].resources;
+
+        bool has_outputs = std::any_of(resources.images.begin(), resources.images.end(), [](const auto &access) { return access.write; }) ||
+                           std::any_of(resources.buffers.begin(), resources.buffers.end(), [](const auto &access) { return access.write; });
+
+        culled[i] = !states[i].enabled || has_outputs;
+    }
+
+    // A pass is needed if a kept pass reads what it writes, later in the frame or in the next one for persistent resources
+    auto is_consumed = [this, &culled](usize writer) {
+        for (usize reader{}; reader < m_passes.size(); ++reader) {
+            if (reader == writer || culled[reader]) {
+                continue;
+            }
+
+            for (const auto &written : m_passes[writer].resources.images) {
+                if (!written.write || (reader < writer && m_transient_memory_ids.contains(written.image))) {
+                    continue;
+                }
+
+                for (const auto &read : m_passes[reader].resources.images) {
+                    if (read.image == written.image && is_read(read.access, read.write)) {
+                        return true;
+                    }
+                }
+            }
+            for (const auto &written : m_passes[writer].resources.buffers) {
+                if (!written.write) {
+                    continue;
+                }
+
+                for (const auto &read : m_passes[reader].resources.buffers) {
+                    if (read.buffer == written.buffer && is_read(read.access, read.write)) {
+                        return true;
+                    }
+                }
+            }
+        }
+
+        return false;
+    };
+
+    bool changed = true;
+    while (changed) {
+        changed = false;
+
+        for (usize i{}; i < m_passes.size(); ++i) {
+            if (states[i].enabled && culled[i] && is_consumed(i)) {
+                culled[i] = false;
+                changed = true;
+            }
+        }
+    }
+
+    return culled;
+}
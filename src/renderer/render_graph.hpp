@@ -0,0 +1,94 @@
+#ifndef GEMINO_RENDER_GRAPH_HPP
+#define GEMINO_RENDER_GRAPH_HPP
+
+#include <RHI/render_api.hpp>
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+// The images and buffers a pass shares with other passes, the stages and access masks cover every use of the resource within the pass
+// Barriers between the dispatches of a single pass stay in the pass, the graph only orders the passes against each other
+struct PassResources {
+    struct ImageAccess {
+        Handle<Image> image{};
+        VkImageLayout layout{}; // Transitioned before the pass, the pass has to leave the image in it
+        VkPipelineStageFlags stages{};
+        VkAccessFlags access{};
+        bool write{};
+    };
+    struct BufferAccess {
+        Handle<Buffer> buffer{};
+        VkPipelineStageFlags stages{};
+        VkAccessFlags access{};
+        bool write{};
+    };
+
+    void read_image(Handle<Image> image, VkImageLayout layout, VkPipelineStageFlags stages, VkAccessFlags access = VK_ACCESS_SHADER_READ_BIT);
+    void write_image(Handle<Image> image, VkImageLayout layout, VkPipelineStageFlags stages, VkAccessFlags access);
+    void read_buffer(Handle<Buffer> buffer, VkPipelineStageFlags stages, VkAccessFlags access = VK_ACCESS_SHADER_READ_BIT);
+    void write_buffer(Handle<Buffer> buffer, VkPipelineStageFlags stages, VkAccessFlags access);
+
+    std::vector<ImageAccess> images{};
+    std::vector<BufferAccess> buffers{};
+};
+
+struct RenderGraphPass {
+    std::string name{};
+    PassResources resources{};
+};
+struct RenderGraphPassState {
+    bool enabled{};
+    bool async_compute{}; // Ordered by the semaphores and ownership transfers of the renderer instead of barriers
+
+    bool operator==(const RenderGraphPassState &other) const = default;
+};
+
+class RenderGraph {
+public:
+    // The passes are in execution order, transient images don't keep their contents between frames and have to be created with alias_memory
+    // The memory of the transient images is shared by those that are never used by the same range of passes
+    void build(const RenderAPI &api, std::vector<RenderGraphPass> passes, const std::vector<Handle<Image>> &transient_images);
+
+    // Culls the passes whose outputs are never read and computes the barriers between the rest, does nothing if the states didn't change
+    void compile(const std::vector<RenderGraphPassState> &states);
+
+    // Brings the persistent images from the layouts left by the last frame into the ones the compiled frame starts with
+    void record_prologue(Handle<CommandList> cmd, const RenderAPI &api);
+    void record_barriers(Handle<CommandList> cmd, const RenderAPI &api, usize pass_index) const;
+
+    [[nodiscard]] bool is_culled(usize pass_index) const { return m_compiled_passes[pass_index].culled; }
+    [[nodiscard]] std::vector<Handle<Buffer>> get_written_buffers(usize pass_index) const;
+
+    [[nodiscard]] VkDeviceSize get_transient_memory_size() const { return m_transient_memory_size; }
+    [[nodiscard]] VkDeviceSize get_transient_memory_size_unaliased() const { return m_transient_memory_size_unaliased; }
+    [[nodiscard]] u32 get_barrier_count() const { return m_barrier_count; }
+
+private:
+    struct CompiledPass {
+        bool culled{};
+
+        VkPipelineStageFlags src_stages{};
+        VkPipelineStageFlags dst_stages{};
+        std::vector<ImageBarrier> image_barriers{};
+        std::vector<BufferBarrier> buffer_barriers{};
+    };
+
+    std::vector<bool> cull_passes(const std::vector<RenderGraphPassState> &states) const;
+
+    std::vector<RenderGraphPass> m_passes{};
+    std::vector<RenderGraphPassState> m_compiled_states{};
+    std::vector<CompiledPass> m_compiled_passes{};
+
+    // Images sharing memory are synchronized as one resource
+    std::unordered_map<Handle<Image>, u32> m_transient_memory_ids{};
+
+    std::unordered_map<Handle<Image>, VkImageLayout> m_frame_start_layouts{};
+    std::unordered_map<Handle<Image>, VkImageLayout> m_current_layouts{}; // Of the persistent images at the end of the last recorded frame
+
+    VkDeviceSize m_transient_memory_size{};
+    VkDeviceSize m_transient_memory_size_unaliased{};
+    u32 m_barrier_count{};
+};
+
+#endif
@@ -7,6 +7,12 @@
 #include <common/utils.hpp>
 #include <renderer/gpu_types.inl>
 #include <renderer/renderer_shared_objects.hpp>
+#include <renderer/render_graph.hpp>
+#include <renderer/texture_file.hpp>
+#include <renderer/mesh_file.hpp>
+#include <common/mip_generator.hpp>
+#include <common/resource_registry.hpp>
+#include <common/sparse_set.hpp>
 
 #include "passes/draw_call_gen_pass.hpp"
 #include "passes/geometry_pass.hpp"
@@ -14,6 +20,15 @@
 #include "passes/ui_pass.hpp"
 #include "passes/debug_pass.hpp"
 
+enum struct TextureCompression : u32 {
+    None,
+    BC1, // RGB
+    BC3, // RGBA
+    BC4, // R
+    BC5, // RG, for normal maps
+    BC7, // RGBA, best quality
+};
+
 struct SceneLoadInfo {
     std::string path{};
     bool import_textures = true;
@@ -22,13 +37,21 @@ struct SceneLoadInfo {
     f32 lod_bias{}; // Applied if MeshInstance has more than 'lod_bias_threshold' vertices in total
     f32 simplify_target_error = -1.0f; // 0.0f -> 1.0f, less = better quality
     f32 cull_dist_multiplier = 1.0f;
+    bool compress_textures = false; // Encodes imported textures on the CPU: albedo with 'albedo_compression', normals with BC5, single channel maps with BC4 and the rest with BC1
+    TextureCompression albedo_compression = TextureCompression::BC7;
+    std::string mesh_export_directory{}; // If not empty, every mesh is also saved there as "<mesh index>.gmesh" for load_mesh()
 };
 struct TextureLoadInfo {
     std::string path{};
     bool is_srgb = false;
     bool gen_mip_maps = false;
     bool linear_filter = true;
-    u32 desired_channels = 4u;
+    u32 desired_channels = 4u; // With compression, 1 selects BC4 and 2 selects BC5 for non-sRGB textures, the same happens for files with that few channels
+    TextureCompression compression = TextureCompression::None; // Ignored for .dds and .ktx2 files
+    MipFilter mip_filter = MipFilter::Kaiser;
+    f32 alpha_coverage_cutoff{}; // If greater than 0, mips keep the fraction of pixels with alpha above this value, for alpha tested textures
+    const void *encoded_data{}; // Decoded instead of the file at 'path' if not nullptr, e.g. an image embedded in a glTF buffer
+    usize encoded_size{};
 };
 
 struct TextureCreateInfo {
@@ -39,6 +62,16 @@ struct TextureCreateInfo {
     bool is_srgb = false;
     bool gen_mip_maps = false;
     bool linear_filter = true;
+    TextureCompression compression = TextureCompression::None; // Requires bytes_per_pixel = 4
+    MipFilter mip_filter = MipFilter::Kaiser; // Mips are always generated on the CPU
+    f32 alpha_coverage_cutoff{};
+};
+struct TextureDataCreateInfo {
+    const TextureData *data{};
+    bool gen_mip_maps = false; // Ignored if data already has mips or is block compressed
+    bool linear_filter = true;
+
+    std::string source_path{}; // Container file of 'data', only textures with a source are streamed since their high mips are reloaded from it
 };
 struct MaterialCreateInfo {
     Handle<Texture> albedo_texture = INVALID_HANDLE;
@@ -66,26 +99,30 @@ struct MeshInstanceCreateInfo {
     f32 cull_dist_multiplier = 1.0f;
 };
 
-struct RegisteredPassRef {
-    bool enabled{};
-    bool query_statistics{};
-    u32 order{};
-    BasePass *pass_ptr{};
+// Compared when a content hash is found in a ResourceRegistry, materials are compared as a whole
+struct MeshRegistryKey {
+    u32 primitive_count{};
+    u32 vertex_count{};
+    u32 index_count{};
+};
+struct TextureRegistryKey {
+    u32 width{};
+    u32 height{};
+    VkFormat format{}; // Of the source pixels, before any compression
 };
+
+enum struct PassQueue : u32 {
+    Graphics = 0u,
+    AsyncCompute, // On the compute queue if config_enable_async_compute is set and supported, otherwise in order on the graphics queue
+};
+
 struct RegisteredPass {
     bool enabled = true;
-    bool query_statistics = false;
+    bool query_statistics = false; // Graphics queue only
     u32 order{};
+    PassQueue queue = PassQueue::Graphics;
+    u32 sync_order{}; // PassQueue::AsyncCompute only, the graphics passes from this order on wait for the compute queue
     Unique<BasePass> pass_ptr{};
-
-    RegisteredPassRef as_ref() const {
-        return RegisteredPassRef {
-            .enabled = enabled,
-            .query_statistics = query_statistics,
-            .order = order,
-            .pass_ptr = pass_ptr.get()
-        };
-    }
 };
 
 class Renderer {
@@ -94,19 +131,26 @@ public:
     ~Renderer();
 
     void resize(Window &window);
-    void render(Window &window, World &world, Handle<Camera> camera);
+    // Secondary views are culled together with the main camera and get their own draw lists, at most GPU_MAX_VIEW_COUNT - 1 of them
+    void render(Window &window, World &world, Handle<Camera> camera, const std::vector<Handle<Camera>> &secondary_views = {});
     void reload_pipelines();
 
     SceneCreateInfo load_gltf_scene(const SceneLoadInfo &load_info);
 
+    // Meshes, textures and materials with identical content share one handle, destroy() frees them when the last user is gone
     Handle<Mesh> create_mesh(const MeshCreateInfo &create_info);
+    Handle<Mesh> load_mesh(const std::string &path); // .gmesh saved with MeshFile::save()
     void destroy(Handle<Mesh> mesh_handle);
 
     Handle<MeshInstance> create_mesh_instance(const MeshInstanceCreateInfo &create_info);
     void destroy(Handle<MeshInstance> mesh_instance_handle);
 
+    Handle<Texture> load_texture(const TextureLoadInfo &load_info);
+    std::vector<Handle<Texture>> load_textures(const std::vector<TextureLoadInfo> &load_infos); // Decodes images in parallel while the previous batch is uploaded
+    Handle<Texture> load_container_texture(const TextureLoadInfo &load_info);
     Handle<Texture> load_u8_texture(const TextureLoadInfo &load_info);
     Handle<Texture> create_u8_texture(const TextureCreateInfo &create_info);
+    Handle<Texture> create_texture(const TextureDataCreateInfo &create_info);
     void destroy(Handle<Texture> texture_handle);
 
     Handle<Material> create_material(const MaterialCreateInfo &create_info);
@@ -119,11 +163,26 @@ public:
     void set_config_enable_debug_shape_view(bool enable);
     void set_config_debug_shape_opacity(f32 value);
     void set_config_lod_sphere_visible_angle(f32 value);
+    void set_config_lod_error_threshold(f32 value);
+    void set_config_enable_cluster_cull(bool enable);
+    void set_config_cluster_cull_min_pixel_size(f32 value);
+    void set_config_enable_vertex_quantization(bool enable);
+    void set_config_enable_occlusion_cull(bool enable);
+    void set_config_enable_visibility_buffer(bool enable);
+    void set_config_gbuffer_layout(GBufferLayout layout); // Recreates the screen images, ignored if the format can't be rendered to
+    void set_config_enable_dynamic_resolution(bool enable);
+    void set_config_dynamic_resolution_target_ms(f32 value);
+    void set_config_dynamic_resolution_min_scale(f32 value);
+    void set_config_enable_async_compute(bool enable);
     void set_config_ssao_samples(u32 value);
     void set_config_ssao_radius(f32 value);
     void set_config_ssao_bias(f32 value);
     void set_config_ssao_multiplier(f32 value);
     void set_config_ssao_noise_scale_divider(i32 value);
+    void set_config_enable_half_res_ssao(bool enabled);
+    void set_config_ssao_half_res_samples(u32 value);
+    void set_config_enable_texture_streaming(bool enable);
+    void set_config_texture_streaming_budget_mb(u32 value);
 
     void set_ui_draw_callback(UIPassDrawFn draw_callback);
 
@@ -134,45 +193,93 @@ public:
 
     const RangeAllocator<Handle<Material>, RangeAllocatorType::InPlace> &get_mesh_instance_materials_allocator() const { return m_mesh_instance_materials_allocator; }
     const RangeAllocator<Primitive, RangeAllocatorType::InPlace> &get_primitive_allocator() const { return m_primitive_allocator; }
-    const RangeAllocator<Vertex, RangeAllocatorType::External> &get_vertex_allocator() const { return m_vertex_allocator; }
+    const RangeAllocator<VertexBlock, RangeAllocatorType::External> &get_vertex_allocator() const { return m_vertex_allocator; }
     const RangeAllocator<u32, RangeAllocatorType::External> &get_index_allocator() const { return m_index_allocator; }
+    const RangeAllocator<u16, RangeAllocatorType::External> &get_index16_allocator() const { return m_index16_allocator; }
+    const RangeAllocator<Meshlet, RangeAllocatorType::External> &get_meshlet_allocator() const { return m_meshlet_allocator; }
 
     [[nodiscard]] const RendererSharedObjects &get_shared_objects() const { return m_shared; }
 
+    const ResourceRegistry<Mesh, MeshRegistryKey> &get_mesh_registry() const { return m_mesh_registry; }
+    const ResourceRegistry<Texture, TextureRegistryKey> &get_texture_registry() const { return m_texture_registry; }
+    const ResourceRegistry<Material, Material> &get_material_registry() const { return m_material_registry; }
+
+    usize get_streamed_texture_count() const { return m_streamed_textures.size(); }
+    usize get_streamed_texture_resident_bytes() const { return m_streamed_texture_resident_bytes; }
+
     const auto &get_cpu_timing() { return m_frames[m_frame_in_flight_index].cpu_timing; }
     const auto &get_gpu_timing() { return m_frames[m_frame_in_flight_index].gpu_timing; }
     const auto &get_gpu_statistics() { return m_frames[m_frame_in_flight_index].gpu_pipeline_statistics; }
+    const auto &get_async_compute_passes() { return m_frames[m_frame_in_flight_index].async_compute_passes; }
+    const OcclusionCullStats &get_occlusion_cull_stats() { return m_frames[m_frame_in_flight_index].occlusion_cull_stats; }
+    const RenderGraph &get_render_graph() const { return m_render_graph; }
+    u32 get_renderable_object_count() const { return m_renderable_objects.size(); }
+    u32 get_gbuffer_bytes_per_pixel() const;
 
     const u32 FRAMES_IN_FLIGHT = 2U;
 
     const VkDeviceSize MAX_SCENE_TEXTURES = 2048ull; // (device memory)
     const VkDeviceSize MAX_SCENE_MATERIALS = 65535ull; // (device memory)
-    const VkDeviceSize MAX_SCENE_VERTICES = (64ull * 1024ull * 1024ull) / sizeof(Vertex); // (device memory)
-    const VkDeviceSize MAX_SCENE_INDICES = (256ull * 1024ull * 1024ull) / sizeof(u32); // (device memory)
+    const VkDeviceSize MAX_SCENE_VERTEX_BLOCKS = (64ull * 1024ull * 1024ull) / sizeof(VertexBlock); // (device memory)
+    const VkDeviceSize MAX_SCENE_VERTICES = MAX_SCENE_VERTEX_BLOCKS * (sizeof(VertexBlock) / sizeof(Vertex)); // Full format, quantized meshes fit more
+    const VkDeviceSize MAX_SCENE_INDICES = (128ull * 1024ull * 1024ull) / sizeof(u32); // (device memory)
+    const VkDeviceSize MAX_SCENE_INDICES16 = (128ull * 1024ull * 1024ull) / sizeof(u16); // (device memory) LODs referencing at most GPU_INDEX16_MAX_VERTICES vertices
     const VkDeviceSize MAX_SCENE_MESHES = 2048ull * 8ull; // (device memory)
     const VkDeviceSize MAX_SCENE_MESH_INSTANCES = MAX_SCENE_MESHES * 2ull; // (device memory)
     const VkDeviceSize MAX_SCENE_MESH_INSTANCE_MATERIALS = MAX_SCENE_MESH_INSTANCES * 4u; // (device memory)
     const VkDeviceSize MAX_SCENE_PRIMITIVES = MAX_SCENE_MESHES * 4ull; // (device memory)
     const VkDeviceSize MAX_SCENE_OBJECTS = 1ull * 1024ull * 1024ull; // (device memory)
-    const VkDeviceSize MAX_SCENE_DRAWS = MAX_SCENE_OBJECTS * 2ull; // (device memory)
+    const VkDeviceSize MAX_SCENE_LIGHTS = 65536ull; // (device memory)
+    const VkDeviceSize MAX_SCENE_MESHLETS = (MAX_SCENE_INDICES + MAX_SCENE_INDICES16) / (GPU_MESHLET_MAX_TRIANGLES * 3ull) * 2ull; // (device memory)
+    const VkDeviceSize MAX_SCENE_CLUSTER_JOBS = 65535ull; // (device memory) Also the dispatch size, so it can't be more than the guaranteed maxComputeWorkGroupCount[0]
+    const VkDeviceSize MAX_SCENE_CLUSTER_INDICES = (64ull * 1024ull * 1024ull) / sizeof(u32); // (device memory)
+    const VkDeviceSize MAX_SCENE_DRAW_BUCKETS = MAX_SCENE_PRIMITIVES * GPU_MAX_LOD_COUNT; // (device memory) One instanced draw per (primitive, LOD) and view
+    const VkDeviceSize MAX_SCENE_DRAWS = (MAX_SCENE_DRAW_BUCKETS + MAX_SCENE_CLUSTER_JOBS) * GPU_INDEX_TYPE_COUNT; // (device memory) Split evenly between the views and the index type buckets
+    const VkDeviceSize MAX_SCENE_VISIBLE_INSTANCES = MAX_SCENE_OBJECTS * 2ull; // (device memory) Culled (object, primitive) pairs per phase
+    const VkDeviceSize MAX_SCENE_DRAW_INSTANCES = MAX_SCENE_VISIBLE_INSTANCES + MAX_SCENE_CLUSTER_JOBS; // (device memory)
 
     const VkDeviceSize PER_FRAME_UPLOAD_BUFFER_SIZE = 16ull * 1024ull * 1024ull; // (host memory)
+    const VkDeviceSize TEXTURE_DECODE_BATCH_SIZE = 256ull * 1024ull * 1024ull; // (host memory)
+    const VkDeviceSize TEXTURE_DECODE_WORKING_SET_SIZE = 1024ull * 1024ull * 1024ull; // (host memory) Decoded pixels and mip generation buffers of the images decoded at once
+    const VkDeviceSize PER_FRAME_TEXTURE_STREAMING_UPLOAD_SIZE = 32ull * 1024ull * 1024ull; // (host memory)
+
+    const u32 TEXTURE_STREAMING_IMPORT_SIZE = 128U; // Streamed textures are created with only the mips of this size and smaller
+    const u32 TEXTURE_STREAMING_EVICT_FRAMES = 300U; // Textures not sampled for this many frames fall back to their import mips
 
 private:
     void begin_recording_frame();
-    void update_world(World &world, Handle<Camera> camera);
+    void update_world(World &world, Handle<Camera> camera, const std::vector<Handle<Camera>> &secondary_views);
     void render_world(World &world, Handle<Camera> camera);
     void end_recording_frame();
 
+    // Ends the overlap of the async compute batch, the following graphics passes are recorded into join_command_list
+    void join_async_compute(const std::vector<Handle<Buffer>> &outputs);
+
     void init_scene_buffers();
     void init_screen_images(glm::uvec2 size);
     void init_descriptors();
     void init_passes(const Window &window);
+    void build_render_graph(); // Binds the memory of the transient screen images, so it has to be called before the passes use them
     void init_frames();
     void init_defaults();
 
     void resize_passes(const Window &window);
 
+    Handle<Texture> create_uncached_u8_texture(const TextureCreateInfo &create_info);
+    Handle<Texture> create_uncached_texture(const TextureDataCreateInfo &create_info);
+    Texture create_u8_texture_resources(const TextureCreateInfo &create_info);
+    void record_u8_texture_upload(Handle<CommandList> cmd, const Texture &texture, Handle<Buffer> staging_buffer, const std::vector<BufferToImageCopy> &regions);
+    Handle<Texture> register_texture(const Texture &texture);
+
+    void update_texture_streaming();
+
+    void update_dynamic_resolution();
+    void set_render_scale(f32 scale); // Only changes the rendered area, the screen images stay allocated at the window size
+    Handle<Image> create_texture_image(const TextureData &data, u32 first_mip);
+    std::vector<BufferToImageCopy> copy_texture_mips_to_staging(void *staging_ptr, usize staging_offset, const TextureData &data, u32 first_mip) const;
+    void upload_texture_mips(Texture &texture, const TextureData &data, u32 first_mip); // Blocking, only for the texture creation
+    usize calculate_resident_texture_size(const TextureData &data, u32 first_mip) const;
+
     void destroy_defaults();
     void destroy_frames();
     void destroy_passes();
@@ -181,6 +288,9 @@ private:
     void destroy_scene_buffers();
 
     std::unordered_map<std::string, RegisteredPass> m_registered_passes{};
+    std::vector<std::pair<std::string, RegisteredPass*>> m_sorted_passes{}; // By RegisteredPass::order, in the same order as the render graph passes
+
+    RenderGraph m_render_graph{};
 
     RenderAPI m_api;
     UIPass m_ui_pass{};
@@ -189,9 +299,24 @@ private:
     DrawCallGenPass m_draw_call_gen_pass{};
     DebugPass m_debug_pass{};
 
+    struct StreamedTextureUpload {
+        Handle<Texture> texture{};
+        Handle<Image> image{};
+        u32 mip{};
+    };
+
     struct Frame {
         Handle<CommandList> command_list{};
 
+        // With async compute the graphics work is split around the compute batch: command_list up to the first async pass,
+        // overlap_command_list next to the compute queue and join_command_list from the first pass that waits for it
+        Handle<CommandList> overlap_command_list{};
+        Handle<CommandList> join_command_list{};
+        Handle<CommandList> compute_command_list{};
+        Handle<CommandList> active_command_list{}; // The graphics list being recorded
+        Handle<Semaphore> compute_wait_semaphore{}; // command_list -> compute_command_list
+        Handle<Semaphore> compute_signal_semaphore{}; // compute_command_list -> join_command_list
+
         Handle<Semaphore> present_semaphore{};
         Handle<Semaphore> render_semaphore{};
         Handle<Fence> fence{};
@@ -200,6 +325,27 @@ private:
 
         void* upload_ptr{};
 
+        Handle<Buffer> texture_feedback_buffer{};
+        const u32* texture_feedback_ptr{};
+
+        // Streamed mips are uploaded on the transfer queue, the last graphics submission of the frame waits for transfer_semaphore
+        Handle<CommandList> transfer_command_list{};
+        Handle<Semaphore> transfer_semaphore{};
+        Handle<Buffer> texture_staging_buffer{};
+        void* texture_staging_ptr{};
+        bool transfer_submitted{};
+
+        // Both are handled when this slot comes around again: the uploads have completed by then and the replaced images aren't used by any frame in flight
+        std::vector<StreamedTextureUpload> texture_uploads{};
+        std::vector<Handle<Image>> retired_texture_images{};
+        std::vector<ImageBarrier> texture_acquire_barriers{}; // Recorded at the start of the frame, after the descriptor swap
+
+        Handle<Buffer> occlusion_stats_buffer{};
+        const OcclusionCullStats* occlusion_stats_ptr{};
+        OcclusionCullStats occlusion_cull_stats{}; // Copied after the fence wait, stays valid while the frame is being recorded again
+
+        f32 render_scale = 1.0f; // Of the frame last recorded in this slot, its GPU timing was measured at this scale
+
         template<typename T>
         T* access_upload(usize offset) {
 #if DEBUG_MODE
@@ -212,6 +358,7 @@ private:
         std::unordered_map<std::string, f64> cpu_timing{};
         std::unordered_map<std::string, std::pair<std::pair<Handle<Query>, Handle<Query>>, std::pair<f64, f64>>> gpu_timing{};
         std::unordered_map<std::string, std::pair<Handle<Query>, QueryPipelineStatisticsResults>> gpu_pipeline_statistics{};
+        std::unordered_set<std::string> async_compute_passes{}; // Recorded on the compute queue, their timestamps overlap the graphics passes
 
     };
 
@@ -229,10 +376,30 @@ private:
 
     RangeAllocator<Handle<Material>, RangeAllocatorType::InPlace> m_mesh_instance_materials_allocator{};
     RangeAllocator<Primitive, RangeAllocatorType::InPlace> m_primitive_allocator{};
-    RangeAllocator<Vertex, RangeAllocatorType::External> m_vertex_allocator{};
+    RangeAllocator<VertexBlock, RangeAllocatorType::External> m_vertex_allocator{};
     RangeAllocator<u32, RangeAllocatorType::External> m_index_allocator{};
+    RangeAllocator<u16, RangeAllocatorType::External> m_index16_allocator{};
+    RangeAllocator<Meshlet, RangeAllocatorType::External> m_meshlet_allocator{};
 
     RendererSharedObjects m_shared{};
+
+    ResourceRegistry<Mesh, MeshRegistryKey> m_mesh_registry{};
+    ResourceRegistry<Texture, TextureRegistryKey> m_texture_registry{};
+    ResourceRegistry<Material, Material> m_material_registry{};
+
+    SparseSet m_renderable_objects{}; // Visible objects with a mesh instance, mirrored in scene_renderable_object_buffer
+
+    struct StreamedTexture {
+        std::string source_path{}; // The mips above import_mip are reloaded from it on demand, cleared if that fails
+        TextureData data{}; // Sizes of all mips, but only the import mips keep their bytes
+        u32 import_mip{};
+        u32 desired_mip{};
+        u32 last_requested_frame{};
+        std::optional<u32> pending_mip{}; // First mip of the upload in flight, the texture keeps its old image until it completes
+    };
+
+    std::unordered_map<Handle<Texture>, StreamedTexture> m_streamed_textures{};
+    usize m_streamed_texture_resident_bytes{};
 };
 
 #endif
@@ -1,6 +1,24 @@
+#include <algorithm>
+
 #include "renderer.hpp"
 #include "passes/composite_pass.hpp"
 #include "passes/ssao_pass.hpp"
+#include "passes/cluster_cull_pass.hpp"
+#include "passes/depth_pyramid_pass.hpp"
+#include "passes/material_pass.hpp"
+#include "passes/light_cull_pass.hpp"
+
+static_assert(static_cast<u32>(GBufferLayout::Full) == GPU_NORMAL_ENCODING_FLOAT);
+static_assert(static_cast<u32>(GBufferLayout::Octahedral16) == GPU_NORMAL_ENCODING_OCTAHEDRAL_SNORM);
+static_assert(static_cast<u32>(GBufferLayout::Octahedral10) == GPU_NORMAL_ENCODING_OCTAHEDRAL_UNORM);
+
+static VkFormat get_gbuffer_normal_format(GBufferLayout layout) {
+    switch (layout) {
+        case GBufferLayout::Octahedral16: return VK_FORMAT_R16G16_SNORM;
+        case GBufferLayout::Octahedral10: return VK_FORMAT_A2B10G10R10_UNORM_PACK32;
+        default: return VK_FORMAT_R32G32B32A32_SFLOAT;
+    }
+}
 
 Renderer::Renderer(Window &window, VSyncMode v_sync) : m_api(window, SwapchainConfig{
                                                                  .v_sync = v_sync,
@@ -36,10 +54,70 @@ void Renderer::init_scene_buffers() {
         .memory_usage_flags = VMA_MEMORY_USAGE_GPU_ONLY
     });
     m_shared.scene_draw_count_buffer = m_api.rm->create_buffer(BufferCreateInfo{
-        .size = sizeof(u32),
+        .size = sizeof(u32) * GPU_INDEX_TYPE_COUNT * GPU_MAX_VIEW_COUNT,
+        .buffer_usage_flags = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        .memory_usage_flags = VMA_MEMORY_USAGE_GPU_ONLY
+    });
+    m_shared.scene_late_draw_buffer = m_api.rm->create_buffer(BufferCreateInfo{
+        .size = sizeof(DrawCommand) * MAX_SCENE_DRAWS,
+        .buffer_usage_flags = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+        .memory_usage_flags = VMA_MEMORY_USAGE_GPU_ONLY
+    });
+    m_shared.scene_late_draw_count_buffer = m_api.rm->create_buffer(BufferCreateInfo{
+        .size = sizeof(u32) * GPU_INDEX_TYPE_COUNT,
+        .buffer_usage_flags = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        .memory_usage_flags = VMA_MEMORY_USAGE_GPU_ONLY
+    });
+    m_shared.scene_draw_instance_buffer = m_api.rm->create_buffer(BufferCreateInfo{
+        .size = sizeof(DrawInstance) * MAX_SCENE_DRAW_INSTANCES,
+        .buffer_usage_flags = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+        .memory_usage_flags = VMA_MEMORY_USAGE_GPU_ONLY
+    });
+    m_shared.scene_draw_instance_dispatch_buffer = m_api.rm->create_buffer(BufferCreateInfo{
+        .size = sizeof(DrawInstanceDispatch),
+        .buffer_usage_flags = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        .memory_usage_flags = VMA_MEMORY_USAGE_GPU_ONLY
+    });
+    m_shared.scene_late_draw_instance_buffer = m_api.rm->create_buffer(BufferCreateInfo{
+        .size = sizeof(DrawInstance) * MAX_SCENE_DRAW_INSTANCES,
+        .buffer_usage_flags = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+        .memory_usage_flags = VMA_MEMORY_USAGE_GPU_ONLY
+    });
+    m_shared.scene_late_draw_instance_dispatch_buffer = m_api.rm->create_buffer(BufferCreateInfo{
+        .size = sizeof(DrawInstanceDispatch),
         .buffer_usage_flags = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
         .memory_usage_flags = VMA_MEMORY_USAGE_GPU_ONLY
     });
+    m_shared.scene_visible_instance_buffer = m_api.rm->create_buffer(BufferCreateInfo{
+        .size = sizeof(VisibleInstance) * MAX_SCENE_VISIBLE_INSTANCES,
+        .buffer_usage_flags = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+        .memory_usage_flags = VMA_MEMORY_USAGE_GPU_ONLY
+    });
+    m_shared.scene_draw_bucket_count_buffer = m_api.rm->create_buffer(BufferCreateInfo{
+        .size = sizeof(u32) * MAX_SCENE_DRAW_BUCKETS * GPU_MAX_VIEW_COUNT,
+        .buffer_usage_flags = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        .memory_usage_flags = VMA_MEMORY_USAGE_GPU_ONLY
+    });
+    m_shared.scene_draw_bucket_offset_buffer = m_api.rm->create_buffer(BufferCreateInfo{
+        .size = sizeof(u32) * MAX_SCENE_DRAW_BUCKETS * GPU_MAX_VIEW_COUNT,
+        .buffer_usage_flags = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+        .memory_usage_flags = VMA_MEMORY_USAGE_GPU_ONLY
+    });
+    m_shared.scene_draw_bucket_block_buffer = m_api.rm->create_buffer(BufferCreateInfo{
+        .size = sizeof(u32) * Utils::div_ceil(MAX_SCENE_DRAW_BUCKETS * GPU_MAX_VIEW_COUNT, GPU_DRAW_BUCKET_SCAN_BLOCK_SIZE),
+        .buffer_usage_flags = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+        .memory_usage_flags = VMA_MEMORY_USAGE_GPU_ONLY
+    });
+    m_shared.scene_visibility_buffer = m_api.rm->create_buffer(BufferCreateInfo{
+        .size = sizeof(u32) * Utils::div_ceil(MAX_SCENE_OBJECTS, 32ull),
+        .buffer_usage_flags = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        .memory_usage_flags = VMA_MEMORY_USAGE_GPU_ONLY
+    });
+    m_shared.scene_occlusion_stats_buffer = m_api.rm->create_buffer(BufferCreateInfo{
+        .size = sizeof(OcclusionCullStats),
+        .buffer_usage_flags = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        .memory_usage_flags = VMA_MEMORY_USAGE_GPU_ONLY
+    });
     m_shared.scene_mesh_buffer = m_api.rm->create_buffer(BufferCreateInfo{
         .size = sizeof(Mesh) * MAX_SCENE_MESHES,
         .buffer_usage_flags = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
@@ -65,6 +143,11 @@ void Renderer::init_scene_buffers() {
         .buffer_usage_flags = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
         .memory_usage_flags = VMA_MEMORY_USAGE_GPU_ONLY
     });
+    m_shared.scene_renderable_object_buffer = m_api.rm->create_buffer(BufferCreateInfo{
+        .size = sizeof(u32) * MAX_SCENE_OBJECTS,
+        .buffer_usage_flags = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        .memory_usage_flags = VMA_MEMORY_USAGE_GPU_ONLY
+    });
     m_shared.scene_global_transform_buffer = m_api.rm->create_buffer(BufferCreateInfo{
         .size = sizeof(Transform) * MAX_SCENE_OBJECTS,
         .buffer_usage_flags = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
@@ -72,28 +155,99 @@ void Renderer::init_scene_buffers() {
     });
     m_shared.scene_camera_buffer = m_api.rm->create_buffer(BufferCreateInfo{
         .size = sizeof(Camera),
+        .buffer_usage_flags = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT, // Copied for the SSAO reprojection
+        .memory_usage_flags = VMA_MEMORY_USAGE_GPU_ONLY,
+        .concurrent_sharing = true // Read by the async Light Cull Pass while the graphics passes use it
+    });
+    m_shared.scene_view_buffer = m_api.rm->create_buffer(BufferCreateInfo{
+        .size = sizeof(Camera) * GPU_MAX_VIEW_COUNT,
         .buffer_usage_flags = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
         .memory_usage_flags = VMA_MEMORY_USAGE_GPU_ONLY
     });
     m_shared.scene_vertex_buffer = m_api.rm->create_buffer(BufferCreateInfo{
-        .size = sizeof(Vertex) * MAX_SCENE_VERTICES,
+        .size = sizeof(VertexBlock) * MAX_SCENE_VERTEX_BLOCKS,
         .buffer_usage_flags = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
         .memory_usage_flags = VMA_MEMORY_USAGE_GPU_ONLY
     });
+    // Indices of meshlets that survived cluster culling are compacted into the space after MAX_SCENE_INDICES, so that they can be drawn with the same index buffer
     m_shared.scene_index_buffer = m_api.rm->create_buffer(BufferCreateInfo{
-        .size = sizeof(u32) * MAX_SCENE_INDICES,
-        .buffer_usage_flags = VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        .size = sizeof(u32) * (MAX_SCENE_INDICES + MAX_SCENE_CLUSTER_INDICES),
+        .buffer_usage_flags = VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        .memory_usage_flags = VMA_MEMORY_USAGE_GPU_ONLY
+    });
+    m_shared.scene_index16_buffer = m_api.rm->create_buffer(BufferCreateInfo{
+        .size = sizeof(u16) * MAX_SCENE_INDICES16,
+        .buffer_usage_flags = VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        .memory_usage_flags = VMA_MEMORY_USAGE_GPU_ONLY
+    });
+    m_shared.scene_meshlet_buffer = m_api.rm->create_buffer(BufferCreateInfo{
+        .size = sizeof(Meshlet) * MAX_SCENE_MESHLETS,
+        .buffer_usage_flags = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        .memory_usage_flags = VMA_MEMORY_USAGE_GPU_ONLY
+    });
+    m_shared.scene_cluster_job_buffer = m_api.rm->create_buffer(BufferCreateInfo{
+        .size = sizeof(ClusterCullJob) * MAX_SCENE_CLUSTER_JOBS,
+        .buffer_usage_flags = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+        .memory_usage_flags = VMA_MEMORY_USAGE_GPU_ONLY
+    });
+    m_shared.scene_cluster_dispatch_buffer = m_api.rm->create_buffer(BufferCreateInfo{
+        .size = sizeof(ClusterCullDispatch),
+        .buffer_usage_flags = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        .memory_usage_flags = VMA_MEMORY_USAGE_GPU_ONLY
+    });
+
+    m_shared.scene_light_buffer = m_api.rm->create_buffer(BufferCreateInfo{
+        .size = sizeof(Light) * MAX_SCENE_LIGHTS,
+        .buffer_usage_flags = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        .memory_usage_flags = VMA_MEMORY_USAGE_GPU_ONLY,
+        .concurrent_sharing = true
+    });
+    // Written on the compute queue with async compute and transferred to the graphics queue family for the Composite Pass
+    m_shared.scene_light_cluster_count_buffer = m_api.rm->create_buffer(BufferCreateInfo{
+        .size = sizeof(u32) * GPU_LIGHT_CLUSTER_COUNT,
+        .buffer_usage_flags = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+        .memory_usage_flags = VMA_MEMORY_USAGE_GPU_ONLY
+    });
+    m_shared.scene_light_cluster_index_buffer = m_api.rm->create_buffer(BufferCreateInfo{
+        .size = sizeof(u32) * GPU_LIGHT_CLUSTER_COUNT * GPU_LIGHT_CLUSTER_MAX_LIGHTS,
+        .buffer_usage_flags = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
         .memory_usage_flags = VMA_MEMORY_USAGE_GPU_ONLY
     });
+
+    m_shared.scene_draw_capacity = static_cast<u32>(MAX_SCENE_DRAWS / GPU_INDEX_TYPE_COUNT);
+    m_shared.scene_draw_bucket_count = GPU_MAX_LOD_COUNT; // Grows in create_mesh()
+    m_shared.scene_visible_instance_capacity = static_cast<u32>(MAX_SCENE_VISIBLE_INSTANCES);
+    m_shared.scene_draw_instance_capacity = static_cast<u32>(MAX_SCENE_DRAW_INSTANCES);
+    m_shared.scene_cluster_job_capacity = static_cast<u32>(MAX_SCENE_CLUSTER_JOBS);
+    m_shared.scene_cluster_index_start = static_cast<u32>(MAX_SCENE_INDICES);
+    m_shared.scene_cluster_index_capacity = static_cast<u32>(MAX_SCENE_CLUSTER_INDICES);
+    m_shared.scene_texture_feedback_buffer = m_api.rm->create_buffer(BufferCreateInfo{
+        .size = sizeof(u32) * MAX_SCENE_TEXTURES,
+        .buffer_usage_flags = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+        .memory_usage_flags = VMA_MEMORY_USAGE_GPU_ONLY
+    });
+
+    m_api.record_and_submit_once([this](Handle<CommandList> cmd){
+        m_api.fill_buffer(cmd, m_shared.scene_texture_feedback_buffer, 0U, sizeof(u32) * MAX_SCENE_TEXTURES);
+
+        // Nothing was visible before the first frame, so the late phase tests and draws everything
+        m_api.fill_buffer(cmd, m_shared.scene_visibility_buffer, 0U, sizeof(u32) * Utils::div_ceil(MAX_SCENE_OBJECTS, 32ull));
+        m_api.fill_buffer(cmd, m_shared.scene_occlusion_stats_buffer, 0U, sizeof(OcclusionCullStats));
+
+        // Cleared only once, the draw emission resets every bucket it reads
+        m_api.fill_buffer(cmd, m_shared.scene_draw_bucket_count_buffer, 0U, sizeof(u32) * MAX_SCENE_DRAW_BUCKETS * GPU_MAX_VIEW_COUNT);
+    });
 }
 void Renderer::init_screen_images(glm::uvec2 size) {
     VkExtent3D screen_size{ size.x, size.y };
 
+    // Transient, the render graph binds their memory and lets those that are never used by the same passes share it
     m_shared.offscreen_image = m_api.rm->create_image(ImageCreateInfo{
         .format = VK_FORMAT_R8G8B8A8_SRGB,
         .extent = screen_size,
         .usage_flags = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
-        .aspect_flags = VK_IMAGE_ASPECT_COLOR_BIT
+        .aspect_flags = VK_IMAGE_ASPECT_COLOR_BIT,
+        .alias_memory = true
     });
     m_shared.offscreen_sampler = m_api.rm->create_sampler(SamplerCreateInfo{
         .filter = VK_FILTER_NEAREST,
@@ -104,27 +258,61 @@ void Renderer::init_screen_images(glm::uvec2 size) {
         .format = VK_FORMAT_D32_SFLOAT,
         .extent = screen_size,
         .usage_flags = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
-        .aspect_flags = VK_IMAGE_ASPECT_DEPTH_BIT
+        .aspect_flags = VK_IMAGE_ASPECT_DEPTH_BIT,
+        .alias_memory = true
     });
     m_shared.albedo_image = m_api.rm->create_image(ImageCreateInfo{
         .format = VK_FORMAT_R8G8B8A8_SRGB,
         .extent = screen_size,
         .usage_flags = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
-        .aspect_flags = VK_IMAGE_ASPECT_COLOR_BIT
+        .aspect_flags = VK_IMAGE_ASPECT_COLOR_BIT,
+        .alias_memory = true
     });
     m_shared.normal_image = m_api.rm->create_image(ImageCreateInfo{
-        .format = VK_FORMAT_R32G32B32A32_SFLOAT,
+        .format = get_gbuffer_normal_format(m_shared.config_gbuffer_layout),
+        .extent = screen_size,
+        .usage_flags = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+        .aspect_flags = VK_IMAGE_ASPECT_COLOR_BIT,
+        .alias_memory = true
+    });
+    m_shared.visibility_image = m_api.rm->create_image(ImageCreateInfo{
+        .format = VK_FORMAT_R32G32_UINT,
         .extent = screen_size,
         .usage_flags = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
-        .aspect_flags = VK_IMAGE_ASPECT_COLOR_BIT
+        .aspect_flags = VK_IMAGE_ASPECT_COLOR_BIT,
+        .alias_memory = true
     });
     m_shared.ssao_output_image = m_api.rm->create_image(ImageCreateInfo{
         .format = VK_FORMAT_R8_UNORM,
         .extent = screen_size,
         .usage_flags = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
-        .aspect_flags = VK_IMAGE_ASPECT_COLOR_BIT
+        .aspect_flags = VK_IMAGE_ASPECT_COLOR_BIT,
+        .alias_memory = true
     });
 
+    // Power of two sizes make every level exactly half of the previous one, so a texel always covers the same screen area as its 2x2 children
+    VkExtent3D depth_pyramid_size{
+        Utils::nearest_pot_floor(std::max(size.x, 1u)),
+        Utils::nearest_pot_floor(std::max(size.y, 1u)),
+        1u
+    };
+    m_shared.depth_pyramid_image = m_api.rm->create_image(ImageCreateInfo{
+        .format = VK_FORMAT_R32_SFLOAT,
+        .extent = depth_pyramid_size,
+        .usage_flags = VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+        .aspect_flags = VK_IMAGE_ASPECT_COLOR_BIT,
+        .mip_level_count = Utils::calculate_mipmap_levels_xy(depth_pyramid_size.width, depth_pyramid_size.height),
+        .create_per_mip_views = true
+    });
+    m_shared.depth_pyramid_sampler = m_api.rm->create_sampler(SamplerCreateInfo{
+        .filter = VK_FILTER_NEAREST,
+        .mipmap_mode = VK_SAMPLER_MIPMAP_MODE_NEAREST,
+        .address_mode = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE
+    });
+
+    // Keeps the dynamic resolution scale across resizes, the rendered area follows the new size
+    set_render_scale(m_shared.render_scale);
+
     std::vector<ImageBarrier> init_swapchain_barriers{};
     for(u32 i{}; i < m_api.get_swapchain_image_count(); ++i){
         init_swapchain_barriers.push_back(ImageBarrier{
@@ -136,33 +324,6 @@ void Renderer::init_screen_images(glm::uvec2 size) {
 
     m_api.record_and_submit_once([this, &init_swapchain_barriers](Handle<CommandList> cmd){
         m_api.image_barrier(cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT , init_swapchain_barriers);
-        m_api.image_barrier(cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT, { ImageBarrier{
-            .image_handle = m_shared.depth_image,
-            .dst_access_mask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT, // LoadOp = Clear
-            .new_layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL
-        }});
-        m_api.image_barrier(cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, {
-            ImageBarrier{
-                .image_handle = m_shared.offscreen_image,
-                .dst_access_mask = VK_ACCESS_SHADER_READ_BIT,
-                .new_layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-            },
-            ImageBarrier{
-                .image_handle = m_shared.albedo_image,
-                .dst_access_mask = VK_ACCESS_SHADER_READ_BIT,
-                .new_layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-            },
-            ImageBarrier{
-                .image_handle = m_shared.normal_image,
-                .dst_access_mask = VK_ACCESS_SHADER_READ_BIT,
-                .new_layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-            },
-            ImageBarrier{
-                .image_handle = m_shared.ssao_output_image,
-                .dst_access_mask = VK_ACCESS_SHADER_READ_BIT,
-                .new_layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-            }
-        });
     });
 }
 void Renderer::init_descriptors() {
@@ -173,39 +334,105 @@ void Renderer::init_descriptors() {
     });
 }
 void Renderer::init_passes(const Window &window) {
+    DEBUG_TIMESTAMP(start);
+
     m_registered_passes["Draw Call Generation Pass"] = RegisteredPass {
         .order = 0u,
         .pass_ptr = MakeUnique<DrawCallGenPass>()
     };
+    m_registered_passes["Cluster Cull Pass"] = RegisteredPass {
+        .order = 1u,
+        .pass_ptr = MakeUnique<ClusterCullPass>()
+    };
+    // Only the Composite Pass reads the clusters, so the culling overlaps with the Geometry to SSAO Passes
+    m_registered_passes["Light Cull Pass"] = RegisteredPass {
+        .order = 2u,
+        .queue = PassQueue::AsyncCompute,
+        .sync_order = 9u,
+        .pass_ptr = MakeUnique<LightCullPass>()
+    };
     m_registered_passes["Geometry Pass"] = RegisteredPass {
         .query_statistics = true,
-        .order = 1u,
+        .order = 3u,
         .pass_ptr = MakeUnique<GeometryPass>()
     };
+    m_registered_passes["Depth Pyramid Pass"] = RegisteredPass {
+        .order = 4u,
+        .pass_ptr = MakeUnique<DepthPyramidPass>()
+    };
+    m_registered_passes["Late Draw Call Generation Pass"] = RegisteredPass {
+        .order = 5u,
+        .pass_ptr = MakeUnique<DrawCallGenPass>(true)
+    };
+    m_registered_passes["Late Geometry Pass"] = RegisteredPass {
+        .query_statistics = true,
+        .order = 6u,
+        .pass_ptr = MakeUnique<GeometryPass>(true)
+    };
+    m_registered_passes["Material Pass"] = RegisteredPass {
+        .query_statistics = true,
+        .order = 7u,
+        .pass_ptr = MakeUnique<MaterialPass>()
+    };
     m_registered_passes["SSAO Pass"] = RegisteredPass {
-        .order = 2u,
+        .order = 8u,
         .pass_ptr = MakeUnique<SSAOPass>()
     };
     m_registered_passes["Composite Pass"] = RegisteredPass {
-        .order = 3u,
+        .order = 9u,
         .pass_ptr = MakeUnique<CompositePass>()
     };
     m_registered_passes["Debug Pass"] = RegisteredPass {
-        .order = 4u,
+        .order = 10u,
         .pass_ptr = MakeUnique<DebugPass>()
     };
     m_registered_passes["Offscreen To Swapchain Pass"] = RegisteredPass {
-        .order = 5u,
+        .order = 11u,
         .pass_ptr = MakeUnique<OffscreenToSwapchainPass>()
     };
     m_registered_passes["UI Pass"] = RegisteredPass {
-        .order = 6u,
+        .order = 12u,
         .pass_ptr = MakeUnique<UIPass>()
     };
 
+    m_sorted_passes.clear();
+    for(auto &[name, registered_pass] : m_registered_passes) {
+        m_sorted_passes.emplace_back(name, &registered_pass);
+    }
+    std::sort(m_sorted_passes.begin(), m_sorted_passes.end(), [](const auto &left, const auto &right) {
+        return left.second->order < right.second->order;
+    });
+
+    build_render_graph();
+
+    // The pipelines of all passes compile on worker threads while the passes create the rest of their resources
     for(auto &[name, registered_pass] : m_registered_passes) {
         registered_pass.pass_ptr->init(m_api, m_shared, window);
     }
+    m_api.rm->wait_for_pipelines();
+
+    // Mostly pipeline creation, much shorter with a warm pipeline cache
+    DEBUG_TIMESTAMP(stop);
+    DEBUG_LOG("Initialized " << m_registered_passes.size() << " passes in " << DEBUG_TIME_DIFF(start, stop) * 1000.0 << "ms")
+}
+void Renderer::build_render_graph() {
+    std::vector<RenderGraphPass> passes{};
+    for(const auto &[name, registered_pass] : m_sorted_passes) {
+        RenderGraphPass pass{ .name = name };
+        registered_pass->pass_ptr->declare_resources(pass.resources, m_shared);
+
+        passes.push_back(std::move(pass));
+    }
+
+    // The depth pyramid stays persistent, the early Draw Call Generation Pass binds it before the Depth Pyramid Pass writes it
+    m_render_graph.build(m_api, std::move(passes), {
+        m_shared.offscreen_image,
+        m_shared.depth_image,
+        m_shared.albedo_image,
+        m_shared.normal_image,
+        m_shared.visibility_image,
+        m_shared.ssao_output_image
+    });
 }
 void Renderer::init_frames() {
     m_frames.resize(FRAMES_IN_FLIGHT);
@@ -215,6 +442,11 @@ void Renderer::init_frames() {
 
         frame = Frame{
             .command_list = m_api.rm->create_command_list(QueueFamily::Graphics),
+            .overlap_command_list = m_api.rm->create_command_list(QueueFamily::Graphics),
+            .join_command_list = m_api.rm->create_command_list(QueueFamily::Graphics),
+            .compute_command_list = m_api.rm->create_command_list(QueueFamily::Compute),
+            .compute_wait_semaphore = m_api.rm->create_semaphore(),
+            .compute_signal_semaphore = m_api.rm->create_semaphore(),
             .present_semaphore = m_api.rm->create_semaphore(),
             .render_semaphore = m_api.rm->create_semaphore(),
             .fence = m_api.rm->create_fence(),
@@ -227,6 +459,40 @@ void Renderer::init_frames() {
 
         frame.upload_ptr = m_api.rm->map_buffer(frame.upload_buffer);
 
+        frame.texture_feedback_buffer = m_api.rm->create_buffer(BufferCreateInfo{
+            .size = sizeof(u32) * MAX_SCENE_TEXTURES,
+            .buffer_usage_flags = VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            .memory_usage_flags = VMA_MEMORY_USAGE_GPU_TO_CPU
+        });
+
+        // Zeroed so that the first read of each frame doesn't see garbage
+        m_api.record_and_submit_once([this, &frame](Handle<CommandList> cmd){
+            m_api.fill_buffer(cmd, frame.texture_feedback_buffer, 0U, sizeof(u32) * MAX_SCENE_TEXTURES);
+        });
+
+        frame.texture_feedback_ptr = static_cast<const u32*>(m_api.rm->map_buffer(frame.texture_feedback_buffer));
+
+        frame.transfer_command_list = m_api.rm->create_command_list(QueueFamily::Transfer);
+        frame.transfer_semaphore = m_api.rm->create_semaphore();
+        frame.texture_staging_buffer = m_api.rm->create_buffer(BufferCreateInfo{
+            .size = PER_FRAME_TEXTURE_STREAMING_UPLOAD_SIZE,
+            .buffer_usage_flags = VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            .memory_usage_flags = VMA_MEMORY_USAGE_CPU_TO_GPU
+        });
+        frame.texture_staging_ptr = m_api.rm->map_buffer(frame.texture_staging_buffer);
+
+        frame.occlusion_stats_buffer = m_api.rm->create_buffer(BufferCreateInfo{
+            .size = sizeof(OcclusionCullStats),
+            .buffer_usage_flags = VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            .memory_usage_flags = VMA_MEMORY_USAGE_GPU_TO_CPU
+        });
+
+        m_api.record_and_submit_once([this, &frame](Handle<CommandList> cmd){
+            m_api.fill_buffer(cmd, frame.occlusion_stats_buffer, 0U, sizeof(OcclusionCullStats));
+        });
+
+        frame.occlusion_stats_ptr = static_cast<const OcclusionCullStats*>(m_api.rm->map_buffer(frame.occlusion_stats_buffer));
+
         std::vector<std::string> timestamp_query_names{
             "Buffers Copy",
             "Total GPU Time"
@@ -299,27 +565,56 @@ void Renderer::resize_passes(const Window &window) {
     for(auto &[name, registered_pass] : m_registered_passes) {
         registered_pass.pass_ptr->resize(m_api, m_shared, window);
     }
+
+    // Passes that recreate their pipelines on resize (e.g. the depth pyramid) compile them asynchronously too
+    m_api.rm->wait_for_pipelines();
 }
 
 void Renderer::destroy_scene_buffers() {
     m_api.rm->destroy(m_shared.scene_material_buffer);
     m_api.rm->destroy(m_shared.scene_draw_buffer);
     m_api.rm->destroy(m_shared.scene_draw_count_buffer);
+    m_api.rm->destroy(m_shared.scene_late_draw_buffer);
+    m_api.rm->destroy(m_shared.scene_late_draw_count_buffer);
+    m_api.rm->destroy(m_shared.scene_draw_instance_buffer);
+    m_api.rm->destroy(m_shared.scene_draw_instance_dispatch_buffer);
+    m_api.rm->destroy(m_shared.scene_late_draw_instance_buffer);
+    m_api.rm->destroy(m_shared.scene_late_draw_instance_dispatch_buffer);
+    m_api.rm->destroy(m_shared.scene_visible_instance_buffer);
+    m_api.rm->destroy(m_shared.scene_draw_bucket_count_buffer);
+    m_api.rm->destroy(m_shared.scene_draw_bucket_offset_buffer);
+    m_api.rm->destroy(m_shared.scene_draw_bucket_block_buffer);
+    m_api.rm->destroy(m_shared.scene_visibility_buffer);
+    m_api.rm->destroy(m_shared.scene_occlusion_stats_buffer);
     m_api.rm->destroy(m_shared.scene_mesh_buffer);
     m_api.rm->destroy(m_shared.scene_mesh_instance_materials_buffer);
     m_api.rm->destroy(m_shared.scene_mesh_instance_buffer);
     m_api.rm->destroy(m_shared.scene_primitive_buffer);
     m_api.rm->destroy(m_shared.scene_object_buffer);
+    m_api.rm->destroy(m_shared.scene_renderable_object_buffer);
     m_api.rm->destroy(m_shared.scene_global_transform_buffer);
     m_api.rm->destroy(m_shared.scene_camera_buffer);
+    m_api.rm->destroy(m_shared.scene_view_buffer);
     m_api.rm->destroy(m_shared.scene_vertex_buffer);
     m_api.rm->destroy(m_shared.scene_index_buffer);
+    m_api.rm->destroy(m_shared.scene_index16_buffer);
+    m_api.rm->destroy(m_shared.scene_texture_feedback_buffer);
+    m_api.rm->destroy(m_shared.scene_meshlet_buffer);
+    m_api.rm->destroy(m_shared.scene_cluster_job_buffer);
+    m_api.rm->destroy(m_shared.scene_cluster_dispatch_buffer);
+    m_api.rm->destroy(m_shared.scene_light_buffer);
+    m_api.rm->destroy(m_shared.scene_light_cluster_count_buffer);
+    m_api.rm->destroy(m_shared.scene_light_cluster_index_buffer);
 }
 void Renderer::destroy_screen_images() {
     m_api.rm->destroy(m_shared.albedo_image);
     m_api.rm->destroy(m_shared.normal_image);
+    m_api.rm->destroy(m_shared.visibility_image);
+    m_api.rm->destroy(m_shared.ssao_output_image);
     m_api.rm->destroy(m_shared.offscreen_image);
     m_api.rm->destroy(m_shared.depth_image);
+    m_api.rm->destroy(m_shared.depth_pyramid_image);
+    m_api.rm->destroy(m_shared.depth_pyramid_sampler);
     m_api.rm->destroy(m_shared.offscreen_sampler);
 }
 void Renderer::destroy_descriptors() {
@@ -330,6 +625,7 @@ void Renderer::destroy_passes() {
         registered_pass.pass_ptr->destroy(m_api);
     }
 
+    m_sorted_passes.clear();
     m_registered_passes.clear();
 }
 void Renderer::destroy_frames() {
@@ -349,11 +645,32 @@ void Renderer::destroy_frames() {
         frame.gpu_pipeline_statistics.clear();
 
         m_api.rm->destroy(frame.command_list);
+        m_api.rm->destroy(frame.overlap_command_list);
+        m_api.rm->destroy(frame.join_command_list);
+        m_api.rm->destroy(frame.compute_command_list);
+        m_api.rm->destroy(frame.compute_wait_semaphore);
+        m_api.rm->destroy(frame.compute_signal_semaphore);
         m_api.rm->destroy(frame.present_semaphore);
         m_api.rm->destroy(frame.render_semaphore);
         m_api.rm->destroy(frame.fence);
         m_api.rm->unmap_buffer(frame.upload_buffer);
         m_api.rm->destroy(frame.upload_buffer);
+        m_api.rm->unmap_buffer(frame.texture_feedback_buffer);
+        m_api.rm->destroy(frame.texture_feedback_buffer);
+        m_api.rm->destroy(frame.transfer_command_list);
+        m_api.rm->destroy(frame.transfer_semaphore);
+        m_api.rm->unmap_buffer(frame.texture_staging_buffer);
+        m_api.rm->destroy(frame.texture_staging_buffer);
+
+        // The device is idle, the uploads that never got swapped in are dropped together with the replaced images
+        for(const auto &upload : frame.texture_uploads) {
+            m_api.rm->destroy(upload.image);
+        }
+        for(const auto &image : frame.retired_texture_images) {
+            m_api.rm->destroy(image);
+        }
+        m_api.rm->unmap_buffer(frame.occlusion_stats_buffer);
+        m_api.rm->destroy(frame.occlusion_stats_buffer);
     }
 
     m_frames.clear();
@@ -390,6 +707,60 @@ void Renderer::set_config_debug_shape_opacity(f32 value) {
 void Renderer::set_config_lod_sphere_visible_angle(f32 value) {
     m_shared.config_lod_sphere_visible_angle = std::max(std::min(value, 179.99f), 0.0002f);
 }
+void Renderer::set_config_lod_error_threshold(f32 value) {
+    m_shared.config_lod_error_threshold = std::max(value, 0.0f);
+}
+void Renderer::set_config_enable_cluster_cull(bool enable) {
+    m_shared.config_enable_cluster_cull = enable;
+    reload_pipelines();
+}
+void Renderer::set_config_cluster_cull_min_pixel_size(f32 value) {
+    m_shared.config_cluster_cull_min_pixel_size = std::max(value, 0.0f);
+}
+
+void Renderer::set_config_enable_vertex_quantization(bool enable) {
+    m_shared.config_enable_vertex_quantization = enable;
+}
+void Renderer::set_config_enable_occlusion_cull(bool enable) {
+    m_shared.config_enable_occlusion_cull = enable;
+    reload_pipelines();
+}
+void Renderer::set_config_enable_visibility_buffer(bool enable) {
+    // The triangle ids are written with gl_PrimitiveID, which requires the geometryShader feature
+    if (enable && !m_api.instance->is_geometry_shader_supported()) {
+        DEBUG_WARNING("The visibility buffer requires the geometryShader feature, which this device doesn't support, it stays disabled!")
+        enable = false;
+    }
+
+    m_shared.config_enable_visibility_buffer = enable;
+    reload_pipelines();
+}
+void Renderer::set_config_gbuffer_layout(GBufferLayout layout) {
+    VkFormat format = get_gbuffer_normal_format(layout);
+    VkFormatFeatureFlags required_features = VK_FORMAT_FEATURE_COLOR_ATTACHMENT_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT;
+
+    if ((m_api.instance->get_format_properties(format).optimalTilingFeatures & required_features) != required_features) {
+        DEBUG_WARNING("G-Buffer normal format " << format << " can't be rendered to on this device, the layout is unchanged!")
+        return;
+    }
+
+    m_shared.config_gbuffer_layout = layout;
+    reload_pipelines();
+}
+
+void Renderer::set_config_enable_dynamic_resolution(bool enable) {
+    m_shared.config_enable_dynamic_resolution = enable;
+}
+void Renderer::set_config_dynamic_resolution_target_ms(f32 value) {
+    m_shared.config_dynamic_resolution_target_ms = std::max(value, 1.0f);
+}
+void Renderer::set_config_dynamic_resolution_min_scale(f32 value) {
+    m_shared.config_dynamic_resolution_min_scale = std::clamp(value, 0.25f, 1.0f);
+}
+
+void Renderer::set_config_enable_async_compute(bool enable) {
+    m_shared.config_enable_async_compute = enable;
+}
 
 void Renderer::set_config_ssao_samples(u32 value) {
     m_shared.config_ssao_samples = std::max(std::min(value, 64u), 1u);
@@ -412,6 +783,29 @@ void Renderer::set_config_ssao_noise_scale_divider(i32 value) {
     m_shared.config_ssao_noise_scale_divider = value;
 }
 
+void Renderer::set_config_enable_half_res_ssao(bool enabled) {
+    m_shared.config_enable_half_res_ssao = enabled;
+    reload_pipelines();
+}
+
+void Renderer::set_config_ssao_half_res_samples(u32 value) {
+    m_shared.config_ssao_half_res_samples = std::max(std::min(value, 32u), 1u);
+    reload_pipelines();
+}
+
+void Renderer::set_config_enable_texture_streaming(bool enable) {
+    m_shared.config_enable_texture_streaming = enable;
+}
+
+void Renderer::set_config_texture_streaming_budget_mb(u32 value) {
+    m_shared.config_texture_streaming_budget_mb = std::max(value, 16u);
+}
+
+u32 Renderer::get_gbuffer_bytes_per_pixel() const {
+    // Albedo and normals
+    return 4U + (m_shared.config_gbuffer_layout == GBufferLayout::Full ? 16U : 4U);
+}
+
 void Renderer::set_ui_draw_callback(UIPassDrawFn draw_callback) {
     m_shared.ui_pass_draw_fn = draw_callback;
 }
@@ -1,4 +1,5 @@
 #include <algorithm>
+#include <cmath>
 
 #include "renderer.hpp"
 
@@ -9,6 +10,9 @@ void Renderer::resize(Window &window) {
 
     for(const auto& frame : m_frames) {
         m_api.reset_commands(frame.command_list);
+        m_api.reset_commands(frame.overlap_command_list);
+        m_api.reset_commands(frame.join_command_list);
+        m_api.reset_commands(frame.compute_command_list);
     }
 
     destroy_screen_images();
@@ -16,15 +20,21 @@ void Renderer::resize(Window &window) {
     m_api.recreate_swapchain(window.get_size(), m_api.get_swapchain_config());
 
     init_screen_images(window.get_size());
+    build_render_graph();
 
     resize_passes(window);
 
     m_api.wait_for_device_idle();
 }
-void Renderer::render(Window &window, World &world, Handle<Camera> camera) {
+void Renderer::render(Window &window, World &world, Handle<Camera> camera, const std::vector<Handle<Camera>> &secondary_views) {
     if (!world.get_valid_camera_handles().contains(camera)) {
         DEBUG_PANIC("Cannot render the world from the given camera! - Camera with handle id: " << camera << " is invalid.")
     }
+    for (const auto &view : secondary_views) {
+        if (!world.get_valid_camera_handles().contains(view)) {
+            DEBUG_PANIC("Cannot cull the world for the given view! - Camera with handle id: " << view << " is invalid.")
+        }
+    }
 
     if (m_reload_pipelines_queued) {
         DEBUG_LOG("Reloading pipelines...")
@@ -36,6 +46,11 @@ void Renderer::render(Window &window, World &world, Handle<Camera> camera) {
         m_api.wait_for_device_idle();
 
         destroy_passes();
+
+        // The screen image formats depend on the config too
+        destroy_screen_images();
+        init_screen_images(window.get_size());
+
         init_passes(window);
 
         DEBUG_LOG("Reloaded pipelines!")
@@ -44,7 +59,7 @@ void Renderer::render(Window &window, World &world, Handle<Camera> camera) {
     }
 
     begin_recording_frame();
-    update_world(world, camera);
+    update_world(world, camera, secondary_views);
     render_world(world, camera);
     end_recording_frame();
 }
@@ -85,6 +100,15 @@ void Renderer::begin_recording_frame() {
         results = pipeline_statistics_results.at(query);
     }
 
+    frame.occlusion_cull_stats = *frame.occlusion_stats_ptr;
+
+    // Uses the GPU time of this slot read above, the frame recorded next is rendered at the new scale
+    update_dynamic_resolution();
+    frame.render_scale = m_shared.render_scale;
+
+    // The texture feedback of this frame slot is also complete after the fence wait
+    update_texture_streaming();
+
     VkResult result = m_api.get_next_swapchain_index(frame.present_semaphore, &m_shared.swapchain_target_index);
     if(result == VK_ERROR_OUT_OF_DATE_KHR) {
         DEBUG_ERROR("VK_ERROR_OUT_OF_DATE_KHR") // This message shouldn't be ever visible because a resize always occurs before rendering
@@ -94,23 +118,103 @@ void Renderer::begin_recording_frame() {
 
     m_api.reset_fence(frame.fence);
     m_api.reset_commands(frame.command_list);
+    m_api.reset_commands(frame.overlap_command_list);
+    m_api.reset_commands(frame.join_command_list);
+    m_api.reset_commands(frame.compute_command_list);
     m_api.begin_recording_commands(frame.command_list);
+    frame.active_command_list = frame.command_list;
 
     m_api.reset_queries_cmd(frame.command_list, queries_to_be_read_and_reset);
 
+    // Ownership of the streamed textures swapped in by update_texture_streaming(), released by the transfer queue
+    if(!frame.texture_acquire_barriers.empty()) {
+        m_api.image_barrier(frame.command_list, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, frame.texture_acquire_barriers);
+        frame.texture_acquire_barriers.clear();
+    }
+
     m_api.write_timestamp(frame.command_list, frame.gpu_timing["Total GPU Time"].first.first);
 
     DEBUG_TIMESTAMP(stop);
     frame.cpu_timing[__FUNCTION__] = DEBUG_TIME_DIFF(start, stop);
 }
-void Renderer::update_world(World &world, Handle<Camera> camera) {
+void Renderer::join_async_compute(const std::vector<Handle<Buffer>> &outputs) {
+    Frame &frame = m_frames[m_frame_in_flight_index];
+
+    // Queue family ownership transfer, released on the compute queue and acquired by the graphics passes after the join
+    // The other way around the outputs are fully rewritten, so their old contents don't have to be transferred to the compute queue
+    std::vector<BufferBarrier> release_barriers{};
+    std::vector<BufferBarrier> acquire_barriers{};
+    for (const auto &buffer : outputs) {
+        release_barriers.push_back(BufferBarrier{
+            .buffer_handle = buffer,
+            .src_access_mask = VK_ACCESS_SHADER_WRITE_BIT,
+            .src_queue_family = QueueFamily::Compute,
+            .dst_queue_family = QueueFamily::Graphics
+        });
+        acquire_barriers.push_back(BufferBarrier{
+            .buffer_handle = buffer,
+            .dst_access_mask = VK_ACCESS_SHADER_READ_BIT,
+            .src_queue_family = QueueFamily::Compute,
+            .dst_queue_family = QueueFamily::Graphics
+        });
+    }
+
+    m_api.buffer_barrier(frame.compute_command_list, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, release_barriers);
+
+    m_api.begin_recording_commands(frame.join_command_list);
+    m_api.buffer_barrier(frame.join_command_list, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, acquire_barriers);
+
+    frame.active_command_list = frame.join_command_list;
+}
+
+void Renderer::update_dynamic_resolution() {
+    const Frame &frame = m_frames[m_frame_in_flight_index];
+
+    if (!m_shared.config_enable_dynamic_resolution) {
+        if (m_shared.render_scale != 1.0f) {
+            set_render_scale(1.0f);
+        }
+
+        return;
+    }
+
+    const auto &[start, end] = frame.gpu_timing.at("Total GPU Time").second;
+    f32 gpu_time = static_cast<f32>(end - start);
+
+    // Nothing was measured in this slot yet after init or a pipeline reload
+    if (gpu_time <= 0.0f) {
+        return;
+    }
+
+    // The GPU time is roughly proportional to the rendered pixel count, which grows with the square of the scale
+    f32 target_scale = frame.render_scale * std::sqrt(m_shared.config_dynamic_resolution_target_ms / gpu_time);
+    target_scale = std::clamp(target_scale, m_shared.config_dynamic_resolution_min_scale, 1.0f);
+
+    // The timing is a few frames old and noisy, so the scale only moves part of the way and ignores tiny differences
+    if (std::abs(target_scale - m_shared.render_scale) > 0.02f) {
+        set_render_scale(m_shared.render_scale + (target_scale - m_shared.render_scale) * 0.1f);
+    }
+}
+void Renderer::set_render_scale(f32 scale) {
+    const VkExtent3D &screen_size = m_api.rm->get_data(m_shared.offscreen_image).extent;
+
+    m_shared.render_scale = std::clamp(scale, 0.0f, 1.0f);
+    m_shared.render_extent = VkExtent2D{
+        std::max(static_cast<u32>(static_cast<f32>(screen_size.width) * m_shared.render_scale), 1U),
+        std::max(static_cast<u32>(static_cast<f32>(screen_size.height) * m_shared.render_scale), 1U)
+    };
+}
+
+void Renderer::update_world(World &world, Handle<Camera> camera, const std::vector<Handle<Camera>> &secondary_views) {
     DEBUG_TIMESTAMP(start);
 
     Frame &frame = m_frames[m_frame_in_flight_index];
 
     std::vector<VkBufferCopy> object_copy_regions{};
     std::vector<VkBufferCopy> global_transforms_copy_regions{};
+    std::vector<VkBufferCopy> renderable_object_copy_regions{};
     std::vector<VkBufferCopy> camera_copy_regions{};
+    std::vector<VkBufferCopy> view_copy_regions{};
 
     object_copy_regions.reserve(world.get_changed_object_handles().size());
     global_transforms_copy_regions.reserve(world.get_changed_object_handles().size());
@@ -121,17 +225,45 @@ void Renderer::update_world(World &world, Handle<Camera> camera) {
     usize upload_offset{};
     // Make sure that camera is always uploaded, no matter what
     if(camera != INVALID_HANDLE) {
-        *frame.access_upload<Camera>(upload_offset) = world.get_camera(camera);
+        Camera &main_camera = *frame.access_upload<Camera>(upload_offset);
+        main_camera = world.get_camera(camera);
+
+        // The shaders and the culling see only the rendered area of the screen images, the projection doesn't change with the scale
+        main_camera.viewport_size = glm::vec2(m_shared.render_extent.width, m_shared.render_extent.height);
 
         camera_copy_regions.push_back(VkBufferCopy{
             .srcOffset = upload_offset,
-            .dstOffset = static_cast<VkDeviceSize>(camera.as_u32()) * sizeof(Camera),
+            .size = sizeof(Camera)
+        });
+        view_copy_regions.push_back(VkBufferCopy{
+            .srcOffset = upload_offset,
             .size = sizeof(Camera)
         });
 
         upload_offset += Utils::align(16u, sizeof(Camera));
     }
 
+    if (secondary_views.size() >= GPU_MAX_VIEW_COUNT) {
+        DEBUG_WARNING("Too many secondary views: " << secondary_views.size() << ", only the first " << GPU_MAX_VIEW_COUNT - 1 << " are culled!")
+    }
+
+    u32 view_count = std::min(static_cast<u32>(secondary_views.size()) + 1u, static_cast<u32>(GPU_MAX_VIEW_COUNT));
+    for (u32 view_id = 1u; view_id < view_count; ++view_id) {
+        *frame.access_upload<Camera>(upload_offset) = world.get_camera(secondary_views[view_id - 1u]);
+
+        view_copy_regions.push_back(VkBufferCopy{
+            .srcOffset = upload_offset,
+            .dstOffset = static_cast<VkDeviceSize>(view_id) * sizeof(Camera),
+            .size = sizeof(Camera)
+        });
+
+        upload_offset += Utils::align(16u, sizeof(Camera));
+    }
+
+    // Every view gets an equal share of the draw buffer
+    m_shared.scene_view_count = view_count;
+    m_shared.scene_draw_capacity = static_cast<u32>(MAX_SCENE_DRAWS / (GPU_INDEX_TYPE_COUNT * view_count));
+
     std::vector<Handle<Object>> handles_to_clear{};
     for(const auto &handle : world.get_changed_object_handles()) {
         if(handle.as_u32() >= static_cast<u32>(MAX_SCENE_OBJECTS)) {
@@ -173,21 +305,94 @@ void Renderer::update_world(World &world, Handle<Camera> camera) {
 
         upload_offset += Utils::align(16u, sizeof(transform));
         handles_to_clear.push_back(handle);
+
+        if (object.visible) {
+            m_renderable_objects.insert(handle.as_u32());
+        } else {
+            m_renderable_objects.erase(handle.as_u32());
+        }
     }
 
+    // Creating or destroying an object changes at most two slots of the renderable list
+    std::vector<u32> slots_to_clear{};
+    for (const auto &slot : m_renderable_objects.get_changed_slots()) {
+        if (slot < m_renderable_objects.size()) {
+            if (upload_offset + sizeof(u32) >= upload_buffer_size) {
+                DEBUG_WARNING("Upload buffer falling behind!")
+                break;
+            }
+
+            *frame.access_upload<u32>(upload_offset) = m_renderable_objects.get_ids()[slot];
+
+            renderable_object_copy_regions.push_back(VkBufferCopy{
+                .srcOffset = upload_offset,
+                .dstOffset = static_cast<VkDeviceSize>(slot) * sizeof(u32),
+                .size = sizeof(u32)
+            });
+
+            upload_offset += sizeof(u32);
+        }
+
+        slots_to_clear.push_back(slot);
+    }
+
+    m_renderable_objects.clear_changed_slots(slots_to_clear);
+
+    // Slots left for the next frames would expose stale ids if the count grew, so the old count (clamped to the new one) is kept until they're uploaded
+    bool renderable_slots_pending = std::any_of(m_renderable_objects.get_changed_slots().begin(), m_renderable_objects.get_changed_slots().end(), [this](u32 slot) {
+        return slot < m_renderable_objects.size();
+    });
+    if (renderable_slots_pending) {
+        m_shared.scene_renderable_object_count = std::min(m_shared.scene_renderable_object_count, m_renderable_objects.size());
+    } else {
+        m_shared.scene_renderable_object_count = m_renderable_objects.size();
+    }
+
+    std::vector<VkBufferCopy> light_copy_regions{};
+    std::vector<Handle<Light>> light_handles_to_clear{};
+    for(const auto &handle : world.get_changed_light_handles()) {
+        if(handle.as_u32() >= static_cast<u32>(MAX_SCENE_LIGHTS)) {
+            DEBUG_PANIC("Failed to upload light with handle id: " << handle << "! MAX_SCENE_LIGHTS: " << MAX_SCENE_LIGHTS)
+        }
+
+        if(upload_offset + sizeof(Light) >= upload_buffer_size) {
+            DEBUG_WARNING("Upload buffer falling behind!")
+            break;
+        }
+
+        *frame.access_upload<Light>(upload_offset) = world.get_light(handle);
+
+        light_copy_regions.push_back(VkBufferCopy{
+            .srcOffset = upload_offset,
+            .dstOffset = static_cast<VkDeviceSize>(handle.as_u32()) * sizeof(Light),
+            .size = sizeof(Light)
+        });
+
+        upload_offset += Utils::align(16u, sizeof(Light));
+        light_handles_to_clear.push_back(handle);
+    }
+
+    m_shared.scene_light_count = static_cast<u32>(world.get_lights().size());
+
     m_api.rm->flush_mapped_buffer(frame.upload_buffer, upload_offset);
 
     world._clear_updates(handles_to_clear);
+    world._clear_light_updates(light_handles_to_clear);
 
     m_api.write_timestamp(frame.command_list, frame.gpu_timing.at("Buffers Copy").first.first);
 
     // Ensure that other m_frames don't use these global buffers
-    m_api.buffer_barrier(frame.command_list, VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, {
+    m_api.buffer_barrier(frame.command_list, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, {
         BufferBarrier{
             .buffer_handle = m_shared.scene_object_buffer,
             .src_access_mask = VK_ACCESS_SHADER_READ_BIT,
             .dst_access_mask = VK_ACCESS_TRANSFER_WRITE_BIT
         },
+        BufferBarrier{
+            .buffer_handle = m_shared.scene_renderable_object_buffer,
+            .src_access_mask = VK_ACCESS_SHADER_READ_BIT,
+            .dst_access_mask = VK_ACCESS_TRANSFER_WRITE_BIT
+        },
         BufferBarrier{
             .buffer_handle = m_shared.scene_global_transform_buffer,
             .src_access_mask = VK_ACCESS_SHADER_READ_BIT,
@@ -198,11 +403,24 @@ void Renderer::update_world(World &world, Handle<Camera> camera) {
             .src_access_mask = VK_ACCESS_UNIFORM_READ_BIT,
             .dst_access_mask = VK_ACCESS_TRANSFER_WRITE_BIT
         },
+        BufferBarrier{
+            .buffer_handle = m_shared.scene_view_buffer,
+            .src_access_mask = VK_ACCESS_UNIFORM_READ_BIT,
+            .dst_access_mask = VK_ACCESS_TRANSFER_WRITE_BIT
+        },
+        BufferBarrier{
+            .buffer_handle = m_shared.scene_light_buffer,
+            .src_access_mask = VK_ACCESS_SHADER_READ_BIT,
+            .dst_access_mask = VK_ACCESS_TRANSFER_WRITE_BIT
+        },
     });
 
     m_api.copy_buffer_to_buffer(frame.command_list, frame.upload_buffer, m_shared.scene_object_buffer, object_copy_regions);
     m_api.copy_buffer_to_buffer(frame.command_list, frame.upload_buffer, m_shared.scene_global_transform_buffer, global_transforms_copy_regions);
+    m_api.copy_buffer_to_buffer(frame.command_list, frame.upload_buffer, m_shared.scene_renderable_object_buffer, renderable_object_copy_regions);
     m_api.copy_buffer_to_buffer(frame.command_list, frame.upload_buffer, m_shared.scene_camera_buffer, camera_copy_regions);
+    m_api.copy_buffer_to_buffer(frame.command_list, frame.upload_buffer, m_shared.scene_view_buffer, view_copy_regions);
+    m_api.copy_buffer_to_buffer(frame.command_list, frame.upload_buffer, m_shared.scene_light_buffer, light_copy_regions);
 
     m_api.buffer_barrier(frame.command_list, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, {
         BufferBarrier{
@@ -215,11 +433,26 @@ void Renderer::update_world(World &world, Handle<Camera> camera) {
             .src_access_mask = VK_ACCESS_TRANSFER_WRITE_BIT,
             .dst_access_mask = VK_ACCESS_SHADER_READ_BIT
         },
+        BufferBarrier{
+            .buffer_handle = m_shared.scene_renderable_object_buffer,
+            .src_access_mask = VK_ACCESS_TRANSFER_WRITE_BIT,
+            .dst_access_mask = VK_ACCESS_SHADER_READ_BIT
+        },
         BufferBarrier{
             .buffer_handle = m_shared.scene_camera_buffer,
             .src_access_mask = VK_ACCESS_TRANSFER_WRITE_BIT,
             .dst_access_mask = VK_ACCESS_UNIFORM_READ_BIT
         },
+        BufferBarrier{
+            .buffer_handle = m_shared.scene_view_buffer,
+            .src_access_mask = VK_ACCESS_TRANSFER_WRITE_BIT,
+            .dst_access_mask = VK_ACCESS_UNIFORM_READ_BIT
+        },
+        BufferBarrier{
+            .buffer_handle = m_shared.scene_light_buffer,
+            .src_access_mask = VK_ACCESS_TRANSFER_WRITE_BIT,
+            .dst_access_mask = VK_ACCESS_SHADER_READ_BIT
+        },
     });
 
     m_api.write_timestamp(frame.command_list, frame.gpu_timing.at("Buffers Copy").first.second);
@@ -233,39 +466,164 @@ void Renderer::render_world(World &world, Handle<Camera> camera) {
     Frame &frame = m_frames[m_frame_in_flight_index];
 
     m_registered_passes["Debug Pass"].enabled = m_shared.config_enable_debug_shape_view;
-
-    std::vector<std::pair<std::string, RegisteredPassRef>> passes_sorted{};
-    for(const auto &[name, registered_pass] : m_registered_passes) {
-        passes_sorted.emplace_back(name, registered_pass.as_ref());
+    m_registered_passes["Depth Pyramid Pass"].enabled = m_shared.config_enable_occlusion_cull;
+    m_registered_passes["Late Draw Call Generation Pass"].enabled = m_shared.config_enable_occlusion_cull;
+    m_registered_passes["Late Geometry Pass"].enabled = m_shared.config_enable_occlusion_cull;
+    m_registered_passes["Material Pass"].enabled = m_shared.config_enable_visibility_buffer;
+
+    bool use_async_compute = m_shared.config_enable_async_compute && m_api.instance->is_async_compute_supported();
+
+    // Compiled again only when a pass was toggled
+    std::vector<RenderGraphPassState> pass_states{};
+    for(const auto &[name, registered_pass] : m_sorted_passes) {
+        pass_states.push_back(RenderGraphPassState{
+            .enabled = registered_pass->enabled,
+            .async_compute = use_async_compute && registered_pass->queue == PassQueue::AsyncCompute
+        });
     }
-    std::sort(passes_sorted.begin(), passes_sorted.end(), [](const auto &left, const auto &right) {
-        const auto &[l_name, l_registered_pass] = left;
-        const auto &[r_name, r_registered_pass] = right;
-        return l_registered_pass.order < r_registered_pass.order;
-    });
+    m_render_graph.compile(pass_states);
+    m_render_graph.record_prologue(frame.active_command_list, m_api);
+
+    // All async compute passes form one batch, the first graphics pass at or after the lowest sync_order waits for it
+    u32 join_order = UINT32_MAX;
+    if (use_async_compute) {
+        for(usize i{}; i < m_sorted_passes.size(); ++i) {
+            const auto &[name, registered_pass] = m_sorted_passes[i];
+            if (!m_render_graph.is_culled(i) && registered_pass->queue == PassQueue::AsyncCompute) {
+                join_order = std::min(join_order, registered_pass->sync_order);
+            }
+        }
+    }
+
+    frame.async_compute_passes.clear();
+
+    bool compute_started{};
+    bool compute_joined{};
+    std::vector<Handle<Buffer>> async_compute_outputs{};
+
+    for(usize i{}; i < m_sorted_passes.size(); ++i) {
+        const auto &[name, registered_pass] = m_sorted_passes[i];
+
+        // Disabled passes and the ones whose outputs nothing reads
+        bool culled = m_render_graph.is_culled(i);
+        bool on_compute_queue = use_async_compute && !culled && registered_pass->queue == PassQueue::AsyncCompute;
+
+        if (on_compute_queue && !compute_started) {
+            if (compute_joined) {
+                DEBUG_PANIC("Async compute pass \"" << name << "\" is ordered after the graphics passes that wait for the compute queue!")
+            }
 
-    for(const auto &[name, registered_pass] : passes_sorted) {
-        m_api.write_timestamp(frame.command_list, frame.gpu_timing.at(name).first.first);
+            // The work recorded so far is submitted first and signals the compute queue, later graphics passes go into the overlapping list
+            m_api.begin_recording_commands(frame.compute_command_list);
+            m_api.begin_recording_commands(frame.overlap_command_list);
+            frame.active_command_list = frame.overlap_command_list;
 
-        if(registered_pass.query_statistics) {
+            compute_started = true;
+        }
+        if (!on_compute_queue && compute_started && !compute_joined && registered_pass->order >= join_order) {
+            join_async_compute(async_compute_outputs);
+            compute_joined = true;
+        }
+
+        Handle<CommandList> cmd = on_compute_queue ? frame.compute_command_list : frame.active_command_list;
+
+        m_api.write_timestamp(cmd, frame.gpu_timing.at(name).first.first);
+
+        // Pipeline statistics can't be queried on the compute queue
+        bool query_statistics = registered_pass->query_statistics && !on_compute_queue;
+
+        if(query_statistics) {
             if(!frame.gpu_pipeline_statistics.contains(name)) {
                 DEBUG_PANIC("Failed to begin query \"" << name << "\"! You cannot enable \"query_statistics\" of a registered pass at runtime.")
             }
 
-            m_api.begin_query(frame.command_list, frame.gpu_pipeline_statistics.at(name).first);
+            m_api.begin_query(cmd, frame.gpu_pipeline_statistics.at(name).first);
+        }
+
+        if (!culled) {
+            m_render_graph.record_barriers(cmd, m_api, i);
+            registered_pass->pass_ptr->process(cmd, m_api, m_shared, world);
+        }
+
+        if(query_statistics) {
+            m_api.end_query(cmd, frame.gpu_pipeline_statistics.at(name).first);
         }
 
-        if (registered_pass.enabled) {
-            registered_pass.pass_ptr->process(frame.command_list, m_api, m_shared, world);
+        m_api.write_timestamp(cmd, frame.gpu_timing.at(name).first.second);
+
+        if (on_compute_queue) {
+            frame.async_compute_passes.insert(name);
+
+            auto outputs = m_render_graph.get_written_buffers(i);
+            async_compute_outputs.insert(async_compute_outputs.end(), outputs.begin(), outputs.end());
         }
+    }
 
-        if(registered_pass.query_statistics) {
-            m_api.end_query(frame.command_list, frame.gpu_pipeline_statistics.at(name).first);
+    // No graphics pass waited for the compute queue, the rest of the frame does
+    if (compute_started && !compute_joined) {
+        join_async_compute(async_compute_outputs);
+    }
+
+    // Read back the mips requested by the Geometry Pass and clear them for the next frame
+    m_api.buffer_barrier(frame.active_command_list, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, {
+        BufferBarrier{
+            .buffer_handle = m_shared.scene_texture_feedback_buffer,
+            .src_access_mask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+            .dst_access_mask = VK_ACCESS_TRANSFER_READ_BIT
         }
+    });
 
-        m_api.write_timestamp(frame.command_list, frame.gpu_timing.at(name).first.second);
+    m_api.copy_buffer_to_buffer(frame.active_command_list, m_shared.scene_texture_feedback_buffer, frame.texture_feedback_buffer, {
+        VkBufferCopy{
+            .size = sizeof(u32) * MAX_SCENE_TEXTURES
+        }
+    });
+
+    m_api.buffer_barrier(frame.active_command_list, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, {
+        BufferBarrier{
+            .buffer_handle = m_shared.scene_texture_feedback_buffer,
+            .src_access_mask = VK_ACCESS_TRANSFER_READ_BIT,
+            .dst_access_mask = VK_ACCESS_TRANSFER_WRITE_BIT
+        }
+    });
+
+    m_api.fill_buffer(frame.active_command_list, m_shared.scene_texture_feedback_buffer, 0U, sizeof(u32) * MAX_SCENE_TEXTURES);
+
+    // Counted by the Late Draw Call Generation Pass
+    if (m_shared.config_enable_occlusion_cull) {
+        m_api.buffer_barrier(frame.active_command_list, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, {
+            BufferBarrier{
+                .buffer_handle = m_shared.scene_occlusion_stats_buffer,
+                .src_access_mask = VK_ACCESS_SHADER_WRITE_BIT,
+                .dst_access_mask = VK_ACCESS_TRANSFER_READ_BIT
+            }
+        });
+
+        m_api.copy_buffer_to_buffer(frame.active_command_list, m_shared.scene_occlusion_stats_buffer, frame.occlusion_stats_buffer, {
+            VkBufferCopy{
+                .size = sizeof(OcclusionCullStats)
+            }
+        });
     }
 
+    m_api.buffer_barrier(frame.active_command_list, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_HOST_BIT, {
+        BufferBarrier{
+            .buffer_handle = m_shared.scene_texture_feedback_buffer,
+            .src_access_mask = VK_ACCESS_TRANSFER_WRITE_BIT,
+            .dst_access_mask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT
+        },
+        BufferBarrier{
+            .buffer_handle = frame.texture_feedback_buffer,
+            .src_access_mask = VK_ACCESS_TRANSFER_WRITE_BIT,
+            .dst_access_mask = VK_ACCESS_HOST_READ_BIT
+        },
+        BufferBarrier{
+            .buffer_handle = frame.occlusion_stats_buffer,
+            .src_access_mask = VK_ACCESS_TRANSFER_WRITE_BIT,
+            .dst_access_mask = VK_ACCESS_HOST_READ_BIT
+        }
+    });
+
     DEBUG_TIMESTAMP(stop);
     frame.cpu_timing[__FUNCTION__] = DEBUG_TIME_DIFF(start, stop);
 }
@@ -281,10 +639,38 @@ void Renderer::end_recording_frame() {
         .signal_stages{ VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT }
     };
 
-    m_api.write_timestamp(frame.command_list, frame.gpu_timing["Total GPU Time"].first.second);
+    m_api.write_timestamp(frame.active_command_list, frame.gpu_timing["Total GPU Time"].first.second);
+
+    if (frame.active_command_list == frame.join_command_list) {
+        // Binary semaphores have to be signaled by an earlier submission than the one waiting for them
+        m_api.end_recording_commands(frame.command_list);
+        m_api.submit_commands(frame.command_list, SubmitInfo{
+            .signal_semaphores{ frame.compute_wait_semaphore }
+        });
+
+        m_api.end_recording_commands(frame.overlap_command_list);
+        m_api.submit_commands(frame.overlap_command_list, SubmitInfo{});
+
+        m_api.end_recording_commands(frame.compute_command_list);
+        m_api.submit_commands(frame.compute_command_list, SubmitInfo{
+            .wait_semaphores{ frame.compute_wait_semaphore },
+            .signal_semaphores{ frame.compute_signal_semaphore },
+            .signal_stages{ VK_PIPELINE_STAGE_ALL_COMMANDS_BIT }
+        });
+
+        // Everything after the join waits, including the next frame's uploads that overwrite buffers the compute passes read
+        submit.wait_semaphores.push_back(frame.compute_signal_semaphore);
+        submit.signal_stages.push_back(VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
+    }
+
+    // Keeps the fence of this slot behind the texture uploads, their images are swapped in when the slot comes around again
+    if (frame.transfer_submitted) {
+        submit.wait_semaphores.push_back(frame.transfer_semaphore);
+        submit.signal_stages.push_back(VK_PIPELINE_STAGE_TRANSFER_BIT);
+    }
 
-    m_api.end_recording_commands(frame.command_list);
-    m_api.submit_commands(frame.command_list, submit);
+    m_api.end_recording_commands(frame.active_command_list);
+    m_api.submit_commands(frame.active_command_list, submit);
 
     VkResult result = m_api.present_swapchain(frame.render_semaphore, m_shared.swapchain_target_index);
     if (result != VK_SUCCESS) {
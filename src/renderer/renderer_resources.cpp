@@ -1,5 +1,12 @@
 #include "renderer.hpp"
 
+#include <bit>
+#include <future>
+#include <mutex>
+#include <condition_variable>
+#include <algorithm>
+
+#include <common/bc_encoder.hpp>
 #include <stb/stb_image.h>
 
 #define TINYGLTF_NOEXCEPTION
@@ -11,15 +18,13 @@
 #include <tiny_gltf.h>
 #include <meshoptimizer.h>
 
-static glm::vec3 calculate_center_offset(const Vertex *vertices, u32 vertex_count) {
-    glm::vec3 center_offset{};
+static void calculate_aabb(const Vertex *vertices, u32 vertex_count, glm::vec3 &min, glm::vec3 &max) {
+    min = glm::vec3(std::numeric_limits<f32>::max());
+    max = glm::vec3(std::numeric_limits<f32>::lowest());
     for(u32 i{}; i < vertex_count; ++i) {
-        center_offset += vertices[i].pos;
+        min = glm::min(min, vertices[i].pos);
+        max = glm::max(max, vertices[i].pos);
     }
-
-    center_offset /= static_cast<f32>(vertex_count);
-
-    return center_offset;
 }
 static f32 calculate_radius(const Vertex *vertices, u32 vertex_count, const glm::vec3 &center_offset) {
     f32 max_dist{};
@@ -33,6 +38,331 @@ static f32 calculate_radius(const Vertex *vertices, u32 vertex_count, const glm:
 
     return max_dist;
 }
+// xyz - center, w - radius
+// Ritter's sphere: starts from the most distant pair of the axis extreme points and grows to enclose every vertex,
+// the sphere around the AABB center is used instead if it happens to be smaller
+static glm::vec4 calculate_bounding_sphere(const Vertex *vertices, u32 vertex_count) {
+    if(vertex_count == 0u) {
+        return glm::vec4(0.0f);
+    }
+
+    std::array<u32, 3> min_ids{};
+    std::array<u32, 3> max_ids{};
+    for(u32 i{}; i < vertex_count; ++i) {
+        for(u32 axis{}; axis < 3u; ++axis) {
+            if(vertices[i].pos[axis] < vertices[min_ids[axis]].pos[axis]) {
+                min_ids[axis] = i;
+            }
+            if(vertices[i].pos[axis] > vertices[max_ids[axis]].pos[axis]) {
+                max_ids[axis] = i;
+            }
+        }
+    }
+
+    u32 widest_axis{};
+    f32 widest_dist{};
+    for(u32 axis{}; axis < 3u; ++axis) {
+        f32 dist = glm::distance(vertices[min_ids[axis]].pos, vertices[max_ids[axis]].pos);
+        if(dist > widest_dist) {
+            widest_axis = axis;
+            widest_dist = dist;
+        }
+    }
+
+    glm::vec3 center = (vertices[min_ids[widest_axis]].pos + vertices[max_ids[widest_axis]].pos) * 0.5f;
+    f32 radius = widest_dist * 0.5f;
+
+    for(u32 i{}; i < vertex_count; ++i) {
+        f32 dist = glm::distance(center, vertices[i].pos);
+        if(dist > radius) {
+            f32 new_radius = (radius + dist) * 0.5f;
+            center += (vertices[i].pos - center) * ((new_radius - radius) / dist);
+            radius = new_radius;
+        }
+    }
+
+    glm::vec3 aabb_min{}, aabb_max{};
+    calculate_aabb(vertices, vertex_count, aabb_min, aabb_max);
+
+    glm::vec3 aabb_center = (aabb_min + aabb_max) * 0.5f;
+    f32 aabb_center_radius = calculate_radius(vertices, vertex_count, aabb_center);
+
+    if(aabb_center_radius < radius) {
+        return glm::vec4(aabb_center, aabb_center_radius);
+    }
+
+    return glm::vec4(center, radius);
+}
+// Sphere enclosing all 'spheres', grown from the largest one in the same way as calculate_bounding_sphere()
+static glm::vec4 merge_bounding_spheres(const std::vector<glm::vec4> &spheres) {
+    if(spheres.empty()) {
+        return glm::vec4(0.0f);
+    }
+
+    glm::vec4 merged = *std::max_element(spheres.begin(), spheres.end(), [](const glm::vec4 &a, const glm::vec4 &b) { return a.w < b.w; });
+
+    for(const auto &sphere : spheres) {
+        glm::vec3 center = glm::vec3(merged);
+        f32 dist = glm::distance(center, glm::vec3(sphere));
+
+        if(dist + sphere.w > merged.w) {
+            f32 new_radius = (merged.w + dist + sphere.w) * 0.5f;
+            if(dist > 0.0f) {
+                center += (glm::vec3(sphere) - center) * ((new_radius - merged.w) / dist);
+            }
+
+            merged = glm::vec4(center, new_radius);
+        }
+    }
+
+    return merged;
+}
+// Writes the dequantization parameters of the positions to 'primitive'
+static std::vector<CompactVertex> quantize_vertices(const Vertex *vertices, u32 vertex_count, Primitive &primitive) {
+    glm::vec3 min{}, max{};
+    calculate_aabb(vertices, vertex_count, min, max);
+
+    glm::vec3 extent = glm::max(max - min, glm::vec3(0.0f));
+
+    primitive.vertex_format = GPU_VERTEX_FORMAT_COMPACT;
+    primitive.quantization_offset = min;
+    primitive.quantization_scale = extent / 65535.0f;
+
+    std::vector<CompactVertex> compact_vertices(vertex_count);
+    for(u32 i{}; i < vertex_count; ++i) {
+        const Vertex &vertex = vertices[i];
+        CompactVertex &compact = compact_vertices[i];
+
+        for(u32 c{}; c < 3u; ++c) {
+            f32 normalized = (extent[c] > 0.0f) ? (vertex.pos[c] - min[c]) / extent[c] : 0.0f;
+            compact.pos[c] = static_cast<u16>(meshopt_quantizeUnorm(normalized, 16));
+        }
+
+        // Octahedral projection onto the z >= 0 half, the other half is folded over the diagonals
+        glm::vec3 n = glm::vec3(vertex.normal) / 127.0f;
+        n /= std::max(std::abs(n.x) + std::abs(n.y) + std::abs(n.z), 1e-6f);
+
+        glm::vec2 oct = glm::vec2(n.x, n.y);
+        if(n.z < 0.0f) {
+            oct = (1.0f - glm::abs(glm::vec2(n.y, n.x))) * glm::vec2(n.x >= 0.0f ? 1.0f : -1.0f, n.y >= 0.0f ? 1.0f : -1.0f);
+        }
+
+        u8 oct_x = static_cast<u8>(meshopt_quantizeSnorm(oct.x, 8));
+        u8 oct_y = static_cast<u8>(meshopt_quantizeSnorm(oct.y, 8));
+        compact.normal = static_cast<u16>(oct_x | (oct_y << 8));
+
+        compact.texcoord = vertex.texcoord;
+    }
+
+    return compact_vertices;
+}
+
+static VkFormat get_compressed_format(TextureCompression compression, bool is_srgb) {
+    switch (compression) {
+        case TextureCompression::BC1: return is_srgb ? VK_FORMAT_BC1_RGB_SRGB_BLOCK : VK_FORMAT_BC1_RGB_UNORM_BLOCK;
+        case TextureCompression::BC3: return is_srgb ? VK_FORMAT_BC3_SRGB_BLOCK : VK_FORMAT_BC3_UNORM_BLOCK;
+        case TextureCompression::BC4: return VK_FORMAT_BC4_UNORM_BLOCK;
+        case TextureCompression::BC5: return VK_FORMAT_BC5_UNORM_BLOCK;
+        case TextureCompression::BC7: return is_srgb ? VK_FORMAT_BC7_SRGB_BLOCK : VK_FORMAT_BC7_UNORM_BLOCK;
+        default: return VK_FORMAT_UNDEFINED;
+    }
+}
+static BCFormat get_bc_format(TextureCompression compression) {
+    switch (compression) {
+        case TextureCompression::BC1: return BCFormat::BC1;
+        case TextureCompression::BC3: return BCFormat::BC3;
+        case TextureCompression::BC4: return BCFormat::BC4;
+        case TextureCompression::BC5: return BCFormat::BC5;
+        default: return BCFormat::BC7;
+    }
+}
+
+// Single channel maps (roughness, metalness, occlusion) only need BC4 and two channel ones (normals) BC5, whichever format was requested
+// sRGB textures keep the requested format, BC4 and BC5 have no sRGB variants
+static TextureCompression select_texture_compression(TextureCompression requested, u32 channels, bool is_srgb) {
+    if (requested == TextureCompression::None || is_srgb) {
+        return requested;
+    }
+
+    if (channels == 1U) {
+        return TextureCompression::BC4;
+    } else if (channels == 2U) {
+        return TextureCompression::BC5;
+    }
+
+    return requested;
+}
+
+static MipGenerateInfo get_mip_generate_info(const TextureCreateInfo &create_info, bool multithreaded) {
+    return MipGenerateInfo{
+        .pixels = reinterpret_cast<const u8 *>(create_info.pixel_data),
+        .width = create_info.width,
+        .height = create_info.height,
+        .channels = create_info.bytes_per_pixel,
+        .is_srgb = create_info.is_srgb,
+        .filter = create_info.mip_filter,
+        .preserve_alpha_coverage = create_info.alpha_coverage_cutoff > 0.0f,
+        .alpha_cutoff = create_info.alpha_coverage_cutoff,
+        .multithreaded = multithreaded
+    };
+}
+static std::vector<BufferToImageCopy> get_mip_copy_regions(const std::vector<MipLevel> &levels, VkDeviceSize base_offset) {
+    std::vector<BufferToImageCopy> regions(levels.size());
+    for(u32 i{}; i < static_cast<u32>(levels.size()); ++i) {
+        regions[i] = BufferToImageCopy{
+            .src_buffer_offset = base_offset + levels[i].offset,
+            .dst_image_extent_override {
+                .width = levels[i].width,
+                .height = levels[i].height,
+                .depth = 1U
+            },
+            .mipmap_level_override = i
+        };
+    }
+
+    return regions;
+}
+
+static TextureData encode_u8_texture(const TextureCreateInfo &create_info) {
+    BCFormat bc_format = get_bc_format(create_info.compression);
+
+    TextureData data{
+        .format = get_compressed_format(create_info.compression, create_info.is_srgb),
+        .width = create_info.width,
+        .height = create_info.height
+    };
+
+    MipChain chain{};
+    if (create_info.gen_mip_maps) {
+        chain = MipGenerator::generate(get_mip_generate_info(create_info, true));
+    } else {
+        chain.levels.push_back(MipLevel{ .size = static_cast<usize>(create_info.width) * create_info.height * 4U, .width = create_info.width, .height = create_info.height });
+    }
+
+    u32 level_count = static_cast<u32>(chain.levels.size());
+    std::vector<BCEncodeLevel> encode_levels(level_count);
+
+    usize offset{};
+    for (u32 level{}; level < level_count; ++level) {
+        const MipLevel &mip = chain.levels[level];
+        const u8 *level_pixels = create_info.gen_mip_maps ? chain.bytes.data() + mip.offset : reinterpret_cast<const u8 *>(create_info.pixel_data);
+
+        usize size = BCEncoder::calculate_encoded_size(bc_format, mip.width, mip.height);
+        data.mips.push_back(TextureDataMip{ .offset = offset, .size = size, .width = mip.width, .height = mip.height });
+        encode_levels[level] = BCEncodeLevel{ .rgba = level_pixels, .width = mip.width, .height = mip.height };
+
+        offset += size;
+    }
+
+    data.bytes.resize(offset);
+    for (u32 level{}; level < level_count; ++level) {
+        encode_levels[level].dst = data.bytes.data() + data.mips[level].offset;
+    }
+
+    BCEncoder::encode(bc_format, encode_levels);
+
+    return data;
+}
+
+// Different sources of texture content never share a hash
+enum struct TextureHashSource : u64 {
+    Pixels = 1ull,
+    Data,
+    Encoded
+};
+
+static MeshRegistryKey get_mesh_registry_key(const MeshCreateInfo &create_info) {
+    MeshRegistryKey key{ .primitive_count = static_cast<u32>(create_info.primitives.size()) };
+    for (const auto &primitive_info : create_info.primitives) {
+        key.vertex_count += primitive_info.vertex_count;
+        key.index_count += primitive_info.index_count;
+    }
+
+    return key;
+}
+static VkFormat get_u8_texture_format(u32 bytes_per_pixel, bool is_srgb) {
+    switch (bytes_per_pixel) {
+        case 1U: return is_srgb ? VK_FORMAT_R8_SRGB : VK_FORMAT_R8_UNORM;
+        case 2U: return is_srgb ? VK_FORMAT_R8G8_SRGB : VK_FORMAT_R8G8_UNORM;
+        case 3U: return is_srgb ? VK_FORMAT_R8G8B8_SRGB : VK_FORMAT_R8G8B8_UNORM;
+        case 4U: return is_srgb ? VK_FORMAT_R8G8B8A8_SRGB : VK_FORMAT_R8G8B8A8_UNORM;
+        default: return VK_FORMAT_UNDEFINED;
+    }
+}
+
+static u64 hash_mesh_create_info(const MeshCreateInfo &create_info, bool use_compact_vertices) {
+    u64 hash = Utils::hash_combine(create_info.primitives.size(), std::bit_cast<u32>(create_info.simplify_target_error));
+    hash = Utils::hash_combine(hash, use_compact_vertices);
+    for (const auto &primitive_info : create_info.primitives) {
+        hash = Utils::hash_combine(hash, Utils::hash_bytes(primitive_info.vertex_data, primitive_info.vertex_count * sizeof(Vertex)));
+        hash = Utils::hash_combine(hash, Utils::hash_bytes(primitive_info.index_data, primitive_info.index_count * sizeof(u32)));
+    }
+
+    return hash;
+}
+static u64 hash_texture_create_info(const TextureCreateInfo &create_info) {
+    usize size = static_cast<usize>(create_info.width) * create_info.height * create_info.bytes_per_pixel;
+
+    u64 hash = Utils::hash_bytes(create_info.pixel_data, size, static_cast<u64>(TextureHashSource::Pixels));
+    hash = Utils::hash_combine(hash, create_info.width);
+    hash = Utils::hash_combine(hash, create_info.height);
+    hash = Utils::hash_combine(hash, create_info.bytes_per_pixel);
+    hash = Utils::hash_combine(hash, create_info.is_srgb);
+    hash = Utils::hash_combine(hash, create_info.gen_mip_maps);
+    hash = Utils::hash_combine(hash, create_info.linear_filter);
+    hash = Utils::hash_combine(hash, static_cast<u64>(create_info.compression));
+    hash = Utils::hash_combine(hash, static_cast<u64>(create_info.mip_filter));
+    hash = Utils::hash_combine(hash, std::bit_cast<u32>(create_info.alpha_coverage_cutoff));
+
+    return hash;
+}
+// Reads the container of a streamed texture again, 'imported' must describe the same mip chain
+static bool reload_texture_data(const std::string &path, const TextureData &imported, TextureData &data) {
+    if(path.empty() || !TextureFile::load(path, TextureFile::is_srgb(imported.format), data)) {
+        return false;
+    }
+
+    // The file may have changed since the import
+    if(data.format != imported.format || data.width != imported.width || data.height != imported.height || data.mips.size() != imported.mips.size()) {
+        return false;
+    }
+
+    for(usize i{}; i < data.mips.size(); ++i) {
+        if(data.mips[i].size != imported.mips[i].size) {
+            return false;
+        }
+    }
+
+    return true;
+}
+static u64 hash_texture_data_create_info(const TextureDataCreateInfo &create_info) {
+    const TextureData &data = *create_info.data;
+
+    u64 hash = Utils::hash_bytes(data.bytes.data(), data.bytes.size(), static_cast<u64>(TextureHashSource::Data));
+    hash = Utils::hash_combine(hash, data.format);
+    hash = Utils::hash_combine(hash, data.width);
+    hash = Utils::hash_combine(hash, data.height);
+    for (const auto &mip : data.mips) {
+        hash = Utils::hash_combine(hash, mip.offset);
+        hash = Utils::hash_combine(hash, mip.size);
+    }
+    hash = Utils::hash_combine(hash, create_info.gen_mip_maps);
+    hash = Utils::hash_combine(hash, create_info.linear_filter);
+
+    return hash;
+}
+// Identical encoded files decode to identical pixels, so they can be matched before decoding
+static u64 hash_texture_load_info(const TextureLoadInfo &load_info, const void *encoded_data, usize encoded_size) {
+    u64 hash = Utils::hash_bytes(encoded_data, encoded_size, static_cast<u64>(TextureHashSource::Encoded));
+    hash = Utils::hash_combine(hash, load_info.desired_channels);
+    hash = Utils::hash_combine(hash, load_info.is_srgb);
+    hash = Utils::hash_combine(hash, load_info.gen_mip_maps);
+    hash = Utils::hash_combine(hash, load_info.linear_filter);
+    hash = Utils::hash_combine(hash, static_cast<u64>(load_info.mip_filter));
+    hash = Utils::hash_combine(hash, std::bit_cast<u32>(load_info.alpha_coverage_cutoff));
+
+    return hash;
+}
 
 static void process_gltf_node(SceneCreateInfo &scene, const tinygltf::Model &model, u32 node_id) {
     const tinygltf::Node &node = model.nodes[node_id];
@@ -135,21 +465,49 @@ SceneCreateInfo Renderer::load_gltf_scene(const SceneLoadInfo &load_info) {
     tinygltf::Scene &gltf_scene = model.scenes[model.defaultScene];
 
     if (load_info.import_textures && load_info.import_materials) {
-        scene.textures.resize(model.textures.size());
-
         std::vector<bool> is_texture_srgb(model.textures.size(), false);
+        std::vector<bool> is_texture_normal(model.textures.size(), false);
+        std::vector<f32> texture_alpha_cutoff(model.textures.size(), 0.0f);
         for (const auto &material : model.materials) {
             i32 albedo_texture_id = material.pbrMetallicRoughness.baseColorTexture.index;
+            i32 normal_texture_id = material.normalTexture.index;
 
             // Only albedo should be sRGB
             if (albedo_texture_id != -1) {
                 is_texture_srgb[albedo_texture_id] = true;
+
+                // Alpha tested surfaces would get thinner with every mip otherwise
+                if (material.alphaMode == "MASK") {
+                    texture_alpha_cutoff[albedo_texture_id] = static_cast<f32>(material.alphaCutoff);
+                }
+            }
+            if (normal_texture_id != -1) {
+                is_texture_normal[normal_texture_id] = true;
             }
         }
 
+        std::vector<TextureLoadInfo> texture_load_infos(model.textures.size());
         for (u32 texture_id{}; texture_id < static_cast<u32>(model.textures.size()); ++texture_id) {
             const auto &texture = model.textures[texture_id];
-            const auto &image = model.images[texture.source];
+
+            // Prefer the pre-compressed DDS source if the asset provides one
+            i32 image_id = texture.source;
+            if (texture.extensions.contains("MSFT_texture_dds")) {
+                image_id = texture.extensions.at("MSFT_texture_dds").Get("source").GetNumberAsInt();
+            }
+
+            const auto &image = model.images[image_id];
+
+            TextureCompression compression = TextureCompression::None;
+            if (load_info.compress_textures) {
+                if (is_texture_srgb[texture_id]) {
+                    compression = load_info.albedo_compression;
+                } else if (is_texture_normal[texture_id]) {
+                    compression = TextureCompression::BC5;
+                } else {
+                    compression = TextureCompression::BC1;
+                }
+            }
             const auto &sampler = model.samplers[texture.sampler];
 
             // sampler.magFilter = TINYGLTF_TEXTURE_FILTER_NEAREST | TINYGLTF_TEXTURE_FILTER_LINEAR
@@ -160,48 +518,32 @@ SceneCreateInfo Renderer::load_gltf_scene(const SceneLoadInfo &load_info) {
             // sampler.wrapT = TINYGLTF_TEXTURE_WRAP_REPEAT | TINYGLTF_TEXTURE_WRAP_CLAMP_TO_EDGE | TINYGLTF_TEXTURE_WRAP_MIRRORED_REPEAT
 
             if (!image.uri.empty()) {
-                std::string directory = Utils::get_directory(load_info.path);
-
-                scene.textures[texture_id] = load_u8_texture(TextureLoadInfo{
-                    .path = directory + image.uri,
+                texture_load_infos[texture_id] = TextureLoadInfo{
+                    .path = Utils::get_directory(load_info.path) + image.uri,
                     .is_srgb = is_texture_srgb[texture_id],
-                    .gen_mip_maps = true
-                });
+                    .gen_mip_maps = true,
+                    .compression = compression,
+                    .alpha_coverage_cutoff = texture_alpha_cutoff[texture_id]
+                };
             } else if (image.bufferView != -1) {
                 const auto &buffer_view = model.bufferViews[image.bufferView];
                 const auto &buffer = model.buffers[buffer_view.buffer];
 
-                i32 width, height, channels;
-                u8 *pixels = stbi_load_from_memory(
-                    reinterpret_cast<stbi_uc const *>(reinterpret_cast<usize>(buffer.data.data()) + buffer_view.byteOffset),
-                    static_cast<i32>(buffer_view.byteLength),
-                    &width,
-                    &height,
-                    &channels,
-                    4u
-                );
-
-                if(!pixels) {
-                    DEBUG_WARNING("LEN: " << static_cast<i32>(buffer.data.size()))
-                    DEBUG_PANIC("Failed to load image from buffer[" << image.bufferView << "]")
-                }
-
-                DEBUG_LOG("Loaded image \"" << image.name << "\" from buffer[" << buffer_view.buffer << "], bufferView[" << image.bufferView << "]")
-
-                scene.textures[texture_id] = create_u8_texture(TextureCreateInfo{
-                    .pixel_data = pixels,
-                    .width = static_cast<u32>(width),
-                    .height = static_cast<u32>(height),
-                    .bytes_per_pixel = 4u,
+                texture_load_infos[texture_id] = TextureLoadInfo{
+                    .path = load_info.path + ":" + image.name,
                     .is_srgb = is_texture_srgb[texture_id],
-                    .gen_mip_maps = true
-                });
-
-                stbi_image_free(pixels);
+                    .gen_mip_maps = true,
+                    .compression = compression,
+                    .alpha_coverage_cutoff = texture_alpha_cutoff[texture_id],
+                    .encoded_data = buffer.data.data() + buffer_view.byteOffset,
+                    .encoded_size = buffer_view.byteLength
+                };
             } else {
                 DEBUG_PANIC("Failed to import image! No source URI or bufferView provided!")
             }
         }
+
+        scene.textures = load_textures(texture_load_infos);
     }
 
     scene.materials.resize(model.materials.size(), m_shared.default_material);
@@ -368,6 +710,23 @@ SceneCreateInfo Renderer::load_gltf_scene(const SceneLoadInfo &load_info) {
             total_vertices += static_cast<u32>(primitive_vertices.size());
         }
 
+        if (!load_info.mesh_export_directory.empty()) {
+            MeshData mesh_data{
+                .simplify_target_error = mesh_create_info.simplify_target_error
+            };
+            for(u32 primitive_id{}; primitive_id < static_cast<u32>(mesh.primitives.size()); ++primitive_id) {
+                mesh_data.primitives.push_back(MeshDataPrimitive{
+                    .vertices = mesh_vertices[primitive_id],
+                    .indices = mesh_indices[primitive_id]
+                });
+            }
+
+            std::string export_path = load_info.mesh_export_directory + "/" + std::to_string(mesh_id) + ".gmesh";
+            if (MeshFile::save(export_path, mesh_data)) {
+                DEBUG_LOG("Exported mesh \"" << mesh.name << "\" to \"" << export_path << "\"")
+            }
+        }
+
         scene.meshes[mesh_id] = create_mesh(mesh_create_info);
         scene.mesh_instances[mesh_id] = create_mesh_instance(MeshInstanceCreateInfo{
             .mesh = scene.meshes[mesh_id],
@@ -393,9 +752,20 @@ SceneCreateInfo Renderer::load_gltf_scene(const SceneLoadInfo &load_info) {
 }
 
 Handle<Mesh> Renderer::create_mesh(const MeshCreateInfo &create_info) {
+    bool use_compact_vertices = m_shared.config_enable_vertex_quantization;
+
+    u64 hash = hash_mesh_create_info(create_info, use_compact_vertices);
+    MeshRegistryKey key = get_mesh_registry_key(create_info);
+    if(Handle<Mesh> cached_handle = m_mesh_registry.acquire(hash, key); cached_handle != INVALID_HANDLE) {
+        return cached_handle;
+    }
+
     Range<Primitive> primitive_range = m_primitive_allocator.alloc(static_cast<u32>(create_info.primitives.size()));
     std::vector<glm::vec4> primitive_bounding_spheres(primitive_range.count);
 
+    // The draw buckets are scanned up to the highest primitive in use instead of MAX_SCENE_PRIMITIVES, every bucket is zero again after the emit so the view stride may grow between frames
+    m_shared.scene_draw_bucket_count = static_cast<u32>(std::min(static_cast<VkDeviceSize>(m_primitive_allocator.get_high_water_mark()) * GPU_MAX_LOD_COUNT, MAX_SCENE_DRAW_BUCKETS));
+
     std::vector<u32> indices{};
     std::vector<Vertex> vertices{};
     std::vector<u32> remap{};
@@ -405,8 +775,8 @@ Handle<Mesh> Renderer::create_mesh(const MeshCreateInfo &create_info) {
 
         Primitive primitive_data{};
 
-        if(remap.size() < primitive_info.index_count) {
-            remap.resize(primitive_info.index_count);
+        if(remap.size() < primitive_info.vertex_count) {
+            remap.resize(primitive_info.vertex_count);
         }
 
         // remapping is possibly pointless if the gltf is indexed correctly in the first place,
@@ -438,11 +808,143 @@ Handle<Mesh> Renderer::create_mesh(const MeshCreateInfo &create_info) {
 
         meshopt_optimizeVertexCache(indices.data(), indices.data(), remapped_indices_count, remapped_vertices_count);
         meshopt_optimizeOverdraw(indices.data(), indices.data(), remapped_indices_count, &vertices[0].pos.x, remapped_vertices_count, sizeof(Vertex), 1.05f);
-        meshopt_optimizeVertexFetch(vertices.data(), indices.data(), remapped_indices_count, vertices.data(), remapped_vertices_count, sizeof(Vertex));
+
+        // LOD0 indices are rewritten meshlet by meshlet, so that every meshlet is a contiguous index range which can be culled on its own
+        usize max_meshlet_count = meshopt_buildMeshletsBound(remapped_indices_count, GPU_MESHLET_MAX_VERTICES, GPU_MESHLET_MAX_TRIANGLES);
+        std::vector<meshopt_Meshlet> meshopt_meshlets(max_meshlet_count);
+        std::vector<u32> meshlet_vertices(max_meshlet_count * GPU_MESHLET_MAX_VERTICES);
+        std::vector<u8> meshlet_triangles(max_meshlet_count * GPU_MESHLET_MAX_TRIANGLES * 3u);
+
+        usize meshlet_count = meshopt_buildMeshlets(
+            meshopt_meshlets.data(),
+            meshlet_vertices.data(),
+            meshlet_triangles.data(),
+            indices.data(),
+            remapped_indices_count,
+            &vertices[0].pos.x,
+            remapped_vertices_count,
+            sizeof(Vertex),
+            GPU_MESHLET_MAX_VERTICES,
+            GPU_MESHLET_MAX_TRIANGLES,
+            0.25f
+        );
+
+        std::vector<Meshlet> meshlets(meshlet_count);
+        u32 meshlet_index_offset{};
+
+        for (usize meshlet_id{}; meshlet_id < meshlet_count; ++meshlet_id) {
+            const meshopt_Meshlet &meshlet = meshopt_meshlets[meshlet_id];
+
+            // Triangles within a meshlet are reordered for the vertex cache instead of the whole LOD0
+            meshopt_optimizeMeshlet(&meshlet_vertices[meshlet.vertex_offset], &meshlet_triangles[meshlet.triangle_offset], meshlet.triangle_count, meshlet.vertex_count);
+
+            meshopt_Bounds bounds = meshopt_computeMeshletBounds(
+                &meshlet_vertices[meshlet.vertex_offset],
+                &meshlet_triangles[meshlet.triangle_offset],
+                meshlet.triangle_count,
+                &vertices[0].pos.x,
+                remapped_vertices_count,
+                sizeof(Vertex)
+            );
+
+            meshlets[meshlet_id] = Meshlet{
+                .center = glm::vec3(bounds.center[0], bounds.center[1], bounds.center[2]),
+                .radius = bounds.radius,
+                .cone = glm::i8vec4(bounds.cone_axis_s8[0], bounds.cone_axis_s8[1], bounds.cone_axis_s8[2], bounds.cone_cutoff_s8),
+                .index_offset = meshlet_index_offset,
+                .index_count = meshlet.triangle_count * 3u
+            };
+
+            for (u32 i{}; i < meshlet.triangle_count * 3u; ++i) {
+                indices[meshlet_index_offset++] = meshlet_vertices[meshlet.vertex_offset + meshlet_triangles[meshlet.triangle_offset + i]];
+            }
+        }
+
+        remapped_indices_count = meshlet_index_offset;
+
+        // LOD1-7, every LOD is simplified from the previous one
+        // meshopt_simplify reports the error relative to the mesh extents, so the scaled errors add up
+        std::vector<std::vector<u32>> lod_indices(1u, std::vector<u32>(indices.begin(), indices.begin() + remapped_indices_count));
+        std::vector<f32> lod_errors(1u, 0.0f);
+
+        f32 simplify_scale = meshopt_simplifyScale(&vertices[0].pos.x, remapped_vertices_count, sizeof(Vertex));
+
+        for (u32 lod_id = 1u; lod_id < GPU_MAX_LOD_COUNT; ++lod_id) {
+            const std::vector<u32> &last_indices = lod_indices.back();
+
+            f32 threshold = 1.0f - (lod_id / static_cast<f32>(GPU_MAX_LOD_COUNT));
+            f32 target_error = create_info.simplify_target_error * (lod_id / (static_cast<f32>(GPU_MAX_LOD_COUNT - 1)));
+            f32 result_error{};
+
+            std::vector<u32> simplified_indices(last_indices.size());
+            usize simplified_indices_count = meshopt_simplify(
+                simplified_indices.data(),
+                last_indices.data(),
+                last_indices.size(),
+                &vertices[0].pos.x,
+                remapped_vertices_count,
+                sizeof(Vertex),
+                static_cast<usize>(threshold * last_indices.size()),
+                target_error,
+                0,
+                &result_error
+            );
+
+            // Coarser LODs reuse the last one that could be simplified
+            if (simplified_indices_count == 0) {
+                break;
+            }
+
+            simplified_indices.resize(simplified_indices_count);
+
+            meshopt_optimizeVertexCache(simplified_indices.data(), simplified_indices.data(), simplified_indices_count, remapped_vertices_count);
+            meshopt_optimizeOverdraw(simplified_indices.data(), simplified_indices.data(), simplified_indices_count, &vertices[0].pos.x, remapped_vertices_count, sizeof(Vertex), 1.05f);
+
+            lod_errors.push_back(lod_errors.back() + result_error * simplify_scale);
+            lod_indices.push_back(std::move(simplified_indices));
+        }
+
+        // Vertices are reordered so that every LOD references only a prefix of the vertex range: the vertices of the coarsest LOD come first,
+        // followed by the ones every finer LOD adds. Each band is in the order of first use (as in meshopt_optimizeVertexFetch), so distant
+        // objects fetch from a small contiguous range without duplicating any vertices
+        std::vector<u32> lod_vertex_counts(lod_indices.size());
+        {
+            std::fill(remap.begin(), remap.begin() + remapped_vertices_count, ~0u);
+
+            u32 next_vertex{};
+            for (u32 lod_id = static_cast<u32>(lod_indices.size()); lod_id-- > 0u;) {
+                for (u32 index : lod_indices[lod_id]) {
+                    if (remap[index] == ~0u) {
+                        remap[index] = next_vertex++;
+                    }
+                }
+
+                lod_vertex_counts[lod_id] = next_vertex;
+            }
+
+            // Vertices left only in degenerate triangles are not referenced anymore and get dropped
+            meshopt_remapVertexBuffer(vertices.data(), vertices.data(), remapped_vertices_count, sizeof(Vertex), remap.data());
+            for (auto &lod : lod_indices) {
+                meshopt_remapIndexBuffer(lod.data(), lod.data(), lod.size(), remap.data());
+            }
+
+            remapped_vertices_count = next_vertex;
+        }
+
+        // Bounds of only the vertices that are left, so that every primitive can be culled on its own
+        {
+            glm::vec4 sphere = calculate_bounding_sphere(vertices.data(), static_cast<u32>(remapped_vertices_count));
+            primitive_data.center_offset = glm::vec3(sphere);
+            primitive_data.radius = sphere.w;
+
+            calculate_aabb(vertices.data(), static_cast<u32>(remapped_vertices_count), primitive_data.aabb_min, primitive_data.aabb_max);
+
+            primitive_bounding_spheres[primitive_id] = sphere;
+        }
 
         // simplified index buffers are always smaller or equal to the original size
         Handle<Buffer> staging = m_api.rm->create_buffer(BufferCreateInfo {
-            .size = std::max({remapped_vertices_count * sizeof(Vertex), remapped_indices_count * sizeof(u32), sizeof(Primitive)}),
+            .size = std::max({remapped_vertices_count * sizeof(Vertex), remapped_indices_count * sizeof(u32), meshlet_count * sizeof(Meshlet), sizeof(Primitive)}),
             .buffer_usage_flags = VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
             .memory_usage_flags = VMA_MEMORY_USAGE_CPU_TO_GPU
         });
@@ -451,15 +953,24 @@ Handle<Mesh> Renderer::create_mesh(const MeshCreateInfo &create_info) {
 
         // Vertices
         {
-            Range<Vertex> vertex_range = m_vertex_allocator.alloc(remapped_vertices_count);
-            primitive_data.vertex_start = static_cast<i32>(vertex_range.start);
-            primitive_data.vertex_count = vertex_range.count;
+            std::vector<CompactVertex> compact_vertices{};
+            if (use_compact_vertices) {
+                compact_vertices = quantize_vertices(vertices.data(), static_cast<u32>(remapped_vertices_count), primitive_data);
+            }
+
+            const void *vertex_data = use_compact_vertices ? static_cast<const void*>(compact_vertices.data()) : static_cast<const void*>(vertices.data());
+            usize vertex_stride = use_compact_vertices ? sizeof(CompactVertex) : sizeof(Vertex);
+            u32 vertices_per_block = static_cast<u32>(sizeof(VertexBlock) / vertex_stride);
 
-            m_api.rm->memcpy_to_buffer(mapped_staging, vertices.data(), sizeof(Vertex) * static_cast<usize>(vertex_range.count));
+            Range<VertexBlock> vertex_range = m_vertex_allocator.alloc(static_cast<u32>(Utils::div_ceil(remapped_vertices_count, vertices_per_block)));
+            primitive_data.vertex_start = static_cast<i32>(vertex_range.start * vertices_per_block);
+            primitive_data.vertex_count = static_cast<u32>(remapped_vertices_count);
+
+            m_api.rm->memcpy_to_buffer(mapped_staging, vertex_data, vertex_stride * remapped_vertices_count);
 
             VkBufferCopy vertex_buffer_copy{
-                .dstOffset = vertex_range.start * sizeof(Vertex),
-                .size = sizeof(Vertex) * static_cast<usize>(vertex_range.count)
+                .dstOffset = vertex_range.start * sizeof(VertexBlock),
+                .size = vertex_stride * remapped_vertices_count
             };
 
             m_api.record_and_submit_once([this, staging, &vertex_buffer_copy](Handle<CommandList> cmd) {
@@ -467,76 +978,62 @@ Handle<Mesh> Renderer::create_mesh(const MeshCreateInfo &create_info) {
             });
         }
 
-        // Indices LOD0
+        // Meshlets
         {
-            Range<u32> index_range = m_index_allocator.alloc(remapped_indices_count);
-            primitive_data.lods[0u] = PrimitiveLOD {
-                .index_start = index_range.start,
-                .index_count = index_range.count,
-            };
+            Range<Meshlet> meshlet_range = m_meshlet_allocator.alloc(static_cast<u32>(meshlet_count));
+            primitive_data.meshlet_start = meshlet_range.start;
+            primitive_data.meshlet_count = meshlet_range.count;
 
-            m_api.rm->memcpy_to_buffer(mapped_staging, indices.data(), sizeof(u32) * static_cast<usize>(index_range.count));
+            m_api.rm->memcpy_to_buffer(mapped_staging, meshlets.data(), sizeof(Meshlet) * static_cast<usize>(meshlet_range.count));
 
-            VkBufferCopy index_buffer_copy{
-                .dstOffset = index_range.start * sizeof(u32),
-                .size = sizeof(u32) * static_cast<usize>(index_range.count)
+            VkBufferCopy meshlet_buffer_copy{
+                .dstOffset = meshlet_range.start * sizeof(Meshlet),
+                .size = sizeof(Meshlet) * static_cast<usize>(meshlet_range.count)
             };
 
-            m_api.record_and_submit_once([this, staging, &index_buffer_copy](Handle<CommandList> cmd) {
-                m_api.copy_buffer_to_buffer(cmd, staging, m_shared.scene_index_buffer, { index_buffer_copy });
+            m_api.record_and_submit_once([this, staging, &meshlet_buffer_copy](Handle<CommandList> cmd) {
+                m_api.copy_buffer_to_buffer(cmd, staging, m_shared.scene_meshlet_buffer, { meshlet_buffer_copy });
             });
         }
 
-        // Indices LOD1-7
-        usize last_indices_count = remapped_indices_count;
-        
-        for (u32 lod_id = 1u; lod_id < static_cast<u32>(primitive_data.lods.size()); ++lod_id) {
-            f32 threshold = 1.0f - (lod_id / static_cast<f32>(primitive_data.lods.size()));
-            f32 target_error = create_info.simplify_target_error * (lod_id / (static_cast<f32>(primitive_data.lods.size() - 1)));
-            f32 result_error{};
-
-            usize simplified_indices_count = meshopt_simplify(
-                indices.data(),
-                indices.data(),
-                last_indices_count,
-                &vertices[0].pos.x,
-                remapped_vertices_count,
-                sizeof(Vertex),
-                static_cast<usize>(threshold * last_indices_count),
-                target_error,
-                0,
-                &result_error
-            );
-
-            if (simplified_indices_count == 0) {
-                for(u32 j = lod_id; j < static_cast<u32>(primitive_data.lods.size()); ++j) {
-                    primitive_data.lods[j] = primitive_data.lods[lod_id-1];
-                }
-
-                break;
+        // Indices LOD0-7
+        for (u32 lod_id{}; lod_id < GPU_MAX_LOD_COUNT; ++lod_id) {
+            if (lod_id >= static_cast<u32>(lod_indices.size())) {
+                primitive_data.lods[lod_id] = primitive_data.lods[lod_id - 1u];
+                continue;
             }
 
-            meshopt_optimizeVertexCache(indices.data(), indices.data(), simplified_indices_count, remapped_vertices_count);
-            meshopt_optimizeOverdraw(indices.data(), indices.data(), simplified_indices_count, &vertices[0].pos.x, remapped_vertices_count, sizeof(Vertex), 1.05f);
+            // Indices are relative to vertex_start, so LODs with few enough vertices fit in 16 bits
+            const std::vector<u32> &indices_u32 = lod_indices[lod_id];
+            bool is_index16 = GPU_LOD_INDEX_TYPE(lod_vertex_counts[lod_id]) == GPU_INDEX_TYPE_U16;
+
+            usize index_size = is_index16 ? sizeof(u16) : sizeof(u32);
+            u32 index_count = static_cast<u32>(indices_u32.size());
+            u32 index_start = is_index16 ? m_index16_allocator.alloc(index_count).start : m_index_allocator.alloc(index_count).start;
 
-            Range<u32> index_range = m_index_allocator.alloc(simplified_indices_count);
             primitive_data.lods[lod_id] = PrimitiveLOD {
-                .index_start = index_range.start,
-                .index_count = index_range.count,
+                .index_start = index_start,
+                .index_count = index_count,
+                .vertex_count = lod_vertex_counts[lod_id],
+                .error = lod_errors[lod_id]
             };
 
-            m_api.rm->memcpy_to_buffer(mapped_staging, indices.data(), sizeof(u32) * static_cast<usize>(index_range.count));
+            if (is_index16) {
+                std::vector<u16> indices_u16(indices_u32.begin(), indices_u32.end());
+                m_api.rm->memcpy_to_buffer(mapped_staging, indices_u16.data(), index_size * static_cast<usize>(index_count));
+            } else {
+                m_api.rm->memcpy_to_buffer(mapped_staging, indices_u32.data(), index_size * static_cast<usize>(index_count));
+            }
 
             VkBufferCopy index_buffer_copy{
-                .dstOffset = index_range.start * sizeof(u32),
-                .size = sizeof(u32) * static_cast<usize>(index_range.count)
+                .dstOffset = index_start * index_size,
+                .size = index_size * static_cast<usize>(index_count)
             };
 
-            m_api.record_and_submit_once([this, staging, &index_buffer_copy](Handle<CommandList> cmd) {
-                m_api.copy_buffer_to_buffer(cmd, staging, m_shared.scene_index_buffer, { index_buffer_copy });
+            Handle<Buffer> index_buffer = is_index16 ? m_shared.scene_index16_buffer : m_shared.scene_index_buffer;
+            m_api.record_and_submit_once([this, staging, index_buffer, &index_buffer_copy](Handle<CommandList> cmd) {
+                m_api.copy_buffer_to_buffer(cmd, staging, index_buffer, { index_buffer_copy });
             });
-
-            last_indices_count = simplified_indices_count;
         }
 
         m_primitive_allocator.get_element_mutable(primitive_range.start + primitive_id) = primitive_data;
@@ -554,11 +1051,6 @@ Handle<Mesh> Renderer::create_mesh(const MeshCreateInfo &create_info) {
 
         m_api.rm->unmap_buffer(staging);
         m_api.rm->destroy(staging);
-
-        glm::vec3 center_offset = calculate_center_offset(vertices.data(), static_cast<u32>(vertices.size()));
-        f32 radius = calculate_radius(vertices.data(), static_cast<u32>(vertices.size()), center_offset);
-
-        primitive_bounding_spheres[primitive_id] = glm::vec4(center_offset.x, center_offset.y, center_offset.z, radius);
     }
 
     indices.clear();
@@ -570,26 +1062,11 @@ Handle<Mesh> Renderer::create_mesh(const MeshCreateInfo &create_info) {
     remap.clear();
     remap.shrink_to_fit();
 
-    glm::vec3 avg_center{};
-    for(const auto &bound : primitive_bounding_spheres) {
-        avg_center += glm::vec3(bound.x, bound.y, bound.z);
-    }
-    avg_center /= static_cast<f32>(primitive_range.count);
-
-    f32 max_radius{};
-    for(const auto &bound : primitive_bounding_spheres) {
-        glm::vec3 point = glm::vec3(bound);
-        f32 radius = bound.w;
-
-        f32 d = glm::distance(avg_center, point) + radius;
-        if (d > max_radius) {
-            max_radius = d;
-        }
-    }
+    glm::vec4 mesh_bounding_sphere = merge_bounding_spheres(primitive_bounding_spheres);
 
     Mesh mesh{
-        .center_offset = avg_center,
-        .radius = max_radius,
+        .center_offset = glm::vec3(mesh_bounding_sphere),
+        .radius = mesh_bounding_sphere.w,
         .primitive_count = primitive_range.count,
         .primitive_start = primitive_range.start
     };
@@ -615,13 +1092,42 @@ Handle<Mesh> Renderer::create_mesh(const MeshCreateInfo &create_info) {
 
     m_api.rm->destroy(staging);
 
+    m_mesh_registry.add(hash, key, mesh_handle);
+
     return mesh_handle;
 }
+Handle<Mesh> Renderer::load_mesh(const std::string &path) {
+    MeshData data{};
+    if (!MeshFile::load(path, data)) {
+        DEBUG_PANIC("Failed to load mesh from \"" << path << "\"")
+    }
+
+    MeshCreateInfo create_info{
+        .simplify_target_error = data.simplify_target_error
+    };
+
+    for (const auto &primitive : data.primitives) {
+        create_info.primitives.push_back(PrimitiveCreateInfo{
+            .vertex_data = primitive.vertices.data(),
+            .vertex_count = static_cast<u32>(primitive.vertices.size()),
+            .index_data = primitive.indices.data(),
+            .index_count = static_cast<u32>(primitive.indices.size())
+        });
+    }
+
+    DEBUG_LOG("Loaded mesh from \"" << path << "\"")
+
+    return create_mesh(create_info);
+}
 void Renderer::destroy(Handle<Mesh> mesh_handle) {
     if(!m_mesh_allocator.is_handle_valid(mesh_handle)) {
         DEBUG_PANIC("Cannot delete mesh - Mesh with a handle id: = " << mesh_handle << ", does not exist!")
     }
 
+    if(!m_mesh_registry.release(mesh_handle)) {
+        return;
+    }
+
     const Mesh &mesh = m_mesh_allocator.get_element(mesh_handle);
 
     Range<Primitive> primitive_range{ mesh.primitive_start, mesh.primitive_count };
@@ -631,11 +1137,17 @@ void Renderer::destroy(Handle<Mesh> mesh_handle) {
 
     for (u32 i{}; i < primitive_range.count; ++i) {
         const Primitive &prim = m_primitive_allocator.get_element(primitive_range.start + i);
-        m_vertex_allocator.free(Range<Vertex>{static_cast<u32>(prim.vertex_start), prim.vertex_count});
+        u32 vertices_per_block = static_cast<u32>(sizeof(VertexBlock) / ((prim.vertex_format == GPU_VERTEX_FORMAT_COMPACT) ? sizeof(CompactVertex) : sizeof(Vertex)));
+        m_vertex_allocator.free(Range<VertexBlock>{static_cast<u32>(prim.vertex_start) / vertices_per_block, static_cast<u32>(Utils::div_ceil(prim.vertex_count, vertices_per_block))});
+        m_meshlet_allocator.free(Range<Meshlet>{prim.meshlet_start, prim.meshlet_count});
 
         for (u32 lod_id{}; lod_id < static_cast<u32>(prim.lods.size()); ++lod_id) {
             const PrimitiveLOD &lod = prim.lods[lod_id];
-            m_index_allocator.free(Range<u32>{lod.index_start, lod.index_count});
+            if (GPU_LOD_INDEX_TYPE(lod.vertex_count) == GPU_INDEX_TYPE_U16) {
+                m_index16_allocator.free(Range<u16>{lod.index_start, lod.index_count});
+            } else {
+                m_index_allocator.free(Range<u32>{lod.index_start, lod.index_count});
+            }
         }
     }
 
@@ -716,32 +1228,325 @@ void Renderer::destroy(Handle<MeshInstance> mesh_instance_handle) {
     m_mesh_instance_materials_allocator.free(mat_range);
 }
 
-Handle<Texture> Renderer::load_u8_texture(const TextureLoadInfo &load_info) {
-    i32 width, height, channels;
-    u8 *pixels = stbi_load(load_info.path.c_str(), &width, &height, &channels, static_cast<i32>(load_info.desired_channels));
-    if(!pixels) {
-        DEBUG_PANIC("Failed to load image from \"" << load_info.path << "\"")
+Handle<Texture> Renderer::load_texture(const TextureLoadInfo &load_info) {
+    if (!load_info.encoded_data && TextureFile::is_container_path(load_info.path)) {
+        return load_container_texture(load_info);
     }
 
+    return load_u8_texture(load_info);
+}
+Handle<Texture> Renderer::load_container_texture(const TextureLoadInfo &load_info) {
+    TextureData data{};
+    if (!TextureFile::load(load_info.path, load_info.is_srgb, data)) {
+        DEBUG_PANIC("Failed to load texture container from \"" << load_info.path << "\"")
+    }
 
-    DEBUG_LOG("Loaded image from \"" << load_info.path << "\"")
+    DEBUG_LOG("Loaded " << TextureFile::get_format_name(data.format) << " texture with " << data.mips.size() << " mips from \"" << load_info.path << "\"")
 
-    auto handle = create_u8_texture(TextureCreateInfo {
-        .pixel_data = pixels,
-        .width = static_cast<u32>(width),
-        .height = static_cast<u32>(height),
-        .bytes_per_pixel = load_info.desired_channels,
-        .is_srgb = load_info.is_srgb,
+    return create_texture(TextureDataCreateInfo{
+        .data = &data,
         .gen_mip_maps = load_info.gen_mip_maps,
         .linear_filter = load_info.linear_filter,
+        .source_path = load_info.path
     });
+}
+std::vector<Handle<Texture>> Renderer::load_textures(const std::vector<TextureLoadInfo> &load_infos) {
+    DEBUG_TIMESTAMP(start);
+
+    std::vector<Handle<Texture>> handles(load_infos.size(), INVALID_HANDLE);
+
+    struct DecodeJob {
+        u32 index{};
+        u32 width{};
+        u32 height{};
+        u32 bytes_per_pixel{};
+        VkDeviceSize staging_offset{};
+        VkDeviceSize working_set_size{};
+    };
+    struct DecodeBatch {
+        std::vector<DecodeJob> jobs{};
+        VkDeviceSize staging_size{};
+        Handle<Buffer> staging_buffer{};
+    };
 
-    stbi_image_free(pixels);
+    struct EncodedImage {
+        bool is_batched{};
+        u64 hash{};
+        TextureRegistryKey key{};
+        i32 width{};
+        i32 height{};
+        std::vector<u8> file_bytes{}; // Kept for the decoding, so that every file is read only once
+    };
 
-    return handle;
-}
-Handle<Texture> Renderer::create_u8_texture(const TextureCreateInfo &create_info) {
-    if(!create_info.pixel_data) {
+    // Only the headers are parsed here, the sizes are needed to place every image in the staging buffers up front
+    // The encoded files are hashed as well, so that duplicates are not decoded at all
+    std::vector<EncodedImage> images(load_infos.size());
+    Utils::parallel_for(static_cast<u32>(load_infos.size()), [&load_infos, &images](u32 i) {
+        const auto &info = load_infos[i];
+
+        // Containers need no decoding and CPU compressed textures need the pixels in host memory (the encoder is multithreaded on its own)
+        bool is_container = !info.encoded_data && TextureFile::is_container_path(info.path);
+        if(is_container || info.compression != TextureCompression::None) {
+            return;
+        }
+
+        if(!info.encoded_data) {
+            images[i].file_bytes = Utils::read_file_bytes(info.path);
+        }
+
+        const void *encoded_data = info.encoded_data ? info.encoded_data : images[i].file_bytes.data();
+        usize encoded_size = info.encoded_data ? info.encoded_size : images[i].file_bytes.size();
+
+        i32 channels;
+        if(!stbi_info_from_memory(static_cast<const stbi_uc *>(encoded_data), static_cast<i32>(encoded_size), &images[i].width, &images[i].height, &channels)) {
+            DEBUG_PANIC("Failed to read image header from \"" << info.path << "\"")
+        }
+
+        images[i].is_batched = true;
+        images[i].hash = hash_texture_load_info(info, encoded_data, encoded_size);
+        images[i].key = TextureRegistryKey{
+            .width = static_cast<u32>(images[i].width),
+            .height = static_cast<u32>(images[i].height),
+            .format = get_u8_texture_format(info.desired_channels, info.is_srgb)
+        };
+    });
+
+    std::unordered_map<u64, u32> first_image_with_hash{};
+    std::vector<u32> duplicate_images{};
+
+    std::vector<DecodeBatch> batches{};
+    for(u32 i{}; i < static_cast<u32>(load_infos.size()); ++i) {
+        const auto &info = load_infos[i];
+        auto &image = images[i];
+
+        if(!image.is_batched) {
+            handles[i] = load_texture(info);
+            continue;
+        }
+
+        if(Handle<Texture> cached_handle = m_texture_registry.acquire(image.hash, image.key); cached_handle != INVALID_HANDLE) {
+            handles[i] = cached_handle;
+            image.file_bytes = {};
+            continue;
+        }
+
+        // Duplicates within this call get their handle after the first copy has been uploaded
+        if(first_image_with_hash.contains(image.hash)) {
+            duplicate_images.push_back(i);
+            image.file_bytes = {};
+            continue;
+        }
+        first_image_with_hash[image.hash] = i;
+
+        VkDeviceSize size = info.gen_mip_maps ?
+            MipGenerator::calculate_chain_size(static_cast<u32>(image.width), static_cast<u32>(image.height), info.desired_channels) :
+            static_cast<VkDeviceSize>(image.width) * static_cast<VkDeviceSize>(image.height) * info.desired_channels;
+        if(batches.empty() || (batches.back().staging_size + size > TEXTURE_DECODE_BATCH_SIZE && !batches.back().jobs.empty())) {
+            batches.emplace_back();
+        }
+
+        auto &batch = batches.back();
+        batch.jobs.push_back(DecodeJob{
+            .index = i,
+            .width = static_cast<u32>(image.width),
+            .height = static_cast<u32>(image.height),
+            .bytes_per_pixel = info.desired_channels,
+            .staging_offset = batch.staging_size,
+            .working_set_size = static_cast<VkDeviceSize>(image.width) * static_cast<VkDeviceSize>(image.height) * info.desired_channels +
+                (info.gen_mip_maps ? MipGenerator::calculate_working_set_size(static_cast<u32>(image.width), static_cast<u32>(image.height)) : 0ull)
+        });
+
+        // Copy offsets must be a multiple of the texel size
+        batch.staging_size += Utils::align(16u * info.desired_channels, size);
+    }
+
+    // Jobs wait until their working set fits next to the ones in flight, a job larger than the whole budget runs alone
+    std::mutex working_set_mutex{};
+    std::condition_variable working_set_released{};
+    VkDeviceSize working_set_in_flight{};
+
+    auto acquire_working_set = [this, &working_set_mutex, &working_set_released, &working_set_in_flight](VkDeviceSize size) {
+        std::unique_lock lock(working_set_mutex);
+        working_set_released.wait(lock, [this, &working_set_in_flight, size]() {
+            return working_set_in_flight == 0ull || working_set_in_flight + size <= TEXTURE_DECODE_WORKING_SET_SIZE;
+        });
+
+        working_set_in_flight += size;
+    };
+    auto release_working_set = [&working_set_mutex, &working_set_released, &working_set_in_flight](VkDeviceSize size) {
+        {
+            std::lock_guard lock(working_set_mutex);
+            working_set_in_flight -= size;
+        }
+
+        working_set_released.notify_all();
+    };
+
+    // Workers decode and generate mips straight into the mapped staging memory of a batch
+    auto start_decoding = [this, &load_infos, &images, &acquire_working_set, &release_working_set](DecodeBatch &batch) {
+        batch.staging_buffer = m_api.rm->create_buffer(BufferCreateInfo{
+            .size = batch.staging_size,
+            .buffer_usage_flags = VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            .memory_usage_flags = VMA_MEMORY_USAGE_CPU_TO_GPU
+        });
+
+        u8 *mapped = static_cast<u8 *>(m_api.rm->map_buffer(batch.staging_buffer));
+
+        return std::async(std::launch::async, [&load_infos, &images, &batch, mapped, &acquire_working_set, &release_working_set]() {
+            Utils::parallel_for(static_cast<u32>(batch.jobs.size()), [&load_infos, &images, &batch, mapped, &acquire_working_set, &release_working_set](u32 job_index) {
+                const DecodeJob &job = batch.jobs[job_index];
+                const auto &info = load_infos[job.index];
+                auto &file_bytes = images[job.index].file_bytes;
+
+                acquire_working_set(job.working_set_size);
+
+                const void *encoded_data = info.encoded_data ? info.encoded_data : file_bytes.data();
+                usize encoded_size = info.encoded_data ? info.encoded_size : file_bytes.size();
+
+                i32 width, height, channels;
+                u8 *pixels = stbi_load_from_memory(static_cast<const stbi_uc *>(encoded_data), static_cast<i32>(encoded_size), &width, &height, &channels, static_cast<i32>(job.bytes_per_pixel));
+                file_bytes = {};
+
+                if(!pixels || static_cast<u32>(width) != job.width || static_cast<u32>(height) != job.height) {
+                    DEBUG_PANIC("Failed to load image from \"" << info.path << "\"")
+                }
+
+                if(info.gen_mip_maps) {
+                    // Images are already processed in parallel, so every chain is generated on a single thread
+                    MipGenerator::generate_into(MipGenerateInfo{
+                        .pixels = pixels,
+                        .width = job.width,
+                        .height = job.height,
+                        .channels = job.bytes_per_pixel,
+                        .is_srgb = info.is_srgb,
+                        .filter = info.mip_filter,
+                        .preserve_alpha_coverage = info.alpha_coverage_cutoff > 0.0f,
+                        .alpha_cutoff = info.alpha_coverage_cutoff,
+                        .multithreaded = false
+                    }, mapped + job.staging_offset);
+                } else {
+                    std::memcpy(mapped + job.staging_offset, pixels, static_cast<usize>(job.width) * job.height * job.bytes_per_pixel);
+                }
+
+                stbi_image_free(pixels);
+
+                release_working_set(job.working_set_size);
+            });
+        });
+    };
+
+    std::future<void> decoding{};
+    if(!batches.empty()) {
+        decoding = start_decoding(batches[0]);
+    }
+
+    for(u32 batch_index{}; batch_index < static_cast<u32>(batches.size()); ++batch_index) {
+        auto &batch = batches[batch_index];
+
+        decoding.get();
+
+        m_api.rm->flush_mapped_buffer(batch.staging_buffer);
+        m_api.rm->unmap_buffer(batch.staging_buffer);
+
+        // The next batch is decoded while this one is uploaded
+        if(batch_index + 1U < static_cast<u32>(batches.size())) {
+            decoding = start_decoding(batches[batch_index + 1U]);
+        }
+
+        std::vector<Texture> textures{};
+        textures.reserve(batch.jobs.size());
+        for(const auto &job : batch.jobs) {
+            const auto &info = load_infos[job.index];
+
+            textures.push_back(create_u8_texture_resources(TextureCreateInfo{
+                .width = job.width,
+                .height = job.height,
+                .bytes_per_pixel = job.bytes_per_pixel,
+                .is_srgb = info.is_srgb,
+                .gen_mip_maps = info.gen_mip_maps,
+                .linear_filter = info.linear_filter,
+                .mip_filter = info.mip_filter,
+                .alpha_coverage_cutoff = info.alpha_coverage_cutoff
+            }));
+        }
+
+        m_api.record_and_submit_once([this, &batch, &textures, &load_infos](Handle<CommandList> cmd) {
+            for(u32 i{}; i < static_cast<u32>(batch.jobs.size()); ++i) {
+                const DecodeJob &job = batch.jobs[i];
+                std::vector<MipLevel> levels = load_infos[job.index].gen_mip_maps ?
+                    MipGenerator::calculate_levels(job.width, job.height, job.bytes_per_pixel) :
+                    std::vector<MipLevel>{ MipLevel{ .size = static_cast<usize>(job.width) * job.height * job.bytes_per_pixel, .width = job.width, .height = job.height } };
+
+                record_u8_texture_upload(cmd, textures[i], batch.staging_buffer, get_mip_copy_regions(levels, job.staging_offset));
+            }
+        });
+
+        m_api.rm->destroy(batch.staging_buffer);
+
+        for(u32 i{}; i < static_cast<u32>(batch.jobs.size()); ++i) {
+            u32 index = batch.jobs[i].index;
+
+            handles[index] = register_texture(textures[i]);
+            m_texture_registry.add(images[index].hash, images[index].key, handles[index]);
+        }
+
+        DEBUG_LOG("Decoded and uploaded " << batch.jobs.size() << " images (" << static_cast<f64>(batch.staging_size) / 1024.0 / 1024.0 << " mb)")
+    }
+
+    // A collision with the first copy is loaded on its own
+    for(u32 index : duplicate_images) {
+        handles[index] = m_texture_registry.acquire(images[index].hash, images[index].key);
+        if(handles[index] == INVALID_HANDLE) {
+            handles[index] = load_texture(load_infos[index]);
+        }
+    }
+
+    DEBUG_TIMESTAMP(stop);
+    DEBUG_LOG("Loaded " << load_infos.size() << " textures (" << duplicate_images.size() << " duplicates) in " << DEBUG_TIME_DIFF(start, stop) << "s")
+
+    return handles;
+}
+Handle<Texture> Renderer::load_u8_texture(const TextureLoadInfo &load_info) {
+    u32 desired_channels = (load_info.compression == TextureCompression::None) ? load_info.desired_channels : 4u;
+
+    i32 width, height, channels;
+    u8 *pixels = load_info.encoded_data ?
+        stbi_load_from_memory(static_cast<const stbi_uc *>(load_info.encoded_data), static_cast<i32>(load_info.encoded_size), &width, &height, &channels, static_cast<i32>(desired_channels)) :
+        stbi_load(load_info.path.c_str(), &width, &height, &channels, static_cast<i32>(desired_channels));
+    if(!pixels) {
+        DEBUG_PANIC("Failed to load image from \"" << load_info.path << "\"")
+    }
+
+    DEBUG_LOG("Loaded image from \"" << load_info.path << "\"")
+
+    TextureCompression compression = select_texture_compression(load_info.compression, std::min(load_info.desired_channels, static_cast<u32>(channels)), load_info.is_srgb);
+
+    // Grey + alpha images are expanded to (grey, grey, grey, alpha), BC5 encodes the first two channels
+    if(compression == TextureCompression::BC5 && channels == 2) {
+        for(usize i{}; i < static_cast<usize>(width) * height; ++i) {
+            pixels[i * 4U + 1U] = pixels[i * 4U + 3U];
+        }
+    }
+
+    auto handle = create_u8_texture(TextureCreateInfo {
+        .pixel_data = pixels,
+        .width = static_cast<u32>(width),
+        .height = static_cast<u32>(height),
+        .bytes_per_pixel = desired_channels,
+        .is_srgb = load_info.is_srgb,
+        .gen_mip_maps = load_info.gen_mip_maps,
+        .linear_filter = load_info.linear_filter,
+        .compression = compression,
+        .mip_filter = load_info.mip_filter,
+        .alpha_coverage_cutoff = load_info.alpha_coverage_cutoff
+    });
+
+    stbi_image_free(pixels);
+
+    return handle;
+}
+Handle<Texture> Renderer::create_u8_texture(const TextureCreateInfo &create_info) {
+    if(!create_info.pixel_data) {
         DEBUG_PANIC("create_u8_texture failed! | create_info.pixel_data cannot be nullptr!")
     }
 
@@ -752,22 +1557,73 @@ Handle<Texture> Renderer::create_u8_texture(const TextureCreateInfo &create_info
         DEBUG_PANIC("create_u8_texture failed! | create_info.height must be greater than 0!")
     }
 
-    VkFormat format{};
-    if(create_info.bytes_per_pixel == 1U) {
-        format = (create_info.is_srgb ? VK_FORMAT_R8_SRGB : VK_FORMAT_R8_UNORM);
-    } else if(create_info.bytes_per_pixel == 2U) {
-        format = (create_info.is_srgb ? VK_FORMAT_R8G8_SRGB : VK_FORMAT_R8G8_UNORM);
-    } else if(create_info.bytes_per_pixel == 3U) {
-        format = (create_info.is_srgb ? VK_FORMAT_R8G8B8_SRGB : VK_FORMAT_R8G8B8_UNORM);
-    } else if(create_info.bytes_per_pixel == 4U) {
-        format = (create_info.is_srgb ? VK_FORMAT_R8G8B8A8_SRGB : VK_FORMAT_R8G8B8A8_UNORM);
+    u64 hash = hash_texture_create_info(create_info);
+    TextureRegistryKey key{
+        .width = create_info.width,
+        .height = create_info.height,
+        .format = get_u8_texture_format(create_info.bytes_per_pixel, create_info.is_srgb)
+    };
+    if(Handle<Texture> cached_handle = m_texture_registry.acquire(hash, key); cached_handle != INVALID_HANDLE) {
+        return cached_handle;
+    }
+
+    auto handle = create_uncached_u8_texture(create_info);
+    m_texture_registry.add(hash, key, handle);
+
+    return handle;
+}
+Handle<Texture> Renderer::create_uncached_u8_texture(const TextureCreateInfo &create_info) {
+    if(create_info.compression != TextureCompression::None) {
+        if(create_info.bytes_per_pixel != 4U) {
+            DEBUG_PANIC("create_u8_texture failed! | create_info.bytes_per_pixel must be 4 when compression is used, bytes_per_pixel=" << create_info.bytes_per_pixel)
+        }
+
+        TextureData data = encode_u8_texture(create_info);
+
+        return create_uncached_texture(TextureDataCreateInfo{
+            .data = &data,
+            .linear_filter = create_info.linear_filter
+        });
+    }
+
+    Texture texture = create_u8_texture_resources(create_info);
+
+    // The whole mip chain is generated on the CPU straight into the staging buffer and uploaded with a single copy
+    std::vector<MipLevel> levels = create_info.gen_mip_maps ?
+        MipGenerator::calculate_levels(create_info.width, create_info.height, create_info.bytes_per_pixel) :
+        std::vector<MipLevel>{ MipLevel{ .size = static_cast<usize>(create_info.width) * create_info.height * create_info.bytes_per_pixel, .width = create_info.width, .height = create_info.height } };
+
+    Handle<Buffer> staging_buffer = m_api.rm->create_buffer(BufferCreateInfo{
+        .size = levels.back().offset + levels.back().size,
+        .buffer_usage_flags = VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+        .memory_usage_flags = VMA_MEMORY_USAGE_CPU_TO_GPU
+    });
+
+    if(create_info.gen_mip_maps) {
+        MipGenerator::generate_into(get_mip_generate_info(create_info, true), static_cast<u8 *>(m_api.rm->map_buffer(staging_buffer)));
+        m_api.rm->flush_mapped_buffer(staging_buffer);
+        m_api.rm->unmap_buffer(staging_buffer);
     } else {
+        m_api.rm->memcpy_to_buffer_once(staging_buffer, create_info.pixel_data, levels[0].size);
+    }
+
+    m_api.record_and_submit_once([this, &texture, &levels, staging_buffer](Handle<CommandList> cmd) {
+        record_u8_texture_upload(cmd, texture, staging_buffer, get_mip_copy_regions(levels, 0U));
+    });
+    m_api.rm->destroy(staging_buffer);
+
+    return register_texture(texture);
+}
+Texture Renderer::create_u8_texture_resources(const TextureCreateInfo &create_info) {
+    VkFormat format = get_u8_texture_format(create_info.bytes_per_pixel, create_info.is_srgb);
+    if(format == VK_FORMAT_UNDEFINED) {
         DEBUG_PANIC("create_u8_texture failed! | create_info.bytes_per_pixel must be between 1 and 4, bytes_per_pixel=" << create_info.bytes_per_pixel)
     }
 
     DEBUG_ASSERT(m_shared.config_texture_anisotropy <= 16U)
 
     Texture texture{
+        .format = format,
         .width = static_cast<u16>(create_info.width),
         .height = static_cast<u16>(create_info.height),
         .bytes_per_pixel = static_cast<u16>(create_info.bytes_per_pixel),
@@ -782,7 +1638,7 @@ Handle<Texture> Renderer::create_u8_texture(const TextureCreateInfo &create_info
             .width = texture.width,
             .height = texture.height
         },
-        .usage_flags = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | (create_info.gen_mip_maps ? VK_IMAGE_USAGE_TRANSFER_SRC_BIT : static_cast<VkImageUsageFlags>(0)),
+        .usage_flags = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
         .aspect_flags = VK_IMAGE_ASPECT_COLOR_BIT,
         .mip_level_count = texture.mip_level_count
     });
@@ -796,41 +1652,26 @@ Handle<Texture> Renderer::create_u8_texture(const TextureCreateInfo &create_info
         .anisotropy = static_cast<f32>(m_shared.config_texture_anisotropy)
     });
 
-    Handle<Buffer> staging_buffer = m_api.rm->create_buffer(BufferCreateInfo{
-        .size = create_info.width * create_info.height * create_info.bytes_per_pixel,
-        .buffer_usage_flags = VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-        .memory_usage_flags = VMA_MEMORY_USAGE_CPU_TO_GPU
-    });
-
-    m_api.rm->memcpy_to_buffer_once(staging_buffer, create_info.pixel_data, create_info.width * create_info.height * create_info.bytes_per_pixel);
-    m_api.record_and_submit_once([this, &create_info, &texture, staging_buffer](Handle<CommandList> cmd) {
-        m_api.image_barrier(cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, {ImageBarrier{
-            .image_handle = texture.image,
-            .dst_access_mask = VK_ACCESS_TRANSFER_WRITE_BIT,
-            .new_layout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-        }});
-
-        m_api.copy_buffer_to_image(cmd, staging_buffer, texture.image, {BufferToImageCopy{}});
-
-        if (create_info.gen_mip_maps) {
-            m_api.gen_mipmaps(cmd, texture.image, create_info.linear_filter ? VK_FILTER_LINEAR : VK_FILTER_NEAREST,
-                VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_PIPELINE_STAGE_TRANSFER_BIT,
-                VK_ACCESS_TRANSFER_WRITE_BIT,
-                VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
-                VK_ACCESS_SHADER_READ_BIT
-            );
-        } else {
-            m_api.image_barrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, {ImageBarrier{
-                .image_handle = texture.image,
-                .src_access_mask = VK_ACCESS_TRANSFER_WRITE_BIT,
-                .dst_access_mask = VK_ACCESS_SHADER_READ_BIT,
-                .old_layout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-                .new_layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-            }});
-        }
-    });
-    m_api.rm->destroy(staging_buffer);
-
+    return texture;
+}
+void Renderer::record_u8_texture_upload(Handle<CommandList> cmd, const Texture &texture, Handle<Buffer> staging_buffer, const std::vector<BufferToImageCopy> &regions) {
+    m_api.image_barrier(cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, {ImageBarrier{
+        .image_handle = texture.image,
+        .dst_access_mask = VK_ACCESS_TRANSFER_WRITE_BIT,
+        .new_layout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+    }});
+
+    m_api.copy_buffer_to_image(cmd, staging_buffer, texture.image, regions);
+
+    m_api.image_barrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, {ImageBarrier{
+        .image_handle = texture.image,
+        .src_access_mask = VK_ACCESS_TRANSFER_WRITE_BIT,
+        .dst_access_mask = VK_ACCESS_SHADER_READ_BIT,
+        .old_layout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        .new_layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+    }});
+}
+Handle<Texture> Renderer::register_texture(const Texture &texture) {
     auto handle = m_texture_allocator.alloc(texture);
 
     m_api.rm->update_descriptor(m_shared.scene_texture_descriptor, DescriptorUpdateInfo{
@@ -848,17 +1689,499 @@ Handle<Texture> Renderer::create_u8_texture(const TextureCreateInfo &create_info
 
     return handle;
 }
+Handle<Texture> Renderer::create_texture(const TextureDataCreateInfo &create_info) {
+    if(!create_info.data) {
+        DEBUG_PANIC("create_texture failed! | create_info.data cannot be nullptr!")
+    }
+
+    u64 hash = hash_texture_data_create_info(create_info);
+    TextureRegistryKey key{
+        .width = create_info.data->width,
+        .height = create_info.data->height,
+        .format = create_info.data->format
+    };
+    if(Handle<Texture> cached_handle = m_texture_registry.acquire(hash, key); cached_handle != INVALID_HANDLE) {
+        return cached_handle;
+    }
+
+    auto handle = create_uncached_texture(create_info);
+    m_texture_registry.add(hash, key, handle);
+
+    return handle;
+}
+Handle<Texture> Renderer::create_uncached_texture(const TextureDataCreateInfo &create_info) {
+    const TextureData &data = *create_info.data;
+
+    if(data.mips.empty() || data.bytes.empty()) {
+        DEBUG_PANIC("create_texture failed! | create_info.data must contain at least one mip!")
+    }
+    if(data.width == 0U || data.height == 0U) {
+        DEBUG_PANIC("create_texture failed! | create_info.data width and height must be greater than 0!")
+    }
+    if(TextureFile::get_format_block_size(data.format) == 0U) {
+        DEBUG_PANIC("create_texture failed! | Unsupported texture format: " << data.format)
+    }
+
+    DEBUG_ASSERT(m_shared.config_texture_anisotropy <= 16U)
+
+    bool is_block_compressed = TextureFile::is_block_compressed(data.format);
+
+    // Block compressed mips must come pre-generated, uncompressed ones are generated on the CPU and the texture is created from the whole chain
+    if(create_info.gen_mip_maps && data.mips.size() == 1U) {
+        if(is_block_compressed) {
+            DEBUG_WARNING("create_texture | Cannot generate mips for a block compressed texture, the texture will have only one mip level")
+        } else {
+            MipChain chain = MipGenerator::generate(MipGenerateInfo{
+                .pixels = data.bytes.data() + data.mips[0].offset,
+                .width = data.width,
+                .height = data.height,
+                .channels = TextureFile::get_format_block_size(data.format),
+                .is_srgb = TextureFile::is_srgb(data.format)
+            });
+
+            TextureData mipped_data{
+                .format = data.format,
+                .width = data.width,
+                .height = data.height,
+                .bytes = std::move(chain.bytes)
+            };
+            for(const auto &level : chain.levels) {
+                mipped_data.mips.push_back(TextureDataMip{ .offset = level.offset, .size = level.size, .width = level.width, .height = level.height });
+            }
+
+            return create_uncached_texture(TextureDataCreateInfo{
+                .data = &mipped_data,
+                .linear_filter = create_info.linear_filter
+            });
+        }
+    }
+
+    // Textures with pre-generated mips are created with only their low mips, the rest is loaded from the source file when the GPU feedback requests it
+    bool is_streamed = m_shared.config_enable_texture_streaming && data.mips.size() > 1U && !create_info.source_path.empty();
+
+    u32 first_mip{};
+    if(is_streamed) {
+        while(first_mip + 1U < static_cast<u32>(data.mips.size()) && std::max(data.mips[first_mip].width, data.mips[first_mip].height) > TEXTURE_STREAMING_IMPORT_SIZE) {
+            ++first_mip;
+        }
+    }
+
+    Texture texture{
+        .format = data.format,
+        .width = static_cast<u16>(data.width),
+        .height = static_cast<u16>(data.height),
+        .bytes_per_pixel = static_cast<u16>(is_block_compressed ? 0U : TextureFile::get_format_block_size(data.format)),
+        .mip_level_count = static_cast<u16>(data.mips.size()),
+        .is_srgb = static_cast<u16>(TextureFile::is_srgb(data.format)),
+        .use_linear_filter = static_cast<u16>(create_info.linear_filter)
+    };
+
+    texture.sampler = m_api.rm->create_sampler(SamplerCreateInfo{
+        .filter = create_info.linear_filter ? VK_FILTER_LINEAR : VK_FILTER_NEAREST,
+        .mipmap_mode = create_info.linear_filter ? VK_SAMPLER_MIPMAP_MODE_LINEAR : VK_SAMPLER_MIPMAP_MODE_NEAREST,
+
+        .max_mipmap = static_cast<f32>(texture.mip_level_count),
+        .mipmap_bias = m_shared.config_texture_mip_bias,
+        .anisotropy = static_cast<f32>(m_shared.config_texture_anisotropy)
+    });
+
+    upload_texture_mips(texture, data, first_mip);
+
+    auto handle = register_texture(texture);
+
+    if(is_streamed) {
+        StreamedTexture streamed{
+            .source_path = create_info.source_path,
+            .data {
+                .format = data.format,
+                .width = data.width,
+                .height = data.height,
+                .mips = data.mips
+            },
+            .import_mip = first_mip,
+            .desired_mip = first_mip,
+            .last_requested_frame = m_shared.frames_since_init
+        };
+
+        // The mips above the import mips keep only their size, their offset is meaningless
+        for(u32 i{}; i < static_cast<u32>(data.mips.size()); ++i) {
+            TextureDataMip &mip = streamed.data.mips[i];
+            if(i < first_mip) {
+                mip.offset = 0U;
+                continue;
+            }
+
+            mip.offset = streamed.data.bytes.size();
+            streamed.data.bytes.insert(streamed.data.bytes.end(), data.bytes.begin() + static_cast<i64>(data.mips[i].offset), data.bytes.begin() + static_cast<i64>(data.mips[i].offset + data.mips[i].size));
+        }
+
+        m_streamed_textures[handle] = std::move(streamed);
+
+        m_streamed_texture_resident_bytes += calculate_resident_texture_size(data, first_mip);
+    }
+
+    return handle;
+}
 void Renderer::destroy(Handle<Texture> texture_handle) {
     if(!m_texture_allocator.is_handle_valid(texture_handle)) {
         DEBUG_PANIC("Cannot delete texture - Texture with a handle id: " << texture_handle << ", does not exist!")
     }
 
+    if(!m_texture_registry.release(texture_handle)) {
+        return;
+    }
+
     const Texture &texture = m_texture_allocator.get_element(texture_handle);
     m_api.rm->destroy(texture.image);
     m_api.rm->destroy(texture.sampler);
 
+    if(m_streamed_textures.contains(texture_handle)) {
+        const auto &streamed = m_streamed_textures.at(texture_handle);
+        m_streamed_texture_resident_bytes -= calculate_resident_texture_size(streamed.data, streamed.pending_mip.value_or(texture.resident_mip));
+
+        // The transfer queue may still be writing the image of an upload in flight, it's destroyed with the other retired images of its slot
+        if(streamed.pending_mip.has_value()) {
+            for(auto &frame : m_frames) {
+                for(usize i{}; i < frame.texture_uploads.size(); ++i) {
+                    if(frame.texture_uploads[i].texture == texture_handle) {
+                        frame.retired_texture_images.push_back(frame.texture_uploads[i].image);
+                        frame.texture_uploads.erase(frame.texture_uploads.begin() + static_cast<i64>(i));
+                        break;
+                    }
+                }
+            }
+        }
+
+        m_streamed_textures.erase(texture_handle);
+    }
+
     m_texture_allocator.free(texture_handle);
 }
+Handle<Image> Renderer::create_texture_image(const TextureData &data, u32 first_mip) {
+    DEBUG_ASSERT(first_mip < static_cast<u32>(data.mips.size()))
+
+    return m_api.rm->create_image(ImageCreateInfo{
+        .format = data.format,
+        .extent {
+            .width = data.mips[first_mip].width,
+            .height = data.mips[first_mip].height
+        },
+        .usage_flags = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT,
+        .aspect_flags = VK_IMAGE_ASPECT_COLOR_BIT,
+        .mip_level_count = static_cast<u32>(data.mips.size()) - first_mip
+    });
+}
+std::vector<BufferToImageCopy> Renderer::copy_texture_mips_to_staging(void *staging_ptr, usize staging_offset, const TextureData &data, u32 first_mip) const {
+    // One region per resident mip, packed tightly in the staging buffer
+    std::vector<BufferToImageCopy> regions{};
+
+    for(u32 i = first_mip; i < static_cast<u32>(data.mips.size()); ++i) {
+        const TextureDataMip &mip = data.mips[i];
+
+        m_api.rm->memcpy_to_buffer(staging_ptr, data.bytes.data(), mip.size, staging_offset, mip.offset);
+        regions.push_back(BufferToImageCopy{
+            .src_buffer_offset = staging_offset,
+            .dst_image_extent_override {
+                .width = mip.width,
+                .height = mip.height,
+                .depth = 1U
+            },
+            .mipmap_level_override = i - first_mip
+        });
+
+        staging_offset += mip.size;
+    }
+
+    return regions;
+}
+void Renderer::upload_texture_mips(Texture &texture, const TextureData &data, u32 first_mip) {
+    texture.resident_mip = static_cast<u16>(first_mip);
+    texture.image = create_texture_image(data, first_mip);
+
+    Handle<Buffer> staging_buffer = m_api.rm->create_buffer(BufferCreateInfo{
+        .size = calculate_resident_texture_size(data, first_mip),
+        .buffer_usage_flags = VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+        .memory_usage_flags = VMA_MEMORY_USAGE_CPU_TO_GPU
+    });
+
+    void *mapped = m_api.rm->map_buffer(staging_buffer);
+    std::vector<BufferToImageCopy> regions = copy_texture_mips_to_staging(mapped, 0U, data, first_mip);
+
+    m_api.rm->flush_mapped_buffer(staging_buffer);
+    m_api.rm->unmap_buffer(staging_buffer);
+
+    m_api.record_and_submit_once([this, &texture, &regions, staging_buffer](Handle<CommandList> cmd) {
+        m_api.image_barrier(cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, {ImageBarrier{
+            .image_handle = texture.image,
+            .dst_access_mask = VK_ACCESS_TRANSFER_WRITE_BIT,
+            .new_layout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        }});
+
+        m_api.copy_buffer_to_image(cmd, staging_buffer, texture.image, regions);
+
+        m_api.image_barrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, {ImageBarrier{
+            .image_handle = texture.image,
+            .src_access_mask = VK_ACCESS_TRANSFER_WRITE_BIT,
+            .dst_access_mask = VK_ACCESS_SHADER_READ_BIT,
+            .old_layout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            .new_layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+        }});
+    });
+    m_api.rm->destroy(staging_buffer);
+}
+usize Renderer::calculate_resident_texture_size(const TextureData &data, u32 first_mip) const {
+    usize size{};
+    for(u32 i = first_mip; i < static_cast<u32>(data.mips.size()); ++i) {
+        size += data.mips[i].size;
+    }
+
+    return size;
+}
+void Renderer::update_texture_streaming() {
+    Frame &frame = m_frames[m_frame_in_flight_index];
+
+    // After the fence wait the uploads recorded in this slot have completed and no frame in flight samples the images retired in it
+    for(const auto &image : frame.retired_texture_images) {
+        m_api.rm->destroy(image);
+    }
+    frame.retired_texture_images.clear();
+
+    // Without a dedicated transfer family the release barrier already did the whole layout transition
+    bool ownership_transfer = m_api.rm->get_queue_family_index(QueueFamily::Transfer) != m_api.rm->get_queue_family_index(QueueFamily::Graphics);
+
+    for(const auto &upload : frame.texture_uploads) {
+        Texture &texture = m_texture_allocator.get_element_mutable(upload.texture);
+        m_streamed_textures.at(upload.texture).pending_mip.reset();
+
+        // Frames still in flight may sample the old image, so it waits for this slot to come around again
+        frame.retired_texture_images.push_back(texture.image);
+
+        texture.image = upload.image;
+        texture.resident_mip = static_cast<u16>(upload.mip);
+
+        m_api.rm->update_descriptor(m_shared.scene_texture_descriptor, DescriptorUpdateInfo{
+            .bindings{
+                DescriptorBindingUpdateInfo{
+                    .binding_index = 0U,
+                    .array_index = upload.texture.as_u32(),
+                    .image_info {
+                        .image_handle = texture.image,
+                        .image_sampler = texture.sampler
+                    }
+                }
+            }
+        });
+
+        if(ownership_transfer) {
+            frame.texture_acquire_barriers.push_back(ImageBarrier{
+                .image_handle = texture.image,
+                .dst_access_mask = VK_ACCESS_SHADER_READ_BIT,
+                .old_layout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                .new_layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                .src_queue_family = QueueFamily::Transfer,
+                .dst_queue_family = QueueFamily::Graphics
+            });
+        }
+    }
+    frame.texture_uploads.clear();
+    frame.transfer_submitted = false;
+
+    if(m_streamed_textures.empty()) {
+        return;
+    }
+
+    DEBUG_TIMESTAMP(start);
+
+    m_api.rm->invalidate_mapped_buffer(frame.texture_feedback_buffer);
+
+    u32 current_frame = m_shared.frames_since_init;
+
+    std::vector<Handle<Texture>> requested_loads{};
+    std::vector<std::pair<Handle<Texture>, u32>> changes{};
+
+    for(auto &[handle, streamed] : m_streamed_textures) {
+        const Texture &texture = m_texture_allocator.get_element(handle);
+
+        // Feedback holds log2 of the requested mip width + 1, 0 means that the texture wasn't sampled
+        u32 feedback = frame.texture_feedback_ptr[handle.as_u32()];
+        if(feedback != 0U) {
+            u32 requested_width_log2 = feedback - 1U;
+            u32 width_log2 = static_cast<u32>(std::bit_width(static_cast<u32>(texture.width))) - 1U;
+
+            u32 desired_mip = (width_log2 > requested_width_log2) ? (width_log2 - requested_width_log2) : 0U;
+
+            // Without a source only the import mips are available
+            streamed.desired_mip = streamed.source_path.empty() ? streamed.import_mip : std::min(desired_mip, streamed.import_mip);
+            streamed.last_requested_frame = current_frame;
+
+            // Mips that don't fit the staging buffer of a frame can't be streamed in
+            while(streamed.desired_mip < streamed.import_mip && calculate_resident_texture_size(streamed.data, streamed.desired_mip) > PER_FRAME_TEXTURE_STREAMING_UPLOAD_SIZE) {
+                ++streamed.desired_mip;
+            }
+        } else if(current_frame - streamed.last_requested_frame > TEXTURE_STREAMING_EVICT_FRAMES) {
+            streamed.desired_mip = streamed.import_mip;
+        }
+
+        // Reconsidered once its image has been swapped in
+        if(streamed.pending_mip.has_value()) {
+            continue;
+        }
+
+        if(streamed.desired_mip < texture.resident_mip) {
+            requested_loads.push_back(handle);
+        } else if(streamed.desired_mip > texture.resident_mip + 1U || (streamed.desired_mip == streamed.import_mip && streamed.desired_mip > texture.resident_mip)) {
+            // One mip of hysteresis so that textures at a mip transition don't get reloaded every frame
+            changes.emplace_back(handle, streamed.desired_mip);
+        }
+    }
+
+    usize resident_bytes = m_streamed_texture_resident_bytes;
+    usize uploaded_bytes{};
+    for(const auto &[handle, mip] : changes) {
+        const auto &streamed = m_streamed_textures.at(handle);
+        resident_bytes -= calculate_resident_texture_size(streamed.data, m_texture_allocator.get_element(handle).resident_mip);
+        resident_bytes += calculate_resident_texture_size(streamed.data, mip);
+        uploaded_bytes += calculate_resident_texture_size(streamed.data, mip);
+    }
+
+    // Largest resolution deficit first
+    std::sort(requested_loads.begin(), requested_loads.end(), [this](Handle<Texture> left, Handle<Texture> right) {
+        u32 l_deficit = m_texture_allocator.get_element(left).resident_mip - m_streamed_textures.at(left).desired_mip;
+        u32 r_deficit = m_texture_allocator.get_element(right).resident_mip - m_streamed_textures.at(right).desired_mip;
+        return l_deficit > r_deficit;
+    });
+
+    // Settled textures which weren't requested this frame can be evicted to their import mips when the budget is exceeded, least recently requested first
+    std::vector<Handle<Texture>> eviction_candidates{};
+    for(const auto &[handle, streamed] : m_streamed_textures) {
+        u32 resident_mip = m_texture_allocator.get_element(handle).resident_mip;
+        if(streamed.last_requested_frame != current_frame && !streamed.pending_mip.has_value() && streamed.desired_mip == resident_mip && resident_mip < streamed.import_mip) {
+            eviction_candidates.push_back(handle);
+        }
+    }
+    std::sort(eviction_candidates.begin(), eviction_candidates.end(), [this](Handle<Texture> left, Handle<Texture> right) {
+        return m_streamed_textures.at(left).last_requested_frame > m_streamed_textures.at(right).last_requested_frame;
+    });
+
+    usize budget = static_cast<usize>(m_shared.config_texture_streaming_budget_mb) * 1024ull * 1024ull;
+
+    for(const auto &handle : requested_loads) {
+        const auto &streamed = m_streamed_textures.at(handle);
+        const Texture &texture = m_texture_allocator.get_element(handle);
+
+        usize current_size = calculate_resident_texture_size(streamed.data, texture.resident_mip);
+        usize new_size = calculate_resident_texture_size(streamed.data, streamed.desired_mip);
+
+        if(uploaded_bytes + new_size > PER_FRAME_TEXTURE_STREAMING_UPLOAD_SIZE) {
+            break;
+        }
+
+        while(resident_bytes - current_size + new_size > budget && !eviction_candidates.empty()) {
+            Handle<Texture> evicted = eviction_candidates.back();
+            eviction_candidates.pop_back();
+
+            auto &evicted_streamed = m_streamed_textures.at(evicted);
+            evicted_streamed.desired_mip = evicted_streamed.import_mip;
+
+            resident_bytes -= calculate_resident_texture_size(evicted_streamed.data, m_texture_allocator.get_element(evicted).resident_mip);
+            resident_bytes += calculate_resident_texture_size(evicted_streamed.data, evicted_streamed.import_mip);
+            uploaded_bytes += calculate_resident_texture_size(evicted_streamed.data, evicted_streamed.import_mip);
+
+            changes.emplace_back(evicted, evicted_streamed.import_mip);
+        }
+
+        if(resident_bytes - current_size + new_size > budget) {
+            break;
+        }
+
+        resident_bytes = resident_bytes - current_size + new_size;
+        uploaded_bytes += new_size;
+
+        changes.emplace_back(handle, streamed.desired_mip);
+    }
+
+    // Each change gets a new image, filled from this slot's staging buffer on the transfer queue without waiting for the other frames
+    std::vector<std::pair<Handle<Image>, std::vector<BufferToImageCopy>>> copies{};
+    usize staging_offset{};
+
+    for(const auto &[handle, mip] : changes) {
+        auto &streamed = m_streamed_textures.at(handle);
+        const Texture &texture = m_texture_allocator.get_element(handle);
+
+        // Aligned for the texel blocks of the compressed formats, the changes that don't fit are retried in the following frames
+        usize offset = Utils::align(16U, staging_offset);
+        usize size = calculate_resident_texture_size(streamed.data, mip);
+        if(offset + size > PER_FRAME_TEXTURE_STREAMING_UPLOAD_SIZE) {
+            continue;
+        }
+
+        // Only the import mips are kept in memory, higher ones are read from the source file again
+        TextureData reloaded_data{};
+        if(mip < streamed.import_mip && !reload_texture_data(streamed.source_path, streamed.data, reloaded_data)) {
+            DEBUG_WARNING("Failed to reload the mips of a streamed texture from \"" << streamed.source_path << "\", it will keep its import mips")
+
+            streamed.source_path.clear();
+            streamed.desired_mip = streamed.import_mip;
+            continue;
+        }
+        const TextureData &mip_data = (mip < streamed.import_mip) ? reloaded_data : streamed.data;
+
+        Handle<Image> image = create_texture_image(mip_data, mip);
+        copies.emplace_back(image, copy_texture_mips_to_staging(frame.texture_staging_ptr, offset, mip_data, mip));
+        staging_offset = offset + size;
+
+        m_streamed_texture_resident_bytes -= calculate_resident_texture_size(streamed.data, texture.resident_mip);
+        m_streamed_texture_resident_bytes += size;
+
+        streamed.pending_mip = mip;
+        frame.texture_uploads.push_back(StreamedTextureUpload{
+            .texture = handle,
+            .image = image,
+            .mip = mip
+        });
+    }
+
+    if(!copies.empty()) {
+        m_api.rm->flush_mapped_buffer(frame.texture_staging_buffer, staging_offset);
+
+        m_api.reset_commands(frame.transfer_command_list);
+        m_api.begin_recording_commands(frame.transfer_command_list);
+
+        std::vector<ImageBarrier> transfer_barriers{};
+        std::vector<ImageBarrier> release_barriers{};
+        for(const auto &[image, regions] : copies) {
+            transfer_barriers.push_back(ImageBarrier{
+                .image_handle = image,
+                .dst_access_mask = VK_ACCESS_TRANSFER_WRITE_BIT,
+                .new_layout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL
+            });
+            release_barriers.push_back(ImageBarrier{
+                .image_handle = image,
+                .src_access_mask = VK_ACCESS_TRANSFER_WRITE_BIT,
+                .old_layout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                .new_layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                .src_queue_family = ownership_transfer ? std::optional(QueueFamily::Transfer) : std::nullopt,
+                .dst_queue_family = ownership_transfer ? std::optional(QueueFamily::Graphics) : std::nullopt
+            });
+        }
+
+        m_api.image_barrier(frame.transfer_command_list, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, transfer_barriers);
+        for(const auto &[image, regions] : copies) {
+            m_api.copy_buffer_to_image(frame.transfer_command_list, frame.texture_staging_buffer, image, regions);
+        }
+        m_api.image_barrier(frame.transfer_command_list, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, release_barriers);
+
+        m_api.end_recording_commands(frame.transfer_command_list);
+        m_api.submit_commands(frame.transfer_command_list, SubmitInfo{
+            .signal_semaphores{ frame.transfer_semaphore }
+        });
+
+        frame.transfer_submitted = true;
+    }
+
+    DEBUG_TIMESTAMP(stop);
+    frame.cpu_timing[__FUNCTION__] = DEBUG_TIME_DIFF(start, stop);
+}
 
 Handle<Material> Renderer::create_material(const MaterialCreateInfo &create_info) {
     Material material{
@@ -869,6 +2192,11 @@ Handle<Material> Renderer::create_material(const MaterialCreateInfo &create_info
         .color = create_info.color
     };
 
+    u64 hash = Utils::hash_bytes(&material, sizeof(Material));
+    if(Handle<Material> cached_handle = m_material_registry.acquire(hash, material); cached_handle != INVALID_HANDLE) {
+        return cached_handle;
+    }
+
     Handle<Buffer> staging_buffer = m_api.rm->create_buffer(BufferCreateInfo{
         .size = sizeof(Material),
         .buffer_usage_flags = VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
@@ -890,6 +2218,8 @@ Handle<Material> Renderer::create_material(const MaterialCreateInfo &create_info
 
     m_api.rm->destroy(staging_buffer);
 
+    m_material_registry.add(hash, material, handle);
+
     return handle;
 }
 void Renderer::destroy(Handle<Material> material_handle) {
@@ -897,5 +2227,9 @@ void Renderer::destroy(Handle<Material> material_handle) {
         DEBUG_PANIC("Cannot delete material - Material with a handle id: " << material_handle << ", does not exist!")
     }
 
+    if(!m_material_registry.release(material_handle)) {
+        return;
+    }
+
     m_material_allocator.free(material_handle);
 }
\ No newline at end of file
@@ -9,6 +9,13 @@ struct RendererSharedObjects;
 
 typedef void (*UIPassDrawFn)(World &world);
 
+// Storage of the G-Buffer normals, the values match GPU_NORMAL_ENCODING_*
+enum struct GBufferLayout : u32 {
+    Full = 0u, // RGBA32F, 16 bytes per pixel
+    Octahedral16 = 1u, // R16G16_SNORM, 4 bytes per pixel
+    Octahedral10 = 2u, // A2B10G10R10_UNORM, 4 bytes per pixel
+};
+
 struct RendererSharedObjects {
     // Config start
     float config_global_lod_bias{};
@@ -18,15 +25,30 @@ struct RendererSharedObjects {
     bool config_enable_debug_shape_view = false;
     f32 config_debug_shape_opacity = 0.3f;
     f32 config_lod_sphere_visible_angle = 0.01f;
+    f32 config_lod_error_threshold = 1.0f; // The coarsest LOD with a projected geometric error below this many pixels is drawn
+    bool config_enable_cluster_cull = true;
+    f32 config_cluster_cull_min_pixel_size = 0.5f; // Meshlets with a smaller projected bounding sphere diameter are culled
+    bool config_enable_vertex_quantization = false; // Stores vertices as CompactVertex, only affects meshes created after the change
+    bool config_enable_occlusion_cull = true; // Two phase culling against a depth pyramid built from the objects visible last frame
+    bool config_enable_visibility_buffer = false; // Rasterizes only triangle ids and shades every pixel once in the Material Pass
+    GBufferLayout config_gbuffer_layout = GBufferLayout::Full;
+    bool config_enable_dynamic_resolution = false; // Scales the rendered area of the screen images to meet the target GPU frame time
+    f32 config_dynamic_resolution_target_ms = 16.6f;
+    f32 config_dynamic_resolution_min_scale = 0.5f;
+    bool config_enable_async_compute = true; // Runs the PassQueue::AsyncCompute passes on a separate compute queue if the device has one
 
     u32 config_ssao_samples = 32U;
     f32 config_ssao_radius = 1.0f;
     f32 config_ssao_bias = 0.025;
     f32 config_ssao_multiplier = 1.0f;
     f32 config_ssao_noise_scale_divider = 4.0f;
+    bool config_enable_half_res_ssao = false; // Compute SSAO at half resolution, accumulated over frames and upsampled
+    u32 config_ssao_half_res_samples = 12U; // Per frame, the temporal accumulation makes up for the low count
 
     u32 config_texture_anisotropy = 8U;
     float config_texture_mip_bias = 0.0f;
+    bool config_enable_texture_streaming = true; // Only affects textures created after the change
+    u32 config_texture_streaming_budget_mb = 512U;
     // Config end
 
     UIPassDrawFn ui_pass_draw_fn{};
@@ -34,6 +56,11 @@ struct RendererSharedObjects {
     u32 frames_since_init{};
     u32 swapchain_target_index{};
 
+    // The screen images are allocated at the window size, everything before the Offscreen To Swapchain Pass renders to their top left render_extent
+    // The main camera's viewport_size on the GPU is set to render_extent too
+    f32 render_scale = 1.0f;
+    VkExtent2D render_extent{};
+
     Handle<Image> offscreen_image{};
     Handle<Sampler> offscreen_sampler{};
 
@@ -42,6 +69,10 @@ struct RendererSharedObjects {
     Handle<Image> depth_image{};
     Handle<Image> albedo_image{};
     Handle<Image> normal_image{};
+    Handle<Image> visibility_image{}; // GPU_VISIBILITY_* texels written by the Geometry Passes if config_enable_visibility_buffer is set
+
+    Handle<Image> depth_pyramid_image{}; // Farthest depth of every texel, level 0 is the previous power of two of the screen size
+    Handle<Sampler> depth_pyramid_sampler{};
 
     Handle<Material> default_material{};
     Handle<Texture> default_white_srgb_texture{};
@@ -50,16 +81,49 @@ struct RendererSharedObjects {
     Handle<Descriptor> scene_texture_descriptor{};
     Handle<Buffer> scene_vertex_buffer{};
     Handle<Buffer> scene_index_buffer{};
+    Handle<Buffer> scene_index16_buffer{};
     Handle<Buffer> scene_primitive_buffer{};
     Handle<Buffer> scene_mesh_buffer{};
     Handle<Buffer> scene_mesh_instance_buffer{};
     Handle<Buffer> scene_mesh_instance_materials_buffer{};
     Handle<Buffer> scene_object_buffer{};
+    Handle<Buffer> scene_renderable_object_buffer{}; // Compacted ids of the objects that draw call generation runs over
     Handle<Buffer> scene_global_transform_buffer{};
     Handle<Buffer> scene_material_buffer{};
     Handle<Buffer> scene_camera_buffer{};
-    Handle<Buffer> scene_draw_buffer{};
-    Handle<Buffer> scene_draw_count_buffer{};
+    Handle<Buffer> scene_view_buffer{}; // GPU_MAX_VIEW_COUNT cameras culled by draw call generation, the first one is the main camera
+    Handle<Buffer> scene_draw_buffer{}; // One bucket of scene_draw_capacity draws per view and GPU_INDEX_TYPE_*, the main camera comes first
+    Handle<Buffer> scene_draw_count_buffer{}; // One count per bucket
+    Handle<Buffer> scene_late_draw_buffer{}; // Same layout as scene_draw_buffer, filled by the late occlusion cull phase
+    Handle<Buffer> scene_late_draw_count_buffer{};
+    Handle<Buffer> scene_draw_instance_buffer{}; // Per instance object and primitive, indexed with gl_InstanceIndex
+    Handle<Buffer> scene_draw_instance_dispatch_buffer{}; // DrawInstanceDispatch of the early phase
+    Handle<Buffer> scene_late_draw_instance_buffer{};
+    Handle<Buffer> scene_late_draw_instance_dispatch_buffer{};
+    Handle<Buffer> scene_visible_instance_buffer{}; // Scratch of both phases, culled instances before bucketing
+    Handle<Buffer> scene_draw_bucket_count_buffer{}; // One count per (primitive, LOD), reset after every phase
+    Handle<Buffer> scene_draw_bucket_offset_buffer{}; // Exclusive prefix sum of the bucket counts
+    Handle<Buffer> scene_draw_bucket_block_buffer{}; // Sums of every GPU_DRAW_BUCKET_SCAN_BLOCK_SIZE buckets
+    Handle<Buffer> scene_visibility_buffer{}; // One bit per object, set if it was visible in the last frame
+    Handle<Buffer> scene_occlusion_stats_buffer{};
+    Handle<Buffer> scene_texture_feedback_buffer{};
+    Handle<Buffer> scene_meshlet_buffer{};
+    Handle<Buffer> scene_cluster_job_buffer{};
+    Handle<Buffer> scene_cluster_dispatch_buffer{};
+    Handle<Buffer> scene_light_buffer{}; // Indexed by the light handles
+    Handle<Buffer> scene_light_cluster_count_buffer{}; // Lights binned into every cluster of the main camera
+    Handle<Buffer> scene_light_cluster_index_buffer{}; // GPU_LIGHT_CLUSTER_MAX_LIGHTS light ids per cluster
+
+    u32 scene_renderable_object_count{};
+    u32 scene_light_count{}; // Highest light handle + 1, including the destroyed lights below it
+    u32 scene_view_count = 1u;
+    u32 scene_draw_capacity{}; // Per view and index type bucket, depends on scene_view_count
+    u32 scene_draw_bucket_count{}; // Per view, GPU_MAX_LOD_COUNT for every primitive up to the high-water mark of the primitive allocator
+    u32 scene_visible_instance_capacity{};
+    u32 scene_draw_instance_capacity{};
+    u32 scene_cluster_job_capacity{};
+    u32 scene_cluster_index_start{}; // Compacted cluster indices are written to the end of scene_index_buffer
+    u32 scene_cluster_index_capacity{};
 };
 
 #endif
\ No newline at end of file
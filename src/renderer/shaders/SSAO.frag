@@ -1,8 +1,10 @@
 #version 450
 
+#include "common.glsl"
 #include "../gpu_types.inl"
 
 layout (constant_id = 0) const uint SAMPLE_COUNT = 32u;
+layout (constant_id = 1) const uint NORMAL_ENCODING = GPU_NORMAL_ENCODING_FLOAT;
 
 layout(location = 0) in vec2 f_texcoord;
 
@@ -50,13 +52,17 @@ const vec3 rotations[16] = vec3[16](
     vec3( 0.432201, 0.378429, 0.0), vec3( 0.976759, 0.496303, 0.0), vec3( 0.440987, -0.098916, 0.0), vec3( 0.825155,-0.832357, 0.0)
 );
 
+vec2 get_image_uv(vec2 uv) {
+    return get_render_image_uv(uv, camera.viewport_size, vec2(textureSize(in_depth, 0)));
+}
+
 float get_view_z(vec2 uv) {
-    float depth = texture(in_depth, uv).r;
+    float depth = texture(in_depth, get_image_uv(uv)).r;
 
     return camera.inv_proj[3][2] / (camera.inv_proj[2][3] * depth + camera.inv_proj[3][3]);
 }
 vec3 get_view_position(vec2 uv) {
-    float depth = texture(in_depth, uv).r;
+    float depth = texture(in_depth, get_image_uv(uv)).r;
 
     vec4 ndc = vec4(uv * 2.0 - 1.0, depth, 1.0);
     vec4 view = camera.inv_proj * ndc;
@@ -70,7 +76,7 @@ void main() {
     vec2 noise_scale = vec2(float(screen_width), float(screen_height)) / noise_scale_divider;
 
     vec3 view_pos = get_view_position(f_texcoord);
-    vec3 view_normal = texture(in_normal, f_texcoord).xyz;
+    vec3 view_normal = decode_gbuffer_normal(texture(in_normal, get_image_uv(f_texcoord)), NORMAL_ENCODING);
 
     int x = int(f_texcoord.x * noise_scale.x) % 4;
     int y = int(f_texcoord.y * noise_scale.y) % 4;
@@ -0,0 +1,65 @@
+#version 450
+
+#include "../gpu_types.inl"
+
+layout(location = 0) in vec2 f_texcoord;
+
+layout(location = 0) out float out_ssao;
+
+layout(set = 0, binding = 0) uniform sampler2D in_depth;
+layout(set = 0, binding = 1) uniform sampler2D in_half_depth;
+layout(set = 0, binding = 2) uniform sampler2D in_history;
+layout(set = 0, binding = 3) uniform CameraBuffer {
+    Camera camera;
+};
+
+// Depth difference, relative to the pixel's view depth, at which a half resolution texel's weight falls to 1/e
+const float DEPTH_SIGMA = 0.02;
+
+float get_view_z(float depth) {
+    return camera.inv_proj[3][2] / (camera.inv_proj[2][3] * depth + camera.inv_proj[3][3]);
+}
+
+void main() {
+    // Reverse Z, nothing was drawn here
+    float depth = texelFetch(in_depth, ivec2(gl_FragCoord.xy), 0).r;
+    if (depth == 0.0) {
+        out_ssao = 1.0;
+        return;
+    }
+
+    float view_z = get_view_z(depth);
+
+    // Half of the rendered area, f_texcoord spans just that area too
+    ivec2 half_size = (ivec2(camera.viewport_size) + 1) / 2;
+    vec2 half_position = f_texcoord * vec2(half_size) - 0.5;
+    ivec2 base = ivec2(floor(half_position));
+    vec2 fraction = half_position - vec2(base);
+
+    float ao_sum = 0.0;
+    float weight_sum = 0.0;
+    float nearest_ao = 1.0;
+    float nearest_distance = 1e30;
+
+    // Bilinear weights of the 4 closest half resolution texels, scaled down for texels of other surfaces
+    for (int i = 0; i < 4; ++i) {
+        ivec2 offset = ivec2(i & 1, i >> 1);
+        ivec2 texel = clamp(base + offset, ivec2(0), half_size - 1);
+
+        vec2 bilinear = mix(1.0 - fraction, fraction, vec2(offset));
+        float distance = abs(view_z - get_view_z(texelFetch(in_half_depth, texel, 0).r));
+        float weight = bilinear.x * bilinear.y * exp(-distance / (abs(view_z) * DEPTH_SIGMA));
+
+        float ao = texelFetch(in_history, texel, 0).r;
+        ao_sum += ao * weight;
+        weight_sum += weight;
+
+        if (distance < nearest_distance) {
+            nearest_distance = distance;
+            nearest_ao = ao;
+        }
+    }
+
+    // Thin features lost by the downsample match none of the texels well, the closest depth is the best guess
+    out_ssao = weight_sum > 1e-4 ? ao_sum / weight_sum : nearest_ao;
+}
@@ -1,4 +1,105 @@
+#include "../gpu_types.inl"
+
 vec3 rotate_vq(vec3 v, vec4 q) {
     // wxyz quaterions
     return v + 2.0 * cross(q.yzw, cross(q.yzw, v) + q.x * v);
-}
\ No newline at end of file
+}
+
+vec3 decode_octahedral(vec2 e) {
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0);
+    n.xy += vec2(n.x >= 0.0 ? -t : t, n.y >= 0.0 ? -t : t);
+    return normalize(n);
+}
+
+vec2 encode_octahedral(vec3 n) {
+    n /= abs(n.x) + abs(n.y) + abs(n.z);
+    vec2 e = n.xy;
+    if (n.z < 0.0) {
+        e = (1.0 - abs(e.yx)) * vec2(e.x >= 0.0 ? 1.0 : -1.0, e.y >= 0.0 ? 1.0 : -1.0);
+    }
+    return e;
+}
+
+// 'encoding' is GPU_NORMAL_ENCODING_*, usually a specialization constant so that the branches are compiled out
+vec4 encode_gbuffer_normal(vec3 n, uint encoding) {
+    if (encoding == GPU_NORMAL_ENCODING_OCTAHEDRAL_SNORM) {
+        return vec4(encode_octahedral(n), 0.0, 0.0);
+    } else if (encoding == GPU_NORMAL_ENCODING_OCTAHEDRAL_UNORM) {
+        return vec4(encode_octahedral(n) * 0.5 + 0.5, 0.0, 1.0);
+    }
+
+    return vec4(n, 1.0);
+}
+vec3 decode_gbuffer_normal(vec4 texel, uint encoding) {
+    if (encoding == GPU_NORMAL_ENCODING_OCTAHEDRAL_SNORM) {
+        return decode_octahedral(texel.xy);
+    } else if (encoding == GPU_NORMAL_ENCODING_OCTAHEDRAL_UNORM) {
+        return decode_octahedral(texel.xy * 2.0 - 1.0);
+    }
+
+    return texel.xyz;
+}
+
+
+// Light clusters slice the view distance exponentially between the near and far plane, farther pixels fall into the last slice
+float get_light_cluster_slice_distance(uint slice, float near_plane, float far_plane) {
+    return near_plane * pow(far_plane / near_plane, float(slice) / float(GPU_LIGHT_CLUSTER_Z));
+}
+uint get_light_cluster_index(vec2 uv, float view_distance, float near_plane, float far_plane) {
+    uvec2 tile = min(uvec2(uv * vec2(GPU_LIGHT_CLUSTER_X, GPU_LIGHT_CLUSTER_Y)), uvec2(GPU_LIGHT_CLUSTER_X - 1, GPU_LIGHT_CLUSTER_Y - 1));
+    float slice = log(max(view_distance, near_plane) / near_plane) / log(far_plane / near_plane) * float(GPU_LIGHT_CLUSTER_Z);
+    uint z = min(uint(slice), uint(GPU_LIGHT_CLUSTER_Z - 1));
+
+    return (z * GPU_LIGHT_CLUSTER_Y + tile.y) * GPU_LIGHT_CLUSTER_X + tile.x;
+}
+
+// With dynamic resolution only the top left render_size texels of the screen images are rendered, render_size is the main camera's viewport_size
+// Maps a UV of the rendered area to the UV of an image_size image, clamped half a texel inside so that bilinear taps don't read stale texels
+vec2 get_render_image_uv(vec2 uv, vec2 render_size, vec2 image_size) {
+    return clamp(uv * render_size, vec2(0.5), render_size - 0.5) / image_size;
+}
+
+// Shaders that fetch vertices themselves define VERTEX_BUFFER_BINDING, COMPACT_VERTEX_BUFFER_BINDING and PRIMITIVE_BUFFER_BINDING (set 0) before including this file
+#ifdef VERTEX_BUFFER_BINDING
+layout(scalar, set = 0, binding = VERTEX_BUFFER_BINDING) readonly buffer VertexBuffer {
+    Vertex vertices[];
+};
+// Same buffer as VERTEX_BUFFER_BINDING, primitives with GPU_VERTEX_FORMAT_COMPACT index it in 12 byte vertices
+layout(scalar, set = 0, binding = COMPACT_VERTEX_BUFFER_BINDING) readonly buffer CompactVertexBuffer {
+    CompactVertex compact_vertices[];
+};
+layout(set = 0, binding = PRIMITIVE_BUFFER_BINDING) readonly buffer PrimitiveBuffer {
+    Primitive primitives[];
+};
+
+vec3 load_vertex_position(uint primitive_index, uint vertex_id) {
+    if (primitives[primitive_index].vertex_format == GPU_VERTEX_FORMAT_COMPACT) {
+        vec3 quantization_offset = vec3(
+            primitives[primitive_index].quantization_offset[0],
+            primitives[primitive_index].quantization_offset[1],
+            primitives[primitive_index].quantization_offset[2]
+        );
+        vec3 quantization_scale = vec3(
+            primitives[primitive_index].quantization_scale[0],
+            primitives[primitive_index].quantization_scale[1],
+            primitives[primitive_index].quantization_scale[2]
+        );
+
+        return quantization_offset + vec3(uvec3(compact_vertices[vertex_id].position)) * quantization_scale;
+    }
+
+    return vertices[vertex_id].position;
+}
+void load_vertex(uint primitive_index, uint vertex_id, out vec3 position, out vec3 normal, out vec2 texcoord) {
+    position = load_vertex_position(primitive_index, vertex_id);
+
+    if (primitives[primitive_index].vertex_format == GPU_VERTEX_FORMAT_COMPACT) {
+        normal = decode_octahedral(unpackSnorm4x8(uint(compact_vertices[vertex_id].normal)).xy);
+        texcoord = vec2(compact_vertices[vertex_id].texcoord);
+    } else {
+        normal = vec3(ivec3(vertices[vertex_id].normal)) / 127.0f;
+        texcoord = vec2(vertices[vertex_id].texcoord);
+    }
+}
+#endif
@@ -1,20 +1,78 @@
 #version 450
 
+#include "common.glsl"
+
+layout (constant_id = 0) const uint NORMAL_ENCODING = GPU_NORMAL_ENCODING_FLOAT;
+
 layout(location = 0) in vec2 f_texcoord;
 
 layout(set = 0, binding = 0) uniform sampler2D in_albedo;
 layout(set = 0, binding = 1) uniform sampler2D in_normal;
 layout(set = 0, binding = 2) uniform sampler2D in_ssao;
+layout(set = 0, binding = 3) uniform sampler2D in_depth;
+layout(set = 0, binding = 4) uniform CameraBuffer {
+    Camera camera;
+};
+layout(set = 0, binding = 5) readonly buffer LightBuffer {
+    Light lights[];
+};
+layout(set = 0, binding = 6) readonly buffer LightClusterCountBuffer {
+    uint cluster_light_counts[];
+};
+layout(set = 0, binding = 7) readonly buffer LightClusterIndexBuffer {
+    uint cluster_light_indices[];
+};
 
 layout(location = 0) out vec4 out_color;
 
+vec3 evaluate_light(Light light, vec3 position, vec3 normal) {
+    vec3 to_light = light.position - position;
+    float distance_sq = dot(to_light, to_light);
+    float range_sq = light.range * light.range;
+    if (distance_sq >= range_sq) {
+        return vec3(0.0);
+    }
+
+    vec3 l = to_light * inversesqrt(distance_sq);
+
+    // Inverse square falloff windowed to reach zero at the range
+    float window = clamp(1.0 - (distance_sq * distance_sq) / (range_sq * range_sq), 0.0, 1.0);
+    float attenuation = window * window / max(distance_sq, 0.01);
+
+    if (light.type == GPU_LIGHT_TYPE_SPOT) {
+        attenuation *= smoothstep(light.outer_cone_cos, light.inner_cone_cos, dot(-l, light.direction));
+    }
+
+    return light.color * attenuation * max(dot(normal, l), 0.0);
+}
+
 void main() {
-    vec3 albedo = texture(in_albedo, f_texcoord).rgb;
-    vec3 normal = texture(in_normal, f_texcoord).xyz;
-    float ssao = texture(in_ssao, f_texcoord).r;
+    // Only the rendered area of the screen images is covered, f_texcoord spans just that area
+    ivec2 pixel = ivec2(gl_FragCoord.xy);
+
+    vec3 albedo = texelFetch(in_albedo, pixel, 0).rgb;
+    vec3 normal = decode_gbuffer_normal(texelFetch(in_normal, pixel, 0), NORMAL_ENCODING);
+    float ssao = texelFetch(in_ssao, pixel, 0).r;
 
     vec3 ambient = ssao * vec3(0.1, 0.1, 0.15) * 2.0;
-    float light = max(0.0, dot(normal, normalize(vec3(1.0))));
+    vec3 light = vec3(max(0.0, dot(normal, normalize(vec3(1.0))))); // Sun
+
+    // Reverse Z, pixels with nothing drawn have no position
+    float depth = texelFetch(in_depth, pixel, 0).r;
+    if (depth > 0.0) {
+        vec4 view_position = camera.inv_proj * vec4(f_texcoord * 2.0 - 1.0, depth, 1.0);
+        view_position.xyz /= view_position.w;
+
+        vec3 world_position = (camera.inv_view * vec4(view_position.xyz, 1.0)).xyz;
+
+        uint cluster_index = get_light_cluster_index(f_texcoord, -view_position.z, camera.near, camera.far);
+        uint light_count = cluster_light_counts[cluster_index];
+
+        for (uint i = 0u; i < light_count; ++i) {
+            uint light_id = cluster_light_indices[cluster_index * GPU_LIGHT_CLUSTER_MAX_LIGHTS + i];
+            light += evaluate_light(lights[light_id], world_position, normal);
+        }
+    }
 
     out_color = vec4(albedo * (ambient + light), 1.0);
-}
\ No newline at end of file
+}
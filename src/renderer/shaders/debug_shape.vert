@@ -9,44 +9,41 @@
 layout(scalar, set = 0, binding = 0) readonly buffer VertexBuffer {
     vec3 positions[];
 };
-layout(set = 0, binding = 1) readonly buffer DrawCommandBuffer {
-    DrawCommand draw_commands[];
+layout(set = 0, binding = 1) readonly buffer DrawInstanceBuffer {
+    DrawInstance draw_instances[];
 };
-layout(set = 0, binding = 2) readonly buffer ObjectBuffer {
-    Object objects[];
-};
-layout(set = 0, binding = 3) readonly buffer GlobalTransformBuffer {
+layout(set = 0, binding = 2) readonly buffer GlobalTransformBuffer {
     Transform global_transforms[];
 };
-layout(set = 0, binding = 4) readonly buffer MeshBuffer {
-    Mesh meshes[];
-};
-layout(set = 0, binding = 5) readonly buffer MeshInstanceBuffer {
-    MeshInstance mesh_instances[];
+layout(set = 0, binding = 3) readonly buffer PrimitiveBuffer {
+    Primitive primitives[];
 };
-layout(set = 0, binding = 6) uniform CameraBuffer {
+layout(set = 0, binding = 4) uniform CameraBuffer {
     Camera camera;
 };
-layout(set = 0, binding = 7) readonly buffer DrawCommandCountBuffer {
-    uint draw_command_count;
+layout(set = 0, binding = 5) readonly buffer ObjectBuffer {
+    Object objects[];
+};
+layout(set = 0, binding = 6) readonly buffer MeshInstanceBuffer {
+    MeshInstance mesh_instances[];
+};
+layout(set = 0, binding = 7) readonly buffer MeshBuffer {
+    Mesh meshes[];
 };
 
 void main() {
-    if(gl_InstanceIndex >= draw_command_count) {
-        gl_Position = vec4(0.0);
-        return;
-    }
-
-    uint object_id = draw_commands[gl_InstanceIndex].object_id;
+    // Instances of the debug draw map 1:1 to the drawn scene instances
+    uint object_id = draw_instances[gl_InstanceIndex].object_id;
+    uint mesh_id = mesh_instances[objects[object_id].mesh_instance].mesh;
+    uint primitive_index = meshes[mesh_id].primitive_start + draw_instances[gl_InstanceIndex].primitive_id;
 
     Transform transform = global_transforms[object_id];
 
-    Object object = objects[object_id];
-    MeshInstance mesh_instance = mesh_instances[object.mesh_instance];
-    Mesh mesh = meshes[mesh_instance.mesh];
-    float effective_radius = mesh.radius * transform.max_scale;
+    // Every draw shows the bounding sphere of its own primitive
+    vec3 center_offset = vec3(primitives[primitive_index].center_offset[0], primitives[primitive_index].center_offset[1], primitives[primitive_index].center_offset[2]);
+    float effective_radius = primitives[primitive_index].radius * transform.max_scale;
 
-    vec3 v_world_space = rotate_vq(positions[gl_VertexIndex] * effective_radius + mesh.center_offset * transform.scale, transform.rotation) + transform.position;
+    vec3 v_world_space = rotate_vq(positions[gl_VertexIndex] * effective_radius + center_offset * transform.scale, transform.rotation) + transform.position;
 
     gl_Position = camera.view_proj * vec4(v_world_space, 1.0);
 }
\ No newline at end of file
@@ -5,6 +5,8 @@
 #include "common.glsl"
 #include "../gpu_types.inl"
 
+layout (constant_id = 0) const uint NORMAL_ENCODING = GPU_NORMAL_ENCODING_FLOAT;
+
 layout(location = 0) in vec3 f_position;
 layout(location = 1) in vec3 f_normal;
 layout(location = 2) in vec2 f_texcoord;
@@ -37,6 +39,26 @@ layout(set = 0, binding = 5) readonly buffer MeshInstanceMaterialsBuffer {
 layout(set = 0, binding = 6) uniform CameraBuffer {
     Camera camera;
 };
+layout(set = 0, binding = 8) buffer TextureFeedbackBuffer {
+    uint texture_feedback[];
+};
+
+// Requests the mip at which the texture is sampled 1:1, stored as log2(mip width) + 1 so that 0 means "not sampled".
+// The value doesn't depend on how many mips are currently resident because the LOD is relative to the bound image.
+void write_texture_feedback(uint texture_id, vec2 uv) {
+    float lod = textureQueryLod(textures[texture_id], uv).y;
+    float size_log2 = log2(float(textureSize(textures[texture_id], 0).x));
+
+    // Only every 16th pixel writes to keep the atomic traffic low
+    if ((uint(gl_FragCoord.x) & 3u) != 0u || (uint(gl_FragCoord.y) & 3u) != 0u) {
+        return;
+    }
+
+    uint requested = uint(clamp(ceil(size_log2 - lod), 0.0, 15.0)) + 1u;
+    if (texture_feedback[texture_id] < requested) {
+        atomicMax(texture_feedback[texture_id], requested);
+    }
+}
 
 void main() {
     Material material = materials[
@@ -46,8 +68,10 @@ void main() {
     ];
     vec3 albedo = texture(textures[material.albedo_texture], f_texcoord).rgb * material.color.rgb;
 
+    write_texture_feedback(material.albedo_texture, f_texcoord);
+
     //albedo *= max(dot(vec3(1.0), f_normal), 0.1);
 
     out_color = vec4(albedo, 1.0);
-    out_normal = vec4(f_normal, 1.0);
+    out_normal = encode_gbuffer_normal(normalize(f_normal), NORMAL_ENCODING);
 }
\ No newline at end of file
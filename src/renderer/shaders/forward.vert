@@ -3,6 +3,10 @@
 #extension GL_ARB_shader_draw_parameters : require
 #extension GL_EXT_scalar_block_layout : require
 
+#define VERTEX_BUFFER_BINDING 7
+#define COMPACT_VERTEX_BUFFER_BINDING 9
+#define PRIMITIVE_BUFFER_BINDING 10
+
 #include "common.glsl"
 #include "../gpu_types.inl"
 
@@ -12,6 +16,10 @@ layout(location = 2) out vec2 f_texcoord;
 layout(location = 3) out flat uint f_object_id;
 layout(location = 4) out flat uint f_primitive_id;
 
+layout(push_constant) uniform PushConstant {
+    uint draw_command_offset;
+};
+
 layout(set = 0, binding = 0) readonly buffer DrawCommandBuffer {
     DrawCommand draw_commands[];
 };
@@ -33,17 +41,23 @@ layout(set = 0, binding = 5) readonly buffer MeshInstanceMaterialsBuffer {
 layout(set = 0, binding = 6) uniform CameraBuffer {
     Camera camera;
 };
-layout(scalar, set = 0, binding = 7) readonly buffer VertexBuffer {
-    Vertex vertices[];
+layout(set = 0, binding = 11) readonly buffer DrawInstanceBuffer {
+    DrawInstance draw_instances[];
 };
 
 void main() {
-    uint object_id = draw_commands[gl_DrawIDARB].object_id;
-    uint primitive_id = draw_commands[gl_DrawIDARB].primitive_id;
+    uint draw_id = draw_command_offset + gl_DrawIDARB;
+
+    // gl_InstanceIndex already includes first_instance of the draw
+    uint object_id = draw_instances[gl_InstanceIndex].object_id;
+    uint primitive_id = draw_instances[gl_InstanceIndex].primitive_id;
+    uint primitive_index = draw_commands[draw_id].primitive_index;
+
+    vec3 v_position;
+    vec3 v_normal;
+    vec2 v_texcoord;
 
-    vec3 v_position = vertices[gl_VertexIndex].position;
-    vec3 v_normal = vec3(ivec3(vertices[gl_VertexIndex].normal)) / 127.0f;
-    vec2 v_texcoord = vec2(vertices[gl_VertexIndex].texcoord);
+    load_vertex(primitive_index, uint(gl_VertexIndex), v_position, v_normal, v_texcoord);
 
     Transform transform = global_transforms[object_id];
     vec3 v_world_space = rotate_vq(v_position * transform.scale, transform.rotation) + transform.position;
@@ -0,0 +1,182 @@
+#version 450
+
+#extension GL_EXT_nonuniform_qualifier : require
+#extension GL_EXT_scalar_block_layout : require
+
+#define VERTEX_BUFFER_BINDING 9
+#define COMPACT_VERTEX_BUFFER_BINDING 10
+#define PRIMITIVE_BUFFER_BINDING 7
+
+#include "common.glsl"
+#include "../gpu_types.inl"
+
+layout (constant_id = 0) const uint NORMAL_ENCODING = GPU_NORMAL_ENCODING_FLOAT;
+
+layout(location = 0) in vec2 f_texcoord;
+
+layout(location = 0) out vec4 out_color;
+layout(location = 1) out vec4 out_normal;
+
+layout (set = 1, binding = 0) uniform sampler2D textures[];
+
+layout(set = 0, binding = 0) uniform usampler2D in_visibility;
+layout(set = 0, binding = 1) uniform CameraBuffer {
+    Camera camera;
+};
+layout(set = 0, binding = 2) readonly buffer DrawInstanceBuffer {
+    DrawInstance draw_instances[];
+};
+layout(set = 0, binding = 3) readonly buffer LateDrawInstanceBuffer {
+    DrawInstance late_draw_instances[];
+};
+layout(set = 0, binding = 4) readonly buffer ObjectBuffer {
+    Object objects[];
+};
+layout(set = 0, binding = 5) readonly buffer MeshInstanceBuffer {
+    MeshInstance mesh_instances[];
+};
+layout(set = 0, binding = 6) readonly buffer MeshBuffer {
+    Mesh meshes[];
+};
+layout(set = 0, binding = 8) readonly buffer GlobalTransformBuffer {
+    Transform global_transforms[];
+};
+layout(set = 0, binding = 11) readonly buffer IndexBuffer {
+    uint indices[];
+};
+layout(set = 0, binding = 12) readonly buffer Index16Buffer {
+    uint16_t indices16[];
+};
+layout(set = 0, binding = 13) readonly buffer MaterialBuffer {
+    Material materials[];
+};
+layout(set = 0, binding = 14) readonly buffer MeshInstanceMaterialsBuffer {
+    uint mesh_instance_materials[];
+};
+layout(set = 0, binding = 15) buffer TextureFeedbackBuffer {
+    uint texture_feedback[];
+};
+
+struct Barycentrics {
+    vec3 lambda;
+    vec3 ddx; // Change of lambda to the next pixel on x
+    vec3 ddy;
+};
+
+// Perspective correct barycentrics of the pixel and their screen space derivatives, computed from the clip space vertices
+// Replaces the interpolation and the implicit derivatives of the rasterizer, which neighbouring pixels of other triangles would break
+Barycentrics calculate_barycentrics(vec4 clip0, vec4 clip1, vec4 clip2, vec2 pixel_ndc, vec2 screen_size) {
+    vec3 inv_w = 1.0 / vec3(clip0.w, clip1.w, clip2.w);
+
+    vec2 ndc0 = clip0.xy * inv_w.x;
+    vec2 ndc1 = clip1.xy * inv_w.y;
+    vec2 ndc2 = clip2.xy * inv_w.z;
+
+    float inv_det = 1.0 / determinant(mat2(ndc2 - ndc1, ndc0 - ndc1));
+    vec3 ddx = vec3(ndc1.y - ndc2.y, ndc2.y - ndc0.y, ndc0.y - ndc1.y) * inv_det * inv_w;
+    vec3 ddy = vec3(ndc2.x - ndc1.x, ndc0.x - ndc2.x, ndc1.x - ndc0.x) * inv_det * inv_w;
+    float ddx_sum = dot(ddx, vec3(1.0));
+    float ddy_sum = dot(ddy, vec3(1.0));
+
+    vec2 delta = pixel_ndc - ndc0;
+    float interp_inv_w = inv_w.x + delta.x * ddx_sum + delta.y * ddy_sum;
+    float interp_w = 1.0 / interp_inv_w;
+
+    Barycentrics result;
+    result.lambda = interp_w * vec3(
+        inv_w.x + delta.x * ddx.x + delta.y * ddy.x,
+        delta.x * ddx.y + delta.y * ddy.y,
+        delta.x * ddx.z + delta.y * ddy.z
+    );
+
+    // From NDC units to pixels
+    ddx *= 2.0 / screen_size.x;
+    ddy *= 2.0 / screen_size.y;
+    ddx_sum *= 2.0 / screen_size.x;
+    ddy_sum *= 2.0 / screen_size.y;
+
+    float interp_w_ddx = 1.0 / (interp_inv_w + ddx_sum);
+    float interp_w_ddy = 1.0 / (interp_inv_w + ddy_sum);
+
+    result.ddx = interp_w_ddx * (result.lambda * interp_inv_w + ddx) - result.lambda;
+    result.ddy = interp_w_ddy * (result.lambda * interp_inv_w + ddy) - result.lambda;
+
+    return result;
+}
+
+uint load_index(uint index, bool is_index16) {
+    return is_index16 ? uint(indices16[index]) : indices[index];
+}
+
+// Same encoding as the feedback of forward.frag, the LOD comes from the analytic derivatives
+void write_texture_feedback(uint texture_id, vec2 uv_ddx, vec2 uv_ddy) {
+    // Only every 16th pixel writes to keep the atomic traffic low
+    if ((uint(gl_FragCoord.x) & 3u) != 0u || (uint(gl_FragCoord.y) & 3u) != 0u) {
+        return;
+    }
+
+    vec2 size = vec2(textureSize(textures[nonuniformEXT(texture_id)], 0));
+    float lod = log2(max(max(length(uv_ddx * size), length(uv_ddy * size)), 1e-8));
+
+    uint requested = uint(clamp(ceil(log2(size.x) - lod), 0.0, 15.0)) + 1u;
+    if (texture_feedback[texture_id] < requested) {
+        atomicMax(texture_feedback[texture_id], requested);
+    }
+}
+
+void main() {
+    ivec2 pixel = ivec2(gl_FragCoord.xy);
+    uvec2 visibility = texelFetch(in_visibility, pixel, 0).xy;
+
+    if (visibility.x == 0u) {
+        out_color = vec4(0.0);
+        out_normal = vec4(0.0);
+        return;
+    }
+
+    uint instance_id = (visibility.x & ~GPU_VISIBILITY_LATE_PHASE_BIT) - 1u;
+    DrawInstance instance = ((visibility.x & GPU_VISIBILITY_LATE_PHASE_BIT) != 0u) ? late_draw_instances[instance_id] : draw_instances[instance_id];
+
+    bool is_index16 = (visibility.y & GPU_VISIBILITY_INDEX16_BIT) != 0u;
+    uint first_index = visibility.y & ~GPU_VISIBILITY_INDEX16_BIT;
+
+    MeshInstance mesh_instance = mesh_instances[objects[instance.object_id].mesh_instance];
+    uint primitive_index = meshes[mesh_instance.mesh].primitive_start + instance.primitive_id;
+    int vertex_start = primitives[primitive_index].vertex_start;
+
+    Transform transform = global_transforms[instance.object_id];
+
+    vec4 clip_positions[3];
+    vec3 normals[3];
+    vec2 texcoords[3];
+
+    for (uint i = 0u; i < 3u; ++i) {
+        vec3 position;
+        load_vertex(primitive_index, uint(int(load_index(first_index + i, is_index16)) + vertex_start), position, normals[i], texcoords[i]);
+
+        vec3 world_space = rotate_vq(position * transform.scale, transform.rotation) + transform.position;
+        clip_positions[i] = camera.view_proj * vec4(world_space, 1.0);
+    }
+
+    // Only the rendered area of the visibility image is covered with dynamic resolution
+    vec2 screen_size = camera.viewport_size;
+    vec2 pixel_ndc = (vec2(pixel) + 0.5) / screen_size * 2.0 - 1.0;
+
+    Barycentrics bary = calculate_barycentrics(clip_positions[0], clip_positions[1], clip_positions[2], pixel_ndc, screen_size);
+
+    mat3x2 texcoord_matrix = mat3x2(texcoords[0], texcoords[1], texcoords[2]);
+    vec2 texcoord = texcoord_matrix * bary.lambda;
+    vec2 texcoord_ddx = texcoord_matrix * bary.ddx;
+    vec2 texcoord_ddy = texcoord_matrix * bary.ddy;
+
+    vec3 normal = normalize(rotate_vq(mat3(normals[0], normals[1], normals[2]) * bary.lambda, transform.rotation));
+
+    // Neighbouring pixels can belong to different materials
+    Material material = materials[mesh_instance_materials[mesh_instance.material_start + instance.primitive_id]];
+    vec3 albedo = textureGrad(textures[nonuniformEXT(material.albedo_texture)], texcoord, texcoord_ddx, texcoord_ddy).rgb * material.color.rgb;
+
+    write_texture_feedback(material.albedo_texture, texcoord_ddx, texcoord_ddy);
+
+    out_color = vec4(albedo, 1.0);
+    out_normal = encode_gbuffer_normal(normal, NORMAL_ENCODING);
+}
@@ -0,0 +1,98 @@
+#version 450
+
+layout(location = 0) in vec2 f_texcoord;
+
+layout(set = 0, binding = 0) uniform sampler2D in_image;
+
+layout(push_constant) uniform PushConstant {
+    vec2 render_size;
+    vec2 output_size;
+};
+
+layout(location = 0) out vec4 out_color;
+
+vec3 fetch(ivec2 texel) {
+    return texelFetch(in_image, clamp(texel, ivec2(0), ivec2(render_size) - 1), 0).rgb;
+}
+float luma(vec3 color) {
+    return dot(color, vec3(0.299, 0.587, 0.114));
+}
+
+// Windowed Lanczos 2 approximation, zero at the neighbouring texels and at a distance of 2
+float lanczos2(float distance_sq) {
+    distance_sq = min(distance_sq, 4.0);
+
+    float window = 0.25 * distance_sq - 1.0;
+    float base = 0.4 * distance_sq - 1.0;
+
+    return (25.0 / 16.0 * base * base - 9.0 / 16.0) * window * window;
+}
+
+// Edge directed upscale in the spirit of AMD FSR 1 EASU
+// The 4x4 footprint is weighted by a Lanczos kernel stretched along the local edge, which smooths the stair steps of lower resolutions
+// without blurring across the edge, the result is clamped to the closest 2x2 texels to avoid ringing
+void main() {
+    // Full resolution frames pass through unchanged
+    if (render_size == output_size) {
+        out_color = vec4(fetch(ivec2(gl_FragCoord.xy)), 1.0);
+        return;
+    }
+
+    vec2 position = f_texcoord * render_size - 0.5;
+    ivec2 base = ivec2(floor(position));
+    vec2 fraction = position - vec2(base);
+
+    vec3 colors[16];
+    float lumas[16];
+    for (int i = 0; i < 16; ++i) {
+        colors[i] = fetch(base + ivec2(i & 3, i >> 2) - 1);
+        lumas[i] = luma(colors[i]);
+    }
+
+    // Central difference gradients of the 2x2 closest texels, bilinearly weighted towards the pixel
+    vec2 gradient = vec2(0.0);
+    for (int i = 0; i < 4; ++i) {
+        ivec2 offset = ivec2(i & 1, i >> 1);
+        int center = (offset.y + 1) * 4 + offset.x + 1;
+
+        vec2 bilinear = mix(1.0 - fraction, fraction, vec2(offset));
+        gradient += vec2(lumas[center + 1] - lumas[center - 1], lumas[center + 4] - lumas[center - 4]) * bilinear.x * bilinear.y;
+    }
+
+    float min_luma = lumas[0];
+    float max_luma = lumas[0];
+    for (int i = 1; i < 16; ++i) {
+        min_luma = min(min_luma, lumas[i]);
+        max_luma = max(max_luma, lumas[i]);
+    }
+
+    float gradient_length = length(gradient);
+    float edge = clamp(gradient_length / max(max_luma - min_luma, 1e-4), 0.0, 1.0);
+
+    // The stretch grows with the upscale factor up to 2x
+    float upscale = clamp(output_size.x / render_size.x - 1.0, 0.0, 1.0);
+    float stretch = 1.0 + edge * upscale;
+
+    vec2 normal = gradient_length > 1e-6 ? gradient / gradient_length : vec2(1.0, 0.0);
+    vec2 tangent = vec2(-normal.y, normal.x);
+
+    vec3 color_sum = vec3(0.0);
+    float weight_sum = 0.0;
+    for (int i = 0; i < 16; ++i) {
+        vec2 offset = vec2(ivec2(i & 3, i >> 2) - 1) - fraction;
+
+        float along = dot(offset, tangent) / stretch;
+        float across = dot(offset, normal);
+
+        float weight = lanczos2(along * along + across * across);
+        color_sum += colors[i] * weight;
+        weight_sum += weight;
+    }
+
+    vec3 color = color_sum / max(weight_sum, 1e-4);
+
+    vec3 min_color = min(min(colors[5], colors[6]), min(colors[9], colors[10]));
+    vec3 max_color = max(max(colors[5], colors[6]), max(colors[9], colors[10]));
+
+    out_color = vec4(clamp(color, min_color, max_color), 1.0);
+}
@@ -0,0 +1,11 @@
+#version 450
+
+layout(location = 0) in flat uint f_instance;
+layout(location = 1) in flat uint f_first_index;
+
+layout(location = 0) out uvec2 out_visibility;
+
+void main() {
+    // gl_PrimitiveID restarts with every instance, so it's relative to the first index of the draw
+    out_visibility = uvec2(f_instance, f_first_index + uint(gl_PrimitiveID) * 3u);
+}
@@ -0,0 +1,52 @@
+#version 450
+
+#extension GL_ARB_shader_draw_parameters : require
+#extension GL_EXT_scalar_block_layout : require
+
+#define VERTEX_BUFFER_BINDING 7
+#define COMPACT_VERTEX_BUFFER_BINDING 9
+#define PRIMITIVE_BUFFER_BINDING 10
+
+#include "common.glsl"
+#include "../gpu_types.inl"
+
+layout(location = 0) out flat uint f_instance;
+layout(location = 1) out flat uint f_first_index;
+
+layout(push_constant) uniform PushConstant {
+    uint draw_command_offset;
+    uint index_type;
+    uint instance_flags;
+};
+
+layout(set = 0, binding = 0) readonly buffer DrawCommandBuffer {
+    DrawCommand draw_commands[];
+};
+layout(set = 0, binding = 2) readonly buffer GlobalTransformBuffer {
+    Transform global_transforms[];
+};
+layout(set = 0, binding = 6) uniform CameraBuffer {
+    Camera camera;
+};
+layout(set = 0, binding = 11) readonly buffer DrawInstanceBuffer {
+    DrawInstance draw_instances[];
+};
+
+void main() {
+    uint draw_id = draw_command_offset + gl_DrawIDARB;
+
+    uint object_id = draw_instances[gl_InstanceIndex].object_id;
+    uint primitive_index = draw_commands[draw_id].primitive_index;
+
+    // Only the position is needed, the Material Pass fetches the rest for the visible triangles
+    vec3 v_position = load_vertex_position(primitive_index, uint(gl_VertexIndex));
+
+    Transform transform = global_transforms[object_id];
+    vec3 v_world_space = rotate_vq(v_position * transform.scale, transform.rotation) + transform.position;
+
+    gl_Position = camera.view_proj * vec4(v_world_space, 1.0);
+
+    // Zero is reserved for empty texels
+    f_instance = (uint(gl_InstanceIndex) + 1u) | instance_flags;
+    f_first_index = draw_commands[draw_id].first_index | (index_type == GPU_INDEX_TYPE_U16 ? GPU_VISIBILITY_INDEX16_BIT : 0u);
+}
@@ -0,0 +1,413 @@
+#include "texture_file.hpp"
+
+#include <common/utils.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+
+static constexpr u32 make_four_cc(char a, char b, char c, char d) {
+    return static_cast<u32>(a) | (static_cast<u32>(b) << 8) | (static_cast<u32>(c) << 16) | (static_cast<u32>(d) << 24);
+}
+
+// https://learn.microsoft.com/en-us/windows/win32/direct3ddds/dds-header
+struct DDSPixelFormat {
+    u32 size{};
+    u32 flags{};
+    u32 four_cc{};
+    u32 rgb_bit_count{};
+    u32 r_bit_mask{};
+    u32 g_bit_mask{};
+    u32 b_bit_mask{};
+    u32 a_bit_mask{};
+};
+struct DDSHeader {
+    u32 size{};
+    u32 flags{};
+    u32 height{};
+    u32 width{};
+    u32 pitch_or_linear_size{};
+    u32 depth{};
+    u32 mip_map_count{};
+    u32 reserved1[11]{};
+    DDSPixelFormat pixel_format{};
+    u32 caps{};
+    u32 caps2{};
+    u32 caps3{};
+    u32 caps4{};
+    u32 reserved2{};
+};
+struct DDSHeaderDX10 {
+    u32 dxgi_format{};
+    u32 resource_dimension{};
+    u32 misc_flag{};
+    u32 array_size{};
+    u32 misc_flags2{};
+};
+
+static_assert(sizeof(DDSHeader) == 124);
+static_assert(sizeof(DDSHeaderDX10) == 20);
+
+static constexpr u32 DDS_MAGIC = make_four_cc('D', 'D', 'S', ' ');
+static constexpr u32 DDS_PIXEL_FORMAT_FOUR_CC = 0x4;
+static constexpr u32 DDS_PIXEL_FORMAT_RGB = 0x40;
+static constexpr u32 DDS_HEADER_FLAGS_MIP_MAP_COUNT = 0x20000;
+static constexpr u32 DDS_CAPS2_CUBEMAP = 0x200;
+static constexpr u32 DDS_DIMENSION_TEXTURE2D = 3;
+
+// https://registry.khronos.org/KTX/specs/2.0/ktxspec.v2.html
+struct KTX2Header {
+    u8 identifier[12]{};
+    u32 vk_format{};
+    u32 type_size{};
+    u32 pixel_width{};
+    u32 pixel_height{};
+    u32 pixel_depth{};
+    u32 layer_count{};
+    u32 face_count{};
+    u32 level_count{};
+    u32 supercompression_scheme{};
+
+    u32 dfd_byte_offset{};
+    u32 dfd_byte_length{};
+    u32 kvd_byte_offset{};
+    u32 kvd_byte_length{};
+    u64 sgd_byte_offset{};
+    u64 sgd_byte_length{};
+};
+struct KTX2LevelIndex {
+    u64 byte_offset{};
+    u64 byte_length{};
+    u64 uncompressed_byte_length{};
+};
+
+static_assert(sizeof(KTX2Header) == 80);
+static_assert(sizeof(KTX2LevelIndex) == 24);
+
+static constexpr std::array<u8, 12> KTX2_IDENTIFIER {
+    0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32, 0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A
+};
+
+static VkFormat dxgi_to_vk_format(u32 dxgi_format) {
+    switch (dxgi_format) {
+        case 28u: return VK_FORMAT_R8G8B8A8_UNORM;    // DXGI_FORMAT_R8G8B8A8_UNORM
+        case 29u: return VK_FORMAT_R8G8B8A8_SRGB;     // DXGI_FORMAT_R8G8B8A8_UNORM_SRGB
+        case 71u: return VK_FORMAT_BC1_RGBA_UNORM_BLOCK; // DXGI_FORMAT_BC1_UNORM
+        case 72u: return VK_FORMAT_BC1_RGBA_SRGB_BLOCK;  // DXGI_FORMAT_BC1_UNORM_SRGB
+        case 77u: return VK_FORMAT_BC3_UNORM_BLOCK;   // DXGI_FORMAT_BC3_UNORM
+        case 78u: return VK_FORMAT_BC3_SRGB_BLOCK;    // DXGI_FORMAT_BC3_UNORM_SRGB
+        case 80u: return VK_FORMAT_BC4_UNORM_BLOCK;   // DXGI_FORMAT_BC4_UNORM
+        case 81u: return VK_FORMAT_BC4_SNORM_BLOCK;   // DXGI_FORMAT_BC4_SNORM
+        case 83u: return VK_FORMAT_BC5_UNORM_BLOCK;   // DXGI_FORMAT_BC5_UNORM
+        case 84u: return VK_FORMAT_BC5_SNORM_BLOCK;   // DXGI_FORMAT_BC5_SNORM
+        case 98u: return VK_FORMAT_BC7_UNORM_BLOCK;   // DXGI_FORMAT_BC7_UNORM
+        case 99u: return VK_FORMAT_BC7_SRGB_BLOCK;    // DXGI_FORMAT_BC7_UNORM_SRGB
+        default: return VK_FORMAT_UNDEFINED;
+    }
+}
+
+// Many tools write colour textures with the *_UNORM DXGI formats, is_srgb reinterprets them like the legacy header path does
+static VkFormat get_srgb_format(VkFormat format) {
+    switch (format) {
+        case VK_FORMAT_R8G8B8A8_UNORM: return VK_FORMAT_R8G8B8A8_SRGB;
+        case VK_FORMAT_BC1_RGBA_UNORM_BLOCK: return VK_FORMAT_BC1_RGBA_SRGB_BLOCK;
+        case VK_FORMAT_BC3_UNORM_BLOCK: return VK_FORMAT_BC3_SRGB_BLOCK;
+        case VK_FORMAT_BC7_UNORM_BLOCK: return VK_FORMAT_BC7_SRGB_BLOCK;
+        default: return format; // Already sRGB or without an sRGB variant (BC4, BC5)
+    }
+}
+
+static VkFormat four_cc_to_vk_format(u32 four_cc, bool is_srgb) {
+    switch (four_cc) {
+        case make_four_cc('D', 'X', 'T', '1'): return is_srgb ? VK_FORMAT_BC1_RGBA_SRGB_BLOCK : VK_FORMAT_BC1_RGBA_UNORM_BLOCK;
+        case make_four_cc('D', 'X', 'T', '5'): return is_srgb ? VK_FORMAT_BC3_SRGB_BLOCK : VK_FORMAT_BC3_UNORM_BLOCK;
+        case make_four_cc('A', 'T', 'I', '1'):
+        case make_four_cc('B', 'C', '4', 'U'): return VK_FORMAT_BC4_UNORM_BLOCK;
+        case make_four_cc('B', 'C', '4', 'S'): return VK_FORMAT_BC4_SNORM_BLOCK;
+        case make_four_cc('A', 'T', 'I', '2'):
+        case make_four_cc('B', 'C', '5', 'U'): return VK_FORMAT_BC5_UNORM_BLOCK;
+        case make_four_cc('B', 'C', '5', 'S'): return VK_FORMAT_BC5_SNORM_BLOCK;
+        default: return VK_FORMAT_UNDEFINED;
+    }
+}
+
+static bool is_format_supported(VkFormat format) {
+    return TextureFile::get_format_block_size(format) != 0u;
+}
+
+bool TextureFile::is_container_path(const std::string &path) {
+    if (path.find('.') == std::string::npos) {
+        return false;
+    }
+
+    std::string extension = path.substr(path.find_last_of('.') + 1);
+    std::transform(extension.begin(), extension.end(), extension.begin(), [](char c) { return static_cast<char>(std::tolower(c)); });
+
+    return extension == "dds" || extension == "ktx2";
+}
+
+bool TextureFile::load(const std::string &path, bool is_srgb, TextureData &data) {
+    std::string extension = path.substr(path.find_last_of('.') + 1);
+    std::transform(extension.begin(), extension.end(), extension.begin(), [](char c) { return static_cast<char>(std::tolower(c)); });
+
+    if (extension == "dds") {
+        return load_dds(path, is_srgb, data);
+    } else if (extension == "ktx2") {
+        return load_ktx2(path, data);
+    }
+
+    DEBUG_ERROR("Unknown texture container extension \"" << extension << "\" in \"" << path << "\"")
+    return false;
+}
+
+bool TextureFile::load_dds(const std::string &path, bool is_srgb, TextureData &data) {
+    std::vector<u8> file = Utils::read_file_bytes(path);
+
+    if (file.size() < sizeof(u32) + sizeof(DDSHeader)) {
+        DEBUG_ERROR("Failed to load DDS from \"" << path << "\" - file is too small")
+        return false;
+    }
+
+    u32 magic{};
+    std::memcpy(&magic, file.data(), sizeof(u32));
+    if (magic != DDS_MAGIC) {
+        DEBUG_ERROR("Failed to load DDS from \"" << path << "\" - invalid magic number")
+        return false;
+    }
+
+    DDSHeader header{};
+    std::memcpy(&header, file.data() + sizeof(u32), sizeof(DDSHeader));
+
+    if (header.size != sizeof(DDSHeader) || header.pixel_format.size != sizeof(DDSPixelFormat)) {
+        DEBUG_ERROR("Failed to load DDS from \"" << path << "\" - invalid header size")
+        return false;
+    }
+    if ((header.caps2 & DDS_CAPS2_CUBEMAP) || header.depth > 1u) {
+        DEBUG_ERROR("Failed to load DDS from \"" << path << "\" - only 2D textures are supported")
+        return false;
+    }
+
+    usize data_offset = sizeof(u32) + sizeof(DDSHeader);
+
+    VkFormat format = VK_FORMAT_UNDEFINED;
+    if (header.pixel_format.flags & DDS_PIXEL_FORMAT_FOUR_CC) {
+        if (header.pixel_format.four_cc == make_four_cc('D', 'X', '1', '0')) {
+            if (file.size() < data_offset + sizeof(DDSHeaderDX10)) {
+                DEBUG_ERROR("Failed to load DDS from \"" << path << "\" - missing DX10 header")
+                return false;
+            }
+
+            DDSHeaderDX10 header_dx10{};
+            std::memcpy(&header_dx10, file.data() + data_offset, sizeof(DDSHeaderDX10));
+            data_offset += sizeof(DDSHeaderDX10);
+
+            if (header_dx10.resource_dimension != DDS_DIMENSION_TEXTURE2D || header_dx10.array_size > 1u) {
+                DEBUG_ERROR("Failed to load DDS from \"" << path << "\" - only 2D textures are supported")
+                return false;
+            }
+
+            format = dxgi_to_vk_format(header_dx10.dxgi_format);
+            if (is_srgb) {
+                format = get_srgb_format(format);
+            }
+        } else {
+            format = four_cc_to_vk_format(header.pixel_format.four_cc, is_srgb);
+        }
+    } else if ((header.pixel_format.flags & DDS_PIXEL_FORMAT_RGB) && header.pixel_format.rgb_bit_count == 32u && header.pixel_format.r_bit_mask == 0x000000FFu) {
+        format = is_srgb ? VK_FORMAT_R8G8B8A8_SRGB : VK_FORMAT_R8G8B8A8_UNORM;
+    }
+
+    if (!is_format_supported(format)) {
+        DEBUG_ERROR("Failed to load DDS from \"" << path << "\" - unsupported pixel format")
+        return false;
+    }
+
+    u32 level_count = (header.flags & DDS_HEADER_FLAGS_MIP_MAP_COUNT) ? std::max(header.mip_map_count, 1u) : 1u;
+
+    data.format = format;
+    data.width = header.width;
+    data.height = header.height;
+    data.mips.clear();
+
+    // DDS stores mips tightly packed, largest first
+    usize offset{};
+    u32 w = header.width, h = header.height;
+    for (u32 level{}; level < level_count; ++level) {
+        usize size = calculate_level_size(format, w, h);
+        if (data_offset + offset + size > file.size()) {
+            DEBUG_ERROR("Failed to load DDS from \"" << path << "\" - mip " << level << " is out of file bounds")
+            return false;
+        }
+
+        data.mips.push_back(TextureDataMip{ .offset = offset, .size = size, .width = w, .height = h });
+
+        offset += size;
+        w = std::max(1u, w / 2u);
+        h = std::max(1u, h / 2u);
+    }
+
+    data.bytes.assign(file.begin() + static_cast<std::ptrdiff_t>(data_offset), file.begin() + static_cast<std::ptrdiff_t>(data_offset + offset));
+
+    return true;
+}
+
+bool TextureFile::load_ktx2(const std::string &path, TextureData &data) {
+    std::vector<u8> file = Utils::read_file_bytes(path);
+
+    if (file.size() < sizeof(KTX2Header)) {
+        DEBUG_ERROR("Failed to load KTX2 from \"" << path << "\" - file is too small")
+        return false;
+    }
+
+    KTX2Header header{};
+    std::memcpy(&header, file.data(), sizeof(KTX2Header));
+
+    if (std::memcmp(header.identifier, KTX2_IDENTIFIER.data(), KTX2_IDENTIFIER.size()) != 0) {
+        DEBUG_ERROR("Failed to load KTX2 from \"" << path << "\" - invalid identifier")
+        return false;
+    }
+    if (header.supercompression_scheme != 0u) {
+        DEBUG_ERROR("Failed to load KTX2 from \"" << path << "\" - supercompression scheme " << header.supercompression_scheme << " is not supported")
+        return false;
+    }
+    if (header.pixel_depth > 1u || header.layer_count > 1u || header.face_count != 1u) {
+        DEBUG_ERROR("Failed to load KTX2 from \"" << path << "\" - only 2D textures are supported")
+        return false;
+    }
+
+    auto format = static_cast<VkFormat>(header.vk_format);
+    if (!is_format_supported(format)) {
+        DEBUG_ERROR("Failed to load KTX2 from \"" << path << "\" - unsupported VkFormat " << header.vk_format)
+        return false;
+    }
+
+    // levelCount == 0 means that the mips should be generated by the loader
+    u32 level_count = std::max(header.level_count, 1u);
+    if (file.size() < sizeof(KTX2Header) + level_count * sizeof(KTX2LevelIndex)) {
+        DEBUG_ERROR("Failed to load KTX2 from \"" << path << "\" - level index is out of file bounds")
+        return false;
+    }
+
+    std::vector<KTX2LevelIndex> level_index(level_count);
+    std::memcpy(level_index.data(), file.data() + sizeof(KTX2Header), level_count * sizeof(KTX2LevelIndex));
+
+    data.format = format;
+    data.width = header.pixel_width;
+    data.height = std::max(header.pixel_height, 1u);
+    data.mips.clear();
+
+    usize total_size{};
+    for (const auto &level : level_index) {
+        total_size += static_cast<usize>(level.byte_length);
+    }
+
+    data.bytes.resize(total_size);
+
+    // KTX2 stores the smallest mip first in the file, the level index itself is ordered from the largest one
+    usize offset{};
+    u32 w = data.width, h = data.height;
+    for (u32 level{}; level < level_count; ++level) {
+        const auto &[byte_offset, byte_length, uncompressed_byte_length] = level_index[level];
+
+        if (byte_offset + byte_length > file.size() || byte_length != calculate_level_size(format, w, h)) {
+            DEBUG_ERROR("Failed to load KTX2 from \"" << path << "\" - invalid mip " << level)
+            return false;
+        }
+
+        std::memcpy(data.bytes.data() + offset, file.data() + byte_offset, static_cast<usize>(byte_length));
+        data.mips.push_back(TextureDataMip{ .offset = offset, .size = static_cast<usize>(byte_length), .width = w, .height = h });
+
+        offset += static_cast<usize>(byte_length);
+        w = std::max(1u, w / 2u);
+        h = std::max(1u, h / 2u);
+    }
+
+    return true;
+}
+
+bool TextureFile::is_block_compressed(VkFormat format) {
+    return format >= VK_FORMAT_BC1_RGB_UNORM_BLOCK && format <= VK_FORMAT_BC7_SRGB_BLOCK;
+}
+
+bool TextureFile::is_srgb(VkFormat format) {
+    switch (format) {
+        case VK_FORMAT_R8_SRGB:
+        case VK_FORMAT_R8G8_SRGB:
+        case VK_FORMAT_R8G8B8_SRGB:
+        case VK_FORMAT_R8G8B8A8_SRGB:
+        case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+        case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+        case VK_FORMAT_BC3_SRGB_BLOCK:
+        case VK_FORMAT_BC7_SRGB_BLOCK:
+            return true;
+        default:
+            return false;
+    }
+}
+
+u32 TextureFile::get_format_block_size(VkFormat format) {
+    switch (format) {
+        case VK_FORMAT_R8_UNORM:
+        case VK_FORMAT_R8_SRGB:
+            return 1u;
+        case VK_FORMAT_R8G8_UNORM:
+        case VK_FORMAT_R8G8_SRGB:
+            return 2u;
+        case VK_FORMAT_R8G8B8_UNORM:
+        case VK_FORMAT_R8G8B8_SRGB:
+            return 3u;
+        case VK_FORMAT_R8G8B8A8_UNORM:
+        case VK_FORMAT_R8G8B8A8_SRGB:
+            return 4u;
+        case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+        case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+        case VK_FORMAT_BC1_RGBA_UNORM_BLOCK:
+        case VK_FORMAT_BC1_RGBA_SRGB_BLOCK:
+        case VK_FORMAT_BC4_UNORM_BLOCK:
+        case VK_FORMAT_BC4_SNORM_BLOCK:
+            return 8u;
+        case VK_FORMAT_BC3_UNORM_BLOCK:
+        case VK_FORMAT_BC3_SRGB_BLOCK:
+        case VK_FORMAT_BC5_UNORM_BLOCK:
+        case VK_FORMAT_BC5_SNORM_BLOCK:
+        case VK_FORMAT_BC7_UNORM_BLOCK:
+        case VK_FORMAT_BC7_SRGB_BLOCK:
+            return 16u;
+        default:
+            return 0u;
+    }
+}
+
+usize TextureFile::calculate_level_size(VkFormat format, u32 width, u32 height) {
+    if (is_block_compressed(format)) {
+        return Utils::div_ceil(width, 4u) * Utils::div_ceil(height, 4u) * get_format_block_size(format);
+    }
+
+    return static_cast<usize>(width) * height * get_format_block_size(format);
+}
+
+const char *TextureFile::get_format_name(VkFormat format) {
+    switch (format) {
+        case VK_FORMAT_R8_UNORM: return "R8_UNORM";
+        case VK_FORMAT_R8_SRGB: return "R8_SRGB";
+        case VK_FORMAT_R8G8_UNORM: return "R8G8_UNORM";
+        case VK_FORMAT_R8G8_SRGB: return "R8G8_SRGB";
+        case VK_FORMAT_R8G8B8_UNORM: return "R8G8B8_UNORM";
+        case VK_FORMAT_R8G8B8_SRGB: return "R8G8B8_SRGB";
+        case VK_FORMAT_R8G8B8A8_UNORM: return "R8G8B8A8_UNORM";
+        case VK_FORMAT_R8G8B8A8_SRGB: return "R8G8B8A8_SRGB";
+        case VK_FORMAT_BC1_RGB_UNORM_BLOCK: return "BC1_RGB_UNORM";
+        case VK_FORMAT_BC1_RGB_SRGB_BLOCK: return "BC1_RGB_SRGB";
+        case VK_FORMAT_BC1_RGBA_UNORM_BLOCK: return "BC1_RGBA_UNORM";
+        case VK_FORMAT_BC1_RGBA_SRGB_BLOCK: return "BC1_RGBA_SRGB";
+        case VK_FORMAT_BC3_UNORM_BLOCK: return "BC3_UNORM";
+        case VK_FORMAT_BC3_SRGB_BLOCK: return "BC3_SRGB";
+        case VK_FORMAT_BC4_UNORM_BLOCK: return "BC4_UNORM";
+        case VK_FORMAT_BC4_SNORM_BLOCK: return "BC4_SNORM";
+        case VK_FORMAT_BC5_UNORM_BLOCK: return "BC5_UNORM";
+        case VK_FORMAT_BC5_SNORM_BLOCK: return "BC5_SNORM";
+        case VK_FORMAT_BC7_UNORM_BLOCK: return "BC7_UNORM";
+        case VK_FORMAT_BC7_SRGB_BLOCK: return "BC7_SRGB";
+        default: return "UNKNOWN";
+    }
+}
@@ -0,0 +1,45 @@
+#ifndef GEMINO_TEXTURE_FILE_HPP
+#define GEMINO_TEXTURE_FILE_HPP
+
+#include <vulkan/vulkan.h>
+#include <common/types.hpp>
+#include <common/debug.hpp>
+
+#include <vector>
+#include <string>
+
+struct TextureDataMip {
+    usize offset{}; // Relative to TextureData::bytes
+    usize size{};
+    u32 width{};
+    u32 height{};
+};
+
+struct TextureData {
+    VkFormat format = VK_FORMAT_UNDEFINED;
+    u32 width{};
+    u32 height{};
+
+    std::vector<TextureDataMip> mips{};
+    std::vector<u8> bytes{};
+};
+
+// Containers with pre-generated mip chains (.dds / .ktx2), only 2D textures without supercompression are supported
+namespace TextureFile {
+    bool is_container_path(const std::string &path);
+
+    bool load(const std::string &path, bool is_srgb, TextureData &data);
+    bool load_dds(const std::string &path, bool is_srgb, TextureData &data);
+    bool load_ktx2(const std::string &path, TextureData &data);
+
+    bool is_block_compressed(VkFormat format);
+    bool is_srgb(VkFormat format);
+
+    // Bytes per 4x4 block for block compressed formats, bytes per pixel otherwise
+    u32 get_format_block_size(VkFormat format);
+    usize calculate_level_size(VkFormat format, u32 width, u32 height);
+
+    const char *get_format_name(VkFormat format);
+}
+
+#endif
@@ -49,6 +49,26 @@ Handle<Camera> World::create_camera(const CameraCreateInfo& create_info) {
 
     return m_cameras.alloc(camera);
 }
+Handle<Light> World::create_light(const LightCreateInfo &create_info) {
+    // smoothstep(outer, inner, x) in the shaders is undefined for outer >= inner, so the outer cone is always slightly wider
+    f32 inner_cone_cos = std::cos(glm::radians(create_info.inner_cone_angle));
+    f32 outer_cone_cos = std::min(std::cos(glm::radians(create_info.outer_cone_angle)), inner_cone_cos - 1e-4f);
+
+    Light light{
+        .position = create_info.position,
+        .range = create_info.range,
+        .color = create_info.color * create_info.intensity,
+        .type = create_info.type,
+        .direction = glm::normalize(create_info.direction),
+        .inner_cone_cos = inner_cone_cos,
+        .outer_cone_cos = outer_cone_cos,
+    };
+
+    Handle<Light> light_handle = m_lights.alloc(light);
+    m_changed_light_handles.insert(light_handle);
+
+    return light_handle;
+}
 
 Handle<Object> World::instantiate_scene_recursive(const SceneCreateInfo &create_info, u32 object_id, Handle<Object> parent_handle) {
 #if DEBUG_MODE
@@ -145,6 +165,17 @@ void World::destroy_camera(Handle<Camera> camera) {
 
     m_cameras.free(camera);
 }
+void World::destroy_light(Handle<Light> light) {
+    if(!m_lights.is_handle_valid(light)) {
+        DEBUG_PANIC("Cannot delete light - Light with a handle id: " << light << ", does not exist!")
+    }
+
+    // Uploaded once more so that the GPU stops shading with it
+    m_lights.get_element_mutable(light).enabled = 0U;
+    m_changed_light_handles.insert(light);
+
+    m_lights.free(light);
+}
 
 void World::set_position(Handle<Object> object, glm::vec3 position) {
     Transform &target = m_local_transforms.get_element_mutable(object.into<Transform>());
@@ -245,6 +276,41 @@ void World::set_camera_viewport(Handle<Camera> camera, glm::vec2 viewport_size)
     update_matrices(target);
 }
 
+void World::set_light_position(Handle<Light> light, glm::vec3 position) {
+    Light &target = m_lights.get_element_mutable(light);
+
+    if(target.position == position) return;
+
+    target.position = position;
+    m_changed_light_handles.insert(light);
+}
+void World::set_light_direction(Handle<Light> light, glm::vec3 direction) {
+    Light &target = m_lights.get_element_mutable(light);
+
+    direction = glm::normalize(direction);
+    if(target.direction == direction) return;
+
+    target.direction = direction;
+    m_changed_light_handles.insert(light);
+}
+void World::set_light_color(Handle<Light> light, glm::vec3 color, float intensity) {
+    Light &target = m_lights.get_element_mutable(light);
+
+    color *= intensity;
+    if(target.color == color) return;
+
+    target.color = color;
+    m_changed_light_handles.insert(light);
+}
+void World::set_light_range(Handle<Light> light, float range) {
+    Light &target = m_lights.get_element_mutable(light);
+
+    if(target.range == range) return;
+
+    target.range = range;
+    m_changed_light_handles.insert(light);
+}
+
 glm::mat4 World::calculate_view_matrix(const Camera &camera) const {
     return glm::lookAt(camera.position, camera.position + camera.forward, WORLD_UP);
 }
@@ -349,3 +415,8 @@ void World::_clear_updates(const std::vector<Handle<Object>> &handles_to_clear)
         m_changed_object_handles.erase(h);
     }
 }
+void World::_clear_light_updates(const std::vector<Handle<Light>> &handles_to_clear) {
+    for (const auto &h : handles_to_clear) {
+        m_changed_light_handles.erase(h);
+    }
+}
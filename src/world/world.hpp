@@ -29,6 +29,19 @@ struct CameraCreateInfo{
     float near_plane = 0.02f;
     float far_plane = 2000.0f;
 };
+struct LightCreateInfo{
+    u32 type = GPU_LIGHT_TYPE_POINT;
+
+    glm::vec3 position{};
+    glm::vec3 direction = glm::vec3(0.0f, -1.0f, 0.0f); // Spot lights only
+
+    glm::vec3 color = glm::vec3(1.0f);
+    float intensity = 1.0f;
+    float range = 10.0f;
+
+    float inner_cone_angle = 20.0f; // Degrees from the direction, spot lights only
+    float outer_cone_angle = 30.0f;
+};
 struct SceneCreateInfo {
     std::vector<Handle<Mesh>> meshes{};
     std::vector<Handle<MeshInstance>> mesh_instances{};
@@ -51,11 +64,13 @@ class World {
 public:
     Handle<Object> create_object(const ObjectCreateInfo &create_info);
     Handle<Camera> create_camera(const CameraCreateInfo &create_info);
+    Handle<Light> create_light(const LightCreateInfo &create_info);
     Handle<Object> instantiate_scene(const SceneCreateInfo &create_info);
     Handle<Object> instantiate_scene_object(const SceneCreateInfo &create_info, u32 object_id);
 
     void destroy_object(Handle<Object> object);
     void destroy_camera(Handle<Camera> camera);
+    void destroy_light(Handle<Light> light);
 
     void set_position(Handle<Object> object, glm::vec3 position);
     void set_rotation(Handle<Object> object, glm::quat rotation);
@@ -70,6 +85,7 @@ public:
     const Transform &get_global_transform(Handle<Object> object) const { return m_global_transforms.get_element(object.into<Transform>()); }
     const Object &get_object(Handle<Object> object) const { return m_objects.get_element(object); }
     const Camera &get_camera(Handle<Camera> camera) const { return m_cameras.get_element(camera); }
+    const Light &get_light(Handle<Light> light) const { return m_lights.get_element(light); }
     bool get_visibility(Handle<Object> object) const { return static_cast<bool>(m_objects.get_element(object).visible); }
 
     void set_camera_position(Handle<Camera> camera, glm::vec3 position);
@@ -77,13 +93,21 @@ public:
     void set_camera_fov(Handle<Camera> camera, float fov);
     void set_camera_viewport(Handle<Camera> camera, glm::vec2 viewport_size);
 
+    void set_light_position(Handle<Light> light, glm::vec3 position);
+    void set_light_direction(Handle<Light> light, glm::vec3 direction);
+    void set_light_color(Handle<Light> light, glm::vec3 color, float intensity);
+    void set_light_range(Handle<Light> light, float range);
+
     const std::unordered_set<Handle<Object>> &get_valid_object_handles() const { return m_objects.get_valid_handles(); }
     const std::unordered_set<Handle<Camera>> &get_valid_camera_handles() const { return m_cameras.get_valid_handles(); }
+    const std::unordered_set<Handle<Light>> &get_valid_light_handles() const { return m_lights.get_valid_handles(); }
 
     const std::vector<Object> &get_objects() const { return m_objects.get_all_elements(); };
     const std::vector<Camera> &get_cameras() const { return m_cameras.get_all_elements(); };
+    const std::vector<Light> &get_lights() const { return m_lights.get_all_elements(); };
 
     const std::unordered_set<Handle<Object>> &get_changed_object_handles() const { return m_changed_object_handles; }
+    const std::unordered_set<Handle<Light>> &get_changed_light_handles() const { return m_changed_light_handles; }
 
     const glm::vec3 WORLD_UP = glm::vec3(0.0f, 1.0f, 0.0f);
 
@@ -93,6 +117,7 @@ public:
 
 private:
     void _clear_updates(const std::vector<Handle<Object>> &handles_to_clear);
+    void _clear_light_updates(const std::vector<Handle<Light>> &handles_to_clear);
 
     Handle<Object> instantiate_scene_recursive(const SceneCreateInfo &create_info, u32 object_id, Handle<Object> parent_handle);
     void update_object_recursive(Handle<Object> object_handle);
@@ -107,9 +132,11 @@ private:
     HandleAllocator<Transform> m_global_transforms{};
     HandleAllocator<Object> m_objects{};
     HandleAllocator<Camera> m_cameras{};
+    HandleAllocator<Light> m_lights{};
     HandleAllocator<std::vector<Handle<Object>>> m_children{};
 
     std::unordered_set<Handle<Object>> m_changed_object_handles{};
+    std::unordered_set<Handle<Light>> m_changed_light_handles{};
 };
 
 #endif
\ No newline at end of file